@@ -0,0 +1,43 @@
+#pragma once
+#include "ShadowMap.h"
+
+// Cascade sizes - MAX_CASCADES
+#include "Utilities.h"
+
+/*
+Cascades of a directional light packed into a single depth atlas, so every cascade can have its own resolution and the
+main shader samples all of them through one sampler. Tiles are placed in columns as tall as the biggest cascade, a column
+is as wide as its first tile and smaller tiles are stacked in it while they fit.
+*/
+class CascadedShadowMap : public ShadowMap {
+private:
+    GLuint cascadeCount;
+
+    // Tile of every cascade in the atlas - x, y, size in texels
+    glm::uvec3 tiles[MAX_CASCADES];
+
+public:
+    // Constructor
+    CascadedShadowMap();
+
+    // Resolution of every cascade, from the nearest to the farthest
+    bool initCascades(const GLuint* resolutions, GLuint count);
+
+    // Bind the atlas for drawing, limited to the tile of the cascade (Viewport and scissor)
+    void writeCascade(GLuint cascade);
+
+    // Tiles are copied to and from the static cache, not the whole atlas
+    void storeStatic(GLuint layer) override;
+    void restoreStatic(GLuint layer) override;
+
+    glm::uvec3 getLayerTile(GLuint layer) const override { return tiles[layer]; }
+
+    GLuint getCascadeCount() const { return cascadeCount; }
+    GLuint getCascadeResolution(GLuint cascade) const { return tiles[cascade].z; }
+
+    // Offset and scale of the tile in texture coordinates
+    glm::vec4 getCascadeRect(GLuint cascade) const;
+
+    // Destructor
+    ~CascadedShadowMap();
+};
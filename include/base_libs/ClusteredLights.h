@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdio.h>
+#include <cstddef>
+#include <vector>
+#include <chrono>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// LIGHT_CLUSTERS_X/Y/Z, CLUSTERED_LIGHTS_THREAD_MIN
+#include "Utilities.h"
+
+// SHADOW_ATLAS_FACES
+#include "ShadowAtlas.h"
+
+// Splitting the slices over the worker threads
+#include "JobSystem.h"
+
+// Binding points of the ClusterLights, ClusterGrid and ClusterIndices buffers in shader.frag
+const GLuint CLUSTER_LIGHTS_BINDING = 1;
+const GLuint CLUSTER_GRID_BINDING = 2;
+const GLuint CLUSTER_INDICES_BINDING = 3;
+
+// Point lights are spot lights with an edge below -1, so every fragment in range is inside the cone
+const GLfloat POINT_LIGHT_EDGE = -2.0f;
+
+// A point or spot light and its shadow in the ClusterLights buffer (std430) - A vec3 followed by a float takes 16 bytes
+struct ClusterLightBlock {
+    // Cone of spot lights, and the tile of every face in the shadow atlas (Offset, scale) - Empty without a tile
+    glm::mat4 shadowTransform;
+    glm::vec4 shadowTiles[SHADOW_ATLAS_FACES];
+
+    glm::vec3 position;
+    GLfloat range;
+    glm::vec3 colour;
+    GLfloat ambientIntensity;
+    glm::vec3 direction;
+    GLfloat edge;
+    GLfloat diffuseIntensity;
+    GLfloat constant;
+    GLfloat linear;
+    GLfloat exponent;
+    GLfloat farPlane;
+    GLfloat padding[3];
+};
+
+static_assert(offsetof(ClusterLightBlock, position) == 160 && offsetof(ClusterLightBlock, farPlane) == 224 &&
+              sizeof(ClusterLightBlock) == 240, "std430 ClusterLightBlock layout");
+
+// Cone of a spot light against a sphere, only for cones narrower than 90 degrees (Cosine is the edge of the light)
+// Conservative, a few spheres just outside the cone are kept - Shared with the object lists
+bool isConeInSphere(const glm::vec3& apex, const glm::vec3& direction, float cosine, float range,
+                    const glm::vec3& center, float radius);
+
+/*
+Clustered forward lighting - The view frustum is split into LIGHT_CLUSTERS_X * Y * Z clusters (Screen tiles, exponential
+depth slices) and every cluster gets the list of the point and spot lights reaching it. The main shader only loops over the
+list of the cluster of the fragment, so the number of lights isn't limited by uniform arrays anymore.
+Lights keep the index they were added with, which is their shadow slot and their index in the object lists. Lights with a
+range of 0 (Switched off) stay in the buffer but reach no cluster.
+Every slice is assigned on its own - The lights touching the slice are picked first, then tested 4 at a time (SSE) against
+the bounds of every cluster of the slice, plus a cone test for spot lights. With enough lights the slices are split over
+the job system.
+*/
+class ClusteredLights {
+private:
+    // Lights of a single slice, filled by its job
+    struct SliceWork {
+        // Lights overlapping the bounds of the slice, and their view space spheres for the SIMD tests
+        std::vector<GLuint> candidates;
+        std::vector<float> candidateX, candidateY, candidateZ, candidateRadius;
+
+        // Lists of the clusters of the slice, one after another
+        std::vector<GLuint> indices;
+        std::vector<GLuint> counts;
+    };
+
+    // Lights of the current frame, in the layout of the ClusterLights buffer
+    std::vector<ClusterLightBlock> lights;
+
+    // View space spheres and directions of the lights - Structure of arrays for the SIMD tests
+    std::vector<float> lightX, lightY, lightZ, lightRadius;
+    std::vector<glm::vec3> lightDirections;
+
+    // View space bounds of the clusters, rebuilt only when the projection changes
+    glm::mat4 clusterProjection;
+    std::vector<glm::vec3> boundsMin, boundsMax;
+    glm::vec3 sliceMin[LIGHT_CLUSTERS_Z], sliceMax[LIGHT_CLUSTERS_Z];
+
+    SliceWork slices[LIGHT_CLUSTERS_Z];
+
+    // Offset and count of the light list of every cluster, then the lists themselves
+    std::vector<glm::uvec2> grid;
+    std::vector<GLuint> indices;
+
+    // Slice of a view depth - log(depth) * depthScale + depthBias
+    GLfloat depthScale, depthBias;
+
+    // Shader storage buffers, grown when the lights or lists don't fit anymore
+    GLuint lightsBuffer, gridBuffer, indicesBuffer;
+    GLsizeiptr lightsCapacity, gridCapacity, indicesCapacity;
+
+    // Stats of the last assignment
+    GLuint maxClusterLights;
+    double assignTime;
+
+    // View space bounds of every cluster seen through projection
+    void buildClusterBounds(const glm::mat4& projection, GLfloat nearPlane, GLfloat farPlane);
+
+    // Lists of every cluster of a slice
+    void assignSlice(int slice);
+
+    // Upload data to buffer, growing it if it doesn't fit
+    static void updateBuffer(GLuint buffer, GLsizeiptr& capacity, const void* data, GLsizeiptr size);
+
+public:
+    // Constructor
+    ClusteredLights();
+
+    // Allocate the buffers and bind them to their binding points
+    void createBuffers();
+
+    // Forget the lights of the previous frame
+    void clearLights();
+
+    // Returns the index of the light in the buffer
+    GLint addLight(const ClusterLightBlock& light);
+
+    // Build the list of every cluster - No GL calls, the projection has to be a perspective one
+    // The slices go to the job system once there are enough lights
+    void assignLights(const glm::mat4& projection, const glm::mat4& view, JobSystem* jobSystem = nullptr);
+
+    // Upload the lights and the lists of the last assignment
+    void uploadBuffers();
+
+    // Getters=========================================================================================================
+    size_t getLightCount() const { return lights.size(); }
+    GLfloat getDepthScale() const { return depthScale; }
+    GLfloat getDepthBias() const { return depthBias; }
+    GLuint getMaxClusterLights() const { return maxClusterLights; }
+    double getAssignTime() const { return assignTime; }
+
+    // Average length of the lists of the last assignment
+    GLfloat getAverageClusterLights() const;
+
+    // Not copyable, the buffers are owned by a single object
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    // Destructor
+    ~ClusteredLights();
+};
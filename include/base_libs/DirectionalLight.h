@@ -1,15 +1,24 @@
 #pragma once
 #include "Light.h"
+#include "CascadedShadowMap.h"
 
 class DirectionalLight : public Light {
 private:
     glm::vec3 direction;
 
+    // Projection * View of every cascade and the view distance where it ends, from the last calculateCascades
+    glm::mat4 cascadeTransforms[MAX_CASCADES];
+    GLfloat cascadeSplits[MAX_CASCADES];
+
+    // World space distance between the near and far plane of every cascade, depth 1 in its shadow map
+    GLfloat cascadeDepthRanges[MAX_CASCADES];
+
 public:
     // Constructor
     DirectionalLight();
 
-    DirectionalLight( GLuint shadowWidth, GLuint shadowHeight,
+    // Resolution of every cascade, from the nearest to the farthest
+    DirectionalLight( const GLuint* cascadeResolutions, GLuint cascadeCount,
                       GLfloat red, GLfloat green, GLfloat blue,
                       GLfloat ambIntensity, GLfloat diffIntensity,
                       GLfloat xDir, GLfloat yDir, GLfloat zDir );
@@ -18,7 +27,15 @@ public:
     void useLight(  GLuint ambientIntensityLocation, GLuint ambientColourLocation,
                     GLuint diffuseIntensityLocation, GLuint directionLocation  );
 
-    glm::mat4 calculateLightTransform();
+    // Split the view frustum of the camera and fit a cascade around every slice
+    // Cascades are spheres snapped to whole texels, so they don't shimmer when the camera moves or turns
+    void calculateCascades(const glm::mat4& view, GLfloat fov, GLfloat aspect, GLfloat nearPlane, GLfloat farPlane);
+
+    CascadedShadowMap* getCascadedShadowMap() { return static_cast<CascadedShadowMap*>(shadowMap); }
+    GLuint getCascadeCount() { return shadowMap ? getCascadedShadowMap()->getCascadeCount() : 0; }
+    const glm::mat4& getCascadeTransform(GLuint cascade) const { return cascadeTransforms[cascade]; }
+    GLfloat getCascadeSplit(GLuint cascade) const { return cascadeSplits[cascade]; }
+    GLfloat getCascadeDepthRange(GLuint cascade) const { return cascadeDepthRanges[cascade]; }
 
     // Destructor
     ~DirectionalLight();
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <iostream>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// Texture units tracked by the cache, binds to higher units always go through
+const int MAX_CACHED_TEXTURE_UNITS = 16;
+
+/*
+Shadow copy of the GL state the renderer changes the most. Every setter compares against the last value it set and skips
+the GL call if nothing would change. All binds of programs, vertex arrays and textures have to go through glState,
+otherwise the copy goes out of sync - invalidate() forgets everything if some code has to change the state directly.
+Objects deleted while bound are unbound by GL, the forget functions have to be called when deleting them.
+*/
+class GLStateCache {
+private:
+    // 0 is a valid binding, unknown values are marked with this
+    static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+    GLuint program;
+    GLuint vertexArray;
+
+    // Active texture unit, offset from GL_TEXTURE0
+    GLuint activeUnit;
+
+    // Texture bound to each unit, one list per target
+    GLuint textures2D[MAX_CACHED_TEXTURE_UNITS];
+    GLuint texturesCube[MAX_CACHED_TEXTURE_UNITS];
+
+    GLenum polygonMode;
+    GLboolean colorMask[4];
+    bool isColorMaskKnown;
+
+    // Stats - Calls sent to GL and calls skipped since the start of the program
+    size_t issuedCalls;
+    size_t elidedCalls;
+
+    // Returns the cached binding of the target on the unit, nullptr for targets and units that aren't cached
+    GLuint* getTextureSlot(GLuint unit, GLenum target);
+
+public:
+    // Constructor
+    GLStateCache();
+
+    // Bind program, vertex array or texture (unit is offset from GL_TEXTURE0)
+    void useProgram(GLuint shaderID);
+    void bindVertexArray(GLuint VAO);
+    void bindTexture(GLuint unit, GLenum target, GLuint textureID);
+
+    // Only GL_FRONT_AND_BACK is supported by the core profile, so only the mode is tracked
+    void setPolygonMode(GLenum mode);
+    void setColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+
+    // Deleted objects, so a new object with the same name isn't skipped
+    void forgetProgram(GLuint shaderID);
+    void forgetVertexArray(GLuint VAO);
+    void forgetTexture(GLuint textureID);
+
+    // Forget all cached state, the next call of every setter goes through
+    void invalidate();
+
+    // Getters=========================================================================================================
+    size_t getIssuedCalls() const { return issuedCalls; }
+    size_t getElidedCalls() const { return elidedCalls; }
+};
+
+// Single GL context, so a single cache for the whole program
+extern GLStateCache glState;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+/*
+Fixed set of worker threads for splitting CPU work of a frame (The light lists of the objects and of the clusters) into partitions.
+run() hands out the partitions to the workers and the calling thread, and only returns once all of them are done.
+Jobs must not make GL calls, there is a single context and it belongs to the main thread.
+The job is called through a function pointer instead of std::function, so running a job never allocates.
+*/
+class JobSystem {
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+
+    // Current job - Incremented generation wakes up the workers
+    void (*invoke)(void* context, size_t partition);
+    void* context;
+    size_t partitionCount;
+    std::atomic<size_t> nextPartition;
+    size_t busyWorkers;
+    uint64_t generation;
+    bool isStopping;
+
+    void workerLoop();
+
+    // Take partitions until there are none left, called by the workers and the calling thread
+    void runPartitions();
+
+    void runJob(size_t count, void (*function)(void*, size_t), void* jobContext);
+
+public:
+    // Constructor
+    JobSystem();
+
+    // Start the workers, 0 starts one less than the number of cores (The thread calling run works as well)
+    void createWorkers(size_t workerCount = 0);
+
+    // Call job(partition) for every partition in [0, count), spread over all the threads
+    template<typename Job>
+    void run(size_t count, Job& job) {
+        runJob(count, [](void* jobContext, size_t partition) { (*static_cast<Job*>(jobContext))(partition); }, &job);
+    }
+
+    // Range of partition when count elements are split into partitionCount contiguous ranges
+    // Every range except the last starts and ends on a multiple of alignment
+    static void getPartitionRange(size_t count, size_t partitionCount, size_t partition, size_t alignment, size_t& begin, size_t& end);
+
+    // Getters=========================================================================================================
+    // Workers and the calling thread
+    size_t getThreadCount() const { return workers.size() + 1; }
+
+    // Not copyable, the workers point to this object
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Wait for the workers to finish and join them
+    void stopWorkers();
+
+    // Destructor
+    ~JobSystem();
+};
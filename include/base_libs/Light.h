@@ -31,6 +31,10 @@ public:
             GLfloat red, GLfloat green, GLfloat blue,
             GLfloat ambIntensity, GLfloat diffIntensity );
 
+    // Without a shadow map, for lights that create their own kind
+    Light(  GLfloat red, GLfloat green, GLfloat blue,
+            GLfloat ambIntensity, GLfloat diffIntensity );
+
     ShadowMap* getShadowMap() { return shadowMap; }
 
     // Destructor
@@ -3,6 +3,12 @@
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
 class Mesh {
 private:
     // IBO is optional but causes issues in some graphics cards
@@ -11,6 +17,9 @@ private:
     // Indexcount, since we will be passing unkown number of indices
     GLsizei indexCount;
 
+    // Local space bounds of the vertices, for culling
+    glm::vec3 boundsMin, boundsMax;
+
 public:
     // Constructor
     Mesh();
@@ -24,6 +33,10 @@ public:
     // Clear Mesh from the Graphics Card
     void cleanMesh();
 
+    const glm::vec3& getBoundsMin() const { return boundsMin; }
+    const glm::vec3& getBoundsMax() const { return boundsMax; }
+    GLsizei getTriangleCount() const { return indexCount / 3; }
+
     // Destructor
     ~Mesh();
 };
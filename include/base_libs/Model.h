@@ -19,6 +19,9 @@ private:
     std::vector<Texture*> textureList;
     std::vector<unsigned int> meshToTex;
 
+    // Local space bounds of all the meshes
+    glm::vec3 boundsMin, boundsMax;
+
     // To load children data
     void loadNode(aiNode *node, const aiScene *scene);
     void loadMesh(aiMesh *mesh, const aiScene *scene);
@@ -32,6 +35,10 @@ public:
     void renderModel();
     void clearModel();
 
+    const glm::vec3& getBoundsMin() const { return boundsMin; }
+    const glm::vec3& getBoundsMax() const { return boundsMax; }
+    GLsizei getTriangleCount() const;
+
     // Destructor
     ~Model();
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdio.h>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
+#include "Shader.h"
+#include "ShadowMap.h"
+
+/*
+Turns the depth of a shadow map layer into blurred moments, so the main shader can replace its PCF loops by a single
+filtered fetch (Variance shadow maps). The horizontal pass reads the depth, scales it to world units and blurs depth and
+depth squared into a temporary map, the vertical pass blurs them into the moments of the shadow map. Both passes stay
+inside the tile of the layer. The shadow passes and their caches don't change, only the layers drawn again are filtered.
+*/
+class MomentShadowFilter {
+private:
+    Shader* blurShader;
+    GLint uniformSource, uniformIsDepthSource, uniformTile, uniformDirection, uniformDepthScale;
+
+    // Horizontal pass result, as big as the biggest shadow map
+    GLuint tempFBO, tempMap;
+    GLuint tempWidth, tempHeight;
+
+    // Empty, the triangle is made in the vertex shader
+    GLuint VAO;
+
+public:
+    // Constructor
+    MomentShadowFilter();
+
+    // Blur shader built from momentBlur.vert and momentBlur.frag, maps up to width x height
+    bool init(Shader* shader, GLuint width, GLuint height);
+
+    // Moments of a single layer, depthScale is the world distance of a depth of 1
+    void filterLayer(ShadowMap* shadowMap, GLuint layer, GLfloat depthScale);
+
+    // Not copyable, the textures are owned by a single object
+    MomentShadowFilter(const MomentShadowFilter&) = delete;
+    MomentShadowFilter& operator=(const MomentShadowFilter&) = delete;
+
+    // Destructor
+    ~MomentShadowFilter();
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// OBJECT_LIGHTS_PARTITION_MIN
+#include "Utilities.h"
+
+// Splitting the objects over the worker threads
+#include "JobSystem.h"
+
+// Binding point of the ObjectLightLists buffer in shader.frag
+const GLuint OBJECT_LIGHTS_BINDING = 0;
+
+/*
+Lights reaching every object - Each object gets the list of the point and spot lights whose sphere (Up to the range of the
+light) touches its bounds, spot lights also have to reach them with their cone. The main shader loops over the list of the
+object instead of the list of the cluster of the fragment. Lights are indexed in the order they are added, which is the
+index of their shadow and their index in the ClusterLights buffer.
+Big scenes are split into contiguous ranges of objects over the job system, and the lists of the ranges are merged in order.
+Everything goes into a single buffer - The offset and count of every object, then the lists. Offsets are from the start
+of the buffer.
+*/
+class ObjectLights {
+private:
+    // Sphere of a light, the cone is only tested for spot lights narrower than 90 degrees (Cosine of the edge above 0)
+    struct LightVolume {
+        glm::vec3 position;
+        GLfloat range;
+        glm::vec3 direction;
+        GLfloat edge;
+    };
+
+    // Lists of a contiguous range of objects, filled by one job
+    struct PartitionWork {
+        std::vector<GLuint> indices;
+        std::vector<GLuint> counts;
+    };
+
+    std::vector<LightVolume> lights;
+
+    // World space bounds, in the order the lists are indexed
+    std::vector<glm::vec3> boundsMin, boundsMax;
+
+    std::vector<PartitionWork> partitions;
+
+    // Offset and count of every object, then the lists - Uploaded as is
+    std::vector<GLuint> lists;
+
+    // Shader storage buffer, grown when the lists don't fit anymore
+    GLuint listsBuffer;
+    GLsizeiptr listsCapacity;
+
+    // Stats of the last assignment
+    size_t totalObjectLights;
+
+    // Lists of the objects [begin, end)
+    void assignRange(PartitionWork& work, size_t begin, size_t end) const;
+
+public:
+    // Constructor
+    ObjectLights();
+
+    // Allocate the buffer and bind it to its binding point
+    void createBuffer();
+
+    // Forget the lights and objects of the previous frame
+    void clear();
+
+    // Lights that are off get a range of 0 and never reach anything, so the following lights keep their index
+    void addPointLight(const glm::vec3& position, GLfloat range);
+    void addSpotLight(const glm::vec3& position, GLfloat range, const glm::vec3& direction, GLfloat edge);
+
+    // Returns the index of the list of the object
+    GLint addObject(const glm::vec3& objectMin, const glm::vec3& objectMax);
+
+    // Build the list of every object, then upload all of them - On the job system if one is given
+    void assignLights(JobSystem* jobSystem = nullptr);
+
+    // Getters=========================================================================================================
+    size_t getObjectCount() const { return boundsMin.size(); }
+    size_t getLightCount() const { return lights.size(); }
+
+    // Average length of the lists of the last assignment
+    GLfloat getAverageObjectLights() const;
+
+    // Not copyable, the buffer is owned by a single object
+    ObjectLights(const ObjectLights&) = delete;
+    ObjectLights& operator=(const ObjectLights&) = delete;
+
+    // Destructor
+    ~ObjectLights();
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include "Light.h"
-#include "OmniShadowMap.h"
+#include "Utilities.h"
+
+// ClusterLightBlock
+#include "ClusteredLights.h"
 
 class PointLight : public Light {
 protected:
@@ -13,7 +16,10 @@ protected:
     // Attenuation Control
     GLfloat constant, linear, exponent;
 
-    GLfloat farPlane;
+    GLfloat nearPlane, farPlane;
+
+    // Biggest tile the light asks the shadow atlas for
+    GLuint shadowResolution;
 
 public:
     // Constructor
@@ -31,10 +37,18 @@ public:
                     GLuint diffuseIntensityLocation, GLuint positionLocation,
                     GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation  );
 
+    // Light and far plane for the ClusterLights buffer, the shadow tiles are left empty
+    void fillBlock(ClusterLightBlock& block);
+
     std::vector<glm::mat4> calculateLightTransform();
 
     GLfloat getFarPlane();
 
+    // Distance where the light falls below LIGHT_ATTENUATION_CUTOFF, never past the far plane
+    GLfloat calculateRange();
+
+    GLuint getShadowResolution() { return shadowResolution; }
+
     glm::vec3 getPosition();
 
     // Destructor
@@ -8,6 +8,9 @@
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
 // GLM Files - Math Library
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -19,11 +22,14 @@
 #include "PointLight.h"
 #include "SpotLight.h"
 
+// Tiles of the point and spot light shadows
+#include "ShadowAtlas.h"
+
+// Point and spot lights of the clusters
+#include "ClusteredLights.h"
+
 class Shader {
 private:
-    int pointLightCount;
-    int spotLightCount;
-
     GLuint  shaderID, uniformProjection, uniformModel, uniformView, uniformEyePosition,
             uniformSpecularIntensity, uniformShininess,
             uniformTexture, uniformDirectionalShadowMap,
@@ -32,6 +38,9 @@ private:
 
     GLuint uniformLightMatrices[6];
 
+    // Single face of the omni shadow map
+    GLuint uniformLightMatrix;
+
     // Creating instance of struct - uniformDirectionalLight
     struct {
         GLuint uniformColour;
@@ -41,40 +50,25 @@ private:
         GLuint uniformDirection;
     } uniformDirectionalLight;
 
-    GLuint uniformPointLightCount;
+    // Directional shadow cascades
+    GLuint uniformCascadeCount;
 
     struct {
-        GLuint uniformColour;
-        GLuint uniformAmbientIntensity;
-        GLuint uniformDiffuseIntensity;
+        GLuint uniformTransform;
+        GLuint uniformSplit;
+        GLuint uniformRect;
+        GLuint uniformDepthRange;
+    } uniformCascades[MAX_CASCADES];
 
-        GLuint uniformPosition;
-        GLuint uniformConstant;
-        GLuint uniformLinear;
-        GLuint uniformExponent;
-    } uniformPointLight[MAX_POINT_LIGHTS];
+    // Single filtered fetch of the prefiltered moments instead of the PCF loops
+    GLuint uniformIsMomentShadows, uniformDirectionalMoments, uniformShadowAtlasMoments;
 
-    GLuint uniformSpotLightCount;
+    // Lights of the object from its list instead of the list of its cluster - See ObjectLights.h
+    GLuint uniformIsObjectLights, uniformObjectLights;
 
-    struct {
-        GLuint uniformColour;
-        GLuint uniformAmbientIntensity;
-        GLuint uniformDiffuseIntensity;
-
-        GLuint uniformPosition;
-        GLuint uniformConstant;
-        GLuint uniformLinear;
-        GLuint uniformExponent;
-
-        GLuint uniformDirection;
-        GLuint uniformEdge;
-    } uniformSpotLight[MAX_SPOT_LIGHTS];
-
-    struct {
-        GLuint shadowMap;
-        GLuint farPlane;
-    }
-    uniformOmniShadowMap[MAX_SPOT_LIGHTS + MAX_POINT_LIGHTS];
+    // Point and spot lights and their tiles live in the ClusterLights buffer - See ClusteredLights.h
+    GLuint uniformShadowAtlas;
+    GLuint uniformClusterCount, uniformClusterDepth;
 
     void compileShader(const char* vertexCode, const char* fragmentCode);
     void compileShader(const char* vertexCode, const char* fragmentCode, const char* geometryCode);
@@ -108,13 +102,27 @@ public:
     GLuint getOmniLightPosLocation();
     GLuint getFarPlaneLocation();
 
+    // Index of the light list of the object being drawn
+    GLuint getObjectLightsLocation();
+
+    // For shaders without their own getters
+    GLint getUniformLocation(const char* name) { return glGetUniformLocation(shaderID, name); }
+
     void setDirectionalLight(DirectionalLight* dLight);
-    void setPointLight(PointLight* pLight, unsigned int lightCount, unsigned int textureUnit, unsigned int offset);
-    void setSpotLight(SpotLight* sLight, unsigned int lightCount, unsigned int textureUnit, unsigned int offset);
+    // Slot i of the atlas is the shadow of light i, the tiles themselves are in the ClusterLights buffer
+    void setShadowAtlas(ShadowAtlas* atlas, GLuint textureUnit);
+    // Grid and depth slices of the last assignment of the clusters
+    void setClusteredLights(ClusteredLights* clusteredLights);
+    // Moments of the cascades and of the atlas, only bound when moment shadows are on
+    void setMomentShadows(bool isEnabled, DirectionalLight* dLight, GLuint directionalUnit, ShadowAtlas* atlas, GLuint atlasUnit);
+    // Light lists of the objects, the list of the cluster of the fragment is used when they are off
+    void setObjectLights(bool isEnabled);
     void setTexture(GLuint textureUnit);
     void setDirectionalShadowMap(GLuint textureUnit);
     void setDirectionalLightTransform(glm::mat4* lTransform);
+    void setDirectionalCascades(DirectionalLight* dLight);
     void setLightMatrices(std::vector<glm::mat4> lightMatrices);
+    void setLightMatrix(const glm::mat4& lightMatrix);
 
     void useShader();
     void cleanShader();
@@ -0,0 +1,111 @@
+#pragma once
+#include "ShadowMap.h"
+
+// Atlas and tile sizes - SHADOW_ATLAS_SIZE, SHADOW_ATLAS_MIN_TILE
+#include "Utilities.h"
+
+// Layers of a light in the atlas, point lights use all the faces of their cube and spot lights only the first one
+const GLuint SHADOW_ATLAS_FACES = 6;
+
+/*
+Shadow maps of every point and spot light in a single depth atlas, so they share one memory budget and the main shader
+samples all of them through one sampler. Tiles are square and power of two sized, handed out by a quadtree - A node is
+either free, used by a tile, or split into 4 children of half its size. Freeing the last used child merges them back.
+Every frame the lights request a size (From their coverage of the screen), the sizes shrink from the least important
+lights until they fit, and lights that ask for the size they already have keep their tiles and their cached depth.
+Lights that don't ask for anything keep their tiles too, until the space is needed - The least recently used go first.
+Every light is a slot with SHADOW_ATLAS_FACES layers, layer = slot * SHADOW_ATLAS_FACES + face.
+*/
+class ShadowAtlas : public ShadowMap {
+private:
+    enum NodeState {
+        NODE_FREE,
+        NODE_SPLIT,
+        NODE_USED
+    };
+
+    // Complete quadtree stored by levels, the children of node i are 4i + 1 to 4i + 4
+    struct Node {
+        GLuint x, y, size;
+        NodeState state;
+    };
+
+    // What a light asked for this frame and the tiles it has
+    struct Slot {
+        GLuint faceCount;
+        GLuint requestedSize;
+        GLfloat importance;
+
+        // Size of the tiles it has, 0 without tiles
+        GLuint size;
+        GLint nodes[SHADOW_ATLAS_FACES];
+
+        GLuint64 lastUsedFrame;
+
+        // Kept its tiles while it wasn't drawn, the dynamic casters in them are out of date
+        bool isResumed;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Slot> slots;
+
+    GLuint64 frame;
+
+    // Smallest free node of exactly size under node, splitting free nodes on the way - -1 if there is none
+    GLint allocateNode(GLint node, GLuint size);
+
+    // Free a node and merge its parents while all their children are free
+    void releaseNode(GLint node);
+
+    // Tiles for every face of the slot, nothing is kept if any of them doesn't fit
+    bool allocateSlot(GLuint slot, GLuint size);
+    void releaseSlot(GLuint slot);
+
+    // Least recently used slot that has tiles but didn't ask for any this frame, -1 if there is none
+    GLint findEvictableSlot() const;
+
+public:
+    // Constructor
+    ShadowAtlas();
+
+    // Square atlas of size texels, for slotCount lights
+    bool initAtlas(GLuint size, GLuint slotCount);
+
+    // Forget the requests of the previous frame
+    void beginFrame();
+
+    // Ask for faceCount tiles of up to size texels, importance decides which lights shrink first when they don't fit
+    void request(GLuint slot, GLuint faceCount, GLuint size, GLfloat importance);
+
+    // Hand out the tiles of every request of the frame
+    void allocateRequests();
+
+    // Bind the atlas for drawing, limited to the tile of the layer (Viewport and scissor)
+    void writeLayer(GLuint layer);
+
+    // Viewport and scissor of every face of the slot in the indices 0 to 5, for the geometry shader pass
+    void writeSlotFaces(GLuint slot);
+
+    // Tiles are copied to and from the static cache, not the whole atlas
+    void storeStatic(GLuint layer) override;
+    void restoreStatic(GLuint layer) override;
+
+    // Empty for layers without a tile
+    glm::uvec3 getLayerTile(GLuint layer) const override;
+
+    // Getters=========================================================================================================
+    // Asked for tiles this frame and got them - Idle lights can still hold tiles, but aren't drawn or sampled
+    bool getIsActive(GLuint slot) const { return slots[slot].requestedSize != 0 && slots[slot].size != 0; }
+    bool getIsResumed(GLuint slot) const { return slots[slot].isResumed; }
+    GLuint getSlotSize(GLuint slot) const { return slots[slot].size; }
+    GLuint getSlotCount() const { return static_cast<GLuint>(slots.size()); }
+
+    // Offset and scale of the tile in texture coordinates, all 0 for layers of lights that aren't active
+    glm::vec4 getLayerRect(GLuint layer) const;
+
+    // Share of the atlas used by tiles, including the ones kept for lights that aren't drawn
+    GLfloat getUsage() const;
+
+    // Destructor
+    ~ShadowAtlas();
+};
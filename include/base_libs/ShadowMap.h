@@ -1,16 +1,42 @@
 #pragma once
 
 #include <stdio.h>
+#include <vector>
 
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
+// Mips of the moments - SHADOW_MOMENT_LEVELS
+#include "Utilities.h"
+
 class ShadowMap
 {
 protected:
     GLuint FBO, shadowMap;
     GLuint shadowWidth, shadowHeight;
 
+    // Depth of the static casters only, copied back over the map before the dynamic casters are drawn again
+    GLuint staticMap;
+    GLenum textureTarget;
+
+    // Light transform every layer was last drawn with, and the layers whose static depth is out of date
+    std::vector<glm::mat4> layerTransforms;
+    std::vector<bool> isStaticDirty;
+
+    // Create the static copy of the map, with the same size and format
+    void initCache(GLenum target, GLuint layerCount);
+
+    // Moments (Depth, depth squared) of every texel, blurred and mipmapped so the shader needs a single filtered fetch
+    // Only created once moment shadows are turned on, layers are filtered again after they are drawn
+    GLuint momentsFBO, momentsMap;
+    std::vector<bool> isMomentsDirty;
+
 public:
     // Constructor
     ShadowMap();
@@ -24,6 +50,41 @@ public:
     GLuint getShadowWidth() { return shadowWidth; }
     GLuint getShadowHeight() { return shadowHeight; }
 
+    // Cache===========================================================================================================
+    // Draw the static casters of every layer again, when a static caster moved
+    void invalidate();
+
+    // Marks the static depth of the layer out of date if the light moved since it was drawn
+    void updateLayerTransform(GLuint layer, const glm::mat4& lightTransform);
+
+    bool getIsStaticDirty(GLuint layer) const { return isStaticDirty[layer]; }
+
+    // Copy the static casters drawn in a layer into the cache, or the cache back into the layer
+    virtual void storeStatic(GLuint layer);
+    virtual void restoreStatic(GLuint layer);
+
+    // Moments=========================================================================================================
+    // Tile of the layer in the map - x, y, size in texels
+    virtual glm::uvec3 getLayerTile(GLuint layer) const;
+
+    // Create the moments texture with SHADOW_MOMENT_LEVELS mips, nothing if it exists already
+    bool initMoments();
+
+    // Bind the moments for drawing, the caller sets the viewport
+    void writeMoments();
+
+    // Mips of the whole map, once the dirty layers are filtered - Power of two tiles aligned to their size never share
+    // a mip texel
+    void generateMomentMips();
+
+    void readMoments(GLenum textureUnit);
+
+    void markMomentsDirty(GLuint layer) { isMomentsDirty[layer] = true; }
+    void clearMomentsDirty(GLuint layer) { isMomentsDirty[layer] = false; }
+    bool getIsMomentsDirty(GLuint layer) const { return isMomentsDirty[layer]; }
+    GLuint getLayerCount() const { return static_cast<GLuint>(isStaticDirty.size()); }
+    GLuint getShadowMapID() const { return shadowMap; }
+
     // Destructor
     ~ShadowMap();
 };
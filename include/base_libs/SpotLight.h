@@ -10,6 +10,9 @@ private:
 
     bool isOn;
 
+    // Perspective covering the cone, for the single tile of the light in the shadow atlas
+    glm::mat4 spotProj;
+
 public:
     // Constructor
     SpotLight();
@@ -29,10 +32,23 @@ public:
                     GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation,
                     GLuint edgeLocation  );
 
+    // Cone and its shadow transform on top of the point light, switched off lights get a range of 0
+    void fillBlock(ClusterLightBlock& block);
+
     void setFlash(glm::vec3 pos, glm::vec3 dir);
 
     void toggle() { isOn = !isOn; }
 
+    bool getIsOn() { return isOn; }
+
+    glm::vec3 getDirection() { return direction; }
+
+    // Cosine of the edge, like the shader gets it
+    GLfloat getProcessedEdge() { return processedEdge; }
+
+    // Projection * View of the cone
+    glm::mat4 calculateSpotTransform();
+
     // Destructor
     ~SpotLight();
 };
@@ -3,6 +3,9 @@
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
 #include "Utilities.h"
 
 class Texture {
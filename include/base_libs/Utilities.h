@@ -11,10 +11,45 @@
 #include <stb_image.h>
 
 // Common Values
-const int MAX_POINT_LIGHTS = 3;
-const int MAX_SPOT_LIGHTS = 3;
+// Directional shadow cascades - Blend between logarithmic (1) and uniform (0) splits of the view distance
+const int MAX_CASCADES = 4;
+const float CASCADE_SPLIT_LAMBDA = 0.75f;
+
+// How far towards the light a cascade still draws casters outside the view
+const float SHADOW_CASTER_DISTANCE = 100.0f;
+
+// Shadow atlas of the point and spot lights - Tiles are powers of two between the minimum and the size a light asks for
+const unsigned int SHADOW_ATLAS_SIZE = 4096;
+const unsigned int SHADOW_ATLAS_MIN_TILE = 64;
+
+// Moment shadows - Mips of the moments, the smallest atlas tile still has a texel of its own at the last one
+const int SHADOW_MOMENT_LEVELS = 7;
+
+// Lights stop reaching anything below this brightness, their shadows are only needed inside that range
+const float LIGHT_ATTENUATION_CUTOFF = 1.0f / 256.0f;
+
+// Objects whose light lists are built by one thread at least, smaller scenes stay on the main thread
+const size_t OBJECT_LIGHTS_PARTITION_MIN = 256;
+
+// Clustered lights - Screen tiles along x and y, exponential depth slices along z
+const int LIGHT_CLUSTERS_X = 16;
+const int LIGHT_CLUSTERS_Y = 9;
+const int LIGHT_CLUSTERS_Z = 24;
+
+// Lights from which the slices of the clusters are split over the job system, fewer stay on the main thread
+const size_t CLUSTERED_LIGHTS_THREAD_MIN = 64;
 
 // Averaging Normals for Phong Shading
 void calcAverageNormals(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount, unsigned int vLength, unsigned int normalOffset);
 
+// Culling=============================================================================================================
+// Planes of the frustum of a projection * view matrix (Normal in xyz, distance in w), pointing inside
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+// False only if the box is completely outside one of the planes
+bool isBoxInFrustum(const glm::vec4 planes[6], const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+// Bounds of a local space box after transforming it
+void transformBounds(const glm::mat4& transform, const glm::vec3& localMin, const glm::vec3& localMax, glm::vec3& worldMin, glm::vec3& worldMax);
+
 #endif
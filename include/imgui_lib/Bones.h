@@ -6,6 +6,9 @@
 #include <glad.h>
 #include <GLFW/glfw3.h>
 
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
 #include <glm/glm.hpp>
 
 class Bones {
@@ -68,6 +68,9 @@ public:
     glm::mat4 calculatePerspectiveProjectionMatrix(const GLint& width, const GLint& height);
     glm::mat4 calculateOrthographicProjectionMatrix();
 
+    // Pixels covered by 1 unit at a distance of 1 unit, for projecting object space errors onto the screen
+    GLfloat calculateProjectionScale(const GLint& height);
+
     // Ray Casting
     // This will be used for object selection and other functionalities
     glm::vec3 getRayDirection(GLfloat mouseX, GLfloat mouseY, int screenWidth, int screenHeight);
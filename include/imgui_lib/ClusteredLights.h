@@ -0,0 +1,155 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Custom Libraries
+#include "Utilities.h"
+#include "JobSystem.h"
+#include "UniformBuffer.h"
+
+// Binding points of the ClusterLights, ClusterGrid and ClusterIndices buffers in BRDF_Normals.frag
+const GLuint CLUSTER_LIGHTS_BINDING = 2;
+const GLuint CLUSTER_GRID_BINDING = 3;
+const GLuint CLUSTER_INDICES_BINDING = 4;
+
+// Light tests shared with the per instance lists - See InstanceLights.h
+// 4 spheres (Structure of arrays) against a box, bit i of the result is set if sphere i touches it
+int sphereBoxMask(const float* x, const float* y, const float* z, const float* radius,
+                  const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+// Cone of a spot light against a sphere, only for cones narrower than 90 degrees (cosine is the edge of the light)
+// Conservative - A few spheres just outside the cone are kept
+bool isConeInSphere(const glm::vec3& apex, const glm::vec3& direction, float cosine, float range,
+                    const glm::vec3& center, float radius);
+
+/*
+Clustered forward lighting - The view frustum is split into LIGHT_CLUSTERS_X * Y * Z clusters (Screen tiles, exponential
+depth slices) and every cluster gets the list of the point and spot lights reaching it. The fragment shader only loops over
+the list of its own cluster, so the number of lights in the scene isn't limited by the uniform block anymore.
+Lights are assigned on the CPU, one job per depth slice - The lights touching the slice are picked first, then tested
+4 at a time against the bounds of every cluster of the slice (Sphere against box, plus a cone test for spot lights).
+Passes with several views (Single pass stereo) get a grid per view.
+*/
+class ClusteredLights {
+private:
+    // View space bounds of the clusters of a view, rebuilt only when the projection changes
+    struct ViewClusters {
+        glm::mat4 projection;
+        float nearPlane, farPlane;
+
+        std::vector<glm::vec3> boundsMin;
+        std::vector<glm::vec3> boundsMax;
+
+        // Bounds of all the clusters of a slice
+        glm::vec3 sliceMin[LIGHT_CLUSTERS_Z];
+        glm::vec3 sliceMax[LIGHT_CLUSTERS_Z];
+    };
+
+    // Lights of a single slice of a view, filled by its job
+    struct SliceWork {
+        // Lights overlapping the bounds of the slice, and their view space spheres for the SIMD tests
+        std::vector<GLuint> candidates;
+        std::vector<float> candidateX, candidateY, candidateZ, candidateRadius;
+
+        // Lists of the clusters of the slice, one after another
+        std::vector<GLuint> indices;
+        std::vector<GLuint> counts;
+    };
+
+    // Lights of the current pass, in the layout of the ClusterLights buffer
+    std::vector<ClusterLightBlock> lights;
+
+    // View space spheres of the lights, per view - Structure of arrays for the SIMD tests
+    std::vector<float> lightX[MAX_VIEWS], lightY[MAX_VIEWS], lightZ[MAX_VIEWS];
+    std::vector<float> lightRadius;
+
+    // View space directions, only used by the cone test of the spot lights
+    std::vector<glm::vec3> lightDirections[MAX_VIEWS];
+
+    ViewClusters views[MAX_VIEWS];
+    std::vector<SliceWork> slices;
+    int viewCount;
+
+    // Offset and count of the light list of every cluster, then the lists themselves
+    std::vector<glm::uvec2> grid;
+    std::vector<GLuint> indices;
+
+    // Slice of a view depth - log(depth) * depthScale + depthBias
+    float depthScale, depthBias;
+
+    // Shader storage buffers, grown when the lights or lists don't fit anymore
+    GLuint lightsBuffer, gridBuffer, indicesBuffer;
+    GLsizeiptr lightsCapacity, gridCapacity, indicesCapacity;
+
+    // Stats of the last assignment
+    GLuint maxClusterLights;
+    double assignTime;
+
+    // View space bounds of every cluster seen through projection
+    void buildClusterBounds(ViewClusters& clusters, const glm::mat4& projection, float nearPlane, float farPlane);
+
+    // Depth range of a slice
+    float getSliceDepth(int slice, float nearPlane, float farPlane) const;
+
+    // Lists of every cluster of a slice of a view, called by the jobs
+    void assignSlice(int view, int slice);
+
+    // Upload data to buffer, growing it if it doesn't fit
+    static void updateBuffer(GLuint buffer, GLsizeiptr& capacity, const void* data, GLsizeiptr size);
+
+public:
+    // Constructor
+    ClusteredLights();
+
+    // Allocate the buffers and bind them to their binding points
+    void createBuffers();
+
+    // Forget the lights of the previous pass
+    void clearLights();
+
+    // Add a light to the current pass, lights with a range of 0 don't light anything and are skipped
+    void addLight(const ClusterLightBlock& light);
+
+    // Build the lists of every cluster of the views, on the job system if one is given - No GL calls
+    // Slices go from the near to the far plane of the first projection, which has to be a perspective one
+    void assignLights(const glm::mat4* projectionMatrices, const glm::mat4* viewMatrices, int passViewCount,
+                      JobSystem* jobSystem = nullptr);
+
+    // Upload the lights and the lists of the last assignment
+    void uploadBuffers();
+
+    // Grid parameters of the last assignment, written into the lights uniform block
+    void fillBlock(LightsBlock& block) const;
+
+    // Getters=========================================================================================================
+    size_t getLightCount() const { return lights.size(); }
+
+    // Lights of the current pass, in the order of the ClusterLights buffer
+    const std::vector<ClusterLightBlock>& getLights() const { return lights; }
+    GLuint getMaxClusterLights() const { return maxClusterLights; }
+    float getAverageClusterLights() const;
+    double getAssignTime() const { return assignTime; }
+
+    // Headless benchmark - lightCount random lights over a city sized area, assigned on one and on every thread
+    static void benchmarkAssign(size_t lightCount, int iterations = 20);
+
+    // Not copyable, the buffers are owned by a single object
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    // Clear the buffers from the Graphics Card
+    void cleanBuffers();
+
+    // Destructor
+    ~ClusteredLights();
+};
@@ -20,6 +20,9 @@ public:
     void useLight(  GLuint ambientIntensityLocation, GLuint ambientColourLocation,
                     GLuint diffuseIntensityLocation, GLuint directionLocation  );
 
+    // Same values as useLight, written into the lights uniform block
+    void fillBlock(DirectionalLightBlock& block) const;
+
     void setDirLight( GLfloat red, GLfloat green, GLfloat blue,
                       GLfloat amb, GLfloat diff,
                       GLfloat x, GLfloat y, GLfloat z );
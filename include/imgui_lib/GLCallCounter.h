@@ -0,0 +1,17 @@
+#pragma once
+
+#include <iostream>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+/*
+Counts the GL calls made by the renderer. GLAD stores every GL function as a function pointer, installGLCallCounters swaps the
+pointers of the functions used while rendering a frame (State, buffers, uniforms, textures and draws) for wrappers that
+increment a counter and forward the call. Has to be called after GLAD is loaded.
+ImGui's OpenGL backend has its own loader, so the UI is not counted.
+*/
+void installGLCallCounters();
+
+// Number of counted GL calls since the start of the program
+size_t getGLCallCount();
@@ -0,0 +1,143 @@
+#pragma once
+
+// General libraries
+#include <iostream>
+#include <vector>
+#include <string>
+
+// Filesystem library for paths
+#include <filesystem>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// Custom libraries
+#include "GeometryArena.h"
+
+// Read-only memory mapping of a whole file, POSIX mmap or Win32 file mapping
+class MappedFile {
+private:
+    const unsigned char* data;
+    size_t size;
+
+    // Platform handles - HANDLEs on Windows, the file descriptor elsewhere
+    void* fileHandle;
+    void* mappingHandle;
+    int fileDescriptor;
+
+public:
+    // Constructor
+    MappedFile();
+
+    bool openFile(const std::string& filePath);
+
+    // Getters=========================================================================================================
+    const unsigned char* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+    // Unmap and close the file
+    void closeFile();
+
+    // Not copyable, the mapping is owned by a single object
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Destructor
+    ~MappedFile();
+};
+
+// A single glTF primitive converted to the layout used by Mesh (x, y, z, u, v, Nx, Ny, Nz, Tx, Ty, Tz)
+struct GLTFPrimitive {
+    // Interleaved vertices
+    std::vector<GLfloat> vertices;
+    unsigned int vertexCount = 0;
+
+    // Points straight into the mapped .bin when the indices are already 32 bit, otherwise convertedIndices is used
+    const unsigned int* mappedIndices = nullptr;
+    std::vector<unsigned int> convertedIndices;
+    unsigned int indexCount = 0;
+
+    int material = -1;
+
+    const unsigned int* getIndices() const { return mappedIndices ? mappedIndices : convertedIndices.data(); }
+};
+
+// Texture paths of a glTF material, empty if the material has no such map
+struct GLTFMaterial {
+    std::string diffusePath;
+    std::string normalPath;
+};
+
+/*
+Loader for glTF 2.0 files (.gltf with external .bin buffers) that bypasses Assimp. The buffers are memory mapped and stay
+mapped until cleanLoader is called, so 32 bit index buffers are handed to the GPU straight from the mapping. Vertex
+attributes are converted to the interleaved Mesh layout with SSE.
+Like the Assimp path in Model, node transforms are ignored and the normals are flipped for the shaders.
+*/
+class GLTFLoader {
+private:
+    struct BufferView {
+        int buffer;
+        size_t byteOffset;
+        size_t byteLength;
+        size_t byteStride;
+    };
+
+    struct Accessor {
+        int bufferView;
+        size_t byteOffset;
+        size_t count;
+        int componentType;
+        int components;
+        bool normalized;
+    };
+
+    // Resolved accessor, pointing into the mapped memory
+    struct AccessorData {
+        const unsigned char* data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        int componentType = 0;
+        int components = 0;
+        bool normalized = false;
+    };
+
+    std::vector<MappedFile*> buffers;
+    std::vector<BufferView> bufferViews;
+    std::vector<Accessor> accessors;
+
+    std::vector<GLTFPrimitive> primitives;
+    std::vector<GLTFMaterial> materials;
+
+    // Bytes handed over without conversion and bytes that had to be converted
+    size_t mappedBytes, convertedBytes;
+
+    bool getAccessorData(int index, AccessorData& result);
+
+    bool loadPrimitive(int position, int texCoord, int normal, int tangent, int indices, int material);
+
+    // Vertex conversion - SSE path for float attributes, scalar path for everything else
+    void convertVertices(const AccessorData& position, const AccessorData& texCoord, const AccessorData& normal,
+                         const AccessorData& tangent, GLTFPrimitive& primitive);
+
+    bool convertIndices(const AccessorData& indices, GLTFPrimitive& primitive);
+
+public:
+    // Constructor
+    GLTFLoader();
+
+    // Parse the .gltf, map the buffers and convert every primitive of every mesh
+    bool loadFile(const std::string& filePath);
+
+    // Getters=========================================================================================================
+    const std::vector<GLTFPrimitive>& getPrimitives() const { return primitives; }
+    const std::vector<GLTFMaterial>& getMaterials() const { return materials; }
+    size_t getMappedBytes() const { return mappedBytes; }
+    size_t getConvertedBytes() const { return convertedBytes; }
+
+    // Unmap the buffers and clear the primitives
+    void cleanLoader();
+
+    // Destructor
+    ~GLTFLoader();
+};
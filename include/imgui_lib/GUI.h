@@ -10,6 +10,9 @@
 
 #include <string>
 
+// Residency of the streamed textures, read by the Stats tab
+class TextureStreamer;
+
 class GUI {
 private:
     ImGuiIO io;
@@ -61,6 +64,7 @@ private:
     bool isFlipAnaglyphChannelsToed = true;
     bool isFlipAnaglyphChannelsFrustum = false;
     bool isAsymmetricFrustum = false;
+    bool isSinglePassStereo = true;
     float interOcularDistance = 0.065f;
     float convergeDistance = 2.0f;
 
@@ -70,6 +74,12 @@ private:
     // Spot Lights
     bool isSpotLights = false;
 
+    // Street Lights of the city, every light is drawn through the clusters
+    bool isStreetLights = false;
+
+    // Objects loop over the lights touching their bounds instead of the lights of their cluster
+    bool isInstanceLights = false;
+
     // Skybox
     bool isSkyBox = false;
 
@@ -112,6 +122,57 @@ private:
     GLuint pointSize = 2;
     GLuint numPoints = 20;
     bool update = false;
+    bool isLOD = true;
+    float lodPixelError = 1.0f;
+
+    // One instanced draw per building type, or one draw per building floor
+    bool isInstancing = true;
+
+    // Culling, LOD selection and recording of the city split over the worker threads
+    bool isMultithreaded = true;
+    bool isCityBenchmark = false;
+
+    // Stats
+    // Cluster culling - Back face culling is off by default since the renderer doesn't use GL_CULL_FACE
+    bool isClusterCulling = true;
+    bool isFrustumCulling = true;
+    unsigned int cullingTested = 0, cullingCulled = 0;
+    bool isOcclusionCulling = true;
+    unsigned int occlusionCulled = 0, occluderCount = 0;
+
+    // Clustered lighting - Lights of the last pass, longest and average list of a cluster, time taken by the assignment
+    unsigned int clusteredLightCount = 0, maxClusterLights = 0;
+    float averageClusterLights = 0.0f;
+    double lightAssignTime = 0.0;
+
+    // Per instance lights - Instances of the last pass, longest and average list, time taken by the assignment
+    unsigned int lightInstanceCount = 0, maxInstanceLights = 0;
+    float averageInstanceLights = 0.0f;
+    double instanceLightTime = 0.0;
+    bool isClusterConeCulling = false;
+    unsigned int clusterCount = 0, clustersCulled = 0, clusterTriangles = 0, clusterTrianglesCulled = 0;
+
+    // Draw calls and CPU time of the last frame
+    unsigned int drawCalls = 0;
+    double frameTime = 0.0;
+
+    // GL calls made by the renderer and uniform blocks uploaded during the last frame
+    size_t glCalls = 0, uniformUploads = 0;
+
+    // Binds and state changes sent to GL or skipped by the state cache during the last frame
+    size_t stateChangesIssued = 0, stateChangesElided = 0;
+
+    // Draws submitted through the render queue in the last pass, the state changes between them and the time spent sorting
+    size_t queuedDraws = 0;
+    unsigned int queueStateChanges = 0;
+    double queueSortTime = 0.0;
+
+    // Heap allocations made during the last frame and the memory used from the frame arena
+    size_t frameAllocations = 0, frameAllocationBytes = 0, frameArenaUsed = 0, frameArenaCapacity = 0;
+
+    // Texture streaming - Bytes uploaded per frame at most in KB (TEXTURE_STREAM_BUDGET), and the streamer shown
+    int textureUploadBudget = 4096;
+    const TextureStreamer* textureStreamer = nullptr;
 
 public:
     // Constructor
@@ -167,6 +228,7 @@ public:
     bool getIsAsymmetricFrustumRendering() const { return isAsymmetricFrustum; }
     bool getIsAnaglyphChannelsFlippedToed() const { return isFlipAnaglyphChannelsToed; }
     bool getIsAnaglyphChannelsFlippedFrustum() const  { return isFlipAnaglyphChannelsFrustum; }
+    bool getIsSinglePassStereo() const { return isSinglePassStereo; }
     float getInterOcularDistance() const { return interOcularDistance; }
     float getCovergenceDistance() const { return convergeDistance; }
 
@@ -182,6 +244,13 @@ public:
     // Spot Light Parameters
     bool getIsSpotLights() const { return isSpotLights; }
 
+    // Street Light Parameters
+    bool getIsStreetLights() const { return isStreetLights; }
+    bool getIsInstanceLights() const { return isInstanceLights; }
+
+    // Texture streaming
+    size_t getTextureUploadBudget() const { return size_t(textureUploadBudget) << 10; }
+
     // Skybox Parameters
     bool getIsSkyBox() const { return isSkyBox; }
     bool getDrawSkyBox() const { return drawSkybox; }
@@ -210,6 +279,17 @@ public:
     GLuint getPointSize() const { return pointSize; }
     GLuint getNumPoints() const { return numPoints; }
     bool getUpdate() const { return update; }
+    bool getIsLOD() const { return isLOD; }
+    bool getIsInstancing() const { return isInstancing; }
+    bool getIsMultithreaded() const { return isMultithreaded; }
+    bool getIsCityBenchmark() const { return isCityBenchmark; }
+
+    // Stats
+    bool getIsClusterCulling() const { return isClusterCulling; }
+    bool getIsFrustumCulling() const { return isFrustumCulling; }
+    bool getIsOcclusionCulling() const { return isOcclusionCulling; }
+    bool getIsClusterConeCulling() const { return isClusterConeCulling; }
+    float getLODPixelError() const { return lodPixelError; }
 
 
     // Project specific components=====================================================================================
@@ -251,6 +331,20 @@ public:
 
     // PCG - Setter to reset the button press value
     void setUpdate(bool updateValue);
+    void setCityBenchmark(bool benchmarkValue);
+
+    // Stats
+    void setCullingStats(unsigned int tested, unsigned int culled);
+    void setOcclusionStats(unsigned int occluded, unsigned int occluders);
+    void setLightClusterStats(unsigned int lightCount, unsigned int maxLights, float averageLights, double assignTime);
+    void setInstanceLightStats(unsigned int instanceCount, unsigned int maxLights, float averageLights, double assignTime);
+    void setClusterStats(unsigned int clusters, unsigned int culledClusters, unsigned int triangles, unsigned int culledTriangles);
+    void setFrameStats(unsigned int drawCallCount, double cpuFrameTime);
+    void setGLStats(size_t glCallCount, size_t uniformUploadCount);
+    void setStateCacheStats(size_t issued, size_t elided);
+    void setRenderQueueStats(size_t draws, unsigned int stateChanges, double sortTime);
+    void setAllocationStats(size_t allocations, size_t allocationBytes, size_t arenaUsed, size_t arenaCapacity);
+    void setTextureStreamer(const TextureStreamer* streamer);
 
     // Destructor
     ~GUI();
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Number of floats per vertex - x, y, z, u, v, Nx, Ny, Nz, Tx, Ty, Tz
+const int VERTEX_LENGTH = 11;
+
+// Layout expected by glMultiDrawElementsIndirect, DO NOT reorder the members
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Location of a single mesh inside the arena
+struct MeshRange {
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+    GLint baseVertex = 0;
+    GLuint vertexCount = 0;
+};
+
+/*
+One large vertex buffer and one index buffer shared by every mesh that is loaded into it. Meshes only store a MeshRange
+(offset, count, baseVertex), all of them use the same VAO, so a frame can be drawn with a handful of GL calls using
+glMultiDrawElementsIndirect.
+Model matrices of static instances are uploaded once with uploadTransforms. Every frame only a list of indices into them is
+uploaded, the shader reads instanceModel[instanceIndex[gl_BaseInstance + gl_InstanceID]]. The commands of every material of
+a model are uploaded together, each material draws its own range of them.
+*/
+class GeometryArena {
+private:
+    // A free region in one of the buffers, in elements (vertices or indices)
+    struct Block {
+        GLuint offset;
+        GLuint size;
+    };
+
+    GLuint VAO, VBO, IBO;
+
+    // Indirect commands, the static model matrices and the per-frame indices into them
+    GLuint indirectBuffer, transformBuffer, instanceIndexBuffer;
+    GLsizeiptr indirectCapacity, instanceIndexCapacity;
+
+    GLuint vertexCapacity, indexCapacity;
+
+    std::vector<Block> freeVertexBlocks;
+    std::vector<Block> freeIndexBlocks;
+
+    // First-fit allocation from a free list
+    bool allocateBlock(std::vector<Block>& freeList, GLuint size, GLuint& offset);
+
+    // Returning a region back to the free list, merging it with its neighbours
+    void releaseBlock(std::vector<Block>& freeList, GLuint offset, GLuint size);
+
+public:
+    // Constructor
+    GeometryArena();
+
+    // Allocate the buffers on the GPU, sizes are in vertices and indices
+    void createArena(GLuint maxVertices, GLuint maxIndices);
+
+    // Upload a mesh into the arena, returns false if there is no space left
+    bool allocateMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices, MeshRange& range);
+
+    // Give the space of a mesh back to the arena
+    void freeMesh(const MeshRange& range);
+
+    // Bind the shared VAO (The element buffer is part of the VAO state)
+    void bindArena();
+
+    // Draw a single range, used by meshes which are rendered one at a time
+    void drawMesh(const MeshRange& range, GLsizei instanceCount = 1);
+
+    // Replace the instance transforms, only needed when the instances change
+    void uploadTransforms(const std::vector<glm::mat4>& transforms);
+
+    // Indices into the transforms of the instances of a model, indexed by baseInstance + gl_InstanceID - Once per model and pass
+    void uploadInstances(const std::vector<GLuint>& instanceIndices);
+
+    // Commands of every draw of a model, the groups of commands are drawn from their own offsets
+    void uploadCommands(const std::vector<DrawElementsIndirectCommand>& commands);
+
+    // Draw commandCount of the uploaded commands with one call, starting at firstCommand
+    void multiDrawIndirect(GLuint firstCommand, GLuint commandCount);
+
+    // Getters=========================================================================================================
+    bool isCreated() const { return VAO != 0; }
+    GLuint getVertexCapacity() const { return vertexCapacity; }
+    GLuint getIndexCapacity() const { return indexCapacity; }
+
+    // Clear Arena from the Graphics Card
+    void cleanArena();
+
+    // Destructor
+    ~GeometryArena();
+};
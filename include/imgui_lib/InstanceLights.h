@@ -0,0 +1,124 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Custom Libraries
+#include "Utilities.h"
+#include "MathFuncs.h"
+#include "JobSystem.h"
+#include "UniformBuffer.h"
+
+// Binding point of the InstanceLightLists buffer in BRDF_Normals.frag
+const GLuint INSTANCE_LIGHTS_BINDING = 5;
+
+// Objects drawn without a list of their own go through the clusters
+const GLint NO_LIGHT_INSTANCE = -1;
+
+/*
+Per instance light lists - Every instance of the pass gets the point and spot lights whose sphere touches its bounds (Plus a
+cone test for spot lights), so the fragment shader only loops over the lights that can reach the object.
+The lists index the lights of the ClusterLights buffer, so both paths share the same lights - See ClusteredLights.h.
+Lights are sorted into a grid on the ground (x and z) with cells as big as the largest range, every instance only tests the
+lights of the cells around its box, 4 at a time - The cells of a row follow each other, so a row is a single run of lights.
+Instances are split into contiguous ranges, one job each, and the lists of the ranges are merged in order.
+Everything goes into a single buffer - The offset and count of every instance, then the lists. Offsets are from the start
+of the buffer.
+*/
+class InstanceLights {
+private:
+    // Lists of a contiguous range of instances, filled by its job
+    struct PartitionWork {
+        std::vector<GLuint> indices;
+        std::vector<GLuint> counts;
+    };
+
+    // World space bounds, in the order the lists are indexed
+    std::vector<AABB> bounds;
+
+    // Lights of the assignment sorted by cell - Structure of arrays for the SIMD tests, padded so loads of 4 stay inside
+    std::vector<float> lightX, lightY, lightZ, lightRadius;
+    std::vector<GLuint> lightOrder;
+
+    // First sorted light of every cell, cell x + gridWidth * z, with the end of the last cell after it
+    std::vector<GLuint> cellStart;
+    std::vector<GLuint> lightCells;
+    glm::vec2 gridOrigin;
+    float cellSize;
+    int gridWidth, gridDepth;
+
+    // Normalized directions and edges of the sorted lights, only used by the cone test of the spot lights
+    std::vector<glm::vec3> lightDirections;
+    std::vector<float> lightEdges;
+
+    // Largest range of the assignment, how far outside a box the light centers are searched
+    float maxRange;
+
+    std::vector<PartitionWork> partitions;
+
+    // Offset and count of every instance, then the lists - Uploaded as is
+    std::vector<GLuint> lists;
+
+    // Shader storage buffer, grown when the lists don't fit anymore
+    GLuint listsBuffer;
+    GLsizeiptr listsCapacity;
+
+    // Stats of the last assignment
+    GLuint maxInstanceLights;
+    size_t totalInstanceLights;
+    double assignTime;
+
+    // Cell of a coordinate along x or z, clamped to the grid
+    int getCell(float coordinate, float origin, int cellCount) const;
+
+    // Lists of the instances [begin, end), called by the jobs
+    void assignRange(PartitionWork& work, size_t begin, size_t end) const;
+
+public:
+    // Constructor
+    InstanceLights();
+
+    // Allocate the buffer and bind it to its binding point
+    void createBuffer();
+
+    // Forget the instances of the previous pass
+    void clearInstances();
+
+    // Add instances in world space, returns the index of the list of the first one
+    GLint addInstances(const AABB* boxes, size_t count);
+    GLint addInstance(const AABB& box) { return addInstances(&box, 1); }
+
+    // Build the list of every instance against the lights, on the job system if one is given - No GL calls
+    void assignLights(const std::vector<ClusterLightBlock>& lights, JobSystem* jobSystem = nullptr);
+
+    // Upload the lists of the last assignment
+    void uploadBuffer();
+
+    // Getters=========================================================================================================
+    size_t getInstanceCount() const { return bounds.size(); }
+    GLuint getMaxInstanceLights() const { return maxInstanceLights; }
+    float getAverageInstanceLights() const;
+    double getAssignTime() const { return assignTime; }
+
+    // Headless benchmark - instanceCount random buildings against lightCount street lights, on one and on every thread
+    // Compared against a scalar test of every light against every instance
+    static void benchmarkAssign(size_t instanceCount, size_t lightCount, int iterations = 20);
+
+    // Not copyable, the buffer is owned by a single object
+    InstanceLights(const InstanceLights&) = delete;
+    InstanceLights& operator=(const InstanceLights&) = delete;
+
+    // Clear the buffer from the Graphics Card
+    void cleanBuffer();
+
+    // Destructor
+    ~InstanceLights();
+};
@@ -6,6 +6,9 @@
 // GLM Files - Math Library
 #include <glm/glm.hpp>
 
+// std140/std430 copies of the light structs
+#include "UniformBuffer.h"
+
 class Light {
 protected:
     // The amount of light being reflected from the surface upon hitting
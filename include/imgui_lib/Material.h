@@ -3,6 +3,9 @@
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// std140 copy of the parameters
+#include "UniformBuffer.h"
+
 // This class contains the material properties
 class Material {
 private:
@@ -20,6 +23,9 @@ public:
     // Bind the current material values to the program
     void useMaterial(GLuint specularIntensityLocation, GLuint shininessLocation, GLuint metalnessLocation);
 
+    // Copy the values into the Material uniform block
+    void fillBlock(MaterialBlock& block) const;
+
     // Getters=========================================================================================================
     const GLfloat getSpecularIntensity() { return specularIntensity; }
     const GLfloat getShininess() { return shininess; }
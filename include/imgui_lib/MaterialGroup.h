@@ -0,0 +1,60 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// Custom Libraries
+#include "Texture.h"
+#include "Material.h"
+#include "UniformBuffer.h"
+
+// Texture units of the maps, same as the samplers of BRDF_Normals.frag
+const GLuint DIFFUSE_TEXTURE_UNIT = 0;
+const GLuint SPECULAR_TEXTURE_UNIT = 1;
+const GLuint NORMAL_TEXTURE_UNIT = 2;
+
+/*
+Everything a draw needs from its material, built once when the material is loaded. The textures go to units 0, 1, 2... in
+order and the parameters live in their own Material block, so switching materials is a few binds and no uniform uploads.
+The texture set never changes after createGroup, the parameters only when setParameters is called (e.g. from the UI).
+*/
+class MaterialGroup {
+private:
+    // Not owned, nullptr entries are skipped
+    std::vector<Texture*> textures;
+
+    Material parameters;
+    UniformBuffer parameterBuffer;
+
+    // Handed out in order from 1, 0 is left for draws without a material
+    GLuint sortID;
+    static GLuint nextSortID;
+
+public:
+    // Constructor
+    MaterialGroup();
+
+    // Upload the parameters, the textures have to stay alive as long as the group
+    void createGroup(const std::vector<Texture*>& textureSet, const Material& material);
+
+    // Bind the textures and the parameter block
+    void bindGroup();
+
+    // Upload new parameters, skipped if they are the same
+    void setParameters(const Material& material);
+
+    // Getters=========================================================================================================
+    const std::vector<Texture*>& getTextures() const { return textures; }
+    const Material& getParameters() const { return parameters; }
+    GLuint getSortID() const { return sortID; }
+
+    // Not copyable, the parameter buffer is owned by a single group
+    MaterialGroup(const MaterialGroup&) = delete;
+    MaterialGroup& operator=(const MaterialGroup&) = delete;
+
+    // Destructor
+    ~MaterialGroup();
+};
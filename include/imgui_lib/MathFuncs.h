@@ -47,4 +47,21 @@ glm::vec3 moveFromAToB(int type, const glm::vec3& A, const glm::vec3& B, float t
 // Function to check if two float3 arrays are equal
 bool areFloatArraysEqual(const float a[3], const float b[3], float epsilon = 0.001);
 
+// Axis aligned bounding box
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// View frustum as 6 planes (Left, Right, Bottom, Top, Near, Far), xyz is the normal pointing inside and w the distance
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Extract the frustum planes from a projection * view (* model) matrix - Gribb/Hartmann method
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// Check if a sphere is at least partially inside the frustum
+bool isSphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+
 #endif
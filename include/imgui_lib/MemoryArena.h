@@ -0,0 +1,130 @@
+#pragma once
+
+// General libraries
+#include <iostream>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Linear (bump) allocator. Allocations are served from large blocks by moving an offset forward, nothing is freed on its own,
+reset() releases everything at once. Used for data that all dies at the same time, i.e. per-frame transient data or scratch
+memory while loading.
+If a block runs out a new one is chained on, on the next reset the blocks are merged into one big enough for all of them, so
+a steady workload stops allocating after the first few frames.
+*/
+class MemoryArena {
+private:
+    struct Block {
+        unsigned char* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+
+    // Offset into the last block
+    size_t offset;
+
+    // Bytes handed out since the last reset and the most handed out during a single reset cycle
+    size_t used, peak;
+
+    void addBlock(size_t minimumSize);
+
+public:
+    // Constructor
+    MemoryArena(size_t initialSize = 64 * 1024);
+
+    // Returns memory aligned to alignment (Power of 2)
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Invalidates everything allocated so far
+    void reset();
+
+    // Getters=========================================================================================================
+    size_t getUsed() const { return used; }
+    size_t getPeak() const { return peak; }
+    size_t getCapacity() const;
+
+    // Not copyable, the blocks are owned by a single arena
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    // Free all the blocks
+    void cleanArena();
+
+    // Destructor
+    ~MemoryArena();
+};
+
+// STL allocator on top of a MemoryArena, deallocate does nothing since the arena is reset as a whole
+template<typename T>
+class ArenaAllocator {
+private:
+    MemoryArena* arena;
+
+    template<typename U> friend class ArenaAllocator;
+
+public:
+    using value_type = T;
+
+    // Constructor
+    ArenaAllocator(MemoryArena& memoryArena) : arena(&memoryArena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// Vector living in an arena, only valid until the arena is reset
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Allocation Tracking=================================================================================================
+/*
+The global operator new/delete are replaced in MemoryArena.cpp to count every heap allocation made through them.
+Allocations are also grouped by call site, the site being the innermost AllocationScope alive on the allocating thread.
+Allocations outside of any scope are counted under "Untagged".
+*/
+
+// Maximum number of different call sites, anything beyond that is counted under "Other"
+const size_t MAX_ALLOCATION_SITES = 32;
+
+struct AllocationSite {
+    const char* name;
+    size_t count;
+    size_t bytes;
+};
+
+// Tags the allocations made on this thread while it is alive, the name has to be a string literal (Compared by address)
+class AllocationScope {
+private:
+    const char* previousSite;
+
+public:
+    // Constructor
+    AllocationScope(const char* siteName);
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    // Destructor
+    ~AllocationScope();
+};
+
+// Totals since the start of the program
+size_t getAllocationCount();
+size_t getAllocationBytes();
+
+// Copy the histogram into sites (Doesn't allocate), returns the number of sites written
+size_t getAllocationSites(AllocationSite* sites, size_t maxSites);
+
+// Print the histogram in Terminal, sorted by count
+void printAllocationSites(const char* title);
@@ -3,6 +3,9 @@
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// Custom libraries
+#include "GeometryArena.h"
+
 class Mesh {
 private:
     // IBO is optional but causes issues in some graphics cards
@@ -11,15 +14,29 @@ private:
     // Indexcount, since we will be passing unkown number of indices
     GLsizei indexCount;
 
+    // Set when the mesh lives inside a shared arena instead of its own buffers
+    GeometryArena* arena;
+    MeshRange range;
+
 public:
     // Constructor
     Mesh();
 
     // Setup the initial mesh
-    void createMesh(GLfloat *vertices, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices);
+    void createMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices);
+
+    // Setup the mesh inside the arena, falls back to its own buffers if the arena is full
+    void createMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices, GeometryArena* geometryArena);
+
+    // Render the mesh, instanceCount times - Once per view of the pass for the BRDF shader, only it knows about views
+    void renderMesh(GLsizei instanceCount = 1);
+
+    // Render part of the index buffer, firstIndex is relative to the start of the mesh
+    void renderMeshRange(GLuint firstIndex, GLsizei count, GLsizei instanceCount = 1);
 
-    // Render the mesh
-    void renderMesh();
+    // Getters=========================================================================================================
+    bool isInArena() const { return arena != nullptr; }
+    const MeshRange& getRange() const { return range; }
 
     // Clear Mesh from the Graphics Card
     void cleanMesh();
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cctype>
+#include <filesystem>
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// Custom Libraries
+#include "Utilities.h"
+#include "JobSystem.h"
+
+// Kernel every level is resampled with
+enum MipFilter {
+    // 2x2 average, the same as most drivers
+    MIP_FILTER_BOX,
+    // Kaiser windowed sinc - Sharper than the box, barely rings
+    MIP_FILTER_KAISER,
+    // Lanczos 3 - Sharpest, rings a bit around hard edges
+    MIP_FILTER_LANCZOS
+};
+
+// What the texels mean, which decides the space they are filtered in
+enum MipContent {
+    // Colour stored with the sRGB curve, filtered in linear light
+    MIP_CONTENT_COLOUR,
+    // Data maps (Specular, roughness, ...), filtered as they are
+    MIP_CONTENT_LINEAR,
+    // Tangent space normals, filtered and renormalized
+    MIP_CONTENT_NORMAL
+};
+
+struct MipSettings {
+    MipContent content = MIP_CONTENT_COLOUR;
+    MipFilter filter = MIP_FILTER_KAISER;
+
+    // Textures repeat (GL_REPEAT) so their edges filter across to the other side, cube faces clamp
+    bool isWrapping = true;
+};
+
+/*
+Mip chain built on the CPU instead of glGenerateMipmap - Every level is resampled from the previous one with a separable
+kernel, vertically into a row of floats and then horizontally. Odd sizes work as well, the kernel is stretched over
+size / (size / 2) texels.
+Source rows are converted to floats (Through the sRGB curve for colour) once into a small ring per thread, the vertical pass
+is a weighted sum of those rows with AVX2 (FMA) when the CPU has it, and the horizontal pass works on a whole RGBA texel at a
+time with SSE.
+Rows of a level are split over the job system once the level is big enough, so large images use every core.
+No GL calls - Used by the streaming workers, the cooker and Texture.
+*/
+class MipChain {
+private:
+    int width, height;
+
+    // RGBA8, level 0 first
+    std::vector<unsigned char> pixels;
+
+    // Offset of every level, plus the end of the last one
+    std::vector<size_t> levelOffsets;
+
+    // Resample the level above into this one, rows [rowBegin, rowEnd) of it
+    void buildLevelRows(GLuint level, const MipSettings& settings, int rowBegin, int rowEnd);
+
+public:
+    // Constructor
+    MipChain();
+
+    // Build the whole chain down to 1x1 from RGBA8 texels, on the job system if one is given
+    void build(const unsigned char* image, int imageWidth, int imageHeight, const MipSettings& settings, JobSystem* jobSystem = nullptr);
+
+    // Drop the levels, swap instead of clear so the memory is released
+    void release();
+
+    // Levels of a full chain down to 1x1
+    static GLuint getLevelCount(int width, int height);
+
+    // Content of a file guessed from its name (Normal maps, data maps, colour otherwise)
+    static MipContent chooseContent(const std::string& path);
+
+    // Getters=========================================================================================================
+    GLuint getLevelCount() const { return levelOffsets.empty() ? 0 : static_cast<GLuint>(levelOffsets.size() - 1); }
+    int getLevelWidth(GLuint level) const { return std::max(width >> level, 1); }
+    int getLevelHeight(GLuint level) const { return std::max(height >> level, 1); }
+    size_t getLevelSize(GLuint level) const { return levelOffsets[level + 1] - levelOffsets[level]; }
+    size_t getLevelOffset(GLuint level) const { return levelOffsets[level]; }
+    const unsigned char* getLevel(GLuint level) const { return pixels.data() + levelOffsets[level]; }
+    size_t getSize() const { return pixels.size(); }
+};
@@ -4,10 +4,17 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <chrono>
+#include <cfloat>
+#include <climits>
+#include <unordered_map>
+#include <unordered_set>
 
 // GLM Files - Math Library
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 // ASSIMP File Importer
 #include <assimp/Importer.hpp>
@@ -18,13 +25,70 @@
 #include "Mesh.h"
 #include "Texture.h"
 #include "Material.h"
+#include "MaterialGroup.h"
 #include "Utilities.h"
+#include "MemoryArena.h"
+
+// LOD generation
+#include "meshSimplify.h"
+
+// Cluster culling
+#include "meshlets.h"
+
+// Frustum culling of the meshes
+#include "frustumCulling.h"
+
+// Native glTF loading, without Assimp
+#include "GLTFLoader.h"
+
+// Sorted submission of the draws
+#include "RenderQueue.h"
+
+// Flat transform hierarchy
+#include "TransformSystem.h"
 
 class Model {
 private:
     std::vector<Mesh*> meshList;
+
+    // Every texture loaded for the model, shared by the material groups
     std::vector<Texture*> textureList;
-    std::vector<unsigned int> meshToTex;
+
+    // One group per material of the file, meshToMaterial[mesh] is the index of the group of each mesh
+    std::vector<MaterialGroup*> materialGroups;
+    std::vector<unsigned int> meshToMaterial;
+
+    // Simplified versions of each mesh, meshLODs[mesh][level] - Level 0 is the mesh in meshList
+    std::vector<std::vector<Mesh*>> meshLODs;
+
+    // Object space error of each level, the maximum over all the meshes
+    std::vector<GLfloat> lodErrors;
+
+    // Clusters of the full detail meshes, empty for meshes too small to be worth splitting
+    std::vector<std::vector<Meshlet>> meshMeshlets;
+
+    // Object space bounds of each mesh (Also used for its LODs) and of the whole model
+    AABBList meshBounds;
+    AABB bounds;
+
+    // Re-used by queueModelCulled
+    std::vector<unsigned char> meshVisible;
+
+    // Radius of the sphere around the origin containing all the vertices
+    GLfloat boundingRadius;
+
+    // Shared buffers the meshes are loaded into, nullptr if every mesh has its own buffers
+    GeometryArena* geometryArena;
+
+    // Textures are streamed in the background through it, nullptr loads them in one go
+    TextureStreamer* textureStreamer;
+
+    // Scratch buffers reused by every mesh while loading, released once the model is loaded
+    std::vector<GLfloat> loadVertices, lodVertices;
+    std::vector<unsigned int> loadIndices, lodIndices;
+
+    // Textures loaded so far by path, materials often share maps (And the defaults)
+    std::unordered_map<std::string, Texture*> loadedTextures;
 
     // Local Transforms for the model
     // You can change them as needed
@@ -44,37 +108,104 @@ private:
     // Transform Matrix with transformations
     glm::mat4 accumulateTransform;
 
-    // Material for the object
-    // TODO : Add support for multiple materials
-    // std::vector<Material> materials;
-    Material material;
-    GLuint matUniformSpecularIntensity, matUniformShininess, matUniformMetalness;
+    // Node in a transform system, used instead of the accumulated transform once attached
+    TransformSystem* transformSystem;
+    TransformHandle transformNode;
 
     // To load children data
     void loadNode(aiNode *node, const aiScene *scene);
     void loadMesh(aiMesh *mesh, const aiScene *scene);
     void loadMaterials(const aiScene *scene);
-    void loadMap(aiMaterial* material, aiTextureType textureType, int textureIndex);
+    Texture* loadMap(aiMaterial* material, aiTextureType textureType, const std::string& defaultName);
+
+    // Interleave the Assimp mesh into the Mesh layout
+    static void buildVertexData(aiMesh *mesh, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices);
+
+    // Upload an interleaved mesh and generate its LODs, shared by the Assimp and glTF paths
+    void addMesh(const std::vector<GLfloat>& vertices, const unsigned int* indices, size_t numOfIndices, unsigned int materialIndex);
+
+    // Load a texture, falling back to a default one from Textures/Default if the path is empty or fails to load
+    // Files that were already loaded for this model are shared
+    Texture* loadTextureOrDefault(const std::string& texturePath, const std::string& defaultName);
+
+    // White group with a flat normal, for meshes without a material
+    void addDefaultMaterial();
+
+    // Make sure there is at least one group and every mesh points to a valid one
+    void finalizeMaterials();
+
+    // Simplify the mesh into MAX_LOD_LEVELS - 1 coarser meshes, meshBox is the bounds of the mesh itself
+    void generateLODs(const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices, const AABB& meshBox);
+
+    // Free the scratch buffers used while loading
+    void releaseLoadBuffers();
 
 public:
     // Constructor
     Model();
 
-    void loadModel(const std::string& filePath);
+    void loadModel(const std::string& filePath, GeometryArena* arena = nullptr, TextureStreamer* streamer = nullptr);
+
+    // Load a .gltf directly, without going through Assimp
+    bool loadGLTF(const std::string& filePath, GeometryArena* arena = nullptr, TextureStreamer* streamer = nullptr);
+
+    // Compare the CPU side of loading a file through Assimp and through GLTFLoader, no GL context needed
+    static void benchmarkLoaders(const std::string& filePath, int iterations = 10);
+
+    // Split the meshes of a file into clusters and cull them from cameras all around the model, no GL context needed
+    static void benchmarkClusterCulling(const std::string& filePath, int views = 64);
 
     // Render a single model using normal method
     void renderModel();
 
+    // Render only the clusters that pass the frustum and normal cone tests
+    // The frustum and eye position are in object space - extractFrustum(projection * view * model) and inverse(model) * eye
+    void renderModelClusters(const Frustum& frustum, const glm::vec3& eyePosition, bool coneCulling, ClusterStats& stats);
+
+    // Render only the meshes whose bounds are inside the frustum, the frustum is in object space like renderModelClusters
+    void queueModelCulled(CommandBuffer& queue, Shader* shader, const glm::mat4* transform, const Frustum& frustum, CullingStats& stats,
+                          GLint lightInstance = -1);
+
+    // Push a draw for every mesh of the model and its children into the queue, transform defaults to the world transform
+    // No GL calls, so worker threads can record into their own buffers
+    // lightInstance is the light list of the model's own meshes, children go through the clusters
+    void queueModel(CommandBuffer& queue, Shader* shader, const glm::mat4* transform = nullptr, GLint lightInstance = -1);
+
     // Render hierarchical model
     void renderModel(const GLuint& uniformModel);
 
+    // Bind the textures and parameters of a material group once for a batch of draws
+    void bindMaterial(GLuint materialIndex);
+
+    // True if every mesh and LOD was loaded into the geometry arena
+    bool isInArena() const;
+
+    // Add one indirect command per mesh (Only the meshes of materialIndex if it isn't -1), all of them drawing
+    // instanceCount instances starting at baseInstance
+    // Returns false if any mesh is not in the arena (Has to be drawn with renderModel instead)
+    bool appendDrawCommands(std::vector<DrawElementsIndirectCommand>& commands, GLuint baseInstance, GLuint instanceCount = 1, GLuint lod = 0, int materialIndex = -1);
+
+    // Pick the coarsest LOD whose error projected on the screen is below pixelError
+    // distance and objectScale are of the instance, projectionScale comes from Camera::calculateProjectionScale
+    GLuint selectLOD(GLfloat distance, GLfloat objectScale, GLfloat projectionScale, GLfloat pixelError, GLuint currentLOD);
+
     // Clear data of the selected model
     void clearModel();
 
     // Getters=========================================================================================================
     glm::mat4 getInitialTransformMatrix() { return initialTransform; }
     glm::mat4 getAccumulateTransformMatrix() { return accumulateTransform; }
+    TransformHandle getTransformNode() const { return transformNode; }
+
+    // Node of the transform system if attached, the accumulated transform otherwise
+    const glm::mat4* getWorldTransform() const;
     glm::vec3 getPosition() { return localPosition; }
+    GLuint getLODCount() const { return lodErrors.size(); }
+    GLuint getMeshCount() const { return meshList.size(); }
+    GLuint getMaterialCount() const { return materialGroups.size(); }
+    GLfloat getLODError(GLuint lod) const { return lodErrors[lod]; }
+    GLfloat getBoundingRadius() const { return boundingRadius; }
+    const AABB& getBounds() const { return bounds; }
     Model* getParent() { return parent; }
     const std::vector<Model*>& getChildren() const { return children; }
 
@@ -97,6 +228,10 @@ public:
     // Add a SINGLE parent to the child
     void attachParent(Model* parentModel);
 
+    // Create nodes for the model and its children in the system, from the local transforms
+    // Afterwards the local transform setters move the node, and the system computes the world transforms
+    void attachTransform(TransformSystem* system, TransformHandle parentNode = INVALID_TRANSFORM);
+
     // Call this after every draw call to reset the accumulate matrix to initial matrix
     void resetTransform();
 
@@ -116,8 +251,7 @@ public:
     void updateRotation(GLfloat angle, glm::vec3& axis, bool rads);
     void updateScale(glm::vec3& scale);
 
-    // Materials
-    void setMaterialUniforms(GLuint uniformSpecularIntensity, GLuint uniformShininess, GLuint uniformMetalness);
+    // Materials - Sets the parameters of every group, only uploaded if they changed
     void updateMaterialProperties(GLfloat specular, GLfloat shine, GLfloat metal);
 
     // Destructor
@@ -25,6 +25,12 @@ public:
                     GLuint diffuseIntensityLocation, GLuint positionLocation,
                     GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation  );
 
+    // Distance at which the light adds less than LIGHT_ATTENUATION_CUTOFF
+    GLfloat calculateRange() const;
+
+    // Same values as useLight, written into the clustered light buffer
+    void fillBlock(ClusterLightBlock& block) const;
+
     // Destructor
     ~PointLight();
 };
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <random>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Custom Libraries
+#include "Mesh.h"
+#include "Shader.h"
+#include "MaterialGroup.h"
+
+// Sorting the keys
+#include "radixSort.h"
+
+// Recording on several threads in the benchmark
+#include "JobSystem.h"
+
+// Passes are submitted in this order
+enum RenderPassType {
+    OPAQUE_PASS = 0,
+    TRANSPARENT_PASS = 1
+};
+
+/*
+Sort key layout, from the least significant bit
+Opaque      - index (17) | depth (19)    | material (20) | shader (6)             | pass (2)
+Transparent - index (17) | material (20) | shader (6)    | far to near depth (19) | pass (2)
+Opaque draws with the same state end up next to each other and are front to back inside each group (Early-z).
+Transparent draws have to blend back to front, so the depth is sorted before the state.
+The index of the draw is carried in the low bits and isn't sorted.
+Materials go in by their sort ID, which are handed out in order, so a scene with a few hundred materials only varies in the low
+bits of the field and the radix sort skips the rest.
+*/
+const int SORT_INDEX_BITS = 17;
+const int SORT_DEPTH_BITS = 19;
+const int SORT_MATERIAL_BITS = 20;
+const int SORT_SHADER_BITS = 6;
+const int SORT_PASS_BITS = 2;
+
+// Draws per queue, limited by the index bits
+const size_t RENDER_QUEUE_MAX_DRAWS = size_t(1) << SORT_INDEX_BITS;
+
+// A single draw, everything needed to submit it without going back to the scene
+struct RenderItem {
+    Mesh* mesh;
+    Shader* shader;
+
+    // Textures and parameters, skipped if nullptr
+    MaterialGroup* material;
+
+    // Not copied, so the items stay small - Has to stay alive until the queue is submitted
+    const glm::mat4* transform;
+
+    // List of the lights reaching the draw, -1 goes through the clusters - See InstanceLights.h
+    GLint lightInstance = -1;
+};
+
+/*
+Draws of a pass with their sort keys, recorded without any GL calls. Worker threads each fill their own buffer, which the
+GL thread then appends to the RenderQueue in a fixed order.
+Shaders and materials only need an ID that is the same for the same state, so the IDs are hashed from the
+program and the addresses - a collision only costs an extra state change, submit compares the actual state.
+*/
+class CommandBuffer {
+protected:
+    std::vector<RenderItem> items;
+
+    // Sort key of each draw with its index into items in the low bits
+    std::vector<uint64_t> keys;
+
+    // View of the pass, for the depth of the draws
+    glm::mat4 view;
+    GLfloat farPlane;
+
+    // Stats of the last pass
+    size_t droppedDraws;
+
+    // Merges other buffers
+    friend class RenderQueue;
+
+public:
+    // Constructor
+    CommandBuffer();
+
+    // Start a new pass, the depth of the draws is measured along the view direction up to the far plane
+    void begin(const glm::mat4& viewMatrix, GLfloat farClipping);
+
+    // Add a draw to the pass, returns false if the buffer is full
+    bool push(const RenderItem& item, RenderPassType pass = OPAQUE_PASS);
+
+    // Getters=========================================================================================================
+    size_t getDrawCount() const { return keys.size(); }
+    size_t getDroppedDraws() const { return droppedDraws; }
+
+    // Destructor
+    ~CommandBuffer();
+};
+
+// Command buffer of the GL thread, the only one that gets sorted and submitted
+class RenderQueue : public CommandBuffer {
+private:
+    std::vector<uint64_t> scratchKeys;
+
+    // Stats of the last pass
+    GLuint stateChanges;
+    double sortTime;
+
+public:
+    // Constructor
+    RenderQueue();
+
+    // Add the draws of a buffer recorded on another thread after the ones already in the queue, the views have to match
+    void append(const CommandBuffer& commands);
+
+    // Sort the draws by their key
+    void sort();
+
+    // Draw everything in the sorted order, only changing the shader and material when they differ
+    // uniformModel and uniformLightInstance are the locations of the shaders, returns the number of draw calls
+    // Every draw is instanced once per view of the pass (Both eyes in single pass stereo)
+    GLuint submit(GLuint uniformModel, GLuint uniformLightInstance, GLsizei viewCount);
+
+    // Compare push and sort against std::sort with random keys, and recording on one thread against all of them
+    // No GL context needed
+    static void benchmarkSort(size_t drawCount = 100000, int iterations = 100);
+
+    // Getters=========================================================================================================
+    GLuint getStateChanges() const { return stateChanges; }
+    double getSortTime() const { return sortTime; }
+
+    // Destructor
+    ~RenderQueue();
+};
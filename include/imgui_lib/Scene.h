@@ -12,6 +12,7 @@
 #include <vector>
 // For smart and shared pointers - To better manage memory leaks
 #include <memory>
+#include <chrono>
 
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
@@ -39,12 +40,62 @@
 // Custom Models
 #include "Model.h"
 
+// Shared vertex/index buffers for the models
+#include "GeometryArena.h"
+
+// Per-frame transient memory and allocation counters
+#include "MemoryArena.h"
+
+// Frame level uniform blocks and the GL call counter
+#include "UniformBuffer.h"
+#include "GLCallCounter.h"
+
 // Skybox
 #include "Skybox.h"
 
+// Both eyes of the anaglyph in a single pass
+#include "StereoTarget.h"
+
+// Software depth buffer of the biggest buildings
+#include "occlusionCulling.h"
+
+// Point and spot lights sorted into clusters of the view frustum
+#include "ClusteredLights.h"
+
+// Or into lists of the lights touching every object
+#include "InstanceLights.h"
+
+// Sorted submission of the draws, recorded on several threads
+#include "RenderQueue.h"
+#include "JobSystem.h"
+
 // Procedural Content Generation
 #include "randomDistribute.h"
 
+// A building floor of the procedural city, compiled from the random points when they change
+struct CityInstance {
+    // Index into the city transforms
+    GLuint transform;
+
+    // For picking the LOD
+    glm::vec3 position;
+    GLfloat scale;
+};
+
+// Work of a range of city instances, filled by a worker thread and merged on the GL thread
+struct CityPartition {
+    // Visible instances of the range for each LOD, for the indirect draws
+    std::vector<std::vector<GLuint>> lodInstances;
+
+    // Draws of the range when the model can't be drawn indirectly
+    CommandBuffer commands;
+
+    // Occluder candidates of the range, from every building type
+    std::vector<OccluderCandidate> occluders;
+
+    CullingStats stats;
+};
+
 /*
 This class encapsulates all the elements in the viewport or scene. That includes the GUI layout, objects in the scene, Skyboxes,
 materials, cameras and anything that should be specific to the scene. Please modify as per required, making sure that the main
@@ -62,7 +113,7 @@ private:
 
     // Setting the variables
     GLuint uniformProjection, uniformModel, uniformView, uniformEyePosition;
-    GLuint uniformSpecularIntensity, uniformShininess, uniformMetalness;
+    GLuint uniformIsIndirect, uniformLightInstance;
     GLuint uniformshadingModel;
     GLuint uniformIsShaded, uniformIsWireframe, uniformObjectColor, uniformWireframeColor;
     GLuint uniformMaterialPreview, uniformSpecularPreview, uniformNormalPreview;
@@ -87,11 +138,17 @@ private:
     // Switching between GLFW and ImGUI
     bool cursorDisabled = true;
 
+    // Decodes and uploads the textures in the background, declared before the textures so it outlives them
+    TextureStreamer textureStreamer;
+
     // Textures
     // TODO : Vectors don't work with these textures? Weird - SOLUTION : USE POINTERS FOR TEXTURE VECTORS
     Texture whiteTexture;
     Texture brickTexture;
 
+    // Brick texture with the rough material, for the floor
+    MaterialGroup floorMaterial;
+
     // Noise Texture for random maps
     // Texture noiseTexture;
 
@@ -106,6 +163,12 @@ private:
     // Spot Lights
     unsigned int spotLightCount = 0;
 
+    // Lists of the point and spot lights reaching each cluster of the view, built every pass
+    ClusteredLights clusteredLights;
+
+    // Lists of the same lights reaching each object of the pass, used instead of the clusters when enabled in the UI
+    InstanceLights instanceLights;
+
     // Skybox
     std::unique_ptr<Skybox> mainSkybox;
     std::vector<std::unique_ptr<Skybox>> skyboxList;
@@ -129,6 +192,80 @@ private:
     // 3. Asymmetric Frustum
     int renderingMode = 0;
 
+    // All models are loaded into the arena so they can be drawn with multi draw indirect
+    GeometryArena geometryArena;
+
+    // Re-used every frame for the indirect draws
+    std::vector<DrawElementsIndirectCommand> drawCommands;
+    std::vector<GLuint> drawInstances;
+
+    // First command of every material in drawCommands, plus the end of the last one
+    std::vector<GLuint> drawMaterialStarts;
+
+    // Procedural city - Transforms of every building floor, uploaded to the arena only when the city changes
+    std::vector<glm::mat4> cityTransforms;
+    std::vector<CityInstance> building0Instances;
+    std::vector<CityInstance> building1Instances;
+    bool isCityUploaded = false;
+
+    // A street light next to every building, built with the city
+    std::vector<ClusterLightBlock> streetLights;
+
+    // World space bounds of the instances of each building type, built with the upload since they need the models
+    AABBList building0Bounds;
+    AABBList building1Bounds;
+
+    // Same bounds indexed like the city transforms, the first instances of the light lists
+    std::vector<AABB> cityLightBounds;
+    std::vector<unsigned char> instanceVisible;
+
+    // Frustum culling results of the current frame
+    CullingStats cullingStats;
+
+    // Occluders of the current pass, drawn before the city is culled. Not ready for multi view passes or when it's off
+    OcclusionBuffer occlusionBuffer;
+    std::vector<OccluderCandidate> occluderCandidates;
+    bool isOcclusionReady = false;
+
+    // Instanced or one draw per building floor, the benchmark switches between both
+    bool isInstancing = true;
+
+    // Stats - Draw calls in the current frame
+    GLuint drawCalls = 0;
+
+    // Draws that aren't batched already are collected every pass and submitted sorted by state
+    RenderQueue renderQueue;
+
+    // Workers for the city, each partition is re-used every pass so recording doesn't allocate once warmed up
+    JobSystem jobSystem;
+    std::vector<CityPartition> cityPartitions;
+
+    // Side by side eyes of single pass stereo
+    StereoTarget stereoTarget;
+
+    // Transforms of the queued draws have to outlive the pass, so they are kept here
+    glm::mat4 floorTransform;
+
+    // Local and world transforms of the models, world transforms are only computed again for the nodes that moved
+    TransformSystem transforms;
+    TransformHandle cubeCursorNode = INVALID_TRANSFORM;
+
+    // City benchmark - Current configuration (-1 when not running), frames rendered and time spent in it
+    int cityBenchmarkStep = -1;
+    int cityBenchmarkFrame = 0;
+    double cityBenchmarkTime = 0.0;
+
+    // Uniform blocks shared by every draw, only uploaded when their contents change
+    UniformBuffer cameraBuffer;
+    UniformBuffer lightsBuffer;
+    UniformBuffer settingsBuffer;
+
+    // Transient data of the current frame, reset at the start of every update
+    MemoryArena frameArena;
+
+    // LOD picked for every building floor (Indexed like the city transforms) last frame, for hysteresis
+    std::vector<GLuint> buildingLODs;
+
     // Models
     Model* building0;
     Model* building1;
@@ -145,6 +282,13 @@ private:
     // Initial Projection Matrix
     glm::mat4 projection;
 
+    // Projection * View of every view of the current pass (Both eyes in single pass stereo), used for culling
+    glm::mat4 viewProjections[MAX_VIEWS];
+    int passViewCount = 1;
+
+    // View of the current pass, used for the depth of the queued draws
+    glm::mat4 passView;
+
 public:
     // Constructor
     Scene(Window& window, GLuint seed = 69420);
@@ -177,10 +321,40 @@ public:
     // Get uniforms from a particular shader in the Shader List
     void getUniformsFromShader(Shader* shader);
 
-    // Set the uniforms for a particular shader in the Shader List
+    // Fill the camera, light and setting blocks of the current pass, the shader has to be bound
     void setUniformsForShader(glm::mat4 projectionMatrix, glm::mat4 viewMatrix, Shader* shader);
 
+    // Same for a pass drawing viewCount views at once, the first view is used for sorting the queued draws
+    void setUniformsForShader(const glm::mat4* projectionMatrices, const glm::mat4* viewMatrices, int viewCount, Shader* shader);
+
+    // Procedural City================================================================================================
+    // Generate new random points and compile them into the city
+    void generateCity(int gridSize, int pointSize, int numPoints, int pointSeed);
+
+    // Build the transforms and instance lists of each building type from the random points
+    void buildCity();
+
+    // Switch to the next configuration of the benchmark once enough frames were measured
+    void updateCityBenchmark(double frameTime);
+
+    // Transform the bounds of the model to every instance, into the culling and the light list bounds
+    void buildCityBounds(Model* model, const std::vector<CityInstance>& instances, AABBList& instanceBounds);
+
     // Render Passes===================================================================================================
+    // Build and upload the light lists of the instances added in the current pass, if they are enabled
+    void assignInstanceLights();
+
+    // Pick the biggest buildings in the frustum and draw them into the occlusion buffer, on the workers
+    void buildOcclusionBuffer();
+
+    // Cull the instances and pick the LOD of the visible ones on the workers, then draw all of them at once
+    // Models that can't be drawn indirectly are recorded as one draw per instance into the render queue instead
+    void renderCityInstances(Model* model, const std::vector<CityInstance>& instances, const AABBList& instanceBounds);
+
+    // Draw every instance of a model with one glMultiDrawElementsIndirect call per material, instances are grouped by LOD
+    // The model has to be in the geometry arena
+    void renderModelIndirect(Model* model, const ArenaVector<ArenaVector<GLuint>>& instances);
+
     // These include the elements that will be render in the scene, can define multiple ones
     // Render a default PCG City/Whatever definition you have for the function
     void renderPCGElements();
@@ -189,8 +363,16 @@ public:
     void renderScene();
 
     // Anaglyph Rendering
+    // Matrices of both eyes for the Toed-In or Asymmetric Frustum method, the first eye goes to the red channel
+    void calculateEyeMatrices(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+                              glm::mat4* projectionMatrices, glm::mat4* viewMatrices);
+
+    // One color masked pass per eye
     void calculateAnaglyph(glm::mat4& projectionMatrix, glm::mat4& viewMatrix);
 
+    // Both eyes in one pass into the stereo target, merged into the window afterwards
+    void calculateStereo(glm::mat4& projectionMatrix, glm::mat4& viewMatrix);
+
     // General Elements of a render pass===============================================================================
     // This includes setting up the Skyboxes and various components initially
     void generalElements(glm::mat4& projectionMatrix, glm::mat4& viewMatrix);
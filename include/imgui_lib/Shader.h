@@ -8,6 +8,9 @@
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
 #include "Utilities.h"
 
 // To directly pass various lights into the shader
@@ -24,6 +27,12 @@ private:
             uniformEyePosition,
             uniformSpecularIntensity, uniformShininess, uniformMetalness;
 
+    // Model matrices come from the InstanceTransforms buffer instead of the model uniform
+    GLuint uniformIsIndirect;
+
+    // Light list of the object when it isn't drawn indirectly - See InstanceLights.h
+    GLuint uniformLightInstance;
+
     // Creating instance of struct - uniformDirectionalLight
     struct {
         GLuint uniformColour;
@@ -92,6 +101,8 @@ public:
     GLuint getProjectionLocation();
     GLuint getModelLocation();
     GLuint getViewLocation();
+    GLuint getIsIndirectLocation();
+    GLuint getLightInstanceLocation();
     GLuint getAmbientIntensityLocation();
     GLuint getAmbientColourLocation();
     GLuint getDiffuseIntensityLocation();
@@ -16,6 +16,7 @@
 #include "Utilities.h"
 #include "Mesh.h"
 #include "Shader.h"
+#include "TextureCooker.h"
 
 class Skybox {
 private:
@@ -26,6 +27,9 @@ private:
     GLuint textureID;
     GLuint uniformProjection, uniformView;
 
+    // Upload the cooked .ktx2 of every face into the bound cube map, false if any face isn't cooked or they don't match
+    bool loadCookedFaces(const std::vector<std::string>& faceLocations);
+
 public:
     // Constructor
     Skybox();
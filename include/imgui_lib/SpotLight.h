@@ -27,6 +27,9 @@ public:
                     GLuint constantLocation, GLuint linearLocation, GLuint exponentLocation,
                     GLuint edgeLocation  );
 
+    // Same values as useLight, written into the clustered light buffer
+    void fillBlock(ClusterLightBlock& block) const;
+
     void setFlash(glm::vec3 pos, glm::vec3 dir);
 
     void toggle() { isOn = !isOn; }
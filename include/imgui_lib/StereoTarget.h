@@ -0,0 +1,70 @@
+#pragma once
+
+#include <iostream>
+#include <filesystem>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// Custom Libraries
+#include "Shader.h"
+#include "Utilities.h"
+#include "GLStateCache.h"
+
+/*
+Render target of single pass stereo - Both eyes side by side in one framebuffer twice as wide as the window.
+The scene is traversed and submitted once, every draw is instanced once per eye and BRDF_Normals.vert moves each
+instance into its half. composite() merges the halves into the default framebuffer, red from the left eye and
+green/blue from the right one, same as the two color masked passes of the anaglyph.
+*/
+class StereoTarget {
+private:
+    GLuint FBO, colorTexture, depthBuffer;
+
+    // The composite triangle is generated in the shader, but the core profile still needs a vertex array bound
+    GLuint emptyVAO;
+
+    // Size of a single eye, the target is twice as wide
+    GLsizei eyeWidth, eyeHeight;
+
+    Shader compositeShader;
+
+    // (Re)allocate the attachments for the current eye size
+    void createBuffers();
+    void cleanBuffers();
+
+public:
+    // Constructor
+    StereoTarget();
+
+    // Load the composite shader, the attachments are only created once the size is known
+    void createTarget(const std::filesystem::path& currentSourceDir);
+
+    // Bind and clear with the current clear color, re-created first if the window changed size
+    // The viewport covers both eyes
+    void bindTarget(GLsizei width, GLsizei height);
+
+    // Viewport of a single eye (0 - Left, 1 - Right), for what can't be drawn for both eyes at once (Skybox)
+    void setEyeViewport(int eye);
+
+    // Viewport of both eyes
+    void setTargetViewport();
+
+    // Back to the default framebuffer and merge both eyes into it, the viewport is set to the window again
+    void composite();
+
+    // Getters=========================================================================================================
+    GLuint getFramebuffer() const { return FBO; }
+    GLsizei getEyeWidth() const { return eyeWidth; }
+    GLsizei getEyeHeight() const { return eyeHeight; }
+
+    // Not copyable, the framebuffer is owned by a single target
+    StereoTarget(const StereoTarget&) = delete;
+    StereoTarget& operator=(const StereoTarget&) = delete;
+
+    // Clear the framebuffer from the Graphics Card
+    void cleanTarget();
+
+    // Destructor
+    ~StereoTarget();
+};
@@ -3,8 +3,23 @@
 // Always include GLFW after GLAD - Core Libraries
 #include <glad.h>
 
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
 #include "Utilities.h"
 
+// Files decoded and uploaded in the background
+#include "TextureStreamer.h"
+
+// Block compressed KTX2 files
+#include "TextureCooker.h"
+
+// Levels built on the CPU instead of glGenerateMipmap
+#include "MipChain.h"
+
+#include <chrono>
+#include <random>
+
 class Texture {
 private:
     GLuint textureID;
@@ -12,6 +27,16 @@ private:
 
     const char* filePath;
 
+    // Streamer of the texture and the id of its request, nullptr for textures loaded in one go
+    TextureStreamer* streamer;
+    uint64_t streamID;
+
+    // Upload the cooked .ktx2 next to the file (Or the file itself) if there is one, every level is compressed already
+    bool loadCookedTexture();
+
+    // Allocate levelCount levels and upload them from the chain, bound texture
+    void uploadMipChain(const MipChain& mips, GLuint levelCount);
+
     // Function to generate noise
     unsigned char* generateNoise();
 
@@ -27,6 +52,9 @@ public:
     bool loadTexture();
     bool loadTexture(int choice);
 
+    // Allocate every level and show the placeholder colour until the streamer uploads the file, only the header is read here
+    bool loadTextureStreamed(TextureStreamer* textureStreamer, const glm::u8vec4& placeholder = glm::u8vec4(255));
+
     // For supporting multiple textures in one shader
     void useTexture();
     void useTexture(int textureUnit);
@@ -36,6 +64,9 @@ public:
     // Noise
     bool generateRandomTexture(GLuint w, GLuint h, GLuint d);
 
+    // Every filter of MipChain on a size x size image, and its upload against glGenerateMipmap - Needs a context
+    static void benchmarkMipChain(int size, int iterations = 5);
+
     // Destructor
     ~Texture();
 };
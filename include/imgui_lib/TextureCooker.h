@@ -0,0 +1,111 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <filesystem>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Custom Libraries
+#include "Utilities.h"
+#include "JobSystem.h"
+
+// Levels filtered before they are compressed
+#include "MipChain.h"
+
+// S3TC isn't core, every desktop driver exposes it through EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Block compressed formats written by the cooker
+enum CookFormat {
+    // Opaque colour, 8 bytes per 4x4 block
+    COOK_FORMAT_BC1,
+    // Colour with alpha, 16 bytes per block
+    COOK_FORMAT_BC3,
+    // Two channel normal maps (x, y), z is rebuilt by the shader - 16 bytes per block
+    COOK_FORMAT_BC5
+};
+
+// What cooking a file took and saved
+struct CookStats {
+    int width, height;
+    GLuint levelCount;
+    CookFormat format;
+
+    // RGBA8 with mips as the driver would allocate it, and the compressed levels
+    size_t rawBytes, cookedBytes;
+
+    double mipTime, encodeTime;
+
+    // Texels of every level over the encode time
+    double megapixelsPerSecond;
+};
+
+// A KTX2 file read back for uploading, the levels point into data
+struct KTX2Image {
+    GLuint vkFormat;
+    int width, height;
+    GLuint faceCount, levelCount;
+
+    std::vector<unsigned char> data;
+
+    // Level 0 first, the faces of a level follow each other
+    std::vector<size_t> levelOffsets, levelSizes;
+
+    // Matching compressed GL format, 0 if the cooker doesn't write it
+    GLenum getGLFormat() const;
+};
+
+/*
+Offline texture cooker - Decodes an image, builds its mips with MipChain (Kaiser filtered, on the job system) and block compresses every level with stb_dxt into a
+KTX2 file (No supercompression), so the renderer uploads the compressed levels directly instead of RGBA8 plus driver mips.
+Normal maps go to BC5, images with alpha to BC3 and everything else to BC1, the content is guessed from the file name.
+Colour maps are written as sRGB formats, since their levels are stored with the sRGB curve, but they are uploaded as UNORM
+since the shaders use the texels as they are (Like the RGB8 uploads) - Only their mips are averaged in linear light.
+Rows of blocks are split over the job system. No GL calls, the cooker runs headless from main.cpp.
+*/
+class TextureCooker {
+private:
+    // Every 4x4 block of a RGBA8 level, edge blocks repeat the last row and column
+    static void compressLevel(const unsigned char* pixels, int width, int height, CookFormat format,
+                              unsigned char* blocks, JobSystem* jobSystem);
+
+    // Colour is declared as sRGB (vkFormat and transfer), data and normal maps as UNORM and linear
+    static bool writeKTX2(const std::string& path, CookFormat format, bool isSRGB, int width, int height,
+                          const std::vector<std::vector<unsigned char>>& levels);
+
+public:
+    // Format of a file, from its content and alpha
+    static CookFormat chooseFormat(MipContent content, bool hasAlpha);
+
+    static size_t getBlockBytes(CookFormat format) { return format == COOK_FORMAT_BC1 ? 8 : 16; }
+
+    // The .ktx2 next to an image, the path itself for .ktx2 files
+    static std::string getCookedPath(const std::string& path);
+
+    // Cook a single image into destination
+    static bool cookFile(const std::string& source, const std::string& destination, JobSystem* jobSystem, CookStats& stats);
+
+    // Cook every image of the paths (Directories are walked recursively) next to the source, and print what it saved
+    static void cookFiles(const std::vector<std::string>& paths);
+
+    // Read a file written by the cooker
+    static bool loadKTX2(const std::string& path, KTX2Image& image);
+};
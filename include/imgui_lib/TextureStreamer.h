@@ -0,0 +1,169 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Skips binds that wouldn't change anything
+#include "GLStateCache.h"
+
+// TEXTURE_STREAM_* and stb_image
+#include "Utilities.h"
+
+// Levels of the decoded files, filtered on the workers
+#include "MipChain.h"
+
+// Where a streamed texture is at, shown in the UI
+enum TextureResidencyState {
+    // Only the placeholder is resident, the file is still waiting for a worker
+    TEXTURE_DECODING,
+    // The mip tail is resident, bigger levels are being uploaded
+    TEXTURE_STREAMING,
+    // Every level is resident
+    TEXTURE_RESIDENT,
+    // Decoding failed, the placeholder stays
+    TEXTURE_FAILED
+};
+
+struct TextureResidency {
+    std::string path;
+    GLuint textureID;
+    int width, height;
+    GLuint levelCount;
+
+    // Finest level the texture samples from - GL_TEXTURE_BASE_LEVEL
+    GLuint residentLevel;
+    TextureResidencyState state;
+};
+
+/*
+Streaming texture loader - The texture gets storage for every level and a 1x1 placeholder right away (See
+Texture::loadTextureStreamed), so materials can use it on the first frame. Worker threads decode the file and build its
+mips, then update() uploads the mip tail (Levels up to TEXTURE_STREAM_TAIL_SIZE) at once and the bigger levels a few rows
+at a time through a persistently mapped pixel buffer, under a budget of bytes per frame.
+The base level of the texture follows the finest level that is complete, so it only gets sharper.
+Coarser levels go first across all the textures, so everything sharpens at the same pace.
+The pixel buffer is a ring of TEXTURE_STREAM_FRAMES regions, a region is skipped (Instead of waited on) while the GPU is
+still copying from it.
+Workers never make GL calls, everything GL happens in update() on the main thread.
+*/
+class TextureStreamer {
+private:
+    struct DecodeRequest {
+        uint64_t id;
+        std::string path;
+        int width, height;
+        GLuint levelCount;
+    };
+
+    // Every level of a decoded file as RGBA8
+    struct DecodedTexture {
+        uint64_t id;
+        MipChain mips;
+        bool isFailed;
+    };
+
+    // Main thread side of a texture
+    struct StreamEntry {
+        uint64_t id;
+        TextureResidency residency;
+        DecodedTexture decoded;
+
+        // Next level to upload and the rows of it already uploaded
+        GLint uploadLevel;
+        GLint uploadRow;
+    };
+
+    // Workers and their queues - Requests go in, decoded files come out
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable requestCondition;
+    std::deque<DecodeRequest> requests;
+    std::vector<DecodedTexture> decodedTextures;
+    bool isStopping;
+
+    // Decoded files taken from the workers this frame, swapped with decodedTextures so neither allocates once warmed up
+    std::vector<DecodedTexture> readyTextures;
+
+    std::vector<StreamEntry> entries;
+    uint64_t nextID;
+
+    // Persistently mapped ring, TEXTURE_STREAM_MAX_BUDGET bytes per region
+    GLuint uploadBuffer;
+    unsigned char* uploadMemory;
+    GLsync uploadFences[TEXTURE_STREAM_FRAMES];
+    GLuint uploadRegion;
+
+    size_t uploadBudget;
+
+    // Stats of the last update
+    size_t uploadedBytes, pendingBytes;
+    unsigned int decodingCount, streamingCount, residentCount;
+    double updateTime;
+
+    void workerLoop();
+
+    // Every level of the tail straight from the decoded pixels
+    void uploadTail(StreamEntry& entry);
+
+    // Rows of the current level of the entry through the ring, returns the bytes used
+    size_t uploadRows(StreamEntry& entry, size_t regionOffset, size_t budget);
+
+    void setResidentLevel(StreamEntry& entry, GLuint level);
+
+    StreamEntry* findEntry(uint64_t id);
+
+public:
+    // Constructor
+    TextureStreamer();
+
+    // Start the workers and map the upload ring
+    void createStreamer(size_t workerCount = TEXTURE_STREAM_WORKERS);
+
+    // Queue the file of a texture whose storage is already allocated, returns the id used to cancel it
+    uint64_t requestTexture(GLuint textureID, const std::string& path, int width, int height, GLuint levelCount);
+
+    // Forget a texture, called before it's deleted
+    void cancelTexture(uint64_t id);
+
+    // Take the decoded files and upload as much as the budget allows, once per frame
+    void update();
+
+    // Bytes per frame, clamped to the size of a region of the ring
+    void setUploadBudget(size_t bytes);
+
+    // Getters=========================================================================================================
+    size_t getTextureCount() const { return entries.size(); }
+    const TextureResidency& getResidency(size_t index) const { return entries[index].residency; }
+
+    size_t getUploadBudget() const { return uploadBudget; }
+    size_t getUploadedBytes() const { return uploadedBytes; }
+    size_t getPendingBytes() const { return pendingBytes; }
+    unsigned int getDecodingCount() const { return decodingCount; }
+    unsigned int getStreamingCount() const { return streamingCount; }
+    unsigned int getResidentCount() const { return residentCount; }
+    double getUpdateTime() const { return updateTime; }
+
+    // Not copyable, the workers point to this object
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Join the workers and release the ring
+    void stopStreamer();
+
+    // Destructor
+    ~TextureStreamer();
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Custom Libraries
+#include "Utilities.h"
+#include "JobSystem.h"
+
+// Stable name of a node, its position in the arrays changes when the hierarchy is sorted again
+typedef GLuint TransformHandle;
+const TransformHandle INVALID_TRANSFORM = 0xFFFFFFFF;
+
+/*
+Flat transform hierarchy - Local TRS and world matrices of every node in separate arrays (Structure of arrays), sorted by
+depth so every parent comes before its children. update() is a single pass over the arrays instead of a recursion over
+pointers, and only nodes whose local transform changed (Or one of their parents) get their world matrix computed again.
+The nodes of a depth level don't depend on each other, so big levels are split over the job system.
+Nodes can't be removed, and a node can't be parented to one of its own children.
+*/
+class TransformSystem {
+private:
+    // Indexed in depth order
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> worldMatrices;
+
+    // Index of the parent, INVALID_TRANSFORM for roots
+    std::vector<GLuint> parents;
+
+    // Local transform changed since the last update, world matrix recomputed by the last update
+    std::vector<unsigned char> dirty;
+    std::vector<unsigned char> changed;
+
+    // Handles of the parents (Survive sorting), and the mapping between handles and indices
+    std::vector<TransformHandle> parentHandles;
+    std::vector<GLuint> handleToIndex;
+    std::vector<TransformHandle> indexToHandle;
+
+    // First node of every depth level, plus the end of the last one
+    std::vector<size_t> levelStarts;
+
+    // A parent changed, the arrays have to be sorted before the next update
+    bool isOrderDirty;
+
+    // Stats - World matrices computed by the last update
+    size_t updatedCount;
+
+    // Sort the arrays by depth, breadth first so the children of a level are in the order of their parents
+    void sortByDepth();
+
+    // Compute the world matrices of the dirty nodes of [begin, end), their parents have to be up to date
+    size_t updateRange(size_t begin, size_t end);
+
+public:
+    // Constructor
+    TransformSystem();
+
+    // Reserve space for nodeCount nodes, so creating them doesn't move the arrays
+    void reserve(size_t nodeCount);
+
+    // Add a node under parent (INVALID_TRANSFORM for a root), it is computed by the next update
+    TransformHandle createNode(TransformHandle parent = INVALID_TRANSFORM, const glm::vec3& position = glm::vec3(0.0f),
+                               const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+    // Move a node (And its children) under another parent
+    void setParent(TransformHandle node, TransformHandle parent);
+
+    // Local transform setters, mark the node dirty
+    void setLocalTransform(TransformHandle node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    void setPosition(TransformHandle node, const glm::vec3& position);
+    void setRotation(TransformHandle node, const glm::quat& rotation);
+    void setScale(TransformHandle node, const glm::vec3& scale);
+
+    // Compute the world matrices of the dirty nodes and their children, on the job system if one is given
+    void update(JobSystem* jobSystem = nullptr);
+
+    // Getters=========================================================================================================
+    // Valid until the next createNode/setParent, so it can be handed to the render queue for the frame
+    const glm::mat4& getWorldMatrix(TransformHandle node) const { return worldMatrices[handleToIndex[node]]; }
+
+    const glm::vec3& getPosition(TransformHandle node) const { return positions[handleToIndex[node]]; }
+    const glm::quat& getRotation(TransformHandle node) const { return rotations[handleToIndex[node]]; }
+    const glm::vec3& getScale(TransformHandle node) const { return scales[handleToIndex[node]]; }
+
+    // World matrix was recomputed by the last update
+    bool isChanged(TransformHandle node) const { return changed[handleToIndex[node]] != 0; }
+
+    size_t getNodeCount() const { return positions.size(); }
+    size_t getLevelCount() const { return levelStarts.empty() ? 0 : levelStarts.size() - 1; }
+    size_t getUpdatedCount() const { return updatedCount; }
+
+    // Headless benchmark - Random hierarchy of nodeCount nodes, updated with everything, a few and nothing dirty
+    static void benchmarkUpdate(size_t nodeCount, int iterations = 20);
+
+    // Destructor
+    ~TransformSystem();
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Always include GLFW after GLAD - Core Libraries
+#include <glad.h>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+#include "Utilities.h"
+
+// Binding points are shared by every program, so binds go through the state cache
+#include "GLStateCache.h"
+
+// Uniform Blocks======================================================================================================
+// Binding points, same as the layout(binding = ...) of the blocks in BRDF_Normals.vert/.frag
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint LIGHTS_BLOCK_BINDING = 1;
+const GLuint SETTINGS_BLOCK_BINDING = 2;
+const GLuint MATERIAL_BLOCK_BINDING = 3;
+
+/*
+C++ copies of the std140 blocks, the padding members make the offsets match the GLSL side.
+std140 - vec3 is aligned to 16 bytes but only takes 12, structs and array elements are padded to a multiple of 16.
+*/
+struct LightBlock {
+    glm::vec3 colour;
+    GLfloat ambientIntensity;
+    GLfloat diffuseIntensity;
+    GLfloat padding[3];
+};
+
+struct DirectionalLightBlock {
+    LightBlock base;
+    glm::vec3 direction;
+    GLfloat padding;
+};
+
+// Changes with every pass, one entry per view (Both eyes in single pass stereo, only the first one otherwise)
+struct CameraBlock {
+    glm::mat4 projection[MAX_VIEWS];
+    glm::mat4 view[MAX_VIEWS];
+    glm::vec4 eyePosition[MAX_VIEWS];
+    GLint viewCount;
+    GLint padding[3];
+};
+
+// Point and spot lights are in the clustered light buffers, this only has what is needed to find the cluster of a fragment
+struct LightsBlock {
+    DirectionalLightBlock directionalLight;
+
+    // Clusters along x, y and z, and the number of lights in the buffer
+    glm::ivec4 clusterCount;
+
+    // Slice of a view depth - log(depth) * x + y
+    glm::vec4 clusterDepth;
+};
+
+// Toggles from the UI, bools are 4 bytes in std140
+struct SettingsBlock {
+    glm::vec4 objectColor;
+    glm::vec4 wireframeColor;
+    glm::vec3 backgroundColor;
+    GLint shadingModel;
+
+    GLint materialPreview;
+    GLint specularPreview;
+    GLint normalPreview;
+    GLint isWireframe;
+    GLint isShaded;
+    GLint envMapping;
+    GLint skybox;
+    GLint reflection;
+    GLint refraction;
+
+    GLfloat ior;
+    GLfloat reflectance;
+    GLfloat dispersion;
+    GLfloat normalStrength;
+    GLfloat specularStrength;
+
+    // Objects with a light list loop over it instead of the lights of their cluster
+    GLint isInstanceLights;
+    GLfloat padding;
+};
+
+// Parameters of a material, one buffer per MaterialGroup
+struct MaterialBlock {
+    GLfloat specularIntensity;
+    GLfloat shininess;
+    GLfloat metalness;
+    GLfloat padding;
+};
+
+static_assert(sizeof(DirectionalLightBlock) == 48, "std140 light layout");
+static_assert(offsetof(LightsBlock, clusterCount) == 48 && sizeof(LightsBlock) == 80, "std140 LightsBlock layout");
+static_assert(offsetof(CameraBlock, viewCount) == 288 && sizeof(CameraBlock) == 304, "std140 CameraBlock layout");
+static_assert(offsetof(SettingsBlock, ior) == 84 && offsetof(SettingsBlock, isInstanceLights) == 104 && sizeof(SettingsBlock) == 112,
+              "std140 SettingsBlock layout");
+static_assert(sizeof(MaterialBlock) == 16, "std140 MaterialBlock layout");
+
+// Shader Storage Blocks===============================================================================================
+// Point and spot lights of the ClusterLights buffer (std430) - A vec3 followed by a float takes 16 bytes
+// Point lights are spot lights with an edge below -1, so every fragment in range is inside the cone
+const GLfloat POINT_LIGHT_EDGE = -2.0f;
+
+struct ClusterLightBlock {
+    glm::vec3 position;
+    GLfloat range;
+    glm::vec3 colour;
+    GLfloat ambientIntensity;
+    glm::vec3 direction;
+    GLfloat edge;
+    GLfloat diffuseIntensity;
+    GLfloat constant;
+    GLfloat linear;
+    GLfloat exponent;
+};
+
+static_assert(offsetof(ClusterLightBlock, diffuseIntensity) == 48 && sizeof(ClusterLightBlock) == 64, "std430 ClusterLightBlock layout");
+
+/*
+Uniform buffer bound to a fixed binding point, with a CPU copy of what was uploaded last.
+updateBuffer only touches the GPU if the contents changed, so blocks that stay the same cost nothing per frame.
+*/
+class UniformBuffer {
+private:
+    GLuint UBO;
+    GLuint bindingPoint;
+    GLsizeiptr size;
+
+    // Contents of the buffer on the GPU
+    std::vector<unsigned char> uploadedData;
+
+    // Number of times the buffer was actually uploaded
+    size_t uploadCount;
+
+public:
+    // Constructor
+    UniformBuffer();
+
+    // Allocate the buffer and bind it to binding
+    void createBuffer(GLsizeiptr bufferSize, GLuint binding);
+
+    // Bind the buffer to its binding point again, for blocks that several buffers take turns on
+    void bindBuffer();
+
+    // Upload data (bufferSize bytes) if it differs from the last upload, returns true if it was uploaded
+    bool updateBuffer(const void* data);
+
+    // Getters=========================================================================================================
+    size_t getUploadCount() const { return uploadCount; }
+
+    // Not copyable, the buffer is owned by a single object
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Clear the buffer from the Graphics Card
+    void cleanBuffer();
+
+    // Destructor
+    ~UniformBuffer();
+};
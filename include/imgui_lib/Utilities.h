@@ -25,6 +25,65 @@ const int MAX_SPOT_LIGHTS = 3;
 const int MAX_SHADING_MODELS = 4;
 const int DEFAULT_SKYBOXES = 6;
 
+// Views drawn by a single pass - Both eyes in single pass stereo, same as MAX_VIEWS of BRDF_Normals.vert/.frag
+const int MAX_VIEWS = 2;
+
+// Size of the shared geometry arena (In vertices and indices)
+const int MAX_ARENA_VERTICES = 1 << 19;
+const int MAX_ARENA_INDICES = 3 << 19;
+
+// Level of detail - Each level keeps LOD_REDUCTION of the triangles of the previous one
+const int MAX_LOD_LEVELS = 4;
+const float LOD_REDUCTION = 0.5f;
+
+// Switching to a coarser LOD only when its error is this much below the threshold, prevents popping
+const float LOD_HYSTERESIS = 0.25f;
+
+// City benchmark - Grid sizes measured, and frames skipped/measured for each of them
+const int CITY_BENCHMARK_GRIDS[] = { 20, 200, 2000 };
+const int CITY_BENCHMARK_GRID_COUNT = 3;
+const int CITY_BENCHMARK_WARMUP = 10;
+const int CITY_BENCHMARK_FRAMES = 120;
+
+// City instances handled by one thread at least, smaller cities aren't worth splitting
+const int CITY_PARTITION_MIN_INSTANCES = 512;
+
+// Nodes of a transform hierarchy level handled by one thread at least
+const size_t TRANSFORM_PARTITION_MIN_NODES = 4096;
+
+// Clustered lighting - Screen tiles along x and y, exponential depth slices along z
+const int LIGHT_CLUSTERS_X = 16;
+const int LIGHT_CLUSTERS_Y = 9;
+const int LIGHT_CLUSTERS_Z = 24;
+
+// Point and spot lights end where they add less than this, the shader fades them out before it
+const float LIGHT_ATTENUATION_CUTOFF = 1.0f / 256.0f;
+
+// Range of the lights that never fade out (No linear or exponent attenuation)
+const float LIGHT_MAX_RANGE = 1000.0f;
+
+// Instances whose lights are gathered by one thread at least
+const size_t INSTANCE_LIGHTS_PARTITION_MIN = 256;
+
+// Cells of the light grid along x and z at most, cells get bigger than the largest range past it
+const int INSTANCE_LIGHTS_MAX_GRID = 256;
+
+// Levels of a streamed texture this size or smaller (Largest side) are uploaded as soon as the file is decoded
+const int TEXTURE_STREAM_TAIL_SIZE = 64;
+
+// Texture bytes uploaded per frame by default, and at most - The most is the size of a region of the upload ring
+const size_t TEXTURE_STREAM_BUDGET = 4 << 20;
+const size_t TEXTURE_STREAM_MAX_BUDGET = 8 << 20;
+
+// Regions of the upload ring, a region is only written again once the GPU is done copying from it
+const int TEXTURE_STREAM_FRAMES = 3;
+
+// Threads decoding the files and building their mips
+const size_t TEXTURE_STREAM_WORKERS = 2;
+
+// Texels of a mip level built by one thread at least, smaller levels aren't worth splitting
+const size_t MIP_PARTITION_MIN_TEXELS = 128 * 128;
+
 // Averaging Normals for Phong Shading
 void calcAverageNormals(unsigned int* indices, unsigned int indexCount, GLfloat* vertices, unsigned int vertexCount, unsigned int vLength, unsigned int normalOffset);
 
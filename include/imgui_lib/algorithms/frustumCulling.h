@@ -0,0 +1,64 @@
+#pragma once
+
+// Frustum culling of axis aligned bounding boxes, 8 boxes at a time
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Custom libraries
+#include "MathFuncs.h"
+
+// Number of boxes tested per iteration, the lists are padded to a multiple of this
+const size_t CULLING_BATCH_SIZE = 8;
+
+/*
+Bounding boxes stored as structure of arrays, so that one load fetches the same coordinate of 8 boxes.
+The padding at the end holds empty boxes at the origin, their results are never read.
+*/
+struct AABBList {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+    size_t count = 0;
+
+    void clear();
+    void addBox(const AABB& box);
+
+    // Number of boxes including the padding
+    size_t getPaddedCount() const { return minX.size(); }
+
+    AABB getBox(size_t i) const { return { glm::vec3(minX[i], minY[i], minZ[i]), glm::vec3(maxX[i], maxY[i], maxZ[i]) }; }
+};
+
+// Results of a culling pass
+struct CullingStats {
+    unsigned int tested = 0;
+    unsigned int culled = 0;
+
+    // Inside the frustum but behind the occluders
+    unsigned int occluded = 0;
+};
+
+// Box around the transformed box (Arvo's method)
+AABB transformAABB(const AABB& box, const glm::mat4& transform);
+
+// Scalar version, for a single box
+bool isAABBInFrustum(const Frustum& frustum, const AABB& box);
+
+/*
+Test every box against the frustum, visible[i] is 1 if box i is at least partially inside.
+Uses AVX when the CPU has it (Checked once at runtime), two SSE halves per batch otherwise.
+Conservative - Boxes crossing the corners of the frustum outside of it are kept.
+*/
+void cullAABBs(const Frustum& frustum, const AABBList& boxes, std::vector<unsigned char>& visible, CullingStats& stats);
+
+// Same for the boxes [first, first + count) only, so ranges can be culled on different threads
+// first has to be a multiple of CULLING_BATCH_SIZE and visible already sized to boxes.getPaddedCount()
+void cullAABBs(const Frustum& frustum, const AABBList& boxes, size_t first, size_t count, std::vector<unsigned char>& visible, CullingStats& stats);
+
+// Same for several frustums at once, a box is visible if it is at least partially inside any of them (Both eyes in stereo)
+void cullAABBs(const Frustum* frustums, size_t frustumCount, const AABBList& boxes, size_t first, size_t count,
+               std::vector<unsigned char>& visible, CullingStats& stats);
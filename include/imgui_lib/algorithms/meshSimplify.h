@@ -0,0 +1,28 @@
+#pragma once
+
+// Quadric error mesh simplification, used for generating the LOD chain of a model at import
+// Reference : Garland and Heckbert, Surface Simplification Using Quadric Error Metrics (1997)
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+/*
+Collapse edges of the mesh until only targetIndexCount indices are left, or until collapsing any more edges would move the
+surface by more than maxError. Vertices are never moved, an edge is collapsed into one of its end points, so the simplified
+indices still reference the original vertex buffer.
+Vertices on open borders and on attribute seams (Same position, different UV/Normal) are locked to prevent holes in the mesh.
+
+vertices        - Interleaved vertex data, the position has to be the first 3 floats
+vertexLength    - Number of floats per vertex
+Returns the error of the result, i.e. the distance the surface moved in object space
+*/
+float simplifyMesh(const std::vector<float>& vertices, unsigned int vertexLength, const std::vector<unsigned int>& indices,
+                   size_t targetIndexCount, float maxError, std::vector<unsigned int>& result);
+
+// Remove the vertices which are not referenced by the indices, remapping the indices to the new vertex buffer
+void compactVertices(const std::vector<float>& vertices, unsigned int vertexLength, std::vector<unsigned int>& indices,
+                     std::vector<float>& result);
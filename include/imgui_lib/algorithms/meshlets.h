@@ -0,0 +1,56 @@
+#pragma once
+
+// Splitting meshes into small clusters (meshlets) that can be culled on their own
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+
+// Custom libraries
+#include "MathFuncs.h"
+
+// Cluster size limits
+const unsigned int MESHLET_MAX_VERTICES = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+// Meshes with fewer triangles than this many full clusters are drawn in one go
+const unsigned int MESHLET_MIN_CLUSTERS = 4;
+
+// A cluster of triangles, stored as a contiguous range in the index buffer
+struct Meshlet {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+
+    // Bounding sphere
+    glm::vec3 center;
+    float radius;
+
+    // Normal cone - The cluster is back facing if dot(normalize(center - eye), coneAxis) >= coneCutoff (Plus the radius)
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+// Results of culling a set of meshlets
+struct ClusterStats {
+    unsigned int clusters = 0;
+    unsigned int triangles = 0;
+    unsigned int frustumCulledClusters = 0;
+    unsigned int frustumCulledTriangles = 0;
+    unsigned int backfaceCulledClusters = 0;
+    unsigned int backfaceCulledTriangles = 0;
+};
+
+/*
+Greedily split the triangles into meshlets, in the order they appear in the index buffer. Since the index buffer is only
+scanned, every meshlet is a contiguous range of the original indices and can be drawn with a single glDrawElements call.
+The position has to be the first 3 floats of each vertex.
+*/
+void buildMeshlets(const std::vector<float>& vertices, unsigned int vertexLength, const std::vector<unsigned int>& indices,
+                   std::vector<Meshlet>& meshlets);
+
+// Frustum and normal cone test for a single meshlet, everything has to be in the same space
+// Returns true if the meshlet has to be drawn, updates the stats
+bool isMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& eyePosition, bool coneCulling, ClusterStats& stats);
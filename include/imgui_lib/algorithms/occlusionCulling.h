@@ -0,0 +1,110 @@
+#pragma once
+
+// Occlusion culling against a small software rasterized depth buffer and its hierarchical-Z pyramid
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// GLM Files - Math Library
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Custom libraries
+#include "MathFuncs.h"
+#include "frustumCulling.h"
+#include "randomDistribute.h"
+
+// Size of the depth buffer, powers of two so every level of the pyramid halves exactly
+// Rows are a multiple of 4 pixels, the rasterizer fills 4 pixels at a time
+const int OCCLUSION_BUFFER_WIDTH = 256;
+const int OCCLUSION_BUFFER_HEIGHT = 128;
+
+// Rows rasterized by one job, the strips don't overlap so they can be drawn on different threads
+const int OCCLUSION_STRIP_HEIGHT = 16;
+
+// Occluders of a frame - The biggest boxes (Radius over distance) above the minimum size are drawn
+const size_t OCCLUSION_MAX_OCCLUDERS = 256;
+const float OCCLUDER_MIN_SIZE = 0.05f;
+
+// Occluder boxes are scaled around their center, the bounds are a bit bigger than the geometry inside
+const float OCCLUDER_SCALE = 0.9f;
+
+// Box that could be drawn as an occluder, list tells apart the box lists of several models
+struct OccluderCandidate {
+    float size;
+    unsigned int list;
+    unsigned int index;
+};
+
+// Add the boxes of [first, first + count) big enough to be occluders seen from the eye, only the ones inside the frustum
+void collectOccluders(const AABBList& boxes, unsigned int list, size_t first, size_t count, const Frustum& frustum,
+                      const glm::vec3& eyePosition, std::vector<OccluderCandidate>& candidates);
+
+// Keep the maxCount biggest candidates
+void selectOccluders(std::vector<OccluderCandidate>& candidates, size_t maxCount = OCCLUSION_MAX_OCCLUDERS);
+
+/*
+Depth buffer of the biggest occluders of the frame, drawn on the CPU so the boxes behind them are culled before anything is
+submitted. Occluders are boxes scaled by OCCLUDER_SCALE (They have to stay inside the real geometry), only their front
+faces are drawn. Depth is NDC z, the buffer keeps the nearest occluder and the pyramid the farthest depth of every 2x2.
+A box is occluded if its nearest corner is behind the farthest depth of every texel it covers.
+Boxes crossing the near plane are never occluders and always visible.
+*/
+class OcclusionBuffer {
+private:
+    // Box projected to the buffer - x and y in pixels, z in NDC
+    struct ScreenBox {
+        glm::vec3 corners[8];
+    };
+
+    glm::mat4 viewProjection;
+    std::vector<ScreenBox> occluders;
+
+    // Level 0 is the depth buffer, every other level halves the previous one
+    std::vector<std::vector<float>> levels;
+
+    // Project the corners of the box, false if any of them is behind the near plane
+    bool projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, ScreenBox& screenBox) const;
+
+    // Draw a triangle into the rows [firstRow, lastRow) only, nothing is drawn if it faces away
+    void rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, int firstRow, int lastRow);
+
+public:
+    // Constructor
+    OcclusionBuffer();
+
+    // Start a new frame, forgetting the occluders of the previous one
+    void begin(const glm::mat4& viewProjectionMatrix);
+
+    // Add a box to draw (Scaled by OCCLUDER_SCALE), returns false if it crosses the near plane
+    bool addOccluder(const AABB& box);
+
+    // Clear the rows of a strip and draw every occluder into them - Strips can be drawn on different threads
+    void rasterizeStrip(int strip);
+
+    // All the strips on this thread
+    void rasterize();
+
+    // Farthest depth of every 2x2 texels, once all the strips are drawn
+    void buildPyramid();
+
+    // Hierarchical-Z test of a single box
+    bool isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    // Test the boxes [first, first + count) that are still visible[i], occluded ones are set to 0 and counted in stats
+    void cullAABBs(const AABBList& boxes, size_t first, size_t count, std::vector<unsigned char>& visible, CullingStats& stats) const;
+
+    // Getters=========================================================================================================
+    size_t getOccluderCount() const { return occluders.size(); }
+    static int getStripCount() { return (OCCLUSION_BUFFER_HEIGHT + OCCLUSION_STRIP_HEIGHT - 1) / OCCLUSION_STRIP_HEIGHT; }
+    const std::vector<float>& getDepth() const { return levels[0]; }
+
+    // Headless benchmark - Cities of random buildings (One box per floor) seen from street level
+    static void benchmarkCity(int gridSize, int views = 32);
+
+    // Destructor
+    ~OcclusionBuffer();
+};
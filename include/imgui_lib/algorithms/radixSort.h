@@ -0,0 +1,20 @@
+#pragma once
+
+// Sorting 64-bit keys in linear time
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Bits sorted per pass at most - 2048 buckets, so both histograms still fit in L1
+const int RADIX_BITS = 11;
+const int RADIX_BUCKETS = 1 << RADIX_BITS;
+
+/*
+LSD radix sort of 64-bit keys by the bits [firstBit, 64), stable. The bits below firstBit are carried along without being
+sorted, so a small payload (e.g. the index of what the key belongs to) can be packed into the low bits.
+scratch is used as the second buffer and resized as needed, keeping both around between calls means sorting doesn't allocate.
+Only the bits that differ between keys are sorted - Each digit gathers the next RADIX_BITS of them (From up to two runs, so
+the gap left by an unused field is skipped), and the pass count is the varying bits over RADIX_BITS.
+*/
+void radixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, int firstBit = 0);
@@ -0,0 +1,96 @@
+#include "CascadedShadowMap.h"
+
+CascadedShadowMap::CascadedShadowMap() : ShadowMap() {
+    cascadeCount = 0;
+}
+
+bool CascadedShadowMap::initCascades(const GLuint* resolutions, GLuint count) {
+    cascadeCount = count < MAX_CASCADES ? count : MAX_CASCADES;
+
+    // Atlas is as tall as the biggest cascade
+    GLuint atlasHeight = 0;
+
+    for(GLuint i = 0; i < cascadeCount; i++) {
+        atlasHeight = resolutions[i] > atlasHeight ? resolutions[i] : atlasHeight;
+    }
+
+    // Column layout - Stacking tiles while they fit in the height and width of the current column
+    GLuint columnX = 0, columnY = 0, columnWidth = 0;
+
+    for(GLuint i = 0; i < cascadeCount; i++) {
+        if(!columnWidth || resolutions[i] > columnWidth || columnY + resolutions[i] > atlasHeight) {
+            columnX += columnWidth;
+            columnY = 0;
+            columnWidth = resolutions[i];
+        }
+
+        tiles[i] = glm::uvec3(columnX, columnY, resolutions[i]);
+        columnY += resolutions[i];
+    }
+
+    shadowWidth = columnX + columnWidth;
+    shadowHeight = atlasHeight;
+
+    glGenFramebuffers(1, &FBO);
+
+    glGenTextures(1, &shadowMap);
+    glState.bindTexture(0, GL_TEXTURE_2D, shadowMap);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, shadowWidth, shadowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    // For zooming out - Minify
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // For zooming in - Magnify
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // The shader keeps the samples inside the tiles, the edges never show
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap, 0);
+
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Frame buffer error : %i\n", status);
+        return false;
+    }
+
+    // One static layer per cascade, all in the same atlas
+    initCache(GL_TEXTURE_2D, cascadeCount);
+
+    return true;
+}
+
+void CascadedShadowMap::writeCascade(GLuint cascade) {
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+
+    // Clearing only touches the tile with the scissor on, the caller turns it off after the pass
+    glViewport(tiles[cascade].x, tiles[cascade].y, tiles[cascade].z, tiles[cascade].z);
+    glScissor(tiles[cascade].x, tiles[cascade].y, tiles[cascade].z, tiles[cascade].z);
+    glEnable(GL_SCISSOR_TEST);
+}
+
+void CascadedShadowMap::storeStatic(GLuint layer) {
+    glCopyImageSubData(shadowMap, GL_TEXTURE_2D, 0, tiles[layer].x, tiles[layer].y, 0,
+                       staticMap, GL_TEXTURE_2D, 0, tiles[layer].x, tiles[layer].y, 0,
+                       tiles[layer].z, tiles[layer].z, 1);
+
+    isStaticDirty[layer] = false;
+}
+
+void CascadedShadowMap::restoreStatic(GLuint layer) {
+    glCopyImageSubData(staticMap, GL_TEXTURE_2D, 0, tiles[layer].x, tiles[layer].y, 0,
+                       shadowMap, GL_TEXTURE_2D, 0, tiles[layer].x, tiles[layer].y, 0,
+                       tiles[layer].z, tiles[layer].z, 1);
+}
+
+glm::vec4 CascadedShadowMap::getCascadeRect(GLuint cascade) const {
+    return glm::vec4(GLfloat(tiles[cascade].x) / shadowWidth, GLfloat(tiles[cascade].y) / shadowHeight,
+                     GLfloat(tiles[cascade].z) / shadowWidth, GLfloat(tiles[cascade].z) / shadowHeight);
+}
+
+CascadedShadowMap::~CascadedShadowMap() {
+}
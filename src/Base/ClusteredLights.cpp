@@ -0,0 +1,339 @@
+#include "ClusteredLights.h"
+
+// SIMD intrinsics - SSE is always there on x64
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Lights the buffer has room for before it has to grow
+const size_t CLUSTER_INITIAL_LIGHTS = 64;
+
+const size_t CLUSTERS_PER_SLICE = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+const size_t CLUSTER_COUNT = CLUSTERS_PER_SLICE * LIGHT_CLUSTERS_Z;
+
+// 4 spheres against a box, bit i is set if sphere i touches it - Squared distance from the center to the box
+static int sphereBoxMask(const float* x, const float* y, const float* z, const float* radius,
+                         const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    __m128 centerX = _mm_loadu_ps(x);
+    __m128 centerY = _mm_loadu_ps(y);
+    __m128 centerZ = _mm_loadu_ps(z);
+    __m128 radius4 = _mm_loadu_ps(radius);
+    __m128 zero = _mm_setzero_ps();
+
+    // Distance along every axis, 0 inside the box
+    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.x), centerX), _mm_sub_ps(centerX, _mm_set1_ps(boxMax.x))), zero);
+    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.y), centerY), _mm_sub_ps(centerY, _mm_set1_ps(boxMax.y))), zero);
+    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.z), centerZ), _mm_sub_ps(centerZ, _mm_set1_ps(boxMax.z))), zero);
+
+    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+    return _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(radius4, radius4)));
+}
+
+// Distance from the center to the side of the cone against the radius, and both caps along the axis
+bool isConeInSphere(const glm::vec3& apex, const glm::vec3& direction, float cosine, float range,
+                    const glm::vec3& center, float radius) {
+    glm::vec3 toCenter = center - apex;
+    float distanceSquared = glm::dot(toCenter, toCenter);
+    float alongAxis = glm::dot(toCenter, direction);
+    float sine = glm::sqrt(glm::max(1.0f - cosine * cosine, 0.0f));
+
+    float coneDistance = cosine * glm::sqrt(glm::max(distanceSquared - alongAxis * alongAxis, 0.0f)) - alongAxis * sine;
+
+    return !(coneDistance > radius || alongAxis > radius + range || alongAxis < -radius);
+}
+
+// Constructor
+ClusteredLights::ClusteredLights() {
+    clusterProjection = glm::mat4(0.0f);
+
+    depthScale = 0.0f;
+    depthBias = 0.0f;
+
+    lightsBuffer = 0;
+    gridBuffer = 0;
+    indicesBuffer = 0;
+
+    lightsCapacity = 0;
+    gridCapacity = 0;
+    indicesCapacity = 0;
+
+    maxClusterLights = 0;
+    assignTime = 0.0;
+}
+
+void ClusteredLights::createBuffers() {
+    // A handful of lights and one light per cluster, grown by updateBuffer if needed
+    lightsCapacity = sizeof(ClusterLightBlock) * CLUSTER_INITIAL_LIGHTS;
+    gridCapacity = sizeof(glm::uvec2) * CLUSTER_COUNT;
+    indicesCapacity = sizeof(GLuint) * CLUSTER_COUNT;
+
+    glGenBuffers(1, &lightsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, lightsCapacity, nullptr, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &gridBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gridBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, gridCapacity, nullptr, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &indicesBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indicesBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, indicesCapacity, nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHTS_BINDING, lightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_GRID_BINDING, gridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDICES_BINDING, indicesBuffer);
+}
+
+void ClusteredLights::clearLights() {
+    lights.clear();
+}
+
+GLint ClusteredLights::addLight(const ClusterLightBlock& light) {
+    lights.push_back(light);
+
+    return static_cast<GLint>(lights.size() - 1);
+}
+
+void ClusteredLights::buildClusterBounds(const glm::mat4& projection, GLfloat nearPlane, GLfloat farPlane) {
+    clusterProjection = projection;
+
+    boundsMin.resize(CLUSTER_COUNT);
+    boundsMax.resize(CLUSTER_COUNT);
+
+    glm::mat4 inverseProjection = glm::inverse(projection);
+
+    for(int z = 0; z < LIGHT_CLUSTERS_Z; z++) {
+        sliceMin[z] = glm::vec3(std::numeric_limits<float>::max());
+        sliceMax[z] = glm::vec3(-std::numeric_limits<float>::max());
+    }
+
+    for(int y = 0; y < LIGHT_CLUSTERS_Y; y++) {
+        for(int x = 0; x < LIGHT_CLUSTERS_X; x++) {
+            // Rays from the eye through the corners of the tile, scaled to a depth of 1
+            glm::vec3 rays[4];
+
+            for(int corner = 0; corner < 4; corner++) {
+                float ndcX = -1.0f + 2.0f * static_cast<float>(x + (corner & 1)) / LIGHT_CLUSTERS_X;
+                float ndcY = -1.0f + 2.0f * static_cast<float>(y + (corner >> 1)) / LIGHT_CLUSTERS_Y;
+
+                glm::vec4 nearPoint = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                nearPoint /= nearPoint.w;
+
+                rays[corner] = glm::vec3(nearPoint) / -nearPoint.z;
+            }
+
+            // Box around the part of the tile between the depths of every slice
+            for(int z = 0; z < LIGHT_CLUSTERS_Z; z++) {
+                float sliceNear = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / LIGHT_CLUSTERS_Z);
+                float sliceFar = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z + 1) / LIGHT_CLUSTERS_Z);
+
+                glm::vec3 clusterMin(std::numeric_limits<float>::max());
+                glm::vec3 clusterMax(-std::numeric_limits<float>::max());
+
+                for(int corner = 0; corner < 4; corner++) {
+                    clusterMin = glm::min(clusterMin, glm::min(rays[corner] * sliceNear, rays[corner] * sliceFar));
+                    clusterMax = glm::max(clusterMax, glm::max(rays[corner] * sliceNear, rays[corner] * sliceFar));
+                }
+
+                size_t cluster = x + LIGHT_CLUSTERS_X * (y + LIGHT_CLUSTERS_Y * z);
+                boundsMin[cluster] = clusterMin;
+                boundsMax[cluster] = clusterMax;
+
+                sliceMin[z] = glm::min(sliceMin[z], clusterMin);
+                sliceMax[z] = glm::max(sliceMax[z], clusterMax);
+            }
+        }
+    }
+}
+
+void ClusteredLights::assignSlice(int slice) {
+    SliceWork& work = slices[slice];
+
+    work.candidates.clear();
+    work.candidateX.clear();
+    work.candidateY.clear();
+    work.candidateZ.clear();
+    work.candidateRadius.clear();
+    work.indices.clear();
+    work.counts.assign(CLUSTERS_PER_SLICE, 0);
+
+    // Lights touching the bounds of the whole slice, same test as the clusters below - Padded to a multiple of 4 with
+    // spheres that are too far away to touch anything
+    for(size_t i = 0; i < lights.size(); i += 4) {
+        int mask = sphereBoxMask(&lightX[i], &lightY[i], &lightZ[i], &lightRadius[i], sliceMin[slice], sliceMax[slice]);
+
+        for(int lane = 0; lane < 4; lane++) {
+            if(mask & (1 << lane)) {
+                work.candidates.push_back(static_cast<GLuint>(i + lane));
+                work.candidateX.push_back(lightX[i + lane]);
+                work.candidateY.push_back(lightY[i + lane]);
+                work.candidateZ.push_back(lightZ[i + lane]);
+                work.candidateRadius.push_back(lightRadius[i + lane]);
+            }
+        }
+    }
+
+    if(work.candidates.empty()) {
+        return;
+    }
+
+    while(work.candidateX.size() % 4) {
+        work.candidateX.push_back(std::numeric_limits<float>::max());
+        work.candidateY.push_back(0.0f);
+        work.candidateZ.push_back(0.0f);
+        work.candidateRadius.push_back(0.0f);
+    }
+
+    // Every cluster of the slice against 4 candidates at a time
+    for(size_t cluster = 0; cluster < CLUSTERS_PER_SLICE; cluster++) {
+        const glm::vec3& clusterMin = boundsMin[slice * CLUSTERS_PER_SLICE + cluster];
+        const glm::vec3& clusterMax = boundsMax[slice * CLUSTERS_PER_SLICE + cluster];
+
+        size_t listStart = work.indices.size();
+
+        for(size_t c = 0; c < work.candidateX.size(); c += 4) {
+            int mask = sphereBoxMask(&work.candidateX[c], &work.candidateY[c], &work.candidateZ[c], &work.candidateRadius[c],
+                                     clusterMin, clusterMax);
+
+            for(int lane = 0; mask && lane < 4; lane++) {
+                if(!(mask & (1 << lane))) {
+                    continue;
+                }
+
+                GLuint light = work.candidates[c + lane];
+
+                // Spot lights also have to reach the cluster with their cone, wide cones only use the sphere
+                if(lights[light].edge > 0.0f) {
+                    glm::vec3 apex(lightX[light], lightY[light], lightZ[light]);
+
+                    if(!isConeInSphere(apex, lightDirections[light], lights[light].edge, lights[light].range,
+                                       0.5f * (clusterMin + clusterMax), 0.5f * glm::length(clusterMax - clusterMin))) {
+                        continue;
+                    }
+                }
+
+                work.indices.push_back(light);
+            }
+        }
+
+        work.counts[cluster] = static_cast<GLuint>(work.indices.size() - listStart);
+    }
+}
+
+void ClusteredLights::assignLights(const glm::mat4& projection, const glm::mat4& view, JobSystem* jobSystem) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Near and far planes of the perspective projection, the slices go from one to the other
+    GLfloat nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    GLfloat farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+
+    GLfloat logRatio = std::log(farPlane / nearPlane);
+    depthScale = LIGHT_CLUSTERS_Z / logRatio;
+    depthBias = -LIGHT_CLUSTERS_Z * std::log(nearPlane) / logRatio;
+
+    if(clusterProjection != projection) {
+        buildClusterBounds(projection, nearPlane, farPlane);
+    }
+
+    // View space spheres of the lights, padded to a multiple of 4 - Switched off lights are moved out of reach
+    size_t lightCount = lights.size();
+    size_t paddedCount = (lightCount + 3) & ~size_t(3);
+
+    lightX.assign(paddedCount, std::numeric_limits<float>::max());
+    lightY.assign(paddedCount, 0.0f);
+    lightZ.assign(paddedCount, 0.0f);
+    lightRadius.assign(paddedCount, 0.0f);
+    lightDirections.resize(lightCount);
+
+    for(size_t i = 0; i < lightCount; i++) {
+        glm::vec4 position = view * glm::vec4(lights[i].position, 1.0f);
+
+        if(lights[i].range > 0.0f) {
+            lightX[i] = position.x;
+            lightY[i] = position.y;
+            lightZ[i] = position.z;
+            lightRadius[i] = lights[i].range;
+        }
+
+        lightDirections[i] = glm::normalize(glm::mat3(view) * lights[i].direction);
+    }
+
+    // Slices don't share any clusters - A job per slice, the job system hands them out as the threads get free
+    auto assignJob = [this](size_t slice) {
+        assignSlice(static_cast<int>(slice));
+    };
+
+    if(jobSystem && lightCount >= CLUSTERED_LIGHTS_THREAD_MIN) {
+        jobSystem->run(LIGHT_CLUSTERS_Z, assignJob);
+    }
+
+    else {
+        for(size_t slice = 0; slice < LIGHT_CLUSTERS_Z; slice++) {
+            assignJob(slice);
+        }
+    }
+
+    // Merged in order, cluster x + X * (y + Y * z) is at the same index of the grid
+    grid.resize(CLUSTER_COUNT);
+    indices.clear();
+    maxClusterLights = 0;
+
+    for(int slice = 0; slice < LIGHT_CLUSTERS_Z; slice++) {
+        const SliceWork& work = slices[slice];
+        GLuint offset = static_cast<GLuint>(indices.size());
+
+        for(size_t cluster = 0; cluster < CLUSTERS_PER_SLICE; cluster++) {
+            grid[slice * CLUSTERS_PER_SLICE + cluster] = glm::uvec2(offset, work.counts[cluster]);
+
+            offset += work.counts[cluster];
+            maxClusterLights = std::max(maxClusterLights, work.counts[cluster]);
+        }
+
+        indices.insert(indices.end(), work.indices.begin(), work.indices.end());
+    }
+
+    assignTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ClusteredLights::updateBuffer(GLuint buffer, GLsizeiptr& capacity, const void* data, GLsizeiptr size) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+    // Growing the buffer only when needed, otherwise just updating the contents
+    if(size > capacity) {
+        capacity = size * 2;
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if(size) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+    }
+}
+
+void ClusteredLights::uploadBuffers() {
+    updateBuffer(lightsBuffer, lightsCapacity, lights.data(), sizeof(ClusterLightBlock) * lights.size());
+    updateBuffer(gridBuffer, gridCapacity, grid.data(), sizeof(glm::uvec2) * grid.size());
+    updateBuffer(indicesBuffer, indicesCapacity, indices.data(), sizeof(GLuint) * indices.size());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHTS_BINDING, lightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_GRID_BINDING, gridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDICES_BINDING, indicesBuffer);
+}
+
+GLfloat ClusteredLights::getAverageClusterLights() const {
+    return grid.empty() ? 0.0f : static_cast<GLfloat>(indices.size()) / grid.size();
+}
+
+// Destructor
+ClusteredLights::~ClusteredLights() {
+    if(lightsBuffer) {
+        glDeleteBuffers(1, &lightsBuffer);
+        glDeleteBuffers(1, &gridBuffer);
+        glDeleteBuffers(1, &indicesBuffer);
+    }
+}
@@ -4,16 +4,22 @@
 DirectionalLight::DirectionalLight() : Light() {
     // Diffuse Light
     direction = glm::vec3(0.0f, -1.0f, 0.0f);
-    lightProj = glm::ortho( -75.0f, 75.0f, -75.0f, 75.0f, 0.01f, 1000.0f );
+
+    // No cascades
+    shadowMap = nullptr;
 }
 
-DirectionalLight::DirectionalLight( GLuint shadowWidth, GLuint shadowHeight,
+DirectionalLight::DirectionalLight( const GLuint* cascadeResolutions, GLuint cascadeCount,
                                     GLfloat red, GLfloat green, GLfloat blue,
                                     GLfloat ambIntensity, GLfloat diffIntensity,
-                                    GLfloat xDir, GLfloat yDir, GLfloat zDir ) : Light(shadowWidth, shadowHeight, red, green, blue, ambIntensity, diffIntensity) {
+                                    GLfloat xDir, GLfloat yDir, GLfloat zDir ) : Light(red, green, blue, ambIntensity, diffIntensity) {
     // Diffuse Light
     direction = glm::vec3(xDir, yDir, zDir);
-    lightProj = glm::ortho( -75.0f, 75.0f, -75.0f, 75.0f, 0.01f, 1000.0f );
+
+    CascadedShadowMap* cascadedShadowMap = new CascadedShadowMap();
+    cascadedShadowMap->initCascades(cascadeResolutions, cascadeCount);
+
+    shadowMap = cascadedShadowMap;
 }
 
 void DirectionalLight::useLight( GLuint ambientIntensityLocation, GLuint ambientColourLocation,
@@ -27,9 +33,70 @@ void DirectionalLight::useLight( GLuint ambientIntensityLocation, GLuint ambient
     glUniform1f(diffuseIntensityLocation, diffuseIntensity);
 }
 
-glm::mat4 DirectionalLight::calculateLightTransform() {
-    // Light Projection * View
-    return lightProj * glm::lookAt(-direction, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+void DirectionalLight::calculateCascades(const glm::mat4& view, GLfloat fov, GLfloat aspect, GLfloat nearPlane, GLfloat farPlane) {
+    glm::mat4 inverseView = glm::inverse(view);
+
+    glm::vec3 lightDirection = glm::normalize(direction);
+    glm::vec3 up = glm::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    // Rotation of the light only, for snapping the centers
+    glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+    glm::mat4 inverseLightRotation = glm::inverse(lightRotation);
+
+    GLfloat tanY = tanf(fov * 0.5f);
+    GLfloat tanX = tanY * aspect;
+
+    GLuint cascadeCount = getCascadeCount();
+    GLfloat splitNear = nearPlane;
+
+    for(GLuint cascade = 0; cascade < cascadeCount; cascade++) {
+        // Practical split scheme
+        GLfloat ratio = GLfloat(cascade + 1) / cascadeCount;
+        GLfloat logSplit = nearPlane * powf(farPlane / nearPlane, ratio);
+        GLfloat uniformSplit = nearPlane + (farPlane - nearPlane) * ratio;
+        GLfloat splitFar = CASCADE_SPLIT_LAMBDA * logSplit + (1.0f - CASCADE_SPLIT_LAMBDA) * uniformSplit;
+
+        // Corners of the slice in world space
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+
+        for(int i = 0; i < 8; i++) {
+            GLfloat distance = i < 4 ? splitNear : splitFar;
+            glm::vec4 corner((i & 1 ? 1.0f : -1.0f) * tanX * distance, (i & 2 ? 1.0f : -1.0f) * tanY * distance, -distance, 1.0f);
+
+            corners[i] = glm::vec3(inverseView * corner);
+            center += corners[i] / 8.0f;
+        }
+
+        // Bounding sphere of the slice, its size doesn't change with the rotation of the camera
+        GLfloat radius = 0.0f;
+
+        for(int i = 0; i < 8; i++) {
+            radius = glm::max(radius, glm::length(corners[i] - center));
+        }
+
+        radius = ceilf(radius * 16.0f) / 16.0f;
+
+        // Moving the center in whole texels of the cascade
+        GLfloat texelSize = 2.0f * radius / getCascadedShadowMap()->getCascadeResolution(cascade);
+
+        glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+        lightCenter.x = floorf(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = floorf(lightCenter.y / texelSize) * texelSize;
+
+        center = glm::vec3(inverseLightRotation * glm::vec4(lightCenter, 1.0f));
+
+        // Casters between the light and the slice are still drawn
+        glm::vec3 eye = center - lightDirection * (radius + SHADOW_CASTER_DISTANCE);
+
+        glm::mat4 cascadeProj = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + SHADOW_CASTER_DISTANCE);
+
+        cascadeTransforms[cascade] = cascadeProj * glm::lookAt(eye, center, up);
+        cascadeSplits[cascade] = splitFar;
+        cascadeDepthRanges[cascade] = 2.0f * radius + SHADOW_CASTER_DISTANCE;
+
+        splitNear = splitFar;
+    }
 }
 
 DirectionalLight::~DirectionalLight() {
@@ -0,0 +1,139 @@
+#include "GLStateCache.h"
+
+GLStateCache glState;
+
+// Constructor
+GLStateCache::GLStateCache() {
+    issuedCalls = 0;
+    elidedCalls = 0;
+
+    invalidate();
+}
+
+GLuint* GLStateCache::getTextureSlot(GLuint unit, GLenum target) {
+    if(unit >= MAX_CACHED_TEXTURE_UNITS) {
+        return nullptr;
+    }
+
+    switch(target) {
+        case GL_TEXTURE_2D:
+            return &textures2D[unit];
+
+        case GL_TEXTURE_CUBE_MAP:
+            return &texturesCube[unit];
+
+        default:
+            return nullptr;
+    }
+}
+
+void GLStateCache::useProgram(GLuint shaderID) {
+    if(program == shaderID) {
+        elidedCalls++;
+        return;
+    }
+
+    glUseProgram(shaderID);
+    program = shaderID;
+    issuedCalls++;
+}
+
+void GLStateCache::bindVertexArray(GLuint VAO) {
+    if(vertexArray == VAO) {
+        elidedCalls++;
+        return;
+    }
+
+    glBindVertexArray(VAO);
+    vertexArray = VAO;
+    issuedCalls++;
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint textureID) {
+    GLuint* slot = getTextureSlot(unit, target);
+
+    // Nothing to do, the active unit doesn't have to change either
+    if(slot && *slot == textureID) {
+        elidedCalls++;
+        return;
+    }
+
+    if(activeUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+        issuedCalls++;
+    }
+
+    glBindTexture(target, textureID);
+    issuedCalls++;
+
+    if(slot) {
+        *slot = textureID;
+    }
+}
+
+void GLStateCache::setPolygonMode(GLenum mode) {
+    if(polygonMode == mode) {
+        elidedCalls++;
+        return;
+    }
+
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+    polygonMode = mode;
+    issuedCalls++;
+}
+
+void GLStateCache::setColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+    if(isColorMaskKnown && colorMask[0] == red && colorMask[1] == green && colorMask[2] == blue && colorMask[3] == alpha) {
+        elidedCalls++;
+        return;
+    }
+
+    glColorMask(red, green, blue, alpha);
+    colorMask[0] = red;
+    colorMask[1] = green;
+    colorMask[2] = blue;
+    colorMask[3] = alpha;
+    isColorMaskKnown = true;
+    issuedCalls++;
+}
+
+void GLStateCache::forgetProgram(GLuint shaderID) {
+    if(program == shaderID) {
+        program = UNKNOWN;
+    }
+}
+
+void GLStateCache::forgetVertexArray(GLuint VAO) {
+    // GL falls back to 0 when the bound vertex array is deleted
+    if(vertexArray == VAO) {
+        vertexArray = 0;
+    }
+}
+
+void GLStateCache::forgetTexture(GLuint textureID) {
+    // Same for textures, every unit it was bound to falls back to 0
+    for(int i = 0; i < MAX_CACHED_TEXTURE_UNITS; i++) {
+        if(textures2D[i] == textureID) {
+            textures2D[i] = 0;
+        }
+
+        if(texturesCube[i] == textureID) {
+            texturesCube[i] = 0;
+        }
+    }
+}
+
+void GLStateCache::invalidate() {
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+
+    for(int i = 0; i < MAX_CACHED_TEXTURE_UNITS; i++) {
+        textures2D[i] = UNKNOWN;
+        texturesCube[i] = UNKNOWN;
+    }
+
+    polygonMode = GL_NONE;
+    isColorMaskKnown = false;
+}
@@ -7,10 +7,19 @@ Light::Light() {
 
     // Diffuse Light
     diffuseIntensity = 0.0f;
+
+    shadowMap = nullptr;
 }
 
 Light::Light(   GLuint shadowWidth, GLuint shadowHeight,
                 GLfloat red, GLfloat green, GLfloat blue,
+                GLfloat ambIntensity, GLfloat diffIntensity ) : Light(red, green, blue, ambIntensity, diffIntensity) {
+    // Creating a new shadow map
+    shadowMap = new ShadowMap();
+    shadowMap->init(shadowWidth, shadowHeight);
+}
+
+Light::Light(   GLfloat red, GLfloat green, GLfloat blue,
                 GLfloat ambIntensity, GLfloat diffIntensity ) {
     // Ambient Light
     colour = glm::vec3(red, green, blue);
@@ -19,9 +28,7 @@ Light::Light(   GLuint shadowWidth, GLuint shadowHeight,
     // Diffuse Light
     diffuseIntensity = diffIntensity;
 
-    // Creating a new shadow map
-    shadowMap = new ShadowMap();
-    shadowMap->init(shadowWidth, shadowHeight);
+    shadowMap = nullptr;
 }
 
 Light::~Light() {
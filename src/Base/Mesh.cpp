@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cfloat>
 
 #include "Mesh.h"
 
@@ -8,15 +9,29 @@ Mesh::Mesh() {
     VBO = 0;
     IBO = 0;
     indexCount = 0;
+
+    boundsMin = glm::vec3(0.0f);
+    boundsMax = glm::vec3(0.0f);
 }
 
 void Mesh::createMesh(GLfloat *vertices, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices) {
     // Getting the number of indices
     indexCount = numOfIndices;
 
+    // Bounds of the positions, every vertex is 8 floats starting with the position
+    boundsMin = glm::vec3(numOfVertices ? FLT_MAX : 0.0f);
+    boundsMax = glm::vec3(numOfVertices ? -FLT_MAX : 0.0f);
+
+    for(unsigned int i = 0; i + 2 < numOfVertices; i += 8) {
+        glm::vec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+
     // Creating and gettting the vertex ID of a VAO
     glCreateVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    glState.bindVertexArray(VAO);
 
         // Creating the Index Buffer Object
         glGenBuffers(1, &IBO);
@@ -51,7 +66,7 @@ void Mesh::createMesh(GLfloat *vertices, unsigned int *indices, unsigned int num
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     // Un-Binding Vertex Array
-    glBindVertexArray(0);
+    glState.bindVertexArray(0);
 
     // Un-Binding IBO/EBO after VAO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -74,14 +89,11 @@ void Mesh::renderMesh() {
         return;
     }
 
-    // Binding the Vertex Array for Drawing
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    // Binding the Vertex Array for Drawing, the IBO is part of the VAO state
+    // Left bound, the next draw of the same mesh doesn't have to bind it again
+    glState.bindVertexArray(VAO);
         // Drawing the Elements (Since we are using Indexed arrays)
         glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
 }
 
 void Mesh::cleanMesh() {
@@ -98,6 +110,7 @@ void Mesh::cleanMesh() {
 
     // Preventing overflow, garbage collection
     if(VAO) {
+        glState.forgetVertexArray(VAO);
         glDeleteVertexArrays(1, &VAO);
         VAO = 0;
     }
@@ -1,6 +1,8 @@
 #include "Model.h"
 
 Model::Model() {
+    boundsMin = glm::vec3(0.0f);
+    boundsMax = glm::vec3(0.0f);
 }
 
 void Model::renderModel() {
@@ -126,6 +128,22 @@ void Model::loadModel(const std::string filePath) {
     loadNode(scene->mRootNode, scene);
 
     loadMaterials(scene);
+
+    // Bounds of the whole model, for culling
+    for(size_t i = 0; i < meshList.size(); i++) {
+        boundsMin = i ? glm::min(boundsMin, meshList[i]->getBoundsMin()) : meshList[i]->getBoundsMin();
+        boundsMax = i ? glm::max(boundsMax, meshList[i]->getBoundsMax()) : meshList[i]->getBoundsMax();
+    }
+}
+
+GLsizei Model::getTriangleCount() const {
+    GLsizei triangleCount = 0;
+
+    for(size_t i = 0; i < meshList.size(); i++) {
+        triangleCount += meshList[i]->getTriangleCount();
+    }
+
+    return triangleCount;
 }
 
 void Model::clearModel() {
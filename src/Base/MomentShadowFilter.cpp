@@ -0,0 +1,109 @@
+#include "MomentShadowFilter.h"
+
+MomentShadowFilter::MomentShadowFilter() {
+    blurShader = nullptr;
+
+    uniformSource = -1;
+    uniformIsDepthSource = -1;
+    uniformTile = -1;
+    uniformDirection = -1;
+    uniformDepthScale = -1;
+
+    tempFBO = 0;
+    tempMap = 0;
+    tempWidth = 0;
+    tempHeight = 0;
+
+    VAO = 0;
+}
+
+bool MomentShadowFilter::init(Shader* shader, GLuint width, GLuint height) {
+    blurShader = shader;
+
+    uniformSource = blurShader->getUniformLocation("source");
+    uniformIsDepthSource = blurShader->getUniformLocation("isDepthSource");
+    uniformTile = blurShader->getUniformLocation("tile");
+    uniformDirection = blurShader->getUniformLocation("direction");
+    uniformDepthScale = blurShader->getUniformLocation("depthScale");
+
+    tempWidth = width; tempHeight = height;
+
+    glGenTextures(1, &tempMap);
+    glState.bindTexture(0, GL_TEXTURE_2D, tempMap);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG32F, tempWidth, tempHeight);
+
+    // Only read with texelFetch
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenFramebuffers(1, &tempFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, tempFBO);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tempMap, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Frame buffer error : %i\n", status);
+        return false;
+    }
+
+    glGenVertexArrays(1, &VAO);
+
+    return true;
+}
+
+void MomentShadowFilter::filterLayer(ShadowMap* shadowMap, GLuint layer, GLfloat depthScale) {
+    glm::uvec3 tile = shadowMap->getLayerTile(layer);
+
+    if(!tile.z || tile.x + tile.z > tempWidth || tile.y + tile.z > tempHeight) {
+        return;
+    }
+
+    blurShader->useShader();
+    glState.bindVertexArray(VAO);
+
+    glUniform1i(uniformSource, 0);
+    glUniform3i(uniformTile, tile.x, tile.y, tile.z);
+    glUniform1f(uniformDepthScale, depthScale);
+
+    // A triangle over the tile, nothing to test against
+    glDisable(GL_DEPTH_TEST);
+    glViewport(tile.x, tile.y, tile.z, tile.z);
+
+    // Depth to moments, along x
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, tempFBO);
+    glState.bindTexture(0, GL_TEXTURE_2D, shadowMap->getShadowMapID());
+    glUniform1i(uniformIsDepthSource, 1);
+    glUniform2i(uniformDirection, 1, 0);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Along y, into the moments of the shadow map
+    shadowMap->writeMoments();
+    glState.bindTexture(0, GL_TEXTURE_2D, tempMap);
+    glUniform1i(uniformIsDepthSource, 0);
+    glUniform2i(uniformDirection, 0, 1);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    shadowMap->clearMomentsDirty(layer);
+}
+
+MomentShadowFilter::~MomentShadowFilter() {
+    if(tempFBO) {
+        glDeleteFramebuffers(1, &tempFBO);
+    }
+
+    if(tempMap) {
+        glState.forgetTexture(tempMap);
+        glDeleteTextures(1, &tempMap);
+    }
+
+    if(VAO) {
+        glState.forgetVertexArray(VAO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+}
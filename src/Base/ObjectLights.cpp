@@ -0,0 +1,165 @@
+#include "ObjectLights.h"
+
+#include <algorithm>
+
+// isConeInSphere, POINT_LIGHT_EDGE
+#include "ClusteredLights.h"
+
+// Constructor
+ObjectLights::ObjectLights() {
+    listsBuffer = 0;
+    listsCapacity = 0;
+
+    totalObjectLights = 0;
+}
+
+void ObjectLights::createBuffer() {
+    // Offset and count of a handful of objects with a few lights each, grown by assignLights if needed
+    listsCapacity = sizeof(GLuint) * 64 * (2 + 8);
+
+    glGenBuffers(1, &listsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, listsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, listsCapacity, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_LIGHTS_BINDING, listsBuffer);
+}
+
+void ObjectLights::clear() {
+    lights.clear();
+    boundsMin.clear();
+    boundsMax.clear();
+}
+
+void ObjectLights::addPointLight(const glm::vec3& position, GLfloat range) {
+    // Edge below -1, every direction is inside
+    lights.push_back({ position, range, glm::vec3(0.0f, -1.0f, 0.0f), POINT_LIGHT_EDGE });
+}
+
+void ObjectLights::addSpotLight(const glm::vec3& position, GLfloat range, const glm::vec3& direction, GLfloat edge) {
+    lights.push_back({ position, range, glm::normalize(direction), edge });
+}
+
+GLint ObjectLights::addObject(const glm::vec3& objectMin, const glm::vec3& objectMax) {
+    boundsMin.push_back(objectMin);
+    boundsMax.push_back(objectMax);
+
+    return static_cast<GLint>(boundsMin.size() - 1);
+}
+
+void ObjectLights::assignRange(PartitionWork& work, size_t begin, size_t end) const {
+    work.indices.clear();
+    work.counts.assign(end - begin, 0);
+
+    for(size_t object = begin; object < end; object++) {
+        const glm::vec3& objectMin = boundsMin[object];
+        const glm::vec3& objectMax = boundsMax[object];
+
+        // Bounding sphere of the box, for the cone test
+        glm::vec3 center = 0.5f * (objectMin + objectMax);
+        float radius = 0.5f * glm::length(objectMax - objectMin);
+
+        size_t listStart = work.indices.size();
+
+        for(size_t light = 0; light < lights.size(); light++) {
+            const LightVolume& volume = lights[light];
+
+            if(volume.range <= 0.0f) {
+                continue;
+            }
+
+            // Closest point of the box to the light
+            glm::vec3 offset = volume.position - glm::clamp(volume.position, objectMin, objectMax);
+
+            if(glm::dot(offset, offset) > volume.range * volume.range) {
+                continue;
+            }
+
+            if(volume.edge > 0.0f && !isConeInSphere(volume.position, volume.direction, volume.edge, volume.range, center, radius)) {
+                continue;
+            }
+
+            work.indices.push_back(static_cast<GLuint>(light));
+        }
+
+        work.counts[object - begin] = static_cast<GLuint>(work.indices.size() - listStart);
+    }
+}
+
+void ObjectLights::assignLights(JobSystem* jobSystem) {
+    size_t objectCount = boundsMin.size();
+
+    // One range per thread of the job system for big scenes, small ones stay on the calling thread
+    size_t partitionCount = jobSystem ? jobSystem->getThreadCount() : 1;
+    partitionCount = std::max<size_t>(1, std::min(partitionCount, objectCount / OBJECT_LIGHTS_PARTITION_MIN));
+
+    if(partitions.size() < partitionCount) {
+        partitions.resize(partitionCount);
+    }
+
+    auto assignPartition = [&](size_t partition) {
+        size_t begin, end;
+        JobSystem::getPartitionRange(objectCount, partitionCount, partition, 1, begin, end);
+
+        assignRange(partitions[partition], begin, end);
+    };
+
+    if(jobSystem) {
+        jobSystem->run(partitionCount, assignPartition);
+    }
+
+    else {
+        assignPartition(0);
+    }
+
+    size_t begin, end;
+
+    // Merged in order - Offset and count of object i at 2i, the lists after all of them
+    lists.resize(2 * objectCount);
+    totalObjectLights = 0;
+
+    GLuint offset = static_cast<GLuint>(lists.size());
+
+    for(size_t partition = 0; partition < partitionCount; partition++) {
+        const PartitionWork& work = partitions[partition];
+        JobSystem::getPartitionRange(objectCount, partitionCount, partition, 1, begin, end);
+
+        for(size_t object = begin; object < end; object++) {
+            lists[2 * object] = offset;
+            lists[2 * object + 1] = work.counts[object - begin];
+
+            offset += work.counts[object - begin];
+        }
+
+        totalObjectLights += work.indices.size();
+        lists.insert(lists.end(), work.indices.begin(), work.indices.end());
+    }
+
+    // Growing the buffer only when needed, otherwise just updating the contents
+    GLsizeiptr size = sizeof(GLuint) * lists.size();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, listsBuffer);
+
+    if(size > listsCapacity) {
+        listsCapacity = size * 2;
+        glBufferData(GL_SHADER_STORAGE_BUFFER, listsCapacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if(size) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, lists.data());
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_LIGHTS_BINDING, listsBuffer);
+}
+
+GLfloat ObjectLights::getAverageObjectLights() const {
+    return boundsMin.empty() ? 0.0f : static_cast<GLfloat>(totalObjectLights) / boundsMin.size();
+}
+
+// Destructor
+ObjectLights::~ObjectLights() {
+    if(listsBuffer) {
+        glDeleteBuffers(1, &listsBuffer);
+    }
+}
@@ -9,6 +9,10 @@ PointLight::PointLight() : Light() {
     constant = 1.0f;
     linear = 0.0f;
     exponent = 0.0f;
+
+    nearPlane = 0.01f;
+    farPlane = 100.0f;
+    shadowResolution = 0;
 }
 
 PointLight::PointLight( GLuint shadowWidth, GLuint shadowHeight,
@@ -16,7 +20,7 @@ PointLight::PointLight( GLuint shadowWidth, GLuint shadowHeight,
                         GLfloat red, GLfloat green, GLfloat blue,
                         GLfloat ambIntensity, GLfloat diffIntensity,
                         GLfloat xPos, GLfloat yPos, GLfloat zPos,
-                        GLfloat cons, GLfloat lin, GLfloat exp ) : Light(shadowWidth, shadowHeight, red, green, blue, ambIntensity, diffIntensity) {
+                        GLfloat cons, GLfloat lin, GLfloat exp ) : Light(red, green, blue, ambIntensity, diffIntensity) {
     // Position of the light
     position = glm::vec3(xPos, yPos, zPos);
 
@@ -25,15 +29,13 @@ PointLight::PointLight( GLuint shadowWidth, GLuint shadowHeight,
     linear = lin;
     exponent = exp;
 
+    nearPlane = near;
     farPlane = far;
 
-    // Getting the aspect ratio
-    float aspect = (float)shadowWidth / (float)shadowHeight;
-
-    lightProj = glm::perspective(glm::radians(90.0f), aspect, near, far);
+    // Shadows live in the shared atlas, the faces are square tiles of up to this size
+    shadowResolution = shadowWidth > shadowHeight ? shadowWidth : shadowHeight;
 
-    shadowMap = new OmniShadowMap();
-    shadowMap->init(shadowWidth, shadowHeight);
+    lightProj = glm::perspective(glm::radians(90.0f), 1.0f, near, far);
 }
 
 void PointLight::useLight(  GLuint ambientIntensityLocation, GLuint ambientColourLocation,
@@ -55,6 +57,31 @@ void PointLight::useLight(  GLuint ambientIntensityLocation, GLuint ambientColou
     glUniform1f(exponentLocation, exponent);
 }
 
+void PointLight::fillBlock(ClusterLightBlock& block) {
+    block = {};
+
+    // Ambient Light
+    block.colour = colour;
+    block.ambientIntensity = ambientIntensity;
+
+    // Diffuse Light
+    block.diffuseIntensity = diffuseIntensity;
+
+    // Point Light - Lights every direction
+    block.position = position;
+    block.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    block.edge = POINT_LIGHT_EDGE;
+
+    // Attenuation Factor
+    block.constant = constant;
+    block.linear = linear;
+    block.exponent = exponent;
+    block.range = calculateRange();
+
+    block.shadowTransform = glm::mat4(1.0f);
+    block.farPlane = farPlane;
+}
+
 std::vector<glm::mat4> PointLight::calculateLightTransform() {
     std::vector<glm::mat4> lightMatrices;
 
@@ -80,6 +107,24 @@ GLfloat PointLight::getFarPlane() {
     return farPlane;
 }
 
+GLfloat PointLight::calculateRange() {
+    // Brightest the light gets, over the attenuation - a d^2 + b d + c = brightness / cutoff
+    GLfloat brightness = glm::max(colour.r, glm::max(colour.g, colour.b)) * (ambientIntensity + diffuseIntensity);
+    GLfloat target = glm::max(brightness / LIGHT_ATTENUATION_CUTOFF - constant, 0.0f);
+
+    GLfloat range = farPlane;
+
+    if(exponent > 0.0f) {
+        range = (-linear + sqrtf(linear * linear + 4.0f * exponent * target)) / (2.0f * exponent);
+    }
+
+    else if(linear > 0.0f) {
+        range = target / linear;
+    }
+
+    return glm::clamp(range, 0.0f, farPlane);
+}
+
 glm::vec3 PointLight::getPosition() {
     return position;
 }
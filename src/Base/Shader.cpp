@@ -6,9 +6,6 @@ Shader::Shader() {
     uniformModel = 0;
     uniformProjection = 0;
     uniformView = 0;
-
-    pointLightCount = 0;
-    spotLightCount = 0;
 }
 
 void Shader::createFromString(const char* vertexCode, const char* fragmentCode) {
@@ -64,77 +61,40 @@ void Shader::compileProgram() {
     uniformSpecularIntensity = glGetUniformLocation(shaderID, "material.specularIntensity");
     uniformEyePosition = glGetUniformLocation(shaderID, "eyePosition");
 
-    // Point Light
-    uniformPointLightCount = glGetUniformLocation(shaderID, "pointLightCount");
+    // Directional Shadow Cascades
+    uniformCascadeCount = glGetUniformLocation(shaderID, "cascadeCount");
 
-    for(size_t i = 0; i<MAX_POINT_LIGHTS; i++) {
+    for(size_t i = 0; i < MAX_CASCADES; i++) {
         char locBuff[100] = { '\0' };
 
-        snprintf(locBuff, sizeof(locBuff), "pointLight[%zd].base.colour", i);
-        uniformPointLight[i].uniformColour = glGetUniformLocation(shaderID, locBuff);
-
-        snprintf(locBuff, sizeof(locBuff), "pointLight[%zd].base.ambientIntensity", i);
-        uniformPointLight[i].uniformAmbientIntensity = glGetUniformLocation(shaderID, locBuff);
-
-        snprintf(locBuff, sizeof(locBuff), "pointLight[%zd].base.diffuseIntensity", i);
-        uniformPointLight[i].uniformDiffuseIntensity = glGetUniformLocation(shaderID, locBuff);
+        snprintf(locBuff, sizeof(locBuff), "cascades[%zd].transform", i);
+        uniformCascades[i].uniformTransform = glGetUniformLocation(shaderID, locBuff);
 
-        snprintf(locBuff, sizeof(locBuff), "pointLight[%zd].position", i);
-        uniformPointLight[i].uniformPosition = glGetUniformLocation(shaderID, locBuff);
+        snprintf(locBuff, sizeof(locBuff), "cascades[%zd].split", i);
+        uniformCascades[i].uniformSplit = glGetUniformLocation(shaderID, locBuff);
 
-        snprintf(locBuff, sizeof(locBuff), "pointLight[%zd].constant", i);
-        uniformPointLight[i].uniformConstant = glGetUniformLocation(shaderID, locBuff);
+        snprintf(locBuff, sizeof(locBuff), "cascades[%zd].rect", i);
+        uniformCascades[i].uniformRect = glGetUniformLocation(shaderID, locBuff);
 
-        snprintf(locBuff, sizeof(locBuff), "pointLight[%zd].linear", i);
-        uniformPointLight[i].uniformLinear = glGetUniformLocation(shaderID, locBuff);
-
-        snprintf(locBuff, sizeof(locBuff), "pointLight[%zd].exponent", i);
-        uniformPointLight[i].uniformExponent = glGetUniformLocation(shaderID, locBuff);
+        snprintf(locBuff, sizeof(locBuff), "cascades[%zd].depthRange", i);
+        uniformCascades[i].uniformDepthRange = glGetUniformLocation(shaderID, locBuff);
     }
 
-    // Spot Light
-    uniformSpotLightCount = glGetUniformLocation(shaderID, "spotLightCount");
-
-	for (size_t i = 0; i < MAX_SPOT_LIGHTS; i++) {
-		char locBuff[100] = { '\0' };
-
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].base.base.colour", i);
-		uniformSpotLight[i].uniformColour = glGetUniformLocation(shaderID, locBuff);
-
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].base.base.ambientIntensity", i);
-		uniformSpotLight[i].uniformAmbientIntensity = glGetUniformLocation(shaderID, locBuff);
-
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].base.base.diffuseIntensity", i);
-		uniformSpotLight[i].uniformDiffuseIntensity = glGetUniformLocation(shaderID, locBuff);
-
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].base.position", i);
-		uniformSpotLight[i].uniformPosition = glGetUniformLocation(shaderID, locBuff);
-
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].base.constant", i);
-		uniformSpotLight[i].uniformConstant = glGetUniformLocation(shaderID, locBuff);
-
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].base.linear", i);
-		uniformSpotLight[i].uniformLinear = glGetUniformLocation(shaderID, locBuff);
+    // Moment Shadows
+    uniformIsMomentShadows = glGetUniformLocation(shaderID, "isMomentShadows");
+    uniformDirectionalMoments = glGetUniformLocation(shaderID, "directionalMoments");
+    uniformShadowAtlasMoments = glGetUniformLocation(shaderID, "shadowAtlasMoments");
 
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].base.exponent", i);
-		uniformSpotLight[i].uniformExponent = glGetUniformLocation(shaderID, locBuff);
+    // Light lists of the objects
+    uniformIsObjectLights = glGetUniformLocation(shaderID, "isObjectLights");
+    uniformObjectLights = glGetUniformLocation(shaderID, "objectLights");
 
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].direction", i);
-		uniformSpotLight[i].uniformDirection = glGetUniformLocation(shaderID, locBuff);
+    // Shadow Atlas
+    uniformShadowAtlas = glGetUniformLocation(shaderID, "shadowAtlas");
 
-		snprintf(locBuff, sizeof(locBuff), "spotLight[%zd].edge", i);
-		uniformSpotLight[i].uniformEdge = glGetUniformLocation(shaderID, locBuff);
-	}
-
-    for(size_t i = 0; i < MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS; i++) {
-        char locBuff[100] = { '\0' };
-
-        snprintf(locBuff, sizeof(locBuff), "omniShadowMaps[%zd].shadowMap", i);
-        uniformOmniShadowMap[i].shadowMap = glGetUniformLocation(shaderID, locBuff);
-
-        snprintf(locBuff, sizeof(locBuff), "omniShadowMaps[%zd].farPlane", i);
-        uniformOmniShadowMap[i].farPlane = glGetUniformLocation(shaderID, locBuff);
-    }
+    // Clustered Lights
+    uniformClusterCount = glGetUniformLocation(shaderID, "clusterCount");
+    uniformClusterDepth = glGetUniformLocation(shaderID, "clusterDepth");
 
     // Shadows
     uniformDirectionalLightTransform = glGetUniformLocation(shaderID, "directionalLightTransform");
@@ -151,6 +111,8 @@ void Shader::compileProgram() {
         snprintf(locBuff, sizeof(locBuff), "lightMatrices[%zd]", i);
         uniformLightMatrices[i] = glGetUniformLocation(shaderID, locBuff);
     }
+
+    uniformLightMatrix = glGetUniformLocation(shaderID, "lightMatrix");
 }
 
 void Shader::compileShader(const char* vertexCode, const char* fragmentCode) {
@@ -316,6 +278,10 @@ GLuint Shader::getFarPlaneLocation() {
     return uniformFarPlane;
 }
 
+GLuint Shader::getObjectLightsLocation() {
+    return uniformObjectLights;
+}
+
 void Shader::setDirectionalLight(DirectionalLight * dLight) {
     dLight->useLight( uniformDirectionalLight.uniformAmbientIntensity,
                       uniformDirectionalLight.uniformColour,
@@ -323,66 +289,59 @@ void Shader::setDirectionalLight(DirectionalLight * dLight) {
                       uniformDirectionalLight.uniformDirection );
 }
 
-void Shader::setPointLight(PointLight * pLight, unsigned int lightCount, unsigned int textureUnit, unsigned int offset) {
-    // Limiting number of point lights due to shader structure
-    if(lightCount > MAX_POINT_LIGHTS) lightCount = MAX_POINT_LIGHTS;
-
-    glUniform1i(uniformPointLightCount, lightCount);
+void Shader::setShadowAtlas(ShadowAtlas* atlas, GLuint textureUnit) {
+    atlas->read(GL_TEXTURE0 + textureUnit);
+    glUniform1i(uniformShadowAtlas, textureUnit);
+}
 
-    for(size_t i = 0; i < lightCount; i++) {
-        pLight[i].useLight( uniformPointLight[i].uniformAmbientIntensity,
-                            uniformPointLight[i].uniformColour,
-                            uniformPointLight[i].uniformDiffuseIntensity,
-                            uniformPointLight[i].uniformPosition,
-                            uniformPointLight[i].uniformConstant,
-                            uniformPointLight[i].uniformLinear,
-                            uniformPointLight[i].uniformExponent );
+void Shader::setClusteredLights(ClusteredLights* clusteredLights) {
+    glUniform3i(uniformClusterCount, LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z);
+    glUniform2f(uniformClusterDepth, clusteredLights->getDepthScale(), clusteredLights->getDepthBias());
+}
 
-        // Iterating over the Textures assigned
-        pLight[i].getShadowMap()->read(GL_TEXTURE0 + textureUnit + i);
+void Shader::setTexture(GLuint textureUnit) {
+    glUniform1i(uniformTexture, textureUnit);
+}
 
-        // For iterating over the i + pointLightCount functionality in our shader
-        glUniform1i(uniformOmniShadowMap[i + offset].shadowMap, textureUnit + i);
-        glUniform1f(uniformOmniShadowMap[i + offset].farPlane, pLight[i].getFarPlane());
-    }
+void Shader::setDirectionalShadowMap(GLuint textureUnit) {
+    glUniform1i(uniformDirectionalShadowMap, textureUnit);
 }
 
-void Shader::setSpotLight(SpotLight * sLight, unsigned int lightCount, unsigned int textureUnit, unsigned int offset) {
-    // Limiting number of point lights due to shader structure
-    if(lightCount > MAX_SPOT_LIGHTS) lightCount = MAX_SPOT_LIGHTS;
+void Shader::setDirectionalLightTransform(glm::mat4 * lTransform) {
+    glUniformMatrix4fv(uniformDirectionalLightTransform, 1, GL_FALSE, glm::value_ptr(*lTransform));
+}
 
-    glUniform1i(uniformSpotLightCount, lightCount);
+void Shader::setDirectionalCascades(DirectionalLight* dLight) {
+    GLuint cascadeCount = dLight->getCascadeCount();
 
-    for(size_t i = 0; i < lightCount; i++) {
-        sLight[i].useLight( uniformSpotLight[i].uniformAmbientIntensity,
-                            uniformSpotLight[i].uniformColour,
-                            uniformSpotLight[i].uniformDiffuseIntensity,
-                            uniformSpotLight[i].uniformPosition,
-                            uniformSpotLight[i].uniformDirection,
-                            uniformSpotLight[i].uniformConstant,
-                            uniformSpotLight[i].uniformLinear,
-                            uniformSpotLight[i].uniformExponent,
-                            uniformSpotLight[i].uniformEdge );
+    glUniform1i(uniformCascadeCount, cascadeCount);
 
-        // Iterating over the Textures assigned
-        sLight[i].getShadowMap()->read(GL_TEXTURE0 + textureUnit + i);
+    for(GLuint i = 0; i < cascadeCount; i++) {
+        glm::vec4 rect = dLight->getCascadedShadowMap()->getCascadeRect(i);
 
-        // For iterating over the i + pointLightCount functionality in our shader
-        glUniform1i(uniformOmniShadowMap[i + offset].shadowMap, textureUnit + i);
-        glUniform1f(uniformOmniShadowMap[i + offset].farPlane, sLight[i].getFarPlane());
+        glUniformMatrix4fv(uniformCascades[i].uniformTransform, 1, GL_FALSE, glm::value_ptr(dLight->getCascadeTransform(i)));
+        glUniform1f(uniformCascades[i].uniformSplit, dLight->getCascadeSplit(i));
+        glUniform4f(uniformCascades[i].uniformRect, rect.x, rect.y, rect.z, rect.w);
+        glUniform1f(uniformCascades[i].uniformDepthRange, dLight->getCascadeDepthRange(i));
     }
 }
 
-void Shader::setTexture(GLuint textureUnit) {
-    glUniform1i(uniformTexture, textureUnit);
-}
+void Shader::setMomentShadows(bool isEnabled, DirectionalLight* dLight, GLuint directionalUnit, ShadowAtlas* atlas, GLuint atlasUnit) {
+    glUniform1i(uniformIsMomentShadows, isEnabled);
 
-void Shader::setDirectionalShadowMap(GLuint textureUnit) {
-    glUniform1i(uniformDirectionalShadowMap, textureUnit);
+    if(!isEnabled) {
+        return;
+    }
+
+    dLight->getShadowMap()->readMoments(GL_TEXTURE0 + directionalUnit);
+    atlas->readMoments(GL_TEXTURE0 + atlasUnit);
+
+    glUniform1i(uniformDirectionalMoments, directionalUnit);
+    glUniform1i(uniformShadowAtlasMoments, atlasUnit);
 }
 
-void Shader::setDirectionalLightTransform(glm::mat4 * lTransform) {
-    glUniformMatrix4fv(uniformDirectionalLightTransform, 1, GL_FALSE, glm::value_ptr(*lTransform));
+void Shader::setObjectLights(bool isEnabled) {
+    glUniform1i(uniformIsObjectLights, isEnabled);
 }
 
 void Shader::setLightMatrices(std::vector<glm::mat4> lightMatrices) {
@@ -391,9 +350,13 @@ void Shader::setLightMatrices(std::vector<glm::mat4> lightMatrices) {
     }
 }
 
+void Shader::setLightMatrix(const glm::mat4& lightMatrix) {
+    glUniformMatrix4fv(uniformLightMatrix, 1, GL_FALSE, glm::value_ptr(lightMatrix));
+}
+
 void Shader::useShader() {
     if(shaderID) {
-        glUseProgram(shaderID);
+        glState.useProgram(shaderID);
     }
 
     else {
@@ -403,6 +366,7 @@ void Shader::useShader() {
 
 void Shader::cleanShader() {
     if(shaderID) {
+        glState.forgetProgram(shaderID);
         glDeleteProgram(shaderID);
         shaderID = 0;
     }
@@ -0,0 +1,38 @@
+#version 460 core
+
+out vec2 moments;
+
+// Depth map on the horizontal pass, the moments it wrote on the vertical one
+uniform sampler2D source;
+uniform bool isDepthSource;
+
+// Tile being filtered - x, y, size in texels, the samples never leave it
+uniform ivec3 tile;
+uniform ivec2 direction;
+
+// World units of a depth of 1, so every light has the same minimum variance in the main shader
+uniform float depthScale;
+
+// 5 tap binomial kernel
+const int BLUR_RADIUS = 2;
+const float weights[5] = float[](0.0625, 0.25, 0.375, 0.25, 0.0625);
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 sum = vec2(0.0);
+
+    for(int i = -BLUR_RADIUS; i <= BLUR_RADIUS; i++) {
+        ivec2 sampleTexel = clamp(texel + direction * i, tile.xy, tile.xy + ivec2(tile.z - 1));
+
+        if(isDepthSource) {
+            float depth = texelFetch(source, sampleTexel, 0).r * depthScale;
+            sum += weights[i + BLUR_RADIUS] * vec2(depth, depth * depth);
+        }
+
+        else {
+            sum += weights[i + BLUR_RADIUS] * texelFetch(source, sampleTexel, 0).rg;
+        }
+    }
+
+    moments = sum;
+}
@@ -0,0 +1,15 @@
+#version 460 core
+
+layout (location = 0) in vec3 pos;
+
+uniform mat4 model;
+
+// Projection * View of the face being drawn
+uniform mat4 lightMatrix;
+
+out vec4 fragPos;
+
+void main() {
+    fragPos = model * vec4(pos, 1.0);
+    gl_Position = lightMatrix * fragPos;
+}
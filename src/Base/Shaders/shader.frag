@@ -4,13 +4,19 @@ in vec4 col;
 in vec2 texCoord;
 in vec3 Normal;
 in vec3 fragPos;
-in vec4 directionalLightSpacePos;
+in float viewDepth;
 
 out vec4 colour;
 
 // Should be same as Utilities.h header file
-const int MAX_POINT_LIGHTS = 3;
-const int MAX_SPOT_LIGHTS = 3;
+const int MAX_CASCADES = 4;
+const int SHADOW_ATLAS_FACES = 6;
+const int SHADOW_MOMENT_LEVELS = 7;
+
+// Moment shadows - Smallest variance in world units squared (Against acne), and the share of light under which a
+// fragment counts as fully shadowed (Against light bleeding where shadows overlap)
+const float MOMENT_MIN_VARIANCE = 0.0002;
+const float MOMENT_BLEED_REDUCTION = 0.3;
 
 struct Light {
     vec3 colour;
@@ -39,29 +45,87 @@ struct SpotLight {
     float edge;
 };
 
-struct OmniShadowMap {
-    samplerCube shadowMap;
+// Point and spot lights with their shadows, filled every frame on the CPU - See ClusteredLights.h
+// Tiles in the shadow atlas (Offset, scale) are empty when the light didn't get any. Point lights have one per cube face,
+// spot lights only use the first one with the transform of their cone
+// Point lights have an edge below -1, range is where the light is faded out completely
+struct ClusterLight {
+    mat4 shadowTransform;
+    vec4 shadowTiles[SHADOW_ATLAS_FACES];
+    vec3 position;
+    float range;
+    vec3 colour;
+    float ambientIntensity;
+    vec3 direction;
+    float edge;
+    float diffuseIntensity;
+    float constant;
+    float linear;
+    float exponent;
     float farPlane;
 };
 
+// Projection * View of the cascade, view distance where it ends, its tile in the atlas (Offset, scale)
+// and the world distance of a depth of 1
+struct Cascade {
+    mat4 transform;
+    float split;
+    vec4 rect;
+    float depthRange;
+};
+
 struct Material {
     float specularIntensity;
     float shininess;
 };
 
-uniform int pointLightCount;
-uniform int spotLightCount;
-
 // Lights
 uniform DirectionalLight directionalLight;
-uniform PointLight pointLight[MAX_POINT_LIGHTS];
-uniform SpotLight spotLight[MAX_SPOT_LIGHTS];
+
+// Point lights first, then spot lights - Light i has slot i of the shadow atlas
+layout(std430, binding = 1) readonly buffer ClusterLights {
+    ClusterLight clusterLights[];
+};
+
+// Offset and count of the light list of every cluster
+layout(std430, binding = 2) readonly buffer ClusterGrid {
+    uvec2 clusterGrid[];
+};
+
+layout(std430, binding = 3) readonly buffer ClusterIndices {
+    uint clusterIndices[];
+};
+
+// Clusters along x, y and z, and the slice of a view depth - log(depth) * x + y
+uniform ivec3 clusterCount;
+uniform vec2 clusterDepth;
+
+// Same as the vertex shader, for the screen tile of the fragment
+uniform mat4 view;
+uniform mat4 projection;
 
 // Textures
 uniform sampler2D theTexture;
+// Atlas of every cascade
 uniform sampler2D directionalShadowMap;
-// Includes both points lights and spot lights
-uniform OmniShadowMap omniShadowMaps[MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS];
+uniform int cascadeCount;
+uniform Cascade cascades[MAX_CASCADES];
+// Depth of every point and spot light, distance to the light over the far plane
+uniform sampler2D shadowAtlas;
+
+// Blurred and mipmapped moments (Depth, depth squared in world units) of both atlases, replacing the PCF loops
+uniform bool isMomentShadows;
+uniform sampler2D directionalMoments;
+uniform sampler2D shadowAtlasMoments;
+
+// Offset and count of the list of every object, then the lists - Indices into the same lights as the clusters
+layout(std430, binding = 0) readonly buffer ObjectLightLists {
+    uint objectLightLists[];
+};
+
+// Only the lights of the list of the object instead of the list of the cluster of the fragment
+uniform bool isObjectLights;
+uniform int objectLights;
 
 // Materials
 uniform Material material;
@@ -78,14 +142,56 @@ vec3 sampleOffsetDirections[20] = vec3[]
    vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
 );
 
+// Chebyshev upper bound of the light reaching depth, the lowest values are cut off to hide light bleeding
+float calcMomentShadow(vec2 moments, float depth) {
+    if(depth <= moments.x) {
+        return 0.0;
+    }
+
+    float variance = max(moments.y - moments.x * moments.x, MOMENT_MIN_VARIANCE);
+    float distance_ = depth - moments.x;
+    float lit = variance / (variance + distance_ * distance_);
+
+    lit = clamp((lit - MOMENT_BLEED_REDUCTION) / (1.0 - MOMENT_BLEED_REDUCTION), 0.0, 1.0);
+
+    return 1.0 - lit;
+}
+
 float calcDirectionalShadowFactor(DirectionalLight light) {
-    vec3 projectionCoords = directionalLightSpacePos.xyz / directionalLightSpacePos.w;
+    // First cascade that reaches the fragment, nothing is shadowed past the last one
+    int cascade = 0;
+
+    while(cascade < cascadeCount && viewDepth > cascades[cascade].split) {
+        cascade++;
+    }
+
+    if(cascade == cascadeCount) {
+        return 0.0;
+    }
+
+    vec4 lightSpacePos = cascades[cascade].transform * vec4(fragPos, 1.0);
+    vec3 projectionCoords = lightSpacePos.xyz / lightSpacePos.w;
 
     // Normalizing coordinates
     projectionCoords = (projectionCoords * 0.5) + 0.5;
 
+    if(projectionCoords.z > 1.0) {
+        return 0.0;
+    }
+
     float current = projectionCoords.z;
 
+    // Tile of the cascade, the samples can't leave it
+    vec4 rect = cascades[cascade].rect;
+    vec2 tileCoords = rect.xy + projectionCoords.xy * rect.zw;
+
+    if(isMomentShadows) {
+        vec2 halfTexel = 0.5 / vec2(textureSize(directionalMoments, 0));
+        vec2 moments = textureLod(directionalMoments, clamp(tileCoords, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel), 0.0).rg;
+
+        return calcMomentShadow(moments, current * cascades[cascade].depthRange);
+    }
+
     vec3 normal = normalize(Normal);
     vec3 lightDir = normalize(directionalLight.direction);
 
@@ -95,40 +201,92 @@ float calcDirectionalShadowFactor(DirectionalLight light) {
 
     vec2 texelSize = 1.0 / textureSize(directionalShadowMap, 0);
 
+    vec2 tileMin = rect.xy + texelSize * 0.5;
+    vec2 tileMax = rect.xy + rect.zw - texelSize * 0.5;
+
     // Getting a 3x3 frame around the pixel and averaging
     for (int x = -1; x <= 1; ++x) {
         for (int y = -1; y <=1; ++y) {
-            float pcfDepth = texture(directionalShadowMap, projectionCoords.xy + vec2(x, y) * texelSize).r;
+            float pcfDepth = texture(directionalShadowMap, clamp(tileCoords + vec2(x, y) * texelSize, tileMin, tileMax)).r;
             shadow += current - bias > pcfDepth ? 1.0 : 0.0;
         }
     }
 
     shadow /= 9.0;
 
-    if(projectionCoords.z > 1.0) {
-        shadow = 0.0;
+    return shadow;
+}
+
+// Axes of the cube faces as drawn by PointLight::calculateLightTransform - Forward, right and up of every face
+const vec3 faceForward[6] = vec3[](vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
+const vec3 faceRight[6] = vec3[](vec3(0, 0, -1), vec3(0, 0, 1), vec3(1, 0, 0), vec3(1, 0, 0), vec3(1, 0, 0), vec3(-1, 0, 0));
+const vec3 faceUp[6] = vec3[](vec3(0, -1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1), vec3(0, -1, 0), vec3(0, -1, 0));
+
+// Atlas coordinates of direction (From the light) in the tiles of the light, kept inside the tile at mip level lod
+vec2 getShadowAtlasCoords(int shadowIndex, vec3 lightPosition, vec3 direction, bool isSpot, float lod) {
+    vec4 rect;
+    vec2 coords;
+
+    if(isSpot) {
+        vec4 lightSpacePos = clusterLights[shadowIndex].shadowTransform * vec4(lightPosition + direction, 1.0);
+        coords = (lightSpacePos.xy / lightSpacePos.w) * 0.5 + 0.5;
+        rect = clusterLights[shadowIndex].shadowTiles[0];
     }
 
-    return shadow;
+    else {
+        // Face of the major axis, then the 90 degree projection of that face
+        vec3 absDirection = abs(direction);
+        int face = absDirection.x >= absDirection.y && absDirection.x >= absDirection.z ? (direction.x > 0.0 ? 0 : 1) :
+                   absDirection.y >= absDirection.z ? (direction.y > 0.0 ? 2 : 3) : (direction.z > 0.0 ? 4 : 5);
+
+        float forward = dot(direction, faceForward[face]);
+        coords = vec2(dot(direction, faceRight[face]), dot(direction, faceUp[face])) / forward * 0.5 + 0.5;
+        rect = clusterLights[shadowIndex].shadowTiles[face];
+    }
+
+    // Samples stay half a texel of the coarsest level used inside the tile, the neighbours belong to other lights
+    vec2 halfTexel = 0.5 * exp2(ceil(lod)) / vec2(textureSize(shadowAtlas, 0));
+
+    return clamp(rect.xy + coords * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel);
 }
 
-float calcOmniShadowFactor(PointLight light, int shadowIndex) {
+// Closest distance the light sees along direction (From the light), through its tiles in the atlas
+float sampleLightShadow(int shadowIndex, vec3 lightPosition, vec3 direction, bool isSpot) {
+    vec2 coords = getShadowAtlasCoords(shadowIndex, lightPosition, direction, isSpot, 0.0);
+
+    return texture(shadowAtlas, coords).r * clusterLights[shadowIndex].farPlane;
+}
+
+float calcOmniShadowFactor(PointLight light, int shadowIndex, bool isSpot) {
+    // Light without a tile this frame
+    if(clusterLights[shadowIndex].shadowTiles[0].z == 0.0) {
+        return 0.0;
+    }
+
     vec3 fragToLight = fragPos - light.position;
     float current = length(fragToLight);
 
+    float viewDistance = length(eyePosition - fragPos);
+    float diskRadius = (1.0 + (viewDistance/clusterLights[shadowIndex].farPlane)) / 25.0;
+
+    if(isMomentShadows) {
+        // Mip whose texels are as wide as the PCF disk, a face is about 2 * current wide at that distance
+        float tileTexels = clusterLights[shadowIndex].shadowTiles[0].z * float(textureSize(shadowAtlasMoments, 0).x);
+        float texelWorld = 2.0 * current / tileTexels;
+        float lod = clamp(log2(diskRadius / texelWorld), 0.0, float(SHADOW_MOMENT_LEVELS - 1));
+
+        vec2 coords = getShadowAtlasCoords(shadowIndex, light.position, fragToLight, isSpot, lod);
+
+        return calcMomentShadow(textureLod(shadowAtlasMoments, coords, lod).rg, current);
+    }
+
     float shadow = 0.0;
     float bias = 0.05;
     int samples = 20;
 
-    float viewDistance = length(eyePosition - fragPos);
-    float diskRadius = (1.0 + (viewDistance/omniShadowMaps[shadowIndex].farPlane)) / 25.0;
-
     for(int i = 0; i < samples; i++) {
-        // Getting the first value for closest object
-        float closest = texture(omniShadowMaps[shadowIndex].shadowMap, fragToLight + sampleOffsetDirections[i] * diskRadius).r;
-
-        // Converting the normalized distance to normal
-        closest *= omniShadowMaps[shadowIndex].farPlane;
+        // Getting the value for closest object
+        float closest = sampleLightShadow(shadowIndex, light.position, fragToLight + sampleOffsetDirections[i] * diskRadius, isSpot);
 
         if(current - bias > closest) {
             shadow += 1.0;
@@ -174,7 +332,7 @@ vec4 calcDirectionalLight() {
     return calcLightByDirection(directionalLight.base, directionalLight.direction, shadowFactor);
 }
 
-vec4 calcPointLightsBase(PointLight pLight, int shadowIndex) {
+vec4 calcPointLightsBase(PointLight pLight, int shadowIndex, bool isSpot) {
     // Calculating Direction of our Point Lights
     // Getting direction from light to fragment
     vec3 direction = fragPos - pLight.position;
@@ -182,7 +340,7 @@ vec4 calcPointLightsBase(PointLight pLight, int shadowIndex) {
 
     direction = normalize(direction);
 
-    float shadowFactor = calcOmniShadowFactor(pLight, shadowIndex);
+    float shadowFactor = calcOmniShadowFactor(pLight, shadowIndex, isSpot);
 
     vec4 colour = calcLightByDirection(pLight.base, direction, shadowFactor);
 
@@ -201,7 +359,7 @@ vec4 calcSpotLightsBase(SpotLight sLight, int shadowIndex) {
 
     // If we are withing range
     if(slFactor > sLight.edge) {
-        colour = calcPointLightsBase(sLight.base, shadowIndex);
+        colour = calcPointLightsBase(sLight.base, shadowIndex, true);
         if(colour != vec4(0, 0, 0, 0)) {
             colour *= (1.0 - (1.0 - slFactor) * (1.0/(1.0 - sLight.edge)));
         }
@@ -210,21 +368,53 @@ vec4 calcSpotLightsBase(SpotLight sLight, int shadowIndex) {
     return colour;
 }
 
-vec4 calcPointLights() {
+// Point or spot light i, faded out before its range so it doesn't stop at the edge of the clusters
+vec4 calcLight(int index) {
+    ClusterLight light = clusterLights[index];
+
+    PointLight pLight = PointLight(Light(light.colour, light.ambientIntensity, light.diffuseIntensity),
+                                   light.position, light.constant, light.linear, light.exponent);
+
+    float distanceRatio = length(fragPos - light.position) / max(light.range, 1e-4);
+    float window = clamp(1.0 - distanceRatio * distanceRatio * distanceRatio * distanceRatio, 0.0, 1.0);
+
+    if(light.edge < -1.0) {
+        return calcPointLightsBase(pLight, index, false) * window * window;
+    }
+
+    return calcSpotLightsBase(SpotLight(pLight, light.direction, light.edge), index) * window * window;
+}
+
+uint getClusterIndex() {
+    // Screen tile and depth slice of the fragment in the view the lights were assigned for
+    vec4 clipPos = projection * view * vec4(fragPos, 1.0);
+    vec2 tile = clamp((clipPos.xy / clipPos.w * 0.5 + 0.5) * vec2(clusterCount.xy), vec2(0.0), vec2(clusterCount.xy - 1));
+
+    int slice = clamp(int(floor(log(max(viewDepth, 1e-4)) * clusterDepth.x + clusterDepth.y)), 0, clusterCount.z - 1);
+
+    return uint(tile.x) + uint(clusterCount.x) * (uint(tile.y) + uint(clusterCount.y) * uint(slice));
+}
+
+vec4 calcClusteredLights() {
     vec4 totalColour = vec4(0, 0, 0, 0);
 
-    for(int i = 0; i < pointLightCount; i++) {
-        totalColour += calcPointLightsBase(pointLight[i], i);
+    uvec2 list = clusterGrid[getClusterIndex()];
+
+    for(uint i = 0; i < list.y; i++) {
+        totalColour += calcLight(int(clusterIndices[list.x + i]));
     }
 
     return totalColour;
 }
 
-vec4 calcSpotLights() {
+vec4 calcObjectLights() {
     vec4 totalColour = vec4(0, 0, 0, 0);
 
-    for(int i = 0; i < spotLightCount; i++) {
-        totalColour += calcSpotLightsBase(spotLight[i], i + pointLightCount);
+    uint offset = objectLightLists[2 * objectLights];
+    uint count = objectLightLists[2 * objectLights + 1];
+
+    for(uint i = 0; i < count; i++) {
+        totalColour += calcLight(int(objectLightLists[offset + i]));
     }
 
     return totalColour;
@@ -232,8 +422,14 @@ vec4 calcSpotLights() {
 
 void main() {
     vec4 finalColour = calcDirectionalLight();
-    finalColour += calcPointLights();
-    finalColour += calcSpotLights();
+
+    if(isObjectLights) {
+        finalColour += calcObjectLights();
+    }
+
+    else {
+        finalColour += calcClusteredLights();
+    }
 
     colour = texture(theTexture, texCoord) * finalColour;
 }
@@ -18,20 +18,18 @@ out vec3 Normal;
 // For specular
 out vec3 fragPos;
 
-out vec4 directionalLightSpacePos;
+// Distance along the view direction, for picking the shadow cascade
+out float viewDepth;
 
 // MVP - Model, View, Projection Structure
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
-// Projection * View
-uniform mat4 directionalLightTransform;
-
 void main() {
     vec4 finalPosition = vec4(pos, 1.0);
     gl_Position = projection * view * model * finalPosition;
-    directionalLightSpacePos = directionalLightTransform * model * finalPosition;
+    viewDepth = -(view * model * finalPosition).z;
 
     texCoord = tex;
 
@@ -0,0 +1,392 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+
+ShadowAtlas::ShadowAtlas() : ShadowMap() {
+    frame = 0;
+}
+
+bool ShadowAtlas::initAtlas(GLuint size, GLuint slotCount) {
+    shadowWidth = size; shadowHeight = size;
+
+    // Every level of the tree down to the smallest tile, built once - Only the states change afterwards
+    nodes.clear();
+    nodes.push_back({ 0, 0, size, NODE_FREE });
+
+    for(size_t i = 0; nodes[i].size > SHADOW_ATLAS_MIN_TILE; i++) {
+        GLuint half = nodes[i].size / 2;
+
+        nodes.push_back({ nodes[i].x, nodes[i].y, half, NODE_FREE });
+        nodes.push_back({ nodes[i].x + half, nodes[i].y, half, NODE_FREE });
+        nodes.push_back({ nodes[i].x, nodes[i].y + half, half, NODE_FREE });
+        nodes.push_back({ nodes[i].x + half, nodes[i].y + half, half, NODE_FREE });
+    }
+
+    Slot emptySlot = {};
+    std::fill(emptySlot.nodes, emptySlot.nodes + SHADOW_ATLAS_FACES, -1);
+    slots.assign(slotCount, emptySlot);
+
+    glGenFramebuffers(1, &FBO);
+
+    glGenTextures(1, &shadowMap);
+    glState.bindTexture(0, GL_TEXTURE_2D, shadowMap);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, shadowWidth, shadowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    // For zooming out - Minify
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // For zooming in - Magnify
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // The shader keeps the samples inside the tiles, the edges never show
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap, 0);
+
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Frame buffer error : %i\n", status);
+        return false;
+    }
+
+    // One static layer per face of every slot, all in the same atlas
+    initCache(GL_TEXTURE_2D, slotCount * SHADOW_ATLAS_FACES);
+
+    return true;
+}
+
+GLint ShadowAtlas::allocateNode(GLint index, GLuint size) {
+    Node& node = nodes[index];
+
+    if(node.state == NODE_USED || node.size < size) {
+        return -1;
+    }
+
+    if(node.size == size) {
+        if(node.state != NODE_FREE) {
+            return -1;
+        }
+
+        node.state = NODE_USED;
+        return index;
+    }
+
+    // Children of a free node are all free, splitting it only changes its own state
+    bool wasFree = node.state == NODE_FREE;
+    node.state = NODE_SPLIT;
+
+    // Nodes that are already split first, so free space stays in big blocks
+    for(int pass = 0; pass < 2; pass++) {
+        for(GLint child = 4 * index + 1; child <= 4 * index + 4; child++) {
+            bool isPartlyUsed = nodes[child].state == NODE_SPLIT || nodes[child].size == size;
+
+            if(isPartlyUsed != (pass == 0)) {
+                continue;
+            }
+
+            GLint allocated = allocateNode(child, size);
+
+            if(allocated != -1) {
+                return allocated;
+            }
+        }
+    }
+
+    if(wasFree) {
+        node.state = NODE_FREE;
+    }
+
+    return -1;
+}
+
+void ShadowAtlas::releaseNode(GLint index) {
+    nodes[index].state = NODE_FREE;
+
+    while(index > 0) {
+        GLint parent = (index - 1) / 4;
+
+        for(GLint child = 4 * parent + 1; child <= 4 * parent + 4; child++) {
+            if(nodes[child].state != NODE_FREE) {
+                return;
+            }
+        }
+
+        nodes[parent].state = NODE_FREE;
+        index = parent;
+    }
+}
+
+bool ShadowAtlas::allocateSlot(GLuint slot, GLuint size) {
+    Slot& current = slots[slot];
+
+    for(GLuint face = 0; face < current.faceCount; face++) {
+        current.nodes[face] = allocateNode(0, size);
+
+        if(current.nodes[face] == -1) {
+            for(GLuint previous = 0; previous < face; previous++) {
+                releaseNode(current.nodes[previous]);
+                current.nodes[previous] = -1;
+            }
+
+            return false;
+        }
+    }
+
+    current.size = size;
+    current.lastUsedFrame = frame;
+    current.isResumed = false;
+
+    // Whatever was drawn in the tiles before belongs to another light
+    for(GLuint face = 0; face < SHADOW_ATLAS_FACES; face++) {
+        GLuint layer = slot * SHADOW_ATLAS_FACES + face;
+
+        layerTransforms[layer] = glm::mat4(0.0f);
+        isStaticDirty[layer] = true;
+    }
+
+    return true;
+}
+
+void ShadowAtlas::releaseSlot(GLuint slot) {
+    Slot& current = slots[slot];
+
+    for(GLuint face = 0; face < SHADOW_ATLAS_FACES; face++) {
+        if(current.nodes[face] != -1) {
+            releaseNode(current.nodes[face]);
+            current.nodes[face] = -1;
+        }
+    }
+
+    current.size = 0;
+}
+
+GLint ShadowAtlas::findEvictableSlot() const {
+    GLint evictable = -1;
+
+    for(GLuint i = 0; i < slots.size(); i++) {
+        if(!slots[i].size || slots[i].requestedSize) {
+            continue;
+        }
+
+        if(evictable == -1 || slots[i].lastUsedFrame < slots[evictable].lastUsedFrame) {
+            evictable = i;
+        }
+    }
+
+    return evictable;
+}
+
+void ShadowAtlas::beginFrame() {
+    frame++;
+
+    for(Slot& slot : slots) {
+        slot.requestedSize = 0;
+        slot.importance = 0.0f;
+    }
+}
+
+void ShadowAtlas::request(GLuint slot, GLuint faceCount, GLuint size, GLfloat importance) {
+    // Power of two between the smallest tile and the atlas
+    GLuint tileSize = SHADOW_ATLAS_MIN_TILE;
+
+    while(tileSize < size && tileSize < shadowWidth) {
+        tileSize *= 2;
+    }
+
+    // A light changing its kind can't keep tiles made for the other kind
+    if(slots[slot].faceCount != faceCount) {
+        releaseSlot(slot);
+        slots[slot].faceCount = faceCount < SHADOW_ATLAS_FACES ? faceCount : SHADOW_ATLAS_FACES;
+    }
+
+    slots[slot].requestedSize = tileSize;
+    slots[slot].importance = importance;
+}
+
+void ShadowAtlas::allocateRequests() {
+    std::vector<GLuint> requested;
+    GLuint64 area = 0;
+
+    for(GLuint i = 0; i < slots.size(); i++) {
+        if(slots[i].requestedSize) {
+            requested.push_back(i);
+            area += GLuint64(slots[i].faceCount) * slots[i].requestedSize * slots[i].requestedSize;
+        }
+    }
+
+    // Most important first
+    std::sort(requested.begin(), requested.end(), [this](GLuint a, GLuint b) {
+        return slots[a].importance > slots[b].importance;
+    });
+
+    // Halving the biggest requests first, the least important of them each time - Dropping lights only when all are at
+    // the smallest tile. Power of two squares sorted by size always fit in the quadtree when their area fits
+    const GLuint64 atlasArea = GLuint64(shadowWidth) * shadowHeight;
+
+    while(area > atlasArea && !requested.empty()) {
+        GLuint biggest = 0;
+
+        for(GLuint i : requested) {
+            biggest = slots[i].requestedSize > biggest ? slots[i].requestedSize : biggest;
+        }
+
+        Slot* shrunk = nullptr;
+
+        for(size_t i = requested.size(); i-- > 0;) {
+            if(slots[requested[i]].requestedSize == biggest) {
+                shrunk = &slots[requested[i]];
+                break;
+            }
+        }
+
+        GLuint64 oldArea = GLuint64(shrunk->faceCount) * shrunk->requestedSize * shrunk->requestedSize;
+
+        if(biggest > SHADOW_ATLAS_MIN_TILE) {
+            shrunk->requestedSize /= 2;
+            area -= oldArea - oldArea / 4;
+        }
+
+        else {
+            slots[requested.back()].requestedSize = 0;
+            area -= oldArea;
+            requested.pop_back();
+        }
+    }
+
+    // Lights asking for the size they have keep their tiles, the others give them back
+    std::vector<GLuint> pending;
+
+    for(GLuint i : requested) {
+        Slot& slot = slots[i];
+
+        if(slot.size == slot.requestedSize) {
+            slot.isResumed = slot.lastUsedFrame + 1 < frame;
+            slot.lastUsedFrame = frame;
+            continue;
+        }
+
+        releaseSlot(i);
+        pending.push_back(i);
+    }
+
+    // Biggest tiles first, evicting idle lights when they don't fit
+    std::stable_sort(pending.begin(), pending.end(), [this](GLuint a, GLuint b) {
+        return slots[a].requestedSize > slots[b].requestedSize;
+    });
+
+    bool isFragmented = false;
+
+    for(GLuint i : pending) {
+        while(!allocateSlot(i, slots[i].requestedSize)) {
+            GLint evicted = findEvictableSlot();
+
+            if(evicted == -1) {
+                isFragmented = true;
+                break;
+            }
+
+            releaseSlot(evicted);
+        }
+
+        if(isFragmented) {
+            break;
+        }
+    }
+
+    // The kept tiles left no room in the right places, every tile is placed again from an empty atlas
+    if(isFragmented) {
+        for(GLuint i = 0; i < slots.size(); i++) {
+            releaseSlot(i);
+        }
+
+        std::stable_sort(requested.begin(), requested.end(), [this](GLuint a, GLuint b) {
+            return slots[a].requestedSize > slots[b].requestedSize;
+        });
+
+        for(GLuint i : requested) {
+            allocateSlot(i, slots[i].requestedSize);
+        }
+    }
+}
+
+void ShadowAtlas::writeLayer(GLuint layer) {
+    const Node& tile = nodes[slots[layer / SHADOW_ATLAS_FACES].nodes[layer % SHADOW_ATLAS_FACES]];
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+
+    // Clearing only touches the tile with the scissor on, the caller turns it off after the pass
+    glViewport(tile.x, tile.y, tile.size, tile.size);
+    glScissor(tile.x, tile.y, tile.size, tile.size);
+    glEnable(GL_SCISSOR_TEST);
+}
+
+void ShadowAtlas::writeSlotFaces(GLuint slot) {
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+
+    for(GLuint face = 0; face < slots[slot].faceCount; face++) {
+        const Node& tile = nodes[slots[slot].nodes[face]];
+
+        glViewportIndexedf(face, GLfloat(tile.x), GLfloat(tile.y), GLfloat(tile.size), GLfloat(tile.size));
+        glScissorIndexed(face, tile.x, tile.y, tile.size, tile.size);
+    }
+
+    glEnable(GL_SCISSOR_TEST);
+}
+
+void ShadowAtlas::storeStatic(GLuint layer) {
+    const Node& tile = nodes[slots[layer / SHADOW_ATLAS_FACES].nodes[layer % SHADOW_ATLAS_FACES]];
+
+    glCopyImageSubData(shadowMap, GL_TEXTURE_2D, 0, tile.x, tile.y, 0,
+                       staticMap, GL_TEXTURE_2D, 0, tile.x, tile.y, 0,
+                       tile.size, tile.size, 1);
+
+    isStaticDirty[layer] = false;
+}
+
+void ShadowAtlas::restoreStatic(GLuint layer) {
+    const Node& tile = nodes[slots[layer / SHADOW_ATLAS_FACES].nodes[layer % SHADOW_ATLAS_FACES]];
+
+    glCopyImageSubData(staticMap, GL_TEXTURE_2D, 0, tile.x, tile.y, 0,
+                       shadowMap, GL_TEXTURE_2D, 0, tile.x, tile.y, 0,
+                       tile.size, tile.size, 1);
+}
+
+glm::uvec3 ShadowAtlas::getLayerTile(GLuint layer) const {
+    GLint node = slots[layer / SHADOW_ATLAS_FACES].nodes[layer % SHADOW_ATLAS_FACES];
+
+    if(node == -1) {
+        return glm::uvec3(0);
+    }
+
+    return glm::uvec3(nodes[node].x, nodes[node].y, nodes[node].size);
+}
+
+glm::vec4 ShadowAtlas::getLayerRect(GLuint layer) const {
+    GLint node = slots[layer / SHADOW_ATLAS_FACES].nodes[layer % SHADOW_ATLAS_FACES];
+
+    if(node == -1 || !getIsActive(layer / SHADOW_ATLAS_FACES)) {
+        return glm::vec4(0.0f);
+    }
+
+    const Node& tile = nodes[node];
+
+    return glm::vec4(GLfloat(tile.x) / shadowWidth, GLfloat(tile.y) / shadowHeight,
+                     GLfloat(tile.size) / shadowWidth, GLfloat(tile.size) / shadowHeight);
+}
+
+GLfloat ShadowAtlas::getUsage() const {
+    GLuint64 used = 0;
+
+    for(const Slot& slot : slots) {
+        used += GLuint64(slot.faceCount) * slot.size * slot.size;
+    }
+
+    return GLfloat(double(used) / (double(shadowWidth) * shadowHeight));
+}
+
+ShadowAtlas::~ShadowAtlas() {
+}
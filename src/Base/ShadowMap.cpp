@@ -3,6 +3,11 @@
 ShadowMap::ShadowMap() {
     FBO = 0;
     shadowMap = 0;
+    staticMap = 0;
+    textureTarget = GL_TEXTURE_2D;
+
+    momentsFBO = 0;
+    momentsMap = 0;
 }
 
 bool ShadowMap::init(unsigned int width, unsigned int height) {
@@ -12,7 +17,7 @@ bool ShadowMap::init(unsigned int width, unsigned int height) {
     glGenFramebuffers(1, &FBO);
 
     glGenTextures(1, &shadowMap);
-    glBindTexture(GL_TEXTURE_2D, shadowMap);
+    glState.bindTexture(0, GL_TEXTURE_2D, shadowMap);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 
     // For zooming out - Minify
@@ -40,16 +45,118 @@ bool ShadowMap::init(unsigned int width, unsigned int height) {
         return false;
     }
 
+    initCache(GL_TEXTURE_2D, 1);
+
     return true;
 }
 
+void ShadowMap::initCache(GLenum target, GLuint layerCount) {
+    textureTarget = target;
+
+    glGenTextures(1, &staticMap);
+    glState.bindTexture(0, target, staticMap);
+
+    // Only copied from, never sampled - Cube maps have a texture per face, 2D layers can share the texture
+    GLuint faceCount = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+
+    for(GLuint face = 0; face < faceCount; face++) {
+        GLenum faceTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+        glTexImage2D(faceTarget, 0, GL_DEPTH_COMPONENT, shadowWidth, shadowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    }
+
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    layerTransforms.assign(layerCount, glm::mat4(0.0f));
+    isStaticDirty.assign(layerCount, true);
+    isMomentsDirty.assign(layerCount, true);
+}
+
+void ShadowMap::invalidate() {
+    isStaticDirty.assign(isStaticDirty.size(), true);
+}
+
+void ShadowMap::updateLayerTransform(GLuint layer, const glm::mat4& lightTransform) {
+    if(layerTransforms[layer] != lightTransform) {
+        layerTransforms[layer] = lightTransform;
+        isStaticDirty[layer] = true;
+    }
+}
+
+void ShadowMap::storeStatic(GLuint layer) {
+    glCopyImageSubData(shadowMap, textureTarget, 0, 0, 0, layer,
+                       staticMap, textureTarget, 0, 0, 0, layer,
+                       shadowWidth, shadowHeight, 1);
+
+    isStaticDirty[layer] = false;
+}
+
+void ShadowMap::restoreStatic(GLuint layer) {
+    glCopyImageSubData(staticMap, textureTarget, 0, 0, 0, layer,
+                       shadowMap, textureTarget, 0, 0, 0, layer,
+                       shadowWidth, shadowHeight, 1);
+}
+
+glm::uvec3 ShadowMap::getLayerTile(GLuint /*layer*/) const {
+    return glm::uvec3(0, 0, shadowWidth);
+}
+
+bool ShadowMap::initMoments() {
+    if(momentsMap) {
+        return true;
+    }
+
+    glGenTextures(1, &momentsMap);
+    glState.bindTexture(0, GL_TEXTURE_2D, momentsMap);
+
+    // 32 bit floats, the square of the depth loses too much with halves
+    glTexStorage2D(GL_TEXTURE_2D, SHADOW_MOMENT_LEVELS, GL_RG32F, shadowWidth, shadowHeight);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // The shader keeps the samples inside the tiles, the edges never show
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, SHADOW_MOMENT_LEVELS - 1);
+
+    glGenFramebuffers(1, &momentsFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, momentsFBO);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, momentsMap, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Frame buffer error : %i\n", status);
+        return false;
+    }
+
+    // Nothing was filtered yet
+    isMomentsDirty.assign(isMomentsDirty.size(), true);
+
+    return true;
+}
+
+void ShadowMap::writeMoments() {
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, momentsFBO);
+}
+
+void ShadowMap::generateMomentMips() {
+    glState.bindTexture(0, GL_TEXTURE_2D, momentsMap);
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void ShadowMap::readMoments(GLenum textureUnit) {
+    glState.bindTexture(textureUnit - GL_TEXTURE0, GL_TEXTURE_2D, momentsMap);
+}
+
 void ShadowMap::write() {
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
 }
 
 void ShadowMap::read(GLenum textureUnit) {
-    glActiveTexture(textureUnit);
-    glBindTexture(GL_TEXTURE_2D, shadowMap);
+    glState.bindTexture(textureUnit - GL_TEXTURE0, GL_TEXTURE_2D, shadowMap);
 }
 
 ShadowMap::~ShadowMap() {
@@ -58,6 +165,21 @@ ShadowMap::~ShadowMap() {
     }
 
     if(shadowMap) {
+        glState.forgetTexture(shadowMap);
         glDeleteTextures(1, &shadowMap);
     }
+
+    if(staticMap) {
+        glState.forgetTexture(staticMap);
+        glDeleteTextures(1, &staticMap);
+    }
+
+    if(momentsFBO) {
+        glDeleteFramebuffers(1, &momentsFBO);
+    }
+
+    if(momentsMap) {
+        glState.forgetTexture(momentsMap);
+        glDeleteTextures(1, &momentsMap);
+    }
 }
@@ -13,7 +13,7 @@ Skybox::Skybox(std::vector<std::string> faceLocations) {
 
     // Texture setup
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, bitDepth;
 
@@ -101,8 +101,7 @@ void Skybox::drawSkybox(glm::mat4 viewMatrix, glm::mat4 projectionMatrix) {
     glUniformMatrix4fv(uniformProjection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
     glUniformMatrix4fv(uniformView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
     skyShader->validate();
 
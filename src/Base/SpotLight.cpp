@@ -6,6 +6,8 @@ SpotLight::SpotLight() : PointLight() {
     processedEdge = cosf(glm::radians(edge));
 
     isOn = true;
+
+    spotProj = glm::mat4(1.0f);
 }
 
 SpotLight::SpotLight(   GLuint shadowWidth, GLuint shadowHeight,
@@ -20,6 +22,11 @@ SpotLight::SpotLight(   GLuint shadowWidth, GLuint shadowHeight,
     edge = edg;
 
     processedEdge = cosf(glm::radians(edge));
+
+    isOn = true;
+
+    // Square frustum around the cone, the edge is the half angle
+    spotProj = glm::perspective(glm::radians(2.0f * edge), 1.0f, near, far);
 }
 
 void SpotLight::useLight(   GLuint ambientIntensityLocation, GLuint ambientColourLocation,
@@ -54,10 +61,34 @@ void SpotLight::useLight(   GLuint ambientIntensityLocation, GLuint ambientColou
     glUniform1f(edgeLocation, processedEdge);
 }
 
+void SpotLight::fillBlock(ClusterLightBlock& block) {
+    PointLight::fillBlock(block);
+
+    // Same as the uniforms used to get, and out of every cluster and object list
+    if(!isOn) {
+        block.ambientIntensity = 0.0f;
+        block.diffuseIntensity = 0.0f;
+        block.range = 0.0f;
+    }
+
+    // SpotLight Factors
+    block.direction = direction;
+    block.edge = processedEdge;
+
+    block.shadowTransform = calculateSpotTransform();
+}
+
 void SpotLight::setFlash(glm::vec3 pos, glm::vec3 dir) {
     position = pos;
     direction = dir;
 }
 
+glm::mat4 SpotLight::calculateSpotTransform() {
+    // Any up vector that isn't along the direction
+    glm::vec3 up = fabsf(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    return spotProj * glm::lookAt(position, position + direction, up);
+}
+
 SpotLight::~SpotLight() {
 }
@@ -25,7 +25,7 @@ bool Texture::loadTexture() {
     }
 
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
 
     // Setting parameter values
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -40,7 +40,7 @@ bool Texture::loadTexture() {
     glGenerateMipmap(GL_TEXTURE_2D);
 
     // Unbinding Texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
 
     // We have already copied the data
     stbi_image_free(texData);
@@ -57,7 +57,7 @@ bool Texture::loadTextureA() {
     }
 
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
 
     // Setting parameter values
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -72,7 +72,7 @@ bool Texture::loadTextureA() {
     glGenerateMipmap(GL_TEXTURE_2D);
 
     // Unbinding Texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
 
     // We have already copied the data
     stbi_image_free(texData);
@@ -81,12 +81,12 @@ bool Texture::loadTextureA() {
 }
 
 void Texture::useTexture() {
-    // Texture Unit
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    // Texture Unit 1, skipped if the texture is already bound there
+    glState.bindTexture(1, GL_TEXTURE_2D, textureID);
 }
 
 void Texture::cleanTexture() {
+    glState.forgetTexture(textureID);
     glDeleteTextures(1, &textureID);
     textureID = 0;
     width = 0;
@@ -39,3 +39,54 @@ void calcAverageNormals( unsigned int* indices, unsigned int indexCount,
         vertices[NOffset] = vec.x; vertices[NOffset + 1] = vec.y; vertices[NOffset + 2] = vec.z;
     }
 }
+
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+    // Rows of the matrix, GLM is column major
+    glm::vec4 rows[4];
+
+    for(int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    // Left, Right, Bottom, Top, Near, Far
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+
+    for(int i = 0; i < 6; i++) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+bool isBoxInFrustum(const glm::vec4 planes[6], const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    for(int i = 0; i < 6; i++) {
+        // Corner of the box furthest along the normal
+        glm::vec3 corner(planes[i].x >= 0.0f ? boxMax.x : boxMin.x,
+                         planes[i].y >= 0.0f ? boxMax.y : boxMin.y,
+                         planes[i].z >= 0.0f ? boxMax.z : boxMin.z);
+
+        if(glm::dot(glm::vec3(planes[i]), corner) + planes[i].w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void transformBounds(const glm::mat4& transform, const glm::vec3& localMin, const glm::vec3& localMax, glm::vec3& worldMin, glm::vec3& worldMax) {
+    // Center and extents, the extents are transformed by the absolute of the matrix
+    glm::vec3 center = glm::vec3(transform * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+    glm::vec3 extents = (localMax - localMin) * 0.5f;
+
+    glm::mat3 absolute = glm::mat3(transform);
+
+    for(int i = 0; i < 3; i++) {
+        absolute[i] = glm::abs(absolute[i]);
+    }
+
+    worldMin = center - absolute * extents;
+    worldMax = center + absolute * extents;
+}
@@ -27,6 +27,11 @@
 #include "DirectionalLight.h"
 #include "PointLight.h"
 #include "SpotLight.h"
+#include "ShadowAtlas.h"
+#include "MomentShadowFilter.h"
+#include "ObjectLights.h"
+#include "ClusteredLights.h"
+#include "JobSystem.h"
 #include "Utilities.h"
 #include "Material.h"
 
@@ -39,9 +44,14 @@
 // Converting to Radians
 const float toRadians = 3.14159265f / 180.0f;
 
+// Camera projection, the shadow cascades are fitted to the same frustum
+const float cameraFOV = 60.0f;
+const float cameraNear = 0.1f;
+const float cameraFar = 100.0f;
+
 // Setting uniforms
 GLuint  uniformProjection = 0, uniformModel = 0, uniformView = 0,
-        uniformEyePosition = 0, uniformSpecularIntensity = 0, uniformShininess = 0,
+        uniformEyePosition = 0, uniformSpecularIntensity = 0, uniformShininess = 0, uniformObjectLights = 0,
         uniformDirectionalLightTransform = 0,
         uniformOmniLightPos = 0, uniformFarPlane = 0;
 
@@ -53,6 +63,8 @@ std::vector<Mesh*> meshList;
 std::vector<Shader> shaderList;
 Shader directionalShadowShader;
 Shader omniShadowShader;
+Shader omniShadowFaceShader;
+Shader momentBlurShader;
 
 // Camera
 Camera camera;
@@ -63,13 +75,30 @@ Texture dirtTexture;
 
 // Lights - 1 Directional, Multiple Point
 DirectionalLight mainLight;
-PointLight pointLights[MAX_POINT_LIGHTS];
-SpotLight spotLights[MAX_SPOT_LIGHTS];
+std::vector<PointLight> pointLights;
+std::vector<SpotLight> spotLights;
 
-Skybox skybox;
+// Small point lights without shadows over the floor, after the spot lights - Toggled with J
+const int LAMP_GRID_SIZE = 8;
+std::vector<PointLight> lampLights;
+bool isLampLights = false;
+
+// Shadows of every point and spot light - Slot i is point light i, the spot lights come after the point lights
+ShadowAtlas* shadowAtlas = nullptr;
+
+// Prefilters the moments of both shadow atlases, created the first time moment shadows are on
+MomentShadowFilter* momentFilter = nullptr;
+
+// Lights reaching every object, rebuilt each frame once the torch followed the camera
+ObjectLights* objectLights = nullptr;
 
-unsigned int pointLightCount = 0;
-unsigned int spotLightCount = 0;
+// Worker threads for the light lists of the objects and of the clusters, started once instead of every frame
+JobSystem jobSystem;
+
+// Lights reaching every cluster of the view, the same lights as the object lists
+ClusteredLights* clusteredLights = nullptr;
+
+Skybox skybox;
 
 // Materials===========================================================================================================
 Material shinyMat;
@@ -100,6 +129,78 @@ Model cube1;
 Model cube2;
 Model cube3;
 
+// Scene Objects=======================================================================================================
+// Everything drawn by the passes, either a mesh or a model
+struct SceneObject {
+    Mesh* mesh;
+    Model* model;
+
+    // Only bound for meshes, models bind their own
+    Texture* texture;
+    Material* material;
+
+    glm::mat4 transform;
+
+    // World space bounds, updated with the transform
+    glm::vec3 boundsMin, boundsMax;
+
+    // Static objects are baked into the shadow caches, dynamic ones are drawn over the caches
+    bool isStatic;
+
+    // Moved this frame, and the bounds before the move
+    bool isMoved;
+    glm::vec3 previousMin, previousMax;
+
+    // Index of the light list of the object in the main pass
+    GLint lightList;
+};
+
+std::vector<SceneObject> sceneObjects;
+
+// A static object moved, every shadow cache has to be drawn again
+bool isStaticSceneDirty = false;
+
+// Index of the cube moving back and forth
+size_t movingCubeObject = 0;
+
+// Shadow Stats========================================================================================================
+// Face by face passes only draw the objects inside each face, the geometry shader sends everything to all 6 faces
+// Toggled with O, caching with K
+bool isOmniFaceCulling = true;
+bool isShadowCaching = true;
+
+// GPU timers and counters of the passes, printed every SHADOW_STATS_FRAMES frames - Off by default, toggled with P
+bool isShadowStats = false;
+
+// Single filtered fetch of the moments, or the PCF loops - Toggled with M, the main pass time is printed with the stats
+bool isMomentShadows = true;
+
+// Only the lights of the list of each object, or of the cluster of each fragment - Toggled with I
+bool isObjectLights = true;
+
+const int SHADOW_STATS_FRAMES = 120;
+
+// GPU time of the shadow passes, the query of the previous frame is read so the CPU doesn't wait for the current one
+GLuint shadowTimerQueries[2] = { 0, 0 };
+GLuint64 shadowTimeTotal = 0;
+GLuint64 shadowTrianglesTotal = 0;
+GLuint64 shadowTriangles = 0;
+GLuint64 shadowLayersTotal = 0;
+GLuint64 shadowLayers = 0;
+int shadowStatsFrame = 0;
+
+// GPU time of the main pass, and the shadowed lights it sampled
+GLuint mainPassTimerQueries[2] = { 0, 0 };
+GLuint64 mainPassTimeTotal = 0;
+GLuint64 shadowedLightsTotal = 0;
+
+// What a layer of a cached shadow map needs, nothing when neither the light nor the casters inside it moved
+enum ShadowUpdate {
+    SHADOW_UPDATE_NONE,
+    SHADOW_UPDATE_DYNAMIC,
+    SHADOW_UPDATE_ALL
+};
+
 // Delta Time
 GLfloat deltaTime = 0.0f;
 GLfloat lastTime = 0.0f;
@@ -181,54 +282,88 @@ void createShaders() {
     omniShadowShader.createFromFiles("D:/Programs/C++/Yumi/src/Base/Shaders/omniShadowMap.vert",
                                      "D:/Programs/C++/Yumi/src/Base/Shaders/omniShadowMap.frag",
                                      "D:/Programs/C++/Yumi/src/Base/Shaders/omniShadowMap.geom");
+
+    // Same depth as the geometry shader version, one face at a time
+    omniShadowFaceShader = Shader();
+    omniShadowFaceShader.createFromFiles("D:/Programs/C++/Yumi/src/Base/Shaders/omniShadowFace.vert",
+                                         "D:/Programs/C++/Yumi/src/Base/Shaders/omniShadowMap.frag");
+
+    // Depth of a shadow map layer to blurred moments
+    momentBlurShader = Shader();
+    momentBlurShader.createFromFiles("D:/Programs/C++/Yumi/src/Base/Shaders/momentBlur.vert",
+                                     "D:/Programs/C++/Yumi/src/Base/Shaders/momentBlur.frag");
 }
 
-float translateVal = 0.0f;
-float val = 0.01f;
+void setObjectTransform(SceneObject& object, const glm::mat4& transform) {
+    object.transform = transform;
 
-void renderScene() {
-    // Happens in a reverse order
-    // Translate
-    glm::mat4 model = glm::mat4(1.0f);
+    object.isMoved = true;
+    object.previousMin = object.boundsMin;
+    object.previousMax = object.boundsMax;
 
-    // // Trial Triangles=================================================================================================
-    // // Object 1
-    // model = glm::translate(model, glm::vec3(0.0f, 1.0f, -2.5f));
-    // glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
+    if(object.isStatic) {
+        isStaticSceneDirty = true;
+    }
 
-    // // Texturing the Mesh
-    // brickTexture.useTexture();
-    // shinyMat.useMaterial(uniformSpecularIntensity, uniformShininess);
-    // meshList[0]->renderMesh();
+    if(object.model) {
+        transformBounds(transform, object.model->getBoundsMin(), object.model->getBoundsMax(), object.boundsMin, object.boundsMax);
+    }
 
-    // // Clearing out the properties
-    // // Object 2
-    // model = glm::mat4(1.0f);
-    // model = glm::translate(model, glm::vec3(0.0f, 1.0f, -5.0f));
-    // glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
+    else {
+        transformBounds(transform, object.mesh->getBoundsMin(), object.mesh->getBoundsMax(), object.boundsMin, object.boundsMax);
+    }
+}
 
-    // // Texturing the Mesh
-    // dirtTexture.useTexture();
-    // roughMat.useMaterial(uniformSpecularIntensity, uniformShininess);
-    // meshList[1]->renderMesh();
+void addSceneObject(Mesh* mesh, Model* model, Texture* texture, Material* material, const glm::mat4& transform, bool isStatic = true) {
+    SceneObject object = {};
+    object.mesh = mesh;
+    object.model = model;
+    object.texture = texture;
+    object.material = material;
+    object.isStatic = isStatic;
 
-    // Object 3
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0f));
-    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
+    setObjectTransform(object, transform);
 
-    // Texturing the Mesh
-    brickTexture.useTexture();
-    extraRoughMat.useMaterial(uniformSpecularIntensity, uniformShininess);
-    meshList[2]->renderMesh();
+    // Nothing to erase from the shadow maps
+    object.previousMin = object.boundsMin;
+    object.previousMax = object.boundsMax;
 
-    // Cubes===========================================================================================================
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(5.0f, -1.0f, 3.0f));
+    sceneObjects.push_back(object);
+}
+
+void createSceneObjects() {
+    // Floor
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    addSceneObject(meshList[2], nullptr, &brickTexture, &extraRoughMat, model);
+
+    // Zombie
+    model = glm::translate(glm::mat4(1.0f), glm::vec3(5.0f, -1.0f, 3.0f));
     model = glm::scale(model, glm::vec3(0.125f / 4, 0.125f / 4, 0.125f / 4));
-    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-    extraRoughMat.useMaterial(uniformSpecularIntensity, uniformShininess);
-    zombie.renderModel();
+    addSceneObject(nullptr, &zombie, nullptr, &extraRoughMat, model);
+
+    // Cubes, the first one is moved every frame
+    movingCubeObject = sceneObjects.size();
+    addSceneObject(nullptr, &cube1, nullptr, &shinyMat, glm::mat4(1.0f), false);
+
+    model = glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 1.0f, 4.0f));
+    addSceneObject(nullptr, &cube2, nullptr, &normalMat, model);
+
+    model = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f, 1.0f, -4.0f));
+    addSceneObject(nullptr, &cube3, nullptr, &roughMat, model);
+}
+
+GLsizei getObjectTriangleCount(const SceneObject& object) {
+    return object.model ? object.model->getTriangleCount() : object.mesh->getTriangleCount();
+}
+
+float translateVal = 0.0f;
+float val = 0.01f;
+
+// Moves the objects, once per frame before any of the passes
+void updateScene() {
+    for(SceneObject& object : sceneObjects) {
+        object.isMoved = false;
+    }
 
     translateVal += val;
 
@@ -241,59 +376,221 @@ void renderScene() {
     }
 
     float translateY = 1.0f;
-    model = glm::mat4(1.0f);
+    glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(translateVal, translateY, 0.0f));
     model = glm::scale(model, glm::vec3(8.0f, 8.0f, 8.0f));
-    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-
-    shinyMat.useMaterial(uniformSpecularIntensity, uniformShininess);
-    cube1.renderModel();
-
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(3.0f, translateY, 4.0f));
-    // model = glm::scale(model, glm::vec3(8.0f, 8.0f, 8.0f));
-    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-    normalMat.useMaterial(uniformSpecularIntensity, uniformShininess);
-    cube2.renderModel();
-
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(-3.0f, translateY, -4.0f));
-    // model = glm::scale(model, glm::vec3(8.0f, 8.0f, 8.0f));
-    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-    roughMat.useMaterial(uniformSpecularIntensity, uniformShininess);
-    cube3.renderModel();
+
+    setObjectTransform(sceneObjects[movingCubeObject], model);
+
+    if(isStaticSceneDirty) {
+        mainLight.getShadowMap()->invalidate();
+        shadowAtlas->invalidate();
+
+        isStaticSceneDirty = false;
+    }
+}
+
+// Materials and textures are only set for the main pass, the shadow passes only need the depth
+void renderObject(const SceneObject& object, bool isShaded) {
+    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(object.transform));
+
+    if(isShaded) {
+        if(object.texture) {
+            object.texture->useTexture();
+        }
+
+        object.material->useMaterial(uniformSpecularIntensity, uniformShininess);
+
+        glUniform1i(uniformObjectLights, object.lightList);
+    }
+
+    if(object.model) {
+        object.model->renderModel();
+    }
+
+    else {
+        object.mesh->renderMesh();
+    }
+}
+
+void renderScene(bool isShaded) {
+    for(const SceneObject& object : sceneObjects) {
+        renderObject(object, isShaded);
+    }
+}
+
+ShadowUpdate getShadowUpdate(ShadowMap* shadowMap, GLuint layer, const glm::mat4& lightTransform, const glm::vec4 planes[6]) {
+    if(!isShadowCaching) {
+        return SHADOW_UPDATE_ALL;
+    }
+
+    shadowMap->updateLayerTransform(layer, lightTransform);
+
+    if(shadowMap->getIsStaticDirty(layer)) {
+        return SHADOW_UPDATE_ALL;
+    }
+
+    // Dynamic objects moving inside the layer, or out of it
+    for(const SceneObject& object : sceneObjects) {
+        if(object.isStatic || !object.isMoved) {
+            continue;
+        }
+
+        if(isBoxInFrustum(planes, object.boundsMin, object.boundsMax) || isBoxInFrustum(planes, object.previousMin, object.previousMax)) {
+            return SHADOW_UPDATE_DYNAMIC;
+        }
+    }
+
+    return SHADOW_UPDATE_NONE;
+}
+
+void renderShadowCasters(const glm::vec4 planes[6], bool withStatic, bool withDynamic) {
+    for(const SceneObject& object : sceneObjects) {
+        if(!(object.isStatic ? withStatic : withDynamic) || !isBoxInFrustum(planes, object.boundsMin, object.boundsMax)) {
+            continue;
+        }
+
+        renderObject(object, false);
+        shadowTriangles += getObjectTriangleCount(object);
+    }
+}
+
+// The layer has to be bound for drawing already
+void renderShadowLayer(ShadowMap* shadowMap, GLuint layer, ShadowUpdate update, const glm::vec4 planes[6]) {
+    shadowLayers++;
+    shadowMap->markMomentsDirty(layer);
+
+    if(!isShadowCaching) {
+        glClear(GL_DEPTH_BUFFER_BIT);
+        renderShadowCasters(planes, true, true);
+        return;
+    }
+
+    // Static casters are only drawn when the cache is out of date, otherwise the cache is copied back
+    if(update == SHADOW_UPDATE_ALL) {
+        glClear(GL_DEPTH_BUFFER_BIT);
+        renderShadowCasters(planes, true, false);
+
+        shadowMap->storeStatic(layer);
+    }
+
+    else {
+        shadowMap->restoreStatic(layer);
+    }
+
+    renderShadowCasters(planes, false, true);
 }
 
 void directionalShadowMapPass(DirectionalLight* light) {
-    directionalShadowShader.useShader();
+    CascadedShadowMap* shadowMap = light->getCascadedShadowMap();
+    GLuint cascadeCount = light->getCascadeCount();
 
-    glViewport(0, 0, light->getShadowMap()->getShadowWidth(), light->getShadowMap()->getShadowHeight());
+    // Every cascade is a layer of the cache, moving the camera only redraws the cascades that moved by a texel
+    glm::vec4 planes[MAX_CASCADES][6];
+    ShadowUpdate updates[MAX_CASCADES];
+    bool isAnyCascadeDirty = false;
 
-    light->getShadowMap()->write();
+    for(GLuint cascade = 0; cascade < cascadeCount; cascade++) {
+        extractFrustumPlanes(light->getCascadeTransform(cascade), planes[cascade]);
 
-    // Clear existing depth buffer information
-    glClear(GL_DEPTH_BUFFER_BIT);
+        updates[cascade] = getShadowUpdate(shadowMap, cascade, light->getCascadeTransform(cascade), planes[cascade]);
+        isAnyCascadeDirty |= updates[cascade] != SHADOW_UPDATE_NONE;
+    }
 
-    uniformModel = directionalShadowShader.getModelLocation();
+    if(!isAnyCascadeDirty) {
+        return;
+    }
 
-    directionalShadowShader.setDirectionalLightTransform(&light->calculateLightTransform());
+    directionalShadowShader.useShader();
+
+    uniformModel = directionalShadowShader.getModelLocation();
 
     directionalShadowShader.validate();
 
-    renderScene();
+    for(GLuint cascade = 0; cascade < cascadeCount; cascade++) {
+        if(updates[cascade] == SHADOW_UPDATE_NONE) {
+            continue;
+        }
+
+        shadowMap->writeCascade(cascade);
+
+        glm::mat4 cascadeTransform = light->getCascadeTransform(cascade);
+        directionalShadowShader.setDirectionalLightTransform(&cascadeTransform);
+
+        renderShadowLayer(shadowMap, cascade, updates[cascade], planes[cascade]);
+    }
+
+    glDisable(GL_SCISSOR_TEST);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void omniShadowMapPass(PointLight* light) {
-    omniShadowShader.useShader();
+// Share of the screen height covered by the range of the light, 0 when the range is outside the view
+GLfloat getLightCoverage(PointLight* light, const glm::vec4 planes[6]) {
+    GLfloat range = light->calculateRange();
+    glm::vec3 position = light->getPosition();
+
+    if(range <= 0.0f || !isBoxInFrustum(planes, position - glm::vec3(range), position + glm::vec3(range))) {
+        return 0.0f;
+    }
+
+    GLfloat distance = glm::length(position - camera.getCameraPosition());
+
+    if(distance <= range) {
+        return 1.0f;
+    }
+
+    // Angular radius of the range sphere over half the field of view
+    GLfloat coverage = tanf(asinf(range / distance)) / tanf(glm::radians(cameraFOV) * 0.5f);
+
+    return coverage < 1.0f ? coverage : 1.0f;
+}
+
+void requestLightShadow(PointLight* light, GLuint slot, GLuint faceCount, const glm::vec4 planes[6]) {
+    GLfloat coverage = getLightCoverage(light, planes);
+
+    if(coverage <= 0.0f) {
+        return;
+    }
+
+    // Tiles as big as the share of the screen the light can reach, closer lights win between lights covering the same
+    GLfloat distance = glm::length(light->getPosition() - camera.getCameraPosition());
+    GLfloat importance = coverage / (1.0f + distance / light->calculateRange());
+
+    shadowAtlas->request(slot, faceCount, GLuint(light->getShadowResolution() * coverage), importance);
+}
+
+// Tiles of this frame, lights outside the view and switched off spot lights don't ask for any
+void allocateShadowAtlas(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix) {
+    glm::vec4 planes[6];
+    extractFrustumPlanes(projectionMatrix * viewMatrix, planes);
+
+    shadowAtlas->beginFrame();
+
+    for(size_t i = 0; i < pointLights.size(); i++) {
+        requestLightShadow(&pointLights[i], GLuint(i), SHADOW_ATLAS_FACES, planes);
+    }
 
-    glViewport(0, 0, light->getShadowMap()->getShadowWidth(), light->getShadowMap()->getShadowHeight());
+    for(size_t i = 0; i < spotLights.size(); i++) {
+        if(spotLights[i].getIsOn()) {
+            requestLightShadow(&spotLights[i], GLuint(pointLights.size() + i), 1, planes);
+        }
+    }
 
-    light->getShadowMap()->write();
+    shadowAtlas->allocateRequests();
+}
 
-    // Clear existing depth buffer information
-    glClear(GL_DEPTH_BUFFER_BIT);
+void omniShadowMapPass(PointLight* light, GLuint slot) {
+    omniShadowShader.useShader();
+
+    // Clear existing depth of every face, a clear only uses the first scissor
+    for(GLuint face = 0; face < SHADOW_ATLAS_FACES; face++) {
+        shadowAtlas->writeLayer(slot * SHADOW_ATLAS_FACES + face);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // The geometry shader sends every triangle to the viewport of each face
+    shadowAtlas->writeSlotFaces(slot);
 
     uniformModel = omniShadowShader.getModelLocation();
 
@@ -307,11 +604,275 @@ void omniShadowMapPass(PointLight* light) {
 
     omniShadowShader.validate();
 
-    renderScene();
+    renderScene(false);
+
+    // Every triangle goes through the geometry shader to all the faces
+    shadowLayers += 6;
+
+    for(GLuint face = 0; face < SHADOW_ATLAS_FACES; face++) {
+        shadowAtlas->markMomentsDirty(slot * SHADOW_ATLAS_FACES + face);
+    }
+
+    for(const SceneObject& object : sceneObjects) {
+        shadowTriangles += 6 * getObjectTriangleCount(object);
+    }
+
+    glDisable(GL_SCISSOR_TEST);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+// One tile per light matrix - The 6 faces of a point light, or the cone of a spot light
+void omniShadowMapFacePass(PointLight* light, GLuint slot, const std::vector<glm::mat4>& lightMatrices) {
+    GLuint faceCount = GLuint(lightMatrices.size());
+
+    // Only the objects inside the frustum of each face are drawn, and only for the faces that changed
+    glm::vec4 planes[SHADOW_ATLAS_FACES][6];
+    ShadowUpdate updates[SHADOW_ATLAS_FACES];
+    bool isAnyFaceDirty = false;
+
+    for(GLuint face = 0; face < faceCount; face++) {
+        extractFrustumPlanes(lightMatrices[face], planes[face]);
+
+        updates[face] = getShadowUpdate(shadowAtlas, slot * SHADOW_ATLAS_FACES + face, lightMatrices[face], planes[face]);
+
+        // Tiles kept while the light wasn't drawn still hold the dynamic casters of back then
+        if(updates[face] == SHADOW_UPDATE_NONE && shadowAtlas->getIsResumed(slot)) {
+            updates[face] = SHADOW_UPDATE_DYNAMIC;
+        }
+
+        isAnyFaceDirty |= updates[face] != SHADOW_UPDATE_NONE;
+    }
+
+    if(!isAnyFaceDirty) {
+        return;
+    }
+
+    omniShadowFaceShader.useShader();
+
+    uniformModel = omniShadowFaceShader.getModelLocation();
+
+    uniformOmniLightPos = omniShadowFaceShader.getOmniLightPosLocation();
+    uniformFarPlane = omniShadowFaceShader.getFarPlaneLocation();
+
+    glUniform3f(uniformOmniLightPos, light->getPosition().x, light->getPosition().y, light->getPosition().z);
+    glUniform1f(uniformFarPlane, light->getFarPlane());
+
+    omniShadowFaceShader.validate();
+
+    for(GLuint face = 0; face < faceCount; face++) {
+        if(updates[face] == SHADOW_UPDATE_NONE) {
+            continue;
+        }
+
+        shadowAtlas->writeLayer(slot * SHADOW_ATLAS_FACES + face);
+
+        omniShadowFaceShader.setLightMatrix(lightMatrices[face]);
+
+        renderShadowLayer(shadowAtlas, slot * SHADOW_ATLAS_FACES + face, updates[face], planes[face]);
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Moments of every layer drawn since they were last filtered, then the mips of the maps that changed
+void momentFilterPass() {
+    ShadowMap* directionalMap = mainLight.getShadowMap();
+
+    if(!momentFilter) {
+        directionalMap->initMoments();
+        shadowAtlas->initMoments();
+
+        momentFilter = new MomentShadowFilter();
+        momentFilter->init(&momentBlurShader, glm::max(directionalMap->getShadowWidth(), shadowAtlas->getShadowWidth()),
+                           glm::max(directionalMap->getShadowHeight(), shadowAtlas->getShadowHeight()));
+    }
+
+    bool isDirectionalFiltered = false;
+
+    for(GLuint cascade = 0; cascade < mainLight.getCascadeCount(); cascade++) {
+        if(directionalMap->getIsMomentsDirty(cascade)) {
+            momentFilter->filterLayer(directionalMap, cascade, mainLight.getCascadeDepthRange(cascade));
+            isDirectionalFiltered = true;
+        }
+    }
+
+    bool isAtlasFiltered = false;
+
+    // Idle lights stay dirty until they are sampled again
+    for(GLuint slot = 0; slot < shadowAtlas->getSlotCount(); slot++) {
+        if(!shadowAtlas->getIsActive(slot)) {
+            continue;
+        }
+
+        bool isSpot = slot >= pointLights.size();
+        GLuint faceCount = isSpot ? 1 : SHADOW_ATLAS_FACES;
+        GLfloat farPlane = isSpot ? spotLights[slot - pointLights.size()].getFarPlane() : pointLights[slot].getFarPlane();
+
+        for(GLuint face = 0; face < faceCount; face++) {
+            if(shadowAtlas->getIsMomentsDirty(slot * SHADOW_ATLAS_FACES + face)) {
+                momentFilter->filterLayer(shadowAtlas, slot * SHADOW_ATLAS_FACES + face, farPlane);
+                isAtlasFiltered = true;
+            }
+        }
+    }
+
+    if(isDirectionalFiltered) {
+        directionalMap->generateMomentMips();
+    }
+
+    if(isAtlasFiltered) {
+        shadowAtlas->generateMomentMips();
+    }
+}
+
+// Starting over, so no query of a frame without stats is read
+void resetShadowStats() {
+    shadowStatsFrame = 0;
+    shadowTimeTotal = 0;
+    shadowTrianglesTotal = 0;
+    shadowLayersTotal = 0;
+    mainPassTimeTotal = 0;
+    shadowedLightsTotal = 0;
+}
+
+void printShadowStats() {
+    // Previous frame, done by now in most cases
+    if(shadowStatsFrame > 0) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(shadowTimerQueries[(shadowStatsFrame + 1) % 2], GL_QUERY_RESULT, &elapsed);
+
+        shadowTimeTotal += elapsed;
+    }
+
+    shadowTrianglesTotal += shadowTriangles;
+    shadowLayersTotal += shadowLayers;
+    shadowStatsFrame++;
+
+    if(shadowStatsFrame % SHADOW_STATS_FRAMES == 0) {
+        printf("Shadows (%s, %s) : %llu triangles, %.2f layers drawn, %.3f ms per frame, %.0f%% of the atlas used\n",
+               isOmniFaceCulling ? "Face culled" : "Geometry shader", isShadowCaching ? "Cached" : "Not cached",
+               static_cast<unsigned long long>(shadowTrianglesTotal / SHADOW_STATS_FRAMES),
+               double(shadowLayersTotal) / SHADOW_STATS_FRAMES, shadowTimeTotal / (SHADOW_STATS_FRAMES * 1e6),
+               shadowAtlas->getUsage() * 100.0);
+
+        shadowTrianglesTotal = 0;
+        shadowLayersTotal = 0;
+        shadowTimeTotal = 0;
+    }
+}
+
+// Every shadow map, timed on the GPU when the stats are on
+void shadowPasses(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix) {
+    if(isShadowStats) {
+        glBeginQuery(GL_TIME_ELAPSED, shadowTimerQueries[shadowStatsFrame % 2]);
+    }
+
+    directionalShadowMapPass(&mainLight);
+
+    allocateShadowAtlas(projectionMatrix, viewMatrix);
+
+    for(size_t i = 0; i < pointLights.size(); i++) {
+        if(!shadowAtlas->getIsActive(GLuint(i))) {
+            continue;
+        }
+
+        if(isOmniFaceCulling) {
+            omniShadowMapFacePass(&pointLights[i], GLuint(i), pointLights[i].calculateLightTransform());
+        }
+
+        else {
+            omniShadowMapPass(&pointLights[i], GLuint(i));
+        }
+    }
+
+    // A single tile for the cone, the same pass either way
+    for(size_t i = 0; i < spotLights.size(); i++) {
+        GLuint slot = GLuint(pointLights.size() + i);
+
+        if(shadowAtlas->getIsActive(slot)) {
+            omniShadowMapFacePass(&spotLights[i], slot, { spotLights[i].calculateSpotTransform() });
+        }
+    }
+
+    if(isMomentShadows) {
+        momentFilterPass();
+    }
+
+    if(isShadowStats) {
+        glEndQuery(GL_TIME_ELAPSED);
+        printShadowStats();
+    }
+
+    shadowTriangles = 0;
+    shadowLayers = 0;
+}
+
+// Tiles of the shadow slot of the light, left empty when it didn't get any this frame
+void setShadowTiles(ClusterLightBlock& block, GLuint slot) {
+    for(GLuint face = 0; face < SHADOW_ATLAS_FACES; face++) {
+        block.shadowTiles[face] = shadowAtlas->getLayerRect(slot * SHADOW_ATLAS_FACES + face);
+    }
+}
+
+// Same index in the clusters and in the object lists
+void addLight(const ClusterLightBlock& block) {
+    clusteredLights->addLight(block);
+
+    if(block.edge < -1.0f) {
+        objectLights->addPointLight(block.position, block.range);
+    }
+
+    else {
+        objectLights->addSpotLight(block.position, block.range, block.direction, block.edge);
+    }
+}
+
+// Lights are added in the order of their shadow slots, the spot lights after the point lights and the lamps last
+void assignLights(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix) {
+    clusteredLights->clearLights();
+    objectLights->clear();
+
+    ClusterLightBlock block;
+    GLuint slot = 0;
+
+    for(PointLight& light : pointLights) {
+        light.fillBlock(block);
+        setShadowTiles(block, slot++);
+        addLight(block);
+    }
+
+    for(SpotLight& light : spotLights) {
+        light.fillBlock(block);
+        setShadowTiles(block, slot++);
+        addLight(block);
+    }
+
+    if(isLampLights) {
+        for(PointLight& light : lampLights) {
+            light.fillBlock(block);
+            addLight(block);
+        }
+    }
+
+    // Only the lists the main pass reads this frame
+    if(isObjectLights) {
+        for(SceneObject& object : sceneObjects) {
+            object.lightList = objectLights->addObject(object.boundsMin, object.boundsMax);
+        }
+
+        objectLights->assignLights(&jobSystem);
+    }
+
+    else {
+        clusteredLights->assignLights(projectionMatrix, viewMatrix, &jobSystem);
+    }
+
+    clusteredLights->uploadBuffers();
+}
+
 void renderPass(glm::mat4 projectionMatrix, glm::mat4 viewMatrix) {
     // Setting initial GLFW Window
     glViewport(0, 0, 1366, 768);
@@ -335,6 +896,7 @@ void renderPass(glm::mat4 projectionMatrix, glm::mat4 viewMatrix) {
     uniformEyePosition = shaderList[0].getEyePositionLocation();
     uniformSpecularIntensity = shaderList[0].getSpecularIntensityLocation();
     uniformShininess = shaderList[0].getShininessLocation();
+    uniformObjectLights = shaderList[0].getObjectLightsLocation();
 
     glUniformMatrix4fv(uniformProjection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
     glUniformMatrix4fv(uniformView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
@@ -344,9 +906,9 @@ void renderPass(glm::mat4 projectionMatrix, glm::mat4 viewMatrix) {
 
     // Lights
     shaderList[0].setDirectionalLight(&mainLight);
-    shaderList[0].setPointLight(pointLights, pointLightCount, 3, 0);
-    shaderList[0].setSpotLight(spotLights, spotLightCount, 3 + pointLightCount, pointLightCount);
-    shaderList[0].setDirectionalLightTransform(&mainLight.calculateLightTransform());
+    shaderList[0].setDirectionalCascades(&mainLight);
+    shaderList[0].setShadowAtlas(shadowAtlas, 3);
+    shaderList[0].setMomentShadows(isMomentShadows, &mainLight, 4, shadowAtlas, 5);
 
     mainLight.getShadowMap()->read(GL_TEXTURE2);
 
@@ -361,9 +923,78 @@ void renderPass(glm::mat4 projectionMatrix, glm::mat4 viewMatrix) {
     // Getting torch control
     spotLights[0].setFlash(lowerLight, camera.getCameraDirection());
 
+    assignLights(projectionMatrix, viewMatrix);
+
+    shaderList[0].setObjectLights(isObjectLights);
+    shaderList[0].setClusteredLights(clusteredLights);
+
     shaderList[0].validate();
 
-    renderScene();
+    renderScene(true);
+}
+
+// Main pass timed on the GPU, so the shadow lookups of PCF and moment shadows can be compared on the same view
+void timedRenderPass(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix) {
+    // Same frame numbering as the shadow stats, which are counted already
+    glBeginQuery(GL_TIME_ELAPSED, mainPassTimerQueries[shadowStatsFrame % 2]);
+
+    renderPass(projectionMatrix, viewMatrix);
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    if(shadowStatsFrame > 1) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(mainPassTimerQueries[(shadowStatsFrame + 1) % 2], GL_QUERY_RESULT, &elapsed);
+
+        mainPassTimeTotal += elapsed;
+    }
+
+    // Directional light and the point and spot lights with tiles
+    shadowedLightsTotal++;
+
+    for(GLuint slot = 0; slot < shadowAtlas->getSlotCount(); slot++) {
+        shadowedLightsTotal += shadowAtlas->getIsActive(slot) ? 1 : 0;
+    }
+
+    if(shadowStatsFrame % SHADOW_STATS_FRAMES == 0) {
+        double frameTime = mainPassTimeTotal / (SHADOW_STATS_FRAMES * 1e6);
+        double lightCount = double(shadowedLightsTotal) / SHADOW_STATS_FRAMES;
+
+        printf("Main pass (%s) : %.3f ms per frame, %.2f shadowed lights, %.3f ms per shadowed light\n",
+               isMomentShadows ? "Moment shadows" : "PCF shadows", frameTime, lightCount, frameTime / lightCount);
+
+        if(isObjectLights) {
+            printf("Object lights : %zu objects, %.2f of %zu lights per object\n", objectLights->getObjectCount(),
+                   objectLights->getAverageObjectLights(), objectLights->getLightCount());
+        }
+
+        else {
+            printf("Clustered lights : %.2f of %zu lights per cluster, %u at most, %.3f ms to assign\n",
+                   clusteredLights->getAverageClusterLights(), clusteredLights->getLightCount(),
+                   clusteredLights->getMaxClusterLights(), clusteredLights->getAssignTime());
+        }
+
+        mainPassTimeTotal = 0;
+        shadowedLightsTotal = 0;
+    }
+}
+
+// Grid of lamps over the floor, cycling through a few colours
+void createLampLights() {
+    glm::vec3 colours[] = { glm::vec3(1.0f, 0.6f, 0.2f), glm::vec3(0.2f, 0.6f, 1.0f), glm::vec3(0.6f, 1.0f, 0.3f), glm::vec3(1.0f, 0.3f, 0.8f) };
+
+    for(int z = 0; z < LAMP_GRID_SIZE; z++) {
+        for(int x = 0; x < LAMP_GRID_SIZE; x++) {
+            glm::vec3 colour = colours[(x + z) % 4];
+
+            lampLights.push_back(PointLight( 0, 0,
+                                             0.01f, 100.0f,
+                                             colour.r, colour.g, colour.b,
+                                             0.0f, 1.0f,
+                                             x * 4.0f - 14.0f, -0.5f, z * 4.0f - 14.0f,
+                                             1.0f, 2.0f, 8.0f ));
+        }
+    }
 }
 
 int main() {
@@ -402,60 +1033,70 @@ int main() {
     // zombie = Model();
     zombie.loadModel("D:/Programs/C++/Yumi/src/Base/Models/Zombie Walk.dae");
 
+    createSceneObjects();
+
     // Setting up lights
-    // Since we will be using cube map, we are using square values for texture
-    int shadowMapResScale = 8;
-    mainLight = DirectionalLight( 1024 * shadowMapResScale, 1024 * shadowMapResScale,
+    // Point and spot lights get square tiles of up to their shadow size in the shadow atlas
+    // Cascades from the nearest to the farthest, packed into a 4096x2048 atlas
+    GLuint cascadeResolutions[] = { 2048, 1024, 1024, 1024 };
+    mainLight = DirectionalLight( cascadeResolutions, 4,
 								  1.0f, 1.0f, 1.0f,
 								  .1f, 0.5f,
 								  0.0f, -15.0f, -5.0f );
     // Point Lights
-    pointLights[0] = PointLight( 1024, 1024,
+    pointLights.push_back(PointLight( 1024, 1024,
                                  0.01f, 1000.0f,
                                  0.0f, 0.0f, 1.0f,
 								 1.0f, 1.5f,
 								 0.0f, 2.0f, 0.0f,
-								 0.3f, 0.2f, 0.1f );
-    pointLightCount++;
+								 0.3f, 0.2f, 0.1f ));
 
-    pointLights[1] = PointLight( 1024, 1024,
+    pointLights.push_back(PointLight( 1024, 1024,
                                  0.01f, 1000.0f,
                                  0.0f, 1.0f, 0.0f,
 								 1.0f, 1.5f,
 								 -4.0f, 3.0f, 0.0f,
-								 0.3f, 0.2f, 0.1f );
-    pointLightCount++;
+								 0.3f, 0.2f, 0.1f ));
 
-    pointLights[2] = PointLight( 1024, 1024,
+    pointLights.push_back(PointLight( 1024, 1024,
                                  0.01f, 1000.0f,
                                  1.0f, 0.0f, 0.0f,
 								 1.0f, 1.5f,
 								 -4.0f, 2.0f, -4.0f,
-								 0.3f, 0.2f, 0.1f );
-    pointLightCount++;
+								 0.3f, 0.2f, 0.1f ));
 
     // Spot Lights
     // This is our torch
-    spotLights[0] = SpotLight(  1024, 1024,
+    spotLights.push_back(SpotLight(  1024, 1024,
                                 0.01f, 1000.0f,
                                 1.0f, 1.0f, 1.0f,
                                 0.5f, 2.0f,
                                 0.0f, 0.0f, 0.0f,
                                 0.0f, -1.0f, 0.0f,
                                 1.0f, 0.0f, 0.0f,
-                                20.0f );
-    spotLightCount++;
+                                20.0f ));
 
-    spotLights[1] = SpotLight(  1024, 1024,
+    spotLights.push_back(SpotLight(  1024, 1024,
                                 0.01f, 1000.0f,
                                 1.0f, 1.0f, 1.0f,
                                 0.75f, 1.0f,
                                 3.0f, -1.5f, -3.0f,
                                 0.0f, -1.0f, -45.0f,
                                 1.0f, 0.0f, 0.0f,
-                                20.0f );
+                                20.0f ));
 
-	spotLightCount++;
+    createLampLights();
+
+    shadowAtlas = new ShadowAtlas();
+    shadowAtlas->initAtlas(SHADOW_ATLAS_SIZE, GLuint(pointLights.size() + spotLights.size()));
+
+    objectLights = new ObjectLights();
+    objectLights->createBuffer();
+
+    jobSystem.createWorkers();
+
+    clusteredLights = new ClusteredLights();
+    clusteredLights->createBuffers();
 
     // Skybox
     std::vector<std::string> skyboxFaces;
@@ -472,7 +1113,11 @@ int main() {
 
     skybox = Skybox(skyboxFaces);
 
-    glm::mat4 projection = glm::perspective(glm::radians(60.0f), GLfloat(mainWindow.getBufferWidht())/GLfloat(mainWindow.getBufferHeight()), 0.1f, 100.0f);
+    glGenQueries(2, shadowTimerQueries);
+    glGenQueries(2, mainPassTimerQueries);
+
+    GLfloat aspect = GLfloat(mainWindow.getBufferWidht())/GLfloat(mainWindow.getBufferHeight());
+    glm::mat4 projection = glm::perspective(glm::radians(cameraFOV), aspect, cameraNear, cameraFar);
 
     // Main Loop - Running till the window is open
     while(!mainWindow.getShouldClose()) {
@@ -496,22 +1141,62 @@ int main() {
             mainWindow.getKeys()[GLFW_KEY_L] = false;
         }
 
-        // Renders the pass to frame buffer which stores it in a texture
-        directionalShadowMapPass(&mainLight);
+        // Switching between face culled and geometry shader omni shadows on pressing O
+        if(mainWindow.getKeys()[GLFW_KEY_O]) {
+            isOmniFaceCulling = !isOmniFaceCulling;
+            mainWindow.getKeys()[GLFW_KEY_O] = false;
+        }
+
+        // Switching between moment and PCF shadow lookups on pressing M
+        if(mainWindow.getKeys()[GLFW_KEY_M]) {
+            isMomentShadows = !isMomentShadows;
+            mainWindow.getKeys()[GLFW_KEY_M] = false;
+        }
+
+        // Switching between the light lists of the objects and of the clusters on pressing I
+        if(mainWindow.getKeys()[GLFW_KEY_I]) {
+            isObjectLights = !isObjectLights;
+            mainWindow.getKeys()[GLFW_KEY_I] = false;
+        }
+
+        // Switching the lamps on and off on pressing J
+        if(mainWindow.getKeys()[GLFW_KEY_J]) {
+            isLampLights = !isLampLights;
+            mainWindow.getKeys()[GLFW_KEY_J] = false;
+        }
 
-        // Omni Shadow Passes
-        for(size_t i = 0; i < pointLightCount; i++) {
-            omniShadowMapPass(&pointLights[i]);
+        // Switching the shadow caches on and off on pressing K
+        if(mainWindow.getKeys()[GLFW_KEY_K]) {
+            isShadowCaching = !isShadowCaching;
+            mainWindow.getKeys()[GLFW_KEY_K] = false;
         }
 
-        for(size_t i = 0; i < spotLightCount; i++) {
-            omniShadowMapPass(&spotLights[i]);
+        // Timing the passes and printing their stats on pressing P
+        if(mainWindow.getKeys()[GLFW_KEY_P]) {
+            isShadowStats = !isShadowStats;
+            resetShadowStats();
+            mainWindow.getKeys()[GLFW_KEY_P] = false;
         }
 
-        renderPass(projection, camera.calculateViewMatrix());
+        updateScene();
+
+        // Fitting the cascades to the view of this frame
+        glm::mat4 view = camera.calculateViewMatrix();
+        mainLight.calculateCascades(view, glm::radians(cameraFOV), aspect, cameraNear, cameraFar);
+
+        // Renders the passes to frame buffers which store them in textures, only the parts that changed
+        shadowPasses(projection, view);
+
+        if(isShadowStats) {
+            timedRenderPass(projection, view);
+        }
+
+        else {
+            renderPass(projection, view);
+        }
 
         // Un-Binding the program
-        glUseProgram(0);
+        glState.useProgram(0);
 
         // We have 2 scenes, one which we are drawing to and one current
         mainWindow.swapBuffers();
@@ -16,7 +16,7 @@ void Bones::createBone(GLfloat * vertices, unsigned int * indices, unsigned int
 
     // Creating and gettting the vertex ID of a VAO
     glCreateVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    glState.bindVertexArray(VAO);
 
         // Creating the Index Buffer Object
         glGenBuffers(1, &IBO);
@@ -40,7 +40,7 @@ void Bones::createBone(GLfloat * vertices, unsigned int * indices, unsigned int
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     // Un-Binding Vertex Array
-    glBindVertexArray(0);
+    glState.bindVertexArray(0);
 
     // Un-Binding IBO/EBO after VAO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -64,13 +64,9 @@ void Bones::renderBones() {
     }
 
     // Binding the Vertex Array for Drawing
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    glState.bindVertexArray(VAO);
         // Drawing the Elements (Since we are using Indexed arrays)
         glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
 }
 
 void Bones::cleanBones() {
@@ -87,6 +83,7 @@ void Bones::cleanBones() {
 
     // Preventing overflow, garbage collection
     if(VAO) {
+        glState.forgetVertexArray(VAO);
         glDeleteVertexArrays(1, &VAO);
         VAO = 0;
     }
@@ -0,0 +1,490 @@
+#include "ClusteredLights.h"
+
+// SIMD intrinsics - SSE is always there on x64
+#include <immintrin.h>
+#include <limits>
+
+#include "PointLight.h"
+
+// Lights the buffer has room for before it has to grow
+const size_t CLUSTER_INITIAL_LIGHTS = 256;
+
+// Every cluster of every view
+const size_t CLUSTERS_PER_SLICE = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y;
+const size_t CLUSTERS_PER_VIEW = CLUSTERS_PER_SLICE * LIGHT_CLUSTERS_Z;
+
+// 4 spheres against a box, bit i is set if sphere i touches it - Squared distance from the center to the box
+int sphereBoxMask(const float* x, const float* y, const float* z, const float* radius,
+                         const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    __m128 centerX = _mm_loadu_ps(x);
+    __m128 centerY = _mm_loadu_ps(y);
+    __m128 centerZ = _mm_loadu_ps(z);
+    __m128 radius4 = _mm_loadu_ps(radius);
+    __m128 zero = _mm_setzero_ps();
+
+    // Distance along every axis, 0 inside the box
+    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.x), centerX), _mm_sub_ps(centerX, _mm_set1_ps(boxMax.x))), zero);
+    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.y), centerY), _mm_sub_ps(centerY, _mm_set1_ps(boxMax.y))), zero);
+    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.z), centerZ), _mm_sub_ps(centerZ, _mm_set1_ps(boxMax.z))), zero);
+
+    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+    return _mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(radius4, radius4)));
+}
+
+// Distance from the center to the side of the cone against the radius, and both caps along the axis
+bool isConeInSphere(const glm::vec3& apex, const glm::vec3& direction, float cosine, float range,
+                           const glm::vec3& center, float radius) {
+    glm::vec3 toCenter = center - apex;
+    float distanceSquared = glm::dot(toCenter, toCenter);
+    float alongAxis = glm::dot(toCenter, direction);
+    float sine = glm::sqrt(glm::max(1.0f - cosine * cosine, 0.0f));
+
+    // Distance from the center to the side of the cone
+    float coneDistance = cosine * glm::sqrt(glm::max(distanceSquared - alongAxis * alongAxis, 0.0f)) - alongAxis * sine;
+
+    return !(coneDistance > radius || alongAxis > radius + range || alongAxis < -radius);
+}
+
+// Constructor
+ClusteredLights::ClusteredLights() {
+    viewCount = 0;
+
+    depthScale = 0.0f;
+    depthBias = 0.0f;
+
+    lightsBuffer = 0;
+    gridBuffer = 0;
+    indicesBuffer = 0;
+
+    lightsCapacity = 0;
+    gridCapacity = 0;
+    indicesCapacity = 0;
+
+    maxClusterLights = 0;
+    assignTime = 0.0;
+
+    for(int view = 0; view < MAX_VIEWS; view++) {
+        views[view].projection = glm::mat4(0.0f);
+        views[view].nearPlane = 0.0f;
+        views[view].farPlane = 0.0f;
+    }
+
+    slices.resize(MAX_VIEWS * LIGHT_CLUSTERS_Z);
+}
+
+void ClusteredLights::createBuffers() {
+    cleanBuffers();
+
+    // Room for the lists of both views with one light per cluster, grown by updateBuffer if needed
+    lightsCapacity = sizeof(ClusterLightBlock) * CLUSTER_INITIAL_LIGHTS;
+    gridCapacity = sizeof(glm::uvec2) * CLUSTERS_PER_VIEW * MAX_VIEWS;
+    indicesCapacity = sizeof(GLuint) * CLUSTERS_PER_VIEW * MAX_VIEWS;
+
+    glGenBuffers(1, &lightsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightsBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, lightsCapacity, nullptr, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &gridBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gridBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, gridCapacity, nullptr, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &indicesBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indicesBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, indicesCapacity, nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHTS_BINDING, lightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_GRID_BINDING, gridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDICES_BINDING, indicesBuffer);
+}
+
+void ClusteredLights::clearLights() {
+    lights.clear();
+}
+
+void ClusteredLights::addLight(const ClusterLightBlock& light) {
+    if(light.range > 0.0f) {
+        lights.push_back(light);
+    }
+}
+
+float ClusteredLights::getSliceDepth(int slice, float nearPlane, float farPlane) const {
+    return nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice) / LIGHT_CLUSTERS_Z);
+}
+
+void ClusteredLights::buildClusterBounds(ViewClusters& clusters, const glm::mat4& projection, float nearPlane, float farPlane) {
+    clusters.projection = projection;
+    clusters.nearPlane = nearPlane;
+    clusters.farPlane = farPlane;
+
+    clusters.boundsMin.resize(CLUSTERS_PER_VIEW);
+    clusters.boundsMax.resize(CLUSTERS_PER_VIEW);
+
+    glm::mat4 inverseProjection = glm::inverse(projection);
+
+    for(int z = 0; z < LIGHT_CLUSTERS_Z; z++) {
+        clusters.sliceMin[z] = glm::vec3(std::numeric_limits<float>::max());
+        clusters.sliceMax[z] = glm::vec3(-std::numeric_limits<float>::max());
+    }
+
+    for(int y = 0; y < LIGHT_CLUSTERS_Y; y++) {
+        for(int x = 0; x < LIGHT_CLUSTERS_X; x++) {
+            // Rays from the eye through the corners of the tile, scaled to a depth of 1
+            glm::vec3 rays[4];
+
+            for(int corner = 0; corner < 4; corner++) {
+                float ndcX = -1.0f + 2.0f * static_cast<float>(x + (corner & 1)) / LIGHT_CLUSTERS_X;
+                float ndcY = -1.0f + 2.0f * static_cast<float>(y + (corner >> 1)) / LIGHT_CLUSTERS_Y;
+
+                glm::vec4 nearPoint = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                nearPoint /= nearPoint.w;
+
+                rays[corner] = glm::vec3(nearPoint) / -nearPoint.z;
+            }
+
+            // Box around the part of the tile between the depths of every slice
+            for(int z = 0; z < LIGHT_CLUSTERS_Z; z++) {
+                float sliceNear = getSliceDepth(z, nearPlane, farPlane);
+                float sliceFar = getSliceDepth(z + 1, nearPlane, farPlane);
+
+                glm::vec3 boundsMin(std::numeric_limits<float>::max());
+                glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+
+                for(int corner = 0; corner < 4; corner++) {
+                    boundsMin = glm::min(boundsMin, glm::min(rays[corner] * sliceNear, rays[corner] * sliceFar));
+                    boundsMax = glm::max(boundsMax, glm::max(rays[corner] * sliceNear, rays[corner] * sliceFar));
+                }
+
+                size_t cluster = x + LIGHT_CLUSTERS_X * (y + LIGHT_CLUSTERS_Y * z);
+                clusters.boundsMin[cluster] = boundsMin;
+                clusters.boundsMax[cluster] = boundsMax;
+
+                clusters.sliceMin[z] = glm::min(clusters.sliceMin[z], boundsMin);
+                clusters.sliceMax[z] = glm::max(clusters.sliceMax[z], boundsMax);
+            }
+        }
+    }
+}
+
+void ClusteredLights::assignSlice(int view, int slice) {
+    SliceWork& work = slices[view * LIGHT_CLUSTERS_Z + slice];
+    const ViewClusters& clusters = views[view];
+
+    work.candidates.clear();
+    work.candidateX.clear();
+    work.candidateY.clear();
+    work.candidateZ.clear();
+    work.candidateRadius.clear();
+    work.indices.clear();
+    work.counts.assign(CLUSTERS_PER_SLICE, 0);
+
+    const float* x = lightX[view].data();
+    const float* y = lightY[view].data();
+    const float* z = lightZ[view].data();
+    const float* radius = lightRadius.data();
+    size_t lightCount = lights.size();
+
+    auto addCandidate = [&](size_t light) {
+        work.candidates.push_back(static_cast<GLuint>(light));
+        work.candidateX.push_back(x[light]);
+        work.candidateY.push_back(y[light]);
+        work.candidateZ.push_back(z[light]);
+        work.candidateRadius.push_back(radius[light]);
+    };
+
+    // Lights touching the bounds of the whole slice, same test as the clusters below
+    const glm::vec3& sliceMin = clusters.sliceMin[slice];
+    const glm::vec3& sliceMax = clusters.sliceMax[slice];
+
+    size_t i = 0;
+
+    for(; i + 4 <= lightCount; i += 4) {
+        int mask = sphereBoxMask(x + i, y + i, z + i, radius + i, sliceMin, sliceMax);
+
+        for(int lane = 0; lane < 4; lane++) {
+            if(mask & (1 << lane)) {
+                addCandidate(i + lane);
+            }
+        }
+    }
+
+    for(; i < lightCount; i++) {
+        glm::vec3 center(x[i], y[i], z[i]);
+        glm::vec3 offset = center - glm::clamp(center, sliceMin, sliceMax);
+
+        if(glm::dot(offset, offset) <= radius[i] * radius[i]) {
+            addCandidate(i);
+        }
+    }
+
+    size_t candidateCount = work.candidates.size();
+
+    if(!candidateCount) {
+        return;
+    }
+
+    // Padded to a multiple of 4 with spheres that are too far away to touch any cluster
+    while(work.candidateX.size() % 4) {
+        work.candidateX.push_back(std::numeric_limits<float>::max());
+        work.candidateY.push_back(0.0f);
+        work.candidateZ.push_back(0.0f);
+        work.candidateRadius.push_back(0.0f);
+    }
+
+    size_t paddedCount = work.candidateX.size();
+    const float* candidateX = work.candidateX.data();
+    const float* candidateY = work.candidateY.data();
+    const float* candidateZ = work.candidateZ.data();
+    const float* candidateRadius = work.candidateRadius.data();
+
+    // Every cluster of the slice against 4 candidates at a time
+    for(size_t cluster = 0; cluster < CLUSTERS_PER_SLICE; cluster++) {
+        size_t clusterIndex = slice * CLUSTERS_PER_SLICE + cluster;
+        const glm::vec3& boundsMin = clusters.boundsMin[clusterIndex];
+        const glm::vec3& boundsMax = clusters.boundsMax[clusterIndex];
+
+        size_t listStart = work.indices.size();
+
+        for(size_t c = 0; c < paddedCount; c += 4) {
+            int mask = sphereBoxMask(candidateX + c, candidateY + c, candidateZ + c, candidateRadius + c, boundsMin, boundsMax);
+
+            if(!mask) {
+                continue;
+            }
+
+            for(int lane = 0; lane < 4; lane++) {
+                if(!(mask & (1 << lane))) {
+                    continue;
+                }
+
+                GLuint light = work.candidates[c + lane];
+                const ClusterLightBlock& block = lights[light];
+
+                // Spot lights also have to reach the cluster with their cone, wide cones only use the sphere
+                if(block.edge > 0.0f) {
+                    glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+                    glm::vec3 apex(x[light], y[light], z[light]);
+
+                    if(!isConeInSphere(apex, lightDirections[view][light], block.edge, block.range,
+                                       center, 0.5f * glm::length(boundsMax - boundsMin))) {
+                        continue;
+                    }
+                }
+
+                work.indices.push_back(light);
+            }
+        }
+
+        work.counts[cluster] = static_cast<GLuint>(work.indices.size() - listStart);
+    }
+}
+
+void ClusteredLights::assignLights(const glm::mat4* projectionMatrices, const glm::mat4* viewMatrices, int passViewCount,
+                                   JobSystem* jobSystem) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    viewCount = std::min(passViewCount, MAX_VIEWS);
+
+    // Same depth slices for every view, near and far planes of the perspective projection
+    const glm::mat4& projection = projectionMatrices[0];
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+
+    float logRatio = std::log(farPlane / nearPlane);
+    depthScale = LIGHT_CLUSTERS_Z / logRatio;
+    depthBias = -LIGHT_CLUSTERS_Z * std::log(nearPlane) / logRatio;
+
+    for(int view = 0; view < viewCount; view++) {
+        ViewClusters& clusters = views[view];
+
+        if(clusters.projection != projectionMatrices[view] || clusters.nearPlane != nearPlane || clusters.farPlane != farPlane) {
+            buildClusterBounds(clusters, projectionMatrices[view], nearPlane, farPlane);
+        }
+    }
+
+    // Spheres of the lights in the space of every view
+    size_t lightCount = lights.size();
+    lightRadius.resize(lightCount);
+
+    for(int view = 0; view < viewCount; view++) {
+        lightX[view].resize(lightCount);
+        lightY[view].resize(lightCount);
+        lightZ[view].resize(lightCount);
+        lightDirections[view].resize(lightCount);
+    }
+
+    for(size_t i = 0; i < lightCount; i++) {
+        lightRadius[i] = lights[i].range;
+
+        for(int view = 0; view < viewCount; view++) {
+            glm::vec4 position = viewMatrices[view] * glm::vec4(lights[i].position, 1.0f);
+
+            lightX[view][i] = position.x;
+            lightY[view][i] = position.y;
+            lightZ[view][i] = position.z;
+            lightDirections[view][i] = glm::normalize(glm::mat3(viewMatrices[view]) * lights[i].direction);
+        }
+    }
+
+    // Slices don't share any clusters, each one can go to a different worker
+    auto assignJob = [&](size_t partition) {
+        assignSlice(static_cast<int>(partition / LIGHT_CLUSTERS_Z), static_cast<int>(partition % LIGHT_CLUSTERS_Z));
+    };
+
+    size_t sliceCount = viewCount * LIGHT_CLUSTERS_Z;
+
+    if(jobSystem) {
+        jobSystem->run(sliceCount, assignJob);
+    }
+
+    else {
+        for(size_t partition = 0; partition < sliceCount; partition++) {
+            assignJob(partition);
+        }
+    }
+
+    // Merged in order, cluster x + X * (y + Y * z) of view v is at v * X * Y * Z in the grid
+    grid.resize(viewCount * CLUSTERS_PER_VIEW);
+    indices.clear();
+    maxClusterLights = 0;
+
+    for(size_t partition = 0; partition < sliceCount; partition++) {
+        const SliceWork& work = slices[partition];
+        GLuint offset = static_cast<GLuint>(indices.size());
+
+        for(size_t cluster = 0; cluster < CLUSTERS_PER_SLICE; cluster++) {
+            grid[partition * CLUSTERS_PER_SLICE + cluster] = glm::uvec2(offset, work.counts[cluster]);
+
+            offset += work.counts[cluster];
+            maxClusterLights = std::max(maxClusterLights, work.counts[cluster]);
+        }
+
+        indices.insert(indices.end(), work.indices.begin(), work.indices.end());
+    }
+
+    assignTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ClusteredLights::updateBuffer(GLuint buffer, GLsizeiptr& capacity, const void* data, GLsizeiptr size) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+    // Growing the buffer only when needed, otherwise just updating the contents
+    if(size > capacity) {
+        capacity = size * 2;
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if(size) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+    }
+}
+
+void ClusteredLights::uploadBuffers() {
+    updateBuffer(lightsBuffer, lightsCapacity, lights.data(), sizeof(ClusterLightBlock) * lights.size());
+    updateBuffer(gridBuffer, gridCapacity, grid.data(), sizeof(glm::uvec2) * grid.size());
+    updateBuffer(indicesBuffer, indicesCapacity, indices.data(), sizeof(GLuint) * indices.size());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHTS_BINDING, lightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_GRID_BINDING, gridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDICES_BINDING, indicesBuffer);
+}
+
+void ClusteredLights::fillBlock(LightsBlock& block) const {
+    block.clusterCount = glm::ivec4(LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z, static_cast<int>(lights.size()));
+    block.clusterDepth = glm::vec4(depthScale, depthBias, 0.0f, 0.0f);
+}
+
+float ClusteredLights::getAverageClusterLights() const {
+    return grid.empty() ? 0.0f : static_cast<float>(indices.size()) / grid.size();
+}
+
+void ClusteredLights::benchmarkAssign(size_t lightCount, int iterations) {
+    std::mt19937 generator(1234);
+
+    // Street lights of a city of 200 x 200, around the height of a lamp post
+    std::uniform_real_distribution<float> street(0.0f, 200.0f);
+    std::uniform_real_distribution<float> height(1.0f, 3.0f);
+
+    ClusteredLights clusteredLights;
+
+    for(size_t i = 0; i < lightCount; i++) {
+        PointLight light(1.0f, 0.7f, 0.35f, 0.0f, 0.8f, street(generator), height(generator), -street(generator), 1.0f, 0.5f, 16.0f);
+
+        ClusterLightBlock block;
+        light.fillBlock(block);
+        clusteredLights.addLight(block);
+    }
+
+    // Street level camera looking into the city
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(100.0f, 1.7f, 0.0f), glm::vec3(100.0f, 1.7f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    JobSystem jobSystem;
+    jobSystem.createWorkers();
+
+    double singleTime = 0.0, jobTime = 0.0;
+
+    for(int i = 0; i < iterations; i++) {
+        clusteredLights.assignLights(&projection, &view, 1);
+        singleTime += clusteredLights.getAssignTime();
+
+        clusteredLights.assignLights(&projection, &view, 1, &jobSystem);
+        jobTime += clusteredLights.getAssignTime();
+    }
+
+    // Same lists as a scalar test of every light against every cluster
+    size_t mismatches = 0;
+    const ViewClusters& clusters = clusteredLights.views[0];
+
+    for(size_t cluster = 0; cluster < CLUSTERS_PER_VIEW; cluster++) {
+        GLuint count = 0;
+
+        for(size_t light = 0; light < lightCount; light++) {
+            glm::vec3 center = glm::vec3(view * glm::vec4(clusteredLights.lights[light].position, 1.0f));
+            glm::vec3 closest = glm::clamp(center, clusters.boundsMin[cluster], clusters.boundsMax[cluster]);
+            glm::vec3 offset = center - closest;
+
+            count += glm::dot(offset, offset) <= clusteredLights.lights[light].range * clusteredLights.lights[light].range;
+        }
+
+        mismatches += count != clusteredLights.grid[cluster].y;
+    }
+
+    printf("Clustered Lights - %zu lights, %i x %i x %i clusters, %i iterations, %zu threads\n", lightCount,
+           LIGHT_CLUSTERS_X, LIGHT_CLUSTERS_Y, LIGHT_CLUSTERS_Z, iterations, jobSystem.getThreadCount());
+    printf("%18s %10.3f ms\n", "Single thread", singleTime / iterations);
+    printf("%18s %10.3f ms\n", "Job system", jobTime / iterations);
+    printf("%18s %10u\n", "Max per cluster", clusteredLights.getMaxClusterLights());
+    printf("%18s %10.2f (%zu without clusters)\n", "Avg per cluster", clusteredLights.getAverageClusterLights(), lightCount);
+    printf("%18s %10zu\n", "Mismatches", mismatches);
+}
+
+void ClusteredLights::cleanBuffers() {
+    if(lightsBuffer) {
+        glDeleteBuffers(1, &lightsBuffer);
+        lightsBuffer = 0;
+    }
+
+    if(gridBuffer) {
+        glDeleteBuffers(1, &gridBuffer);
+        gridBuffer = 0;
+    }
+
+    if(indicesBuffer) {
+        glDeleteBuffers(1, &indicesBuffer);
+        indicesBuffer = 0;
+    }
+
+    lightsCapacity = 0;
+    gridCapacity = 0;
+    indicesCapacity = 0;
+}
+
+// Destructor
+ClusteredLights::~ClusteredLights() {
+    cleanBuffers();
+}
@@ -0,0 +1,74 @@
+#include "GLCallCounter.h"
+
+namespace {
+    size_t glCallCount = 0;
+
+    // One wrapper per GLAD function pointer, Slot is the address of the pointer (e.g. &glad_glUniform1i)
+    template<auto Slot>
+    struct CountedGLCall;
+
+    template<typename R, typename... Args, R (APIENTRY **Slot)(Args...)>
+    struct CountedGLCall<Slot> {
+        static inline R (APIENTRY *original)(Args...) = nullptr;
+
+        static R APIENTRY call(Args... args) {
+            glCallCount++;
+            return original(args...);
+        }
+
+        static void install() {
+            // Skipping functions the driver doesn't have and wrappers that are already installed
+            if(*Slot && *Slot != &call) {
+                original = *Slot;
+                *Slot = &call;
+            }
+        }
+    };
+}
+
+// GLAD defines glX as glad_glX, the prefix is added back to get the pointer
+#define COUNT_GL_CALL(function) CountedGLCall<&glad_##function>::install()
+
+void installGLCallCounters() {
+    // State
+    COUNT_GL_CALL(glEnable);
+    COUNT_GL_CALL(glDisable);
+    COUNT_GL_CALL(glDepthFunc);
+    COUNT_GL_CALL(glDepthMask);
+    COUNT_GL_CALL(glPolygonMode);
+    COUNT_GL_CALL(glClear);
+    COUNT_GL_CALL(glClearColor);
+    COUNT_GL_CALL(glViewport);
+    COUNT_GL_CALL(glColorMask);
+    COUNT_GL_CALL(glUseProgram);
+
+    // Buffers
+    COUNT_GL_CALL(glBindVertexArray);
+    COUNT_GL_CALL(glBindBuffer);
+    COUNT_GL_CALL(glBindBufferBase);
+    COUNT_GL_CALL(glBufferData);
+    COUNT_GL_CALL(glBufferSubData);
+
+    // Uniforms
+    COUNT_GL_CALL(glUniform1i);
+    COUNT_GL_CALL(glUniform1f);
+    COUNT_GL_CALL(glUniform3f);
+    COUNT_GL_CALL(glUniform4f);
+    COUNT_GL_CALL(glUniformMatrix4fv);
+
+    // Textures
+    COUNT_GL_CALL(glActiveTexture);
+    COUNT_GL_CALL(glBindTexture);
+
+    // Draws
+    COUNT_GL_CALL(glDrawArrays);
+    COUNT_GL_CALL(glDrawElements);
+    COUNT_GL_CALL(glDrawElementsBaseVertex);
+    COUNT_GL_CALL(glDrawElementsInstanced);
+    COUNT_GL_CALL(glDrawElementsInstancedBaseVertex);
+    COUNT_GL_CALL(glMultiDrawElementsIndirect);
+}
+
+size_t getGLCallCount() {
+    return glCallCount;
+}
@@ -0,0 +1,759 @@
+#include "GLTFLoader.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+// SSE2 is always available on x64
+#include <emmintrin.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+// glTF component types
+const int GLTF_BYTE = 5120;
+const int GLTF_UNSIGNED_BYTE = 5121;
+const int GLTF_SHORT = 5122;
+const int GLTF_UNSIGNED_SHORT = 5123;
+const int GLTF_UNSIGNED_INT = 5125;
+const int GLTF_FLOAT = 5126;
+
+// Triangles, the only primitive mode we render
+const int GLTF_TRIANGLES = 4;
+
+// Minimal JSON reader=================================================================================================
+// Only what glTF needs, the whole document is parsed into a tree of values
+namespace {
+    struct JSONValue {
+        enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JSONValue> array;
+        std::vector<std::pair<std::string, JSONValue>> object;
+
+        const JSONValue* find(const char* key) const {
+            for(const auto& member : object) {
+                if(member.first == key) {
+                    return &member.second;
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Returns fallback if the key is missing or not a number
+        double getNumber(const char* key, double fallback) const {
+            const JSONValue* value = find(key);
+            return (value && value->type == Number) ? value->number : fallback;
+        }
+
+        const JSONValue& get(const char* key) const {
+            static const JSONValue empty;
+            const JSONValue* value = find(key);
+            return value ? *value : empty;
+        }
+    };
+
+    class JSONParser {
+    private:
+        const char* current;
+        const char* end;
+
+        void skipWhitespace() {
+            while(current < end && (*current == ' ' || *current == '\n' || *current == '\r' || *current == '\t')) {
+                current++;
+            }
+        }
+
+        bool parseString(std::string& result) {
+            // Skipping the opening quote
+            current++;
+
+            while(current < end && *current != '"') {
+                if(*current == '\\' && current + 1 < end) {
+                    current++;
+
+                    switch(*current) {
+                        case 'n': result += '\n'; break;
+                        case 't': result += '\t'; break;
+                        case 'r': result += '\r'; break;
+                        case 'b': result += '\b'; break;
+                        case 'f': result += '\f'; break;
+
+                        // Unicode escapes only show up in names, keeping them as they are
+                        case 'u': result += "\\u"; break;
+
+                        default: result += *current; break;
+                    }
+                }
+
+                else {
+                    result += *current;
+                }
+
+                current++;
+            }
+
+            if(current >= end) {
+                return false;
+            }
+
+            // Skipping the closing quote
+            current++;
+            return true;
+        }
+
+    public:
+        JSONParser(const char* text, size_t length) : current(text), end(text + length) {}
+
+        bool parseValue(JSONValue& value) {
+            skipWhitespace();
+
+            if(current >= end) {
+                return false;
+            }
+
+            if(*current == '{') {
+                value.type = JSONValue::Object;
+                current++;
+                skipWhitespace();
+
+                if(current < end && *current == '}') {
+                    current++;
+                    return true;
+                }
+
+                while(current < end) {
+                    skipWhitespace();
+
+                    std::pair<std::string, JSONValue> member;
+                    if(current >= end || *current != '"' || !parseString(member.first)) {
+                        return false;
+                    }
+
+                    skipWhitespace();
+                    if(current >= end || *current != ':') {
+                        return false;
+                    }
+
+                    current++;
+
+                    if(!parseValue(member.second)) {
+                        return false;
+                    }
+
+                    value.object.push_back(std::move(member));
+
+                    skipWhitespace();
+                    if(current < end && *current == ',') {
+                        current++;
+                        continue;
+                    }
+
+                    if(current < end && *current == '}') {
+                        current++;
+                        return true;
+                    }
+
+                    return false;
+                }
+
+                return false;
+            }
+
+            if(*current == '[') {
+                value.type = JSONValue::Array;
+                current++;
+                skipWhitespace();
+
+                if(current < end && *current == ']') {
+                    current++;
+                    return true;
+                }
+
+                while(current < end) {
+                    value.array.emplace_back();
+
+                    if(!parseValue(value.array.back())) {
+                        return false;
+                    }
+
+                    skipWhitespace();
+                    if(current < end && *current == ',') {
+                        current++;
+                        continue;
+                    }
+
+                    if(current < end && *current == ']') {
+                        current++;
+                        return true;
+                    }
+
+                    return false;
+                }
+
+                return false;
+            }
+
+            if(*current == '"') {
+                value.type = JSONValue::String;
+                return parseString(value.string);
+            }
+
+            if(end - current >= 4 && strncmp(current, "true", 4) == 0) {
+                value.type = JSONValue::Bool;
+                value.boolean = true;
+                current += 4;
+                return true;
+            }
+
+            if(end - current >= 5 && strncmp(current, "false", 5) == 0) {
+                value.type = JSONValue::Bool;
+                current += 5;
+                return true;
+            }
+
+            if(end - current >= 4 && strncmp(current, "null", 4) == 0) {
+                current += 4;
+                return true;
+            }
+
+            // Number - The text is null terminated, so strtod can't run past the end
+            char* numberEnd = nullptr;
+            value.type = JSONValue::Number;
+            value.number = strtod(current, &numberEnd);
+
+            if(numberEnd == current) {
+                return false;
+            }
+
+            current = numberEnd;
+            return true;
+        }
+    };
+
+    // Number of components for the accessor type string
+    int componentCount(const std::string& type) {
+        if(type == "SCALAR") return 1;
+        if(type == "VEC2") return 2;
+        if(type == "VEC3") return 3;
+        if(type == "VEC4") return 4;
+        if(type == "MAT4") return 16;
+        return 0;
+    }
+
+    size_t componentSize(int componentType) {
+        switch(componentType) {
+            case GLTF_BYTE:
+            case GLTF_UNSIGNED_BYTE: return 1;
+            case GLTF_SHORT:
+            case GLTF_UNSIGNED_SHORT: return 2;
+            case GLTF_UNSIGNED_INT:
+            case GLTF_FLOAT: return 4;
+            default: return 0;
+        }
+    }
+
+    // Reading a single component as a float, applying the normalization rules of the spec
+    float readComponent(const unsigned char* element, int componentType, bool normalized, int component) {
+        switch(componentType) {
+            case GLTF_FLOAT: {
+                float value;
+                memcpy(&value, element + component * 4, sizeof(float));
+                return value;
+            }
+
+            case GLTF_UNSIGNED_BYTE: {
+                float value = element[component];
+                return normalized ? value / 255.0f : value;
+            }
+
+            case GLTF_BYTE: {
+                float value = (signed char)element[component];
+                return normalized ? std::max(value / 127.0f, -1.0f) : value;
+            }
+
+            case GLTF_UNSIGNED_SHORT: {
+                unsigned short raw;
+                memcpy(&raw, element + component * 2, sizeof(raw));
+                return normalized ? raw / 65535.0f : float(raw);
+            }
+
+            case GLTF_SHORT: {
+                short raw;
+                memcpy(&raw, element + component * 2, sizeof(raw));
+                return normalized ? std::max(raw / 32767.0f, -1.0f) : float(raw);
+            }
+
+            default:
+                return 0.0f;
+        }
+    }
+
+    // Scalar conversion of a single vertex, used for the last vertex and for non float attributes
+    template<typename Attribute>
+    void convertVertex(const Attribute& position, const Attribute& texCoord, const Attribute& normal, const Attribute& tangent,
+                       size_t i, GLfloat* out) {
+        for(int c = 0; c < 3; c++) {
+            out[c] = readComponent(position.data + i * position.stride, position.componentType, position.normalized, c);
+        }
+
+        // V as stored - Assimp's glTF importer flips it and aiProcess_FlipUVs flips it back, so both loaders agree
+        out[3] = texCoord.data ? readComponent(texCoord.data + i * texCoord.stride, texCoord.componentType, texCoord.normalized, 0) : 0.0f;
+        out[4] = texCoord.data ? readComponent(texCoord.data + i * texCoord.stride, texCoord.componentType, texCoord.normalized, 1) : 0.0f;
+
+        // Adding the reversed values because of the shader code
+        for(int c = 0; c < 3; c++) {
+            out[5 + c] = normal.data ? -readComponent(normal.data + i * normal.stride, normal.componentType, normal.normalized, c) : 0.0f;
+            out[8 + c] = tangent.data ? readComponent(tangent.data + i * tangent.stride, tangent.componentType, tangent.normalized, c) : 0.0f;
+        }
+    }
+
+    // Reading the whole file, the .gltf is small compared to the buffers
+    bool readTextFile(const std::string& filePath, std::string& result) {
+        std::ifstream file(filePath, std::ios::in | std::ios::binary);
+
+        if(!file.is_open()) {
+            return false;
+        }
+
+        std::stringstream stream;
+        stream << file.rdbuf();
+        result = stream.str();
+
+        return true;
+    }
+}
+
+// MappedFile==========================================================================================================
+// Constructor
+MappedFile::MappedFile() {
+    data = nullptr;
+    size = 0;
+
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+    fileDescriptor = -1;
+}
+
+bool MappedFile::openFile(const std::string& filePath) {
+    closeFile();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if(!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if(!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const unsigned char*>(view);
+    size = size_t(fileSize.QuadPart);
+#else
+    int descriptor = open(filePath.c_str(), O_RDONLY);
+
+    if(descriptor < 0) {
+        return false;
+    }
+
+    struct stat fileStats;
+    if(fstat(descriptor, &fileStats) != 0 || fileStats.st_size == 0) {
+        close(descriptor);
+        return false;
+    }
+
+    void* view = mmap(nullptr, fileStats.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+    if(view == MAP_FAILED) {
+        close(descriptor);
+        return false;
+    }
+
+    // The whole buffer is read front to back during the conversion
+    madvise(view, fileStats.st_size, MADV_SEQUENTIAL);
+
+    fileDescriptor = descriptor;
+    data = static_cast<const unsigned char*>(view);
+    size = size_t(fileStats.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::closeFile() {
+    if(!data) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+    munmap(const_cast<unsigned char*>(data), size);
+    close(fileDescriptor);
+#endif
+
+    data = nullptr;
+    size = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+    fileDescriptor = -1;
+}
+
+MappedFile::~MappedFile() {
+    closeFile();
+}
+
+// GLTFLoader==========================================================================================================
+// Constructor
+GLTFLoader::GLTFLoader() {
+    mappedBytes = 0;
+    convertedBytes = 0;
+}
+
+bool GLTFLoader::getAccessorData(int index, AccessorData& result) {
+    result = AccessorData();
+
+    // Missing attribute
+    if(index < 0) {
+        return true;
+    }
+
+    if(size_t(index) >= accessors.size()) {
+        return false;
+    }
+
+    const Accessor& accessor = accessors[index];
+
+    // Sparse accessors without a buffer view are not supported
+    if(accessor.bufferView < 0 || size_t(accessor.bufferView) >= bufferViews.size()) {
+        return false;
+    }
+
+    const BufferView& view = bufferViews[accessor.bufferView];
+
+    if(view.buffer < 0 || size_t(view.buffer) >= buffers.size()) {
+        return false;
+    }
+
+    size_t elementSize = componentSize(accessor.componentType) * accessor.components;
+    size_t stride = view.byteStride ? view.byteStride : elementSize;
+
+    // Making sure the last element is inside the view and the view is inside the buffer
+    if(accessor.count && (accessor.byteOffset + (accessor.count - 1) * stride + elementSize > view.byteLength ||
+                          view.byteOffset + view.byteLength > buffers[view.buffer]->getSize())) {
+        return false;
+    }
+
+    result.data = buffers[view.buffer]->getData() + view.byteOffset + accessor.byteOffset;
+    result.count = accessor.count;
+    result.stride = stride;
+    result.componentType = accessor.componentType;
+    result.components = accessor.components;
+    result.normalized = accessor.normalized;
+
+    return true;
+}
+
+void GLTFLoader::convertVertices(const AccessorData& position, const AccessorData& texCoord, const AccessorData& normal,
+                                 const AccessorData& tangent, GLTFPrimitive& primitive) {
+    size_t count = position.count;
+
+    primitive.vertices.resize(count * VERTEX_LENGTH);
+    primitive.vertexCount = count;
+
+    GLfloat* out = primitive.vertices.data();
+
+    bool allFloats = position.componentType == GLTF_FLOAT &&
+                     (!texCoord.data || texCoord.componentType == GLTF_FLOAT) &&
+                     (!normal.data || normal.componentType == GLTF_FLOAT) &&
+                     (!tangent.data || tangent.componentType == GLTF_FLOAT);
+
+    size_t i = 0;
+
+    if(allFloats) {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        // Every 4 wide load reads one float past a VEC3, which is still inside the buffer for all but the last vertex
+        for(; i + 1 < count; i++) {
+            GLfloat* vertex = out + i * VERTEX_LENGTH;
+
+            // Stores overlap, each one overwrites the garbage lane of the previous one
+            _mm_storeu_ps(vertex, _mm_loadu_ps(reinterpret_cast<const float*>(position.data + i * position.stride)));
+
+            // U and V as stored, like the scalar path
+            __m128 uv = texCoord.data ? _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(texCoord.data + i * texCoord.stride))) : zero;
+            _mm_storel_pi(reinterpret_cast<__m64*>(vertex + 3), uv);
+
+            __m128 n = normal.data ? _mm_xor_ps(_mm_loadu_ps(reinterpret_cast<const float*>(normal.data + i * normal.stride)), signMask) : zero;
+            _mm_storeu_ps(vertex + 5, n);
+
+            // Writes into the next vertex, which is always written after this one
+            __m128 t = tangent.data ? _mm_loadu_ps(reinterpret_cast<const float*>(tangent.data + i * tangent.stride)) : zero;
+            _mm_storeu_ps(vertex + 8, t);
+        }
+    }
+
+    for(; i < count; i++) {
+        convertVertex(position, texCoord, normal, tangent, i, out + i * VERTEX_LENGTH);
+    }
+}
+
+bool GLTFLoader::convertIndices(const AccessorData& indices, GLTFPrimitive& primitive) {
+    primitive.indexCount = indices.count;
+
+    // Same layout as the GPU buffer, no copy at all
+    if(indices.componentType == GLTF_UNSIGNED_INT && indices.stride == sizeof(unsigned int)) {
+        primitive.mappedIndices = reinterpret_cast<const unsigned int*>(indices.data);
+        mappedBytes += indices.count * sizeof(unsigned int);
+        return true;
+    }
+
+    primitive.convertedIndices.resize(indices.count);
+    unsigned int* out = primitive.convertedIndices.data();
+    size_t i = 0;
+
+    // Widening 8 indices at a time
+    if(indices.componentType == GLTF_UNSIGNED_SHORT && indices.stride == sizeof(unsigned short)) {
+        const __m128i zero = _mm_setzero_si128();
+
+        for(; i + 8 <= indices.count; i += 8) {
+            __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices.data + i * 2));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(shorts, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(shorts, zero));
+        }
+    }
+
+    for(; i < indices.count; i++) {
+        const unsigned char* element = indices.data + i * indices.stride;
+
+        switch(indices.componentType) {
+            case GLTF_UNSIGNED_BYTE: out[i] = element[0]; break;
+            case GLTF_UNSIGNED_SHORT: { unsigned short value; memcpy(&value, element, 2); out[i] = value; break; }
+            case GLTF_UNSIGNED_INT: memcpy(&out[i], element, 4); break;
+            default: return false;
+        }
+    }
+
+    convertedBytes += indices.count * componentSize(indices.componentType);
+    return true;
+}
+
+bool GLTFLoader::loadPrimitive(int position, int texCoord, int normal, int tangent, int indices, int material) {
+    AccessorData positionData, texCoordData, normalData, tangentData, indexData;
+
+    if(!getAccessorData(position, positionData) || !getAccessorData(texCoord, texCoordData) ||
+       !getAccessorData(normal, normalData) || !getAccessorData(tangent, tangentData) || !getAccessorData(indices, indexData)) {
+        printf("Invalid accessor in glTF primitive!\n");
+        return false;
+    }
+
+    if(!positionData.data || positionData.components != 3) {
+        printf("glTF primitive has no positions!\n");
+        return false;
+    }
+
+    // Attributes have to match the vertex count, and need enough components
+    if((texCoordData.data && (texCoordData.count != positionData.count || texCoordData.components < 2)) ||
+       (normalData.data && (normalData.count != positionData.count || normalData.components < 3)) ||
+       (tangentData.data && (tangentData.count != positionData.count || tangentData.components < 3))) {
+        printf("glTF attribute counts don't match!\n");
+        return false;
+    }
+
+    primitives.emplace_back();
+    GLTFPrimitive& primitive = primitives.back();
+    primitive.material = material;
+
+    convertVertices(positionData, texCoordData, normalData, tangentData, primitive);
+    convertedBytes += positionData.count * VERTEX_LENGTH * sizeof(GLfloat);
+
+    if(indexData.data) {
+        if(!convertIndices(indexData, primitive)) {
+            printf("Unsupported glTF index type!\n");
+            primitives.pop_back();
+            return false;
+        }
+    }
+
+    // Non-indexed primitive, generating the trivial index buffer
+    else {
+        primitive.convertedIndices.resize(positionData.count);
+
+        for(size_t i = 0; i < positionData.count; i++) {
+            primitive.convertedIndices[i] = i;
+        }
+
+        primitive.indexCount = positionData.count;
+    }
+
+    return true;
+}
+
+bool GLTFLoader::loadFile(const std::string& filePath) {
+    cleanLoader();
+
+    std::string text;
+    if(!readTextFile(filePath, text)) {
+        printf("Failed to open glTF file : %s\n", filePath.c_str());
+        return false;
+    }
+
+    JSONValue document;
+    JSONParser parser(text.c_str(), text.size());
+
+    if(!parser.parseValue(document) || document.type != JSONValue::Object) {
+        printf("Failed to parse glTF file : %s\n", filePath.c_str());
+        return false;
+    }
+
+    std::filesystem::path directory = std::filesystem::path(filePath).parent_path();
+
+    // Buffers - Mapping the external .bin files
+    for(const JSONValue& buffer : document.get("buffers").array) {
+        const std::string& uri = buffer.get("uri").string;
+
+        // Embedded base64 buffers and .glb files would need a copy anyway
+        if(uri.empty() || uri.compare(0, 5, "data:") == 0) {
+            printf("Only external glTF buffers are supported : %s\n", filePath.c_str());
+            cleanLoader();
+            return false;
+        }
+
+        MappedFile* mapped = new MappedFile();
+
+        if(!mapped->openFile((directory / uri).string())) {
+            printf("Failed to map glTF buffer : %s\n", (directory / uri).string().c_str());
+            delete mapped;
+            cleanLoader();
+            return false;
+        }
+
+        buffers.push_back(mapped);
+    }
+
+    for(const JSONValue& view : document.get("bufferViews").array) {
+        bufferViews.push_back({ int(view.getNumber("buffer", -1)),
+                                size_t(view.getNumber("byteOffset", 0)),
+                                size_t(view.getNumber("byteLength", 0)),
+                                size_t(view.getNumber("byteStride", 0)) });
+    }
+
+    for(const JSONValue& accessor : document.get("accessors").array) {
+        const JSONValue* normalized = accessor.find("normalized");
+
+        accessors.push_back({ int(accessor.getNumber("bufferView", -1)),
+                              size_t(accessor.getNumber("byteOffset", 0)),
+                              size_t(accessor.getNumber("count", 0)),
+                              int(accessor.getNumber("componentType", 0)),
+                              componentCount(accessor.get("type").string),
+                              normalized && normalized->boolean });
+    }
+
+    // Materials - Texture index -> Image -> Path
+    const JSONValue& textures = document.get("textures");
+    const JSONValue& images = document.get("images");
+
+    auto texturePath = [&](const JSONValue& textureInfo) -> std::string {
+        const JSONValue* index = textureInfo.find("index");
+
+        if(!index || size_t(index->number) >= textures.array.size()) {
+            return "";
+        }
+
+        size_t source = size_t(textures.array[size_t(index->number)].getNumber("source", -1));
+
+        if(source >= images.array.size() || images.array[source].get("uri").string.empty()) {
+            return "";
+        }
+
+        return (directory / images.array[source].get("uri").string).string();
+    };
+
+    for(const JSONValue& material : document.get("materials").array) {
+        GLTFMaterial result;
+        result.diffusePath = texturePath(material.get("pbrMetallicRoughness").get("baseColorTexture"));
+        result.normalPath = texturePath(material.get("normalTexture"));
+
+        materials.push_back(result);
+    }
+
+    // Meshes - Every primitive becomes its own Mesh
+    for(const JSONValue& mesh : document.get("meshes").array) {
+        for(const JSONValue& primitive : mesh.get("primitives").array) {
+            if(int(primitive.getNumber("mode", GLTF_TRIANGLES)) != GLTF_TRIANGLES) {
+                printf("Skipping glTF primitive that isn't made of triangles\n");
+                continue;
+            }
+
+            const JSONValue& attributes = primitive.get("attributes");
+
+            loadPrimitive( int(attributes.getNumber("POSITION", -1)),
+                           int(attributes.getNumber("TEXCOORD_0", -1)),
+                           int(attributes.getNumber("NORMAL", -1)),
+                           int(attributes.getNumber("TANGENT", -1)),
+                           int(primitive.getNumber("indices", -1)),
+                           int(primitive.getNumber("material", -1)) );
+        }
+    }
+
+    return !primitives.empty();
+}
+
+void GLTFLoader::cleanLoader() {
+    // Primitives may point into the buffers, clearing them first
+    primitives.clear();
+    materials.clear();
+    accessors.clear();
+    bufferViews.clear();
+
+    for(size_t i = 0; i < buffers.size(); i++) {
+        delete buffers[i];
+        buffers[i] = nullptr;
+    }
+
+    buffers.clear();
+
+    mappedBytes = 0;
+    convertedBytes = 0;
+}
+
+GLTFLoader::~GLTFLoader() {
+    cleanLoader();
+}
@@ -1,5 +1,11 @@
 #include "GUI.h"
 
+// Allocation histogram
+#include "MemoryArena.h"
+
+// Residency of the streamed textures
+#include "TextureStreamer.h"
+
 // Global variables for stride speed
 float sliderSpeed = 0.01f;
 
@@ -172,6 +178,7 @@ void GUI::elements(const std::string& shadingMode) {
                     ImGui::Checkbox("Asymmetric Frustum", &isAsymmetricFrustum);
                     ImGui::Checkbox("Flip Channels (Toed)", &isFlipAnaglyphChannelsToed);
                     ImGui::Checkbox("Flip Channels (Frustum)", &isFlipAnaglyphChannelsFrustum);
+                    ImGui::Checkbox("Single Pass", &isSinglePassStereo);
                     ImGui::DragFloat("IoD (Eye Distance)", (float*)&interOcularDistance, sliderSpeed * 0.1);
                     ImGui::DragFloat("CD (Convergence Distance)", (float*)&convergeDistance, sliderSpeed * 0.1);
                 }
@@ -224,6 +231,16 @@ void GUI::elements(const std::string& shadingMode) {
             ImGui::Text("Spot Lights");
             ImGui::Checkbox("Spot Active", &isSpotLights);
 
+            // A lamp next to every building of the city
+            ImGui::Spacing();
+            ImGui::Text("Street Lights");
+            ImGui::Checkbox("Street Active", &isStreetLights);
+
+            // Lists built from the bounds of every object instead of the clusters of the view
+            ImGui::Spacing();
+            ImGui::Text("Light Lists");
+            ImGui::Checkbox("Per Instance Lights", &isInstanceLights);
+
             // End Current Tab Item
             ImGui::EndTabItem();
         }
@@ -248,9 +265,118 @@ void GUI::elements(const std::string& shadingMode) {
                 ImGui::DragInt("Point Size", (int*)&pointSize);
                 ImGui::DragInt("Number of Points", (int*)&numPoints);
 
+                // Level of detail - Maximum error on screen in pixels before switching to a finer LOD
+                ImGui::Checkbox("LOD", &isLOD);
+                ImGui::DragFloat("LOD Error (px)", &lodPixelError, sliderSpeed, 0.1f, 64.0f);
+
+                // Instancing - One draw for all the floors of a building type
+                ImGui::Checkbox("Instancing", &isInstancing);
+
+                // Worker threads - Instances are culled and recorded in parallel, GL calls stay on this thread
+                ImGui::Checkbox("Multithreaded", &isMultithreaded);
+
                 if(ImGui::Button("Update")) {
                     update = true;
                 }
+
+                // Draw calls and CPU time for a few grid sizes, printed in Terminal
+                ImGui::SameLine();
+                if(ImGui::Button("Benchmark")) {
+                    isCityBenchmark = true;
+                }
+            }
+
+            // End Current Tab Item
+            ImGui::EndTabItem();
+        }
+
+        if (ImGui::BeginTabItem("Stats")) {
+            // Spacing
+            ImGui::Spacing();
+            ImGui::Text("Frame");
+
+            ImGui::Text("CPU : %.3f ms", frameTime);
+            ImGui::Text("Draw Calls : %u", drawCalls);
+            ImGui::Text("GL calls : %zu per frame", glCalls);
+            ImGui::Text("Uniform block uploads : %zu per frame", uniformUploads);
+            ImGui::Text("State changes : %zu issued, %zu elided", stateChangesIssued, stateChangesElided);
+            ImGui::Text("Render queue : %zu draws, %u state changes, %.3f ms sort", queuedDraws, queueStateChanges, queueSortTime);
+
+            // Spacing
+            ImGui::Spacing();
+            ImGui::Text("Frustum Culling");
+
+            // Bounding boxes of the city instances, or of the meshes when cluster culling is off
+            ImGui::Checkbox("Frustum Culling", &isFrustumCulling);
+            ImGui::Text("Boxes : %u / %u culled", cullingCulled, cullingTested);
+
+            // City instances behind the biggest buildings, single view passes only
+            ImGui::Checkbox("Occlusion Culling", &isOcclusionCulling);
+            ImGui::Text("Occluded : %u boxes, %u occluders", occlusionCulled, occluderCount);
+
+            // Spacing
+            ImGui::Spacing();
+            ImGui::Text("Clustered Lighting");
+
+            ImGui::Text("Lights : %u, %.3f ms assignment", clusteredLightCount, lightAssignTime);
+            ImGui::Text("Per cluster : %u max, %.2f average", maxClusterLights, averageClusterLights);
+
+            // Only filled while the per instance lights are on
+            ImGui::Text("Instances : %u, %.3f ms assignment", lightInstanceCount, instanceLightTime);
+            ImGui::Text("Per instance : %u max, %.2f average", maxInstanceLights, averageInstanceLights);
+
+            // Spacing
+            ImGui::Spacing();
+            ImGui::Text("Cluster Culling");
+
+            ImGui::Checkbox("Cluster Culling", &isClusterCulling);
+            ImGui::Checkbox("Back Face Clusters", &isClusterConeCulling);
+
+            ImGui::Text("Clusters : %u / %u culled", clustersCulled, clusterCount);
+            ImGui::Text("Triangles : %u / %u culled", clusterTrianglesCulled, clusterTriangles);
+
+            // Spacing
+            ImGui::Spacing();
+            ImGui::Text("Texture Streaming");
+
+            // Levels bigger than the budget are split over several frames
+            ImGui::SliderInt("Upload Budget (KB)", &textureUploadBudget, 256, 8192);
+
+            if(textureStreamer) {
+                ImGui::Text("Textures : %u resident, %u streaming, %u decoding", textureStreamer->getResidentCount(),
+                            textureStreamer->getStreamingCount(), textureStreamer->getDecodingCount());
+                ImGui::Text("Uploads : %.2f MB this frame, %.2f MB pending, %.3f ms", textureStreamer->getUploadedBytes() / 1048576.0f,
+                            textureStreamer->getPendingBytes() / 1048576.0f, textureStreamer->getUpdateTime());
+
+                // Finest level each texture samples from
+                if(ImGui::TreeNode("Residency")) {
+                    static const char* stateNames[] = { "Decoding", "Streaming", "Resident", "Failed" };
+
+                    for(size_t i = 0; i < textureStreamer->getTextureCount(); i++) {
+                        const TextureResidency& residency = textureStreamer->getResidency(i);
+
+                        size_t nameStart = residency.path.find_last_of("/\\");
+                        const char* name = residency.path.c_str() + (nameStart == std::string::npos ? 0 : nameStart + 1);
+
+                        ImGui::Text("%s : %ix%i, level %u of %u (%s)", name, std::max(residency.width >> residency.residentLevel, 1),
+                                    std::max(residency.height >> residency.residentLevel, 1), residency.residentLevel,
+                                    residency.levelCount, stateNames[residency.state]);
+                    }
+
+                    ImGui::TreePop();
+                }
+            }
+
+            // Spacing
+            ImGui::Spacing();
+            ImGui::Text("Memory");
+
+            ImGui::Text("Heap allocations : %zu per frame (%.2f KB)", frameAllocations, frameAllocationBytes / 1024.0f);
+            ImGui::Text("Frame arena : %.2f / %.2f KB", frameArenaUsed / 1024.0f, frameArenaCapacity / 1024.0f);
+
+            // Terminal only, the histogram is too long for the panel
+            if(ImGui::Button("Print Allocation Sites")) {
+                printAllocationSites("Allocations since startup");
             }
 
             // End Current Tab Item
@@ -316,6 +442,74 @@ void GUI::setUpdate(bool updateValue) {
     update = updateValue;
 }
 
+void GUI::setCityBenchmark(bool benchmarkValue) {
+    isCityBenchmark = benchmarkValue;
+}
+
+// Stats
+void GUI::setFrameStats(unsigned int drawCallCount, double cpuFrameTime) {
+    drawCalls = drawCallCount;
+    frameTime = cpuFrameTime;
+}
+
+void GUI::setGLStats(size_t glCallCount, size_t uniformUploadCount) {
+    glCalls = glCallCount;
+    uniformUploads = uniformUploadCount;
+}
+
+void GUI::setStateCacheStats(size_t issued, size_t elided) {
+    stateChangesIssued = issued;
+    stateChangesElided = elided;
+}
+
+void GUI::setRenderQueueStats(size_t draws, unsigned int stateChanges, double sortTime) {
+    queuedDraws = draws;
+    queueStateChanges = stateChanges;
+    queueSortTime = sortTime;
+}
+
+void GUI::setCullingStats(unsigned int tested, unsigned int culled) {
+    cullingTested = tested;
+    cullingCulled = culled;
+}
+
+void GUI::setOcclusionStats(unsigned int occluded, unsigned int occluders) {
+    occlusionCulled = occluded;
+    occluderCount = occluders;
+}
+
+void GUI::setLightClusterStats(unsigned int lightCount, unsigned int maxLights, float averageLights, double assignTime) {
+    clusteredLightCount = lightCount;
+    maxClusterLights = maxLights;
+    averageClusterLights = averageLights;
+    lightAssignTime = assignTime;
+}
+
+void GUI::setInstanceLightStats(unsigned int instanceCount, unsigned int maxLights, float averageLights, double assignTime) {
+    lightInstanceCount = instanceCount;
+    maxInstanceLights = maxLights;
+    averageInstanceLights = averageLights;
+    instanceLightTime = assignTime;
+}
+
+void GUI::setClusterStats(unsigned int clusters, unsigned int culledClusters, unsigned int triangles, unsigned int culledTriangles) {
+    clusterCount = clusters;
+    clustersCulled = culledClusters;
+    clusterTriangles = triangles;
+    clusterTrianglesCulled = culledTriangles;
+}
+
+void GUI::setAllocationStats(size_t allocations, size_t allocationBytes, size_t arenaUsed, size_t arenaCapacity) {
+    frameAllocations = allocations;
+    frameAllocationBytes = allocationBytes;
+    frameArenaUsed = arenaUsed;
+    frameArenaCapacity = arenaCapacity;
+}
+
+void GUI::setTextureStreamer(const TextureStreamer* streamer) {
+    textureStreamer = streamer;
+}
+
 void GUI::render(const std::string& shadingMode) {
     // Render ImGui elements here
     ImGui::Begin("Yumi");
@@ -0,0 +1,291 @@
+#include <iostream>
+
+#include "GeometryArena.h"
+
+// Binding points of the InstanceTransforms and InstanceIndices buffers in BRDF_Normals.vert
+const GLuint TRANSFORM_BINDING = 0;
+const GLuint INSTANCE_INDEX_BINDING = 1;
+
+// Constructor
+GeometryArena::GeometryArena() {
+    VAO = 0;
+    VBO = 0;
+    IBO = 0;
+
+    indirectBuffer = 0;
+    transformBuffer = 0;
+    instanceIndexBuffer = 0;
+    indirectCapacity = 0;
+    instanceIndexCapacity = 0;
+
+    vertexCapacity = 0;
+    indexCapacity = 0;
+}
+
+void GeometryArena::createArena(GLuint maxVertices, GLuint maxIndices) {
+    // Failsafe, in case the arena is re-created
+    cleanArena();
+
+    vertexCapacity = maxVertices;
+    indexCapacity = maxIndices;
+
+    // The whole arena is free in the beginning
+    freeVertexBlocks.push_back({ 0, vertexCapacity });
+    freeIndexBlocks.push_back({ 0, indexCapacity });
+
+    glCreateVertexArrays(1, &VAO);
+    glState.bindVertexArray(VAO);
+
+        // Index buffer is stored in the VAO, so we never have to rebind it while drawing
+        glGenBuffers(1, &IBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+
+            // Only reserving the memory, meshes are copied in with glBufferSubData
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indexCapacity, nullptr, GL_STATIC_DRAW);
+
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+            glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * VERTEX_LENGTH * vertexCapacity, nullptr, GL_STATIC_DRAW);
+
+            // Same layout as Mesh::createMesh
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * VERTEX_LENGTH, 0);
+            glEnableVertexAttribArray(0);
+
+            // UV values - Texture
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * VERTEX_LENGTH, (void*)(sizeof(GLfloat) * 3));
+            glEnableVertexAttribArray(1);
+
+            // Normals
+            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * VERTEX_LENGTH, (void*)(sizeof(GLfloat) * 5));
+            glEnableVertexAttribArray(2);
+
+            // Tangents
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * VERTEX_LENGTH, (void*)(sizeof(GLfloat) * 8));
+            glEnableVertexAttribArray(3);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glState.bindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    // Buffers for indirect drawing, the transforms only change with the instances
+    glGenBuffers(1, &indirectBuffer);
+    glGenBuffers(1, &transformBuffer);
+    glGenBuffers(1, &instanceIndexBuffer);
+}
+
+bool GeometryArena::allocateBlock(std::vector<Block>& freeList, GLuint size, GLuint& offset) {
+    for(size_t i = 0; i < freeList.size(); i++) {
+        if(freeList[i].size < size) {
+            continue;
+        }
+
+        offset = freeList[i].offset;
+
+        // Shrinking the block from the front, removing it once it is used up
+        freeList[i].offset += size;
+        freeList[i].size -= size;
+
+        if(freeList[i].size == 0) {
+            freeList.erase(freeList.begin() + i);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void GeometryArena::releaseBlock(std::vector<Block>& freeList, GLuint offset, GLuint size) {
+    // Keeping the list sorted by offset so neighbours can be merged
+    size_t i = 0;
+    while(i < freeList.size() && freeList[i].offset < offset) {
+        i++;
+    }
+
+    freeList.insert(freeList.begin() + i, { offset, size });
+
+    // Merge with the next block
+    if(i + 1 < freeList.size() && freeList[i].offset + freeList[i].size == freeList[i + 1].offset) {
+        freeList[i].size += freeList[i + 1].size;
+        freeList.erase(freeList.begin() + i + 1);
+    }
+
+    // Merge with the previous block
+    if(i > 0 && freeList[i - 1].offset + freeList[i - 1].size == freeList[i].offset) {
+        freeList[i - 1].size += freeList[i].size;
+        freeList.erase(freeList.begin() + i);
+    }
+}
+
+bool GeometryArena::allocateMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices, MeshRange& range) {
+    if(!VAO) {
+        return false;
+    }
+
+    // numOfVertices is the number of floats, same as Mesh::createMesh
+    GLuint vertexCount = numOfVertices / VERTEX_LENGTH;
+    GLuint vertexOffset = 0, indexOffset = 0;
+
+    if(!allocateBlock(freeVertexBlocks, vertexCount, vertexOffset)) {
+        return false;
+    }
+
+    if(!allocateBlock(freeIndexBlocks, numOfIndices, indexOffset)) {
+        // Giving back the vertices we just took
+        releaseBlock(freeVertexBlocks, vertexOffset, vertexCount);
+        return false;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(GLfloat) * VERTEX_LENGTH * vertexOffset, sizeof(GLfloat) * numOfVertices, vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Using the copy target so that we don't disturb the element buffer of whichever VAO is bound
+    glBindBuffer(GL_COPY_WRITE_BUFFER, IBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * indexOffset, sizeof(GLuint) * numOfIndices, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // Indices stay local to the mesh, baseVertex moves them to the right place
+    range.firstIndex = indexOffset;
+    range.indexCount = numOfIndices;
+    range.baseVertex = static_cast<GLint>(vertexOffset);
+    range.vertexCount = vertexCount;
+
+    return true;
+}
+
+void GeometryArena::freeMesh(const MeshRange& range) {
+    if(!range.indexCount) {
+        return;
+    }
+
+    releaseBlock(freeVertexBlocks, static_cast<GLuint>(range.baseVertex), range.vertexCount);
+    releaseBlock(freeIndexBlocks, range.firstIndex, range.indexCount);
+}
+
+void GeometryArena::bindArena() {
+    glState.bindVertexArray(VAO);
+}
+
+void GeometryArena::drawMesh(const MeshRange& range, GLsizei instanceCount) {
+    glState.bindVertexArray(VAO);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+                                          (void*)(sizeof(GLuint) * range.firstIndex), instanceCount, range.baseVertex);
+}
+
+void GeometryArena::uploadTransforms(const std::vector<glm::mat4>& transforms) {
+    if(!VAO) {
+        return;
+    }
+
+    // Re-specifying the whole buffer, the driver can orphan the old one if it is still in use
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, transformBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * transforms.size(), transforms.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GeometryArena::uploadInstances(const std::vector<GLuint>& instanceIndices) {
+    if(instanceIndices.empty() || !VAO) {
+        return;
+    }
+
+    GLsizeiptr instanceIndexSize = sizeof(GLuint) * instanceIndices.size();
+
+    // Orphaning the old storage, the draws of the previous model may still be reading it
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceIndexBuffer);
+
+    if(instanceIndexSize > instanceIndexCapacity) {
+        instanceIndexCapacity = instanceIndexSize * 2;
+    }
+
+    glBufferData(GL_SHADER_STORAGE_BUFFER, instanceIndexCapacity, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, instanceIndexSize, instanceIndices.data());
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TRANSFORM_BINDING, transformBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_INDEX_BINDING, instanceIndexBuffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GeometryArena::uploadCommands(const std::vector<DrawElementsIndirectCommand>& commands) {
+    if(commands.empty() || !VAO) {
+        return;
+    }
+
+    GLsizeiptr commandSize = sizeof(DrawElementsIndirectCommand) * commands.size();
+
+    // Same as the instances, the draws of the previous model keep the old storage
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+    if(commandSize > indirectCapacity) {
+        indirectCapacity = commandSize * 2;
+    }
+
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCapacity, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commandSize, commands.data());
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GeometryArena::multiDrawIndirect(GLuint firstCommand, GLuint commandCount) {
+    if(!commandCount || !VAO) {
+        return;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+    glState.bindVertexArray(VAO);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(sizeof(DrawElementsIndirectCommand) * firstCommand),
+                                    static_cast<GLsizei>(commandCount), 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GeometryArena::cleanArena() {
+    // Preventing overflow, garbage collection
+    if(IBO) {
+        glDeleteBuffers(1, &IBO);
+        IBO = 0;
+    }
+
+    if(VBO) {
+        glDeleteBuffers(1, &VBO);
+        VBO = 0;
+    }
+
+    if(indirectBuffer) {
+        glDeleteBuffers(1, &indirectBuffer);
+        indirectBuffer = 0;
+    }
+
+    if(transformBuffer) {
+        glDeleteBuffers(1, &transformBuffer);
+        transformBuffer = 0;
+    }
+
+    if(instanceIndexBuffer) {
+        glDeleteBuffers(1, &instanceIndexBuffer);
+        instanceIndexBuffer = 0;
+    }
+
+    if(VAO) {
+        glState.forgetVertexArray(VAO);
+        glDeleteVertexArrays(1, &VAO);
+        VAO = 0;
+    }
+
+    indirectCapacity = 0;
+    instanceIndexCapacity = 0;
+    vertexCapacity = 0;
+    indexCapacity = 0;
+
+    freeVertexBlocks.clear();
+    freeIndexBlocks.clear();
+}
+
+// Failsafe, in case we accidentally delete the arena
+GeometryArena::~GeometryArena() {
+    cleanArena();
+}
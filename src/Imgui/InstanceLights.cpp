@@ -0,0 +1,352 @@
+#include "InstanceLights.h"
+
+#include <algorithm>
+#include <limits>
+
+// Shared light tests
+#include "ClusteredLights.h"
+#include "PointLight.h"
+
+// Room for the lists before the buffer has to grow - A few thousand instances with a few lights each
+const size_t INSTANCE_LIGHTS_INITIAL_SIZE = 16384;
+
+// Constructor
+InstanceLights::InstanceLights() {
+    maxRange = 0.0f;
+
+    gridOrigin = glm::vec2(0.0f);
+    cellSize = 1.0f;
+    gridWidth = 0;
+    gridDepth = 0;
+
+    listsBuffer = 0;
+    listsCapacity = 0;
+
+    maxInstanceLights = 0;
+    totalInstanceLights = 0;
+    assignTime = 0.0;
+}
+
+void InstanceLights::createBuffer() {
+    cleanBuffer();
+
+    listsCapacity = sizeof(GLuint) * INSTANCE_LIGHTS_INITIAL_SIZE;
+
+    glGenBuffers(1, &listsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, listsBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, listsCapacity, nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_LIGHTS_BINDING, listsBuffer);
+}
+
+void InstanceLights::clearInstances() {
+    bounds.clear();
+}
+
+GLint InstanceLights::addInstances(const AABB* boxes, size_t count) {
+    GLint first = static_cast<GLint>(bounds.size());
+    bounds.insert(bounds.end(), boxes, boxes + count);
+
+    return first;
+}
+
+int InstanceLights::getCell(float coordinate, float origin, int cellCount) const {
+    // Clamped before the conversion, boxes far outside the grid would overflow the int
+    float cell = std::floor((coordinate - origin) / cellSize);
+
+    return static_cast<int>(std::clamp(cell, 0.0f, static_cast<float>(cellCount - 1)));
+}
+
+void InstanceLights::assignRange(PartitionWork& work, size_t begin, size_t end) const {
+    work.indices.clear();
+    work.counts.assign(end - begin, 0);
+
+    if(lightOrder.empty()) {
+        return;
+    }
+
+    const float* x = lightX.data();
+    const float* y = lightY.data();
+    const float* z = lightZ.data();
+    const float* radius = lightRadius.data();
+
+    for(size_t i = begin; i < end; i++) {
+        const AABB& box = bounds[i];
+
+        // Only the lights centered less than the largest range away from the box can reach it
+        int firstX = getCell(box.min.x - maxRange, gridOrigin.x, gridWidth);
+        int lastX = getCell(box.max.x + maxRange, gridOrigin.x, gridWidth);
+        int firstZ = getCell(box.min.z - maxRange, gridOrigin.y, gridDepth);
+        int lastZ = getCell(box.max.z + maxRange, gridOrigin.y, gridDepth);
+
+        // Bounding sphere of the box, for the cone test
+        glm::vec3 center = 0.5f * (box.min + box.max);
+        float boxRadius = 0.5f * glm::length(box.max - box.min);
+
+        size_t listStart = work.indices.size();
+
+        for(int row = firstZ; row <= lastZ; row++) {
+            size_t first = cellStart[firstX + gridWidth * row];
+            size_t last = cellStart[lastX + 1 + gridWidth * row];
+
+            for(size_t light = first; light < last; light += 4) {
+                int mask = sphereBoxMask(x + light, y + light, z + light, radius + light, box.min, box.max);
+
+                // Lanes past the run belong to other cells
+                if(last - light < 4) {
+                    mask &= (1 << (last - light)) - 1;
+                }
+
+                for(int lane = 0; lane < 4; lane++) {
+                    if(!(mask & (1 << lane))) {
+                        continue;
+                    }
+
+                    size_t sorted = light + lane;
+
+                    // Spot lights also have to reach the box with their cone, wide cones only use the sphere
+                    if(lightEdges[sorted] > 0.0f && !isConeInSphere(glm::vec3(x[sorted], y[sorted], z[sorted]), lightDirections[sorted],
+                                                                    lightEdges[sorted], radius[sorted], center, boxRadius)) {
+                        continue;
+                    }
+
+                    work.indices.push_back(lightOrder[sorted]);
+                }
+            }
+        }
+
+        work.counts[i - begin] = static_cast<GLuint>(work.indices.size() - listStart);
+    }
+}
+
+void InstanceLights::assignLights(const std::vector<ClusterLightBlock>& lights, JobSystem* jobSystem) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Grid over the light centers on the ground, cells as big as the largest range unless there would be too many
+    size_t lightCount = lights.size();
+    glm::vec2 gridMin(std::numeric_limits<float>::max());
+    glm::vec2 gridMax(-std::numeric_limits<float>::max());
+    maxRange = 0.0f;
+
+    for(const ClusterLightBlock& light : lights) {
+        gridMin = glm::min(gridMin, glm::vec2(light.position.x, light.position.z));
+        gridMax = glm::max(gridMax, glm::vec2(light.position.x, light.position.z));
+        maxRange = std::max(maxRange, light.range);
+    }
+
+    glm::vec2 extent = lightCount ? gridMax - gridMin : glm::vec2(0.0f);
+    cellSize = std::max({ maxRange, extent.x / INSTANCE_LIGHTS_MAX_GRID, extent.y / INSTANCE_LIGHTS_MAX_GRID, 1e-3f });
+    gridOrigin = lightCount ? gridMin : glm::vec2(0.0f);
+    gridWidth = std::min(static_cast<int>(extent.x / cellSize) + 1, INSTANCE_LIGHTS_MAX_GRID);
+    gridDepth = std::min(static_cast<int>(extent.y / cellSize) + 1, INSTANCE_LIGHTS_MAX_GRID);
+
+    // Counting sort by cell, lights keep their order inside a cell so the lists don't depend on anything else
+    cellStart.assign(gridWidth * gridDepth + 1, 0);
+    lightCells.resize(lightCount);
+
+    for(size_t i = 0; i < lightCount; i++) {
+        lightCells[i] = getCell(lights[i].position.x, gridOrigin.x, gridWidth) + gridWidth * getCell(lights[i].position.z, gridOrigin.y, gridDepth);
+        cellStart[lightCells[i] + 1]++;
+    }
+
+    for(size_t cell = 1; cell < cellStart.size(); cell++) {
+        cellStart[cell] += cellStart[cell - 1];
+    }
+
+    lightOrder.resize(lightCount);
+
+    for(size_t i = 0; i < lightCount; i++) {
+        lightOrder[cellStart[lightCells[i]]++] = static_cast<GLuint>(i);
+    }
+
+    // Filling moved every start to the end of its cell, shifting them back
+    for(size_t cell = cellStart.size() - 1; cell > 0; cell--) {
+        cellStart[cell] = cellStart[cell - 1];
+    }
+
+    cellStart[0] = 0;
+
+    lightX.clear();
+    lightY.clear();
+    lightZ.clear();
+    lightRadius.clear();
+    lightDirections.clear();
+    lightEdges.clear();
+
+    for(GLuint light : lightOrder) {
+        const ClusterLightBlock& block = lights[light];
+
+        lightX.push_back(block.position.x);
+        lightY.push_back(block.position.y);
+        lightZ.push_back(block.position.z);
+        lightRadius.push_back(block.range);
+
+        float directionLength = glm::length(block.direction);
+        lightDirections.push_back(directionLength > 0.0f ? block.direction / directionLength : glm::vec3(0.0f, -1.0f, 0.0f));
+        lightEdges.push_back(block.edge);
+    }
+
+    // Spheres that don't touch anything, so the last loads of 4 never read past the end
+    for(int padding = 0; padding < 3; padding++) {
+        lightX.push_back(std::numeric_limits<float>::max());
+        lightY.push_back(0.0f);
+        lightZ.push_back(0.0f);
+        lightRadius.push_back(0.0f);
+    }
+
+    // Contiguous ranges of instances, small passes stay on this thread
+    size_t instanceCount = bounds.size();
+    size_t partitionCount = jobSystem ? jobSystem->getThreadCount() : 1;
+    partitionCount = std::max<size_t>(1, std::min(partitionCount, instanceCount / INSTANCE_LIGHTS_PARTITION_MIN));
+
+    if(partitions.size() < partitionCount) {
+        partitions.resize(partitionCount);
+    }
+
+    // Ranges don't share any instances, each one can go to a different worker
+    auto assignJob = [&](size_t partition) {
+        size_t begin, end;
+        JobSystem::getPartitionRange(instanceCount, partitionCount, partition, 1, begin, end);
+
+        assignRange(partitions[partition], begin, end);
+    };
+
+    if(jobSystem && partitionCount > 1) {
+        jobSystem->run(partitionCount, assignJob);
+    }
+
+    else {
+        for(size_t partition = 0; partition < partitionCount; partition++) {
+            assignJob(partition);
+        }
+    }
+
+    // Merged in order - Offset and count of instance i at 2i, the lists after all of them
+    lists.resize(2 * instanceCount);
+    maxInstanceLights = 0;
+    totalInstanceLights = 0;
+
+    GLuint offset = static_cast<GLuint>(lists.size());
+
+    for(size_t partition = 0; partition < partitionCount; partition++) {
+        const PartitionWork& work = partitions[partition];
+
+        size_t begin, end;
+        JobSystem::getPartitionRange(instanceCount, partitionCount, partition, 1, begin, end);
+
+        for(size_t i = begin; i < end; i++) {
+            GLuint count = work.counts[i - begin];
+
+            lists[2 * i] = offset;
+            lists[2 * i + 1] = count;
+
+            offset += count;
+            maxInstanceLights = std::max(maxInstanceLights, count);
+        }
+
+        totalInstanceLights += work.indices.size();
+        lists.insert(lists.end(), work.indices.begin(), work.indices.end());
+    }
+
+    assignTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void InstanceLights::uploadBuffer() {
+    GLsizeiptr size = sizeof(GLuint) * lists.size();
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, listsBuffer);
+
+    // Growing the buffer only when needed, otherwise just updating the contents
+    if(size > listsCapacity) {
+        listsCapacity = size * 2;
+        glBufferData(GL_SHADER_STORAGE_BUFFER, listsCapacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if(size) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, lists.data());
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_LIGHTS_BINDING, listsBuffer);
+}
+
+float InstanceLights::getAverageInstanceLights() const {
+    return bounds.empty() ? 0.0f : static_cast<float>(totalInstanceLights) / bounds.size();
+}
+
+void InstanceLights::benchmarkAssign(size_t instanceCount, size_t lightCount, int iterations) {
+    std::mt19937 generator(1234);
+
+    // Buildings and street lights of a city of 200 x 200, like the clustered lighting benchmark
+    std::uniform_real_distribution<float> street(0.0f, 200.0f);
+    std::uniform_real_distribution<float> width(1.0f, 3.0f);
+    std::uniform_real_distribution<float> height(2.0f, 10.0f);
+    std::uniform_real_distribution<float> lampHeight(1.0f, 3.0f);
+
+    InstanceLights instanceLights;
+
+    for(size_t i = 0; i < instanceCount; i++) {
+        glm::vec3 corner(street(generator), 0.0f, -street(generator));
+        instanceLights.addInstance({ corner, corner + glm::vec3(width(generator), height(generator), width(generator)) });
+    }
+
+    std::vector<ClusterLightBlock> lights(lightCount);
+
+    for(size_t i = 0; i < lightCount; i++) {
+        PointLight light(1.0f, 0.7f, 0.35f, 0.0f, 0.8f, street(generator), lampHeight(generator), -street(generator), 1.0f, 0.5f, 16.0f);
+        light.fillBlock(lights[i]);
+    }
+
+    JobSystem jobSystem;
+    jobSystem.createWorkers();
+
+    double singleTime = 0.0, jobTime = 0.0;
+
+    for(int i = 0; i < iterations; i++) {
+        instanceLights.assignLights(lights);
+        singleTime += instanceLights.getAssignTime();
+
+        instanceLights.assignLights(lights, &jobSystem);
+        jobTime += instanceLights.getAssignTime();
+    }
+
+    // Same counts as a scalar test of every light against every instance
+    size_t mismatches = 0;
+
+    for(size_t instance = 0; instance < instanceCount; instance++) {
+        const AABB& box = instanceLights.bounds[instance];
+        GLuint count = 0;
+
+        for(const ClusterLightBlock& light : lights) {
+            glm::vec3 offset = light.position - glm::clamp(light.position, box.min, box.max);
+            count += glm::dot(offset, offset) <= light.range * light.range;
+        }
+
+        mismatches += count != instanceLights.lists[2 * instance + 1];
+    }
+
+    printf("Instance Lights - %zu instances, %zu lights, %i iterations, %zu threads\n", instanceCount, lightCount,
+           iterations, jobSystem.getThreadCount());
+    printf("%18s %10.3f ms\n", "Single thread", singleTime / iterations);
+    printf("%18s %10.3f ms\n", "Job system", jobTime / iterations);
+    printf("%18s %10u\n", "Max per instance", instanceLights.getMaxInstanceLights());
+    printf("%18s %10.2f (%zu without lists)\n", "Avg per instance", instanceLights.getAverageInstanceLights(), lightCount);
+    printf("%18s %10zu\n", "Mismatches", mismatches);
+}
+
+void InstanceLights::cleanBuffer() {
+    if(listsBuffer) {
+        glDeleteBuffers(1, &listsBuffer);
+        listsBuffer = 0;
+    }
+
+    listsCapacity = 0;
+}
+
+// Destructor
+InstanceLights::~InstanceLights() {
+    cleanBuffer();
+}
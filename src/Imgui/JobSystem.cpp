@@ -0,0 +1,120 @@
+#include "JobSystem.h"
+
+// Constructor
+JobSystem::JobSystem() {
+    invoke = nullptr;
+    context = nullptr;
+    partitionCount = 0;
+    nextPartition = 0;
+    busyWorkers = 0;
+    generation = 0;
+    isStopping = false;
+}
+
+void JobSystem::createWorkers(size_t workerCount) {
+    // Failsafe, in case the workers are created again
+    stopWorkers();
+
+    if(!workerCount) {
+        // hardware_concurrency can return 0 if it doesn't know
+        size_t cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 0;
+    }
+
+    isStopping = false;
+
+    for(size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this);
+    }
+}
+
+void JobSystem::workerLoop() {
+    uint64_t seenGeneration = 0;
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&]() { return isStopping || generation != seenGeneration; });
+
+            if(isStopping) {
+                return;
+            }
+
+            seenGeneration = generation;
+        }
+
+        runPartitions();
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(--busyWorkers == 0) {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+void JobSystem::runPartitions() {
+    for(size_t partition = nextPartition.fetch_add(1); partition < partitionCount; partition = nextPartition.fetch_add(1)) {
+        invoke(context, partition);
+    }
+}
+
+void JobSystem::runJob(size_t count, void (*function)(void*, size_t), void* jobContext) {
+    // Not worth waking anyone up
+    if(workers.empty() || count < 2) {
+        for(size_t partition = 0; partition < count; partition++) {
+            function(jobContext, partition);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        invoke = function;
+        context = jobContext;
+        partitionCount = count;
+        nextPartition = 0;
+        busyWorkers = workers.size();
+        generation++;
+    }
+
+    startCondition.notify_all();
+
+    // The calling thread works as well instead of just waiting
+    runPartitions();
+
+    // Workers may still be running their last partition
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [&]() { return busyWorkers == 0; });
+}
+
+void JobSystem::getPartitionRange(size_t count, size_t partitionCount, size_t partition, size_t alignment, size_t& begin, size_t& end) {
+    // Rounding the size of the ranges up to the alignment, the last ranges may end up shorter or empty
+    size_t rangeSize = (count + partitionCount - 1) / partitionCount;
+    rangeSize = (rangeSize + alignment - 1) / alignment * alignment;
+
+    begin = std::min(count, partition * rangeSize);
+    end = std::min(count, begin + rangeSize);
+}
+
+void JobSystem::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+
+    startCondition.notify_all();
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+
+    workers.clear();
+}
+
+// Destructor
+JobSystem::~JobSystem() {
+    stopWorkers();
+}
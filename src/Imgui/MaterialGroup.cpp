@@ -0,0 +1,38 @@
+#include "MaterialGroup.h"
+
+GLuint MaterialGroup::nextSortID = 1;
+
+// Constructor
+MaterialGroup::MaterialGroup() {
+    sortID = nextSortID++;
+}
+
+void MaterialGroup::createGroup(const std::vector<Texture*>& textureSet, const Material& material) {
+    textures = textureSet;
+
+    parameterBuffer.createBuffer(sizeof(MaterialBlock), MATERIAL_BLOCK_BINDING);
+    setParameters(material);
+}
+
+void MaterialGroup::bindGroup() {
+    for(size_t unit = 0; unit < textures.size(); unit++) {
+        if(textures[unit]) {
+            textures[unit]->useTexture(unit);
+        }
+    }
+
+    parameterBuffer.bindBuffer();
+}
+
+void MaterialGroup::setParameters(const Material& material) {
+    parameters = material;
+
+    MaterialBlock block = {};
+    parameters.fillBlock(block);
+
+    parameterBuffer.updateBuffer(&block);
+}
+
+// Destructor
+MaterialGroup::~MaterialGroup() {
+}
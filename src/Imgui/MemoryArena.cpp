@@ -0,0 +1,233 @@
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <algorithm>
+
+#include "MemoryArena.h"
+
+// Constructor
+MemoryArena::MemoryArena(size_t initialSize) {
+    offset = 0;
+    used = 0;
+    peak = 0;
+
+    addBlock(initialSize);
+}
+
+void MemoryArena::addBlock(size_t minimumSize) {
+    // Doubling the capacity, so the number of blocks stays small even if the first guess was way off
+    size_t size = std::max(minimumSize, getCapacity());
+
+    blocks.push_back({ static_cast<unsigned char*>(::operator new(size)), size });
+    offset = 0;
+}
+
+void* MemoryArena::allocate(size_t size, size_t alignment) {
+    Block& block = blocks.back();
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + offset;
+    size_t padding = (alignment - address % alignment) % alignment;
+
+    if(offset + padding + size > block.size) {
+        // Worst case padding, a fresh block is aligned to max_align_t but alignment can be larger
+        addBlock(size + alignment);
+        return allocate(size, alignment);
+    }
+
+    offset += padding + size;
+    used += padding + size;
+    peak = std::max(peak, used);
+
+    return block.data + offset - size;
+}
+
+void MemoryArena::reset() {
+    // Merging the blocks into a single one that fits everything from the last cycle
+    if(blocks.size() > 1) {
+        size_t capacity = getCapacity();
+
+        cleanArena();
+        addBlock(capacity);
+    }
+
+    offset = 0;
+    used = 0;
+}
+
+size_t MemoryArena::getCapacity() const {
+    size_t capacity = 0;
+
+    for(const Block& block : blocks) {
+        capacity += block.size;
+    }
+
+    return capacity;
+}
+
+void MemoryArena::cleanArena() {
+    for(const Block& block : blocks) {
+        ::operator delete(block.data);
+    }
+
+    blocks.clear();
+    offset = 0;
+    used = 0;
+}
+
+// Destructor
+MemoryArena::~MemoryArena() {
+    cleanArena();
+}
+
+// Allocation Tracking=================================================================================================
+namespace {
+    struct SiteCounter {
+        std::atomic<const char*> name;
+        std::atomic<size_t> count;
+        std::atomic<size_t> bytes;
+    };
+
+    // Zero initialized before any constructor runs, so allocations made during static initialization are safe to count
+    SiteCounter siteCounters[MAX_ALLOCATION_SITES];
+    std::atomic<size_t> totalCount;
+    std::atomic<size_t> totalBytes;
+
+    const char* const UNTAGGED_SITE = "Untagged";
+    const char* const OTHER_SITE = "Other";
+
+    thread_local const char* currentSite = nullptr;
+
+    void recordAllocation(size_t size) {
+        totalCount.fetch_add(1, std::memory_order_relaxed);
+        totalBytes.fetch_add(size, std::memory_order_relaxed);
+
+        const char* site = currentSite ? currentSite : UNTAGGED_SITE;
+
+        // Finding the slot of the site or claiming an empty one, the last slot collects everything that didn't fit
+        for(size_t i = 0; i < MAX_ALLOCATION_SITES; i++) {
+            const char* name = siteCounters[i].name.load(std::memory_order_acquire);
+
+            if(name == nullptr) {
+                const char* expected = nullptr;
+                const char* claim = i == MAX_ALLOCATION_SITES - 1 ? OTHER_SITE : site;
+
+                if(siteCounters[i].name.compare_exchange_strong(expected, claim, std::memory_order_acq_rel)) {
+                    name = claim;
+                }
+
+                else {
+                    name = expected;
+                }
+            }
+
+            if(name == site || i == MAX_ALLOCATION_SITES - 1) {
+                siteCounters[i].count.fetch_add(1, std::memory_order_relaxed);
+                siteCounters[i].bytes.fetch_add(size, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    void* trackedAllocate(size_t size) {
+        recordAllocation(size);
+
+        // malloc(0) may return nullptr, new has to return a unique pointer
+        void* memory = std::malloc(size ? size : 1);
+
+        if(!memory) {
+            throw std::bad_alloc();
+        }
+
+        return memory;
+    }
+}
+
+void* operator new(size_t size) {
+    return trackedAllocate(size);
+}
+
+void* operator new[](size_t size) {
+    return trackedAllocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    recordAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    recordAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+// Constructor
+AllocationScope::AllocationScope(const char* siteName) {
+    previousSite = currentSite;
+    currentSite = siteName;
+}
+
+// Destructor
+AllocationScope::~AllocationScope() {
+    currentSite = previousSite;
+}
+
+size_t getAllocationCount() {
+    return totalCount.load(std::memory_order_relaxed);
+}
+
+size_t getAllocationBytes() {
+    return totalBytes.load(std::memory_order_relaxed);
+}
+
+size_t getAllocationSites(AllocationSite* sites, size_t maxSites) {
+    size_t written = 0;
+
+    for(size_t i = 0; i < MAX_ALLOCATION_SITES && written < maxSites; i++) {
+        const char* name = siteCounters[i].name.load(std::memory_order_acquire);
+
+        if(name == nullptr) {
+            break;
+        }
+
+        sites[written++] = { name, siteCounters[i].count.load(std::memory_order_relaxed), siteCounters[i].bytes.load(std::memory_order_relaxed) };
+    }
+
+    return written;
+}
+
+void printAllocationSites(const char* title) {
+    AllocationSite sites[MAX_ALLOCATION_SITES];
+    size_t siteCount = getAllocationSites(sites, MAX_ALLOCATION_SITES);
+
+    std::sort(sites, sites + siteCount, [](const AllocationSite& a, const AllocationSite& b) { return a.count > b.count; });
+
+    printf("%s - %zu allocations, %.2f MB\n", title, getAllocationCount(), getAllocationBytes() / (1024.0 * 1024.0));
+
+    for(size_t i = 0; i < siteCount; i++) {
+        printf("    %-28s %10zu allocations %10.2f MB\n", sites[i].name, sites[i].count, sites[i].bytes / (1024.0 * 1024.0));
+    }
+}
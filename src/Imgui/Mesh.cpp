@@ -8,15 +8,16 @@ Mesh::Mesh() {
     VBO = 0;
     IBO = 0;
     indexCount = 0;
+    arena = nullptr;
 }
 
-void Mesh::createMesh(GLfloat *vertices, unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices) {
+void Mesh::createMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices) {
     // Getting the number of indices
     indexCount = numOfIndices;
 
     // Creating and gettting the vertex ID of a VAO
     glCreateVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    glState.bindVertexArray(VAO);
 
         // Creating the Index Buffer Object
         glGenBuffers(1, &IBO);
@@ -55,13 +56,30 @@ void Mesh::createMesh(GLfloat *vertices, unsigned int *indices, unsigned int num
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     // Un-Binding Vertex Array
-    glBindVertexArray(0);
+    glState.bindVertexArray(0);
 
     // Un-Binding IBO/EBO after VAO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void Mesh::renderMesh() {
+void Mesh::createMesh(const GLfloat *vertices, const unsigned int *indices, unsigned int numOfVertices, unsigned int numOfIndices, GeometryArena* geometryArena) {
+    if(geometryArena && geometryArena->allocateMesh(vertices, indices, numOfVertices, numOfIndices, range)) {
+        arena = geometryArena;
+        indexCount = numOfIndices;
+        return;
+    }
+
+    // Arena is missing or full, using separate buffers
+    createMesh(vertices, indices, numOfVertices, numOfIndices);
+}
+
+void Mesh::renderMesh(GLsizei instanceCount) {
+    // Shared buffers, the VAO already holds the element buffer
+    if(arena) {
+        arena->drawMesh(range);
+        return;
+    }
+
     // Fail conditions
     if(!VAO) {
         std::cout<<"VAO NOT DEFINED PROPERLY!";
@@ -78,17 +96,40 @@ void Mesh::renderMesh() {
         return;
     }
 
-    // Binding the Vertex Array for Drawing
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-        // Drawing the Elements (Since we are using Indexed arrays)
-        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    // Binding the Vertex Array for Drawing, the IBO is part of the VAO state
+    // Left bound, the next draw of the same mesh doesn't have to bind it again
+    glState.bindVertexArray(VAO);
+        // Drawing the Elements (Since we are using Indexed arrays), one instance per view
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, instanceCount);
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void Mesh::renderMeshRange(GLuint firstIndex, GLsizei count, GLsizei instanceCount) {
+    if(arena) {
+        MeshRange subRange = range;
+        subRange.firstIndex += firstIndex;
+        subRange.indexCount = count;
+
+        arena->drawMesh(subRange, instanceCount);
+        return;
+    }
+
+    if(!VAO || !IBO) {
+        std::cout<<"MESH NOT DEFINED PROPERLY!";
+        return;
+    }
+
+    glState.bindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * firstIndex), instanceCount);
 }
 
 void Mesh::cleanMesh() {
+    // Giving the space back, the arena owns the buffers
+    if(arena) {
+        arena->freeMesh(range);
+        arena = nullptr;
+        range = MeshRange();
+    }
+
     // Preventing overflow, garbage collection
     if(IBO) {
         glDeleteBuffers(1, &IBO);
@@ -102,6 +143,7 @@ void Mesh::cleanMesh() {
 
     // Preventing overflow, garbage collection
     if(VAO) {
+        glState.forgetVertexArray(VAO);
         glDeleteVertexArrays(1, &VAO);
         VAO = 0;
     }
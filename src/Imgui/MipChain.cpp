@@ -0,0 +1,411 @@
+#include "MipChain.h"
+
+// SIMD intrinsics - SSE is always there on x64, the AVX2/FMA kernel is picked at runtime
+#include <immintrin.h>
+
+// MSVC compiles AVX2 intrinsics without /arch, GCC and Clang need the target on the function itself - A whole file built with
+// /arch:AVX2 or -mavx2 could use AVX2 anywhere in it, which the runtime check can't guard
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MIP_TARGET_AVX2
+#else
+#define MIP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+// Radius of every kernel in texels of the level being built
+static const float KAISER_RADIUS = 2.0f;
+static const float LANCZOS_RADIUS = 3.0f;
+
+// Steepness of the Kaiser window, higher rings less and blurs more
+static const float KAISER_ALPHA = 4.0f;
+
+// Entries of the linear to sRGB table - Fine enough that every byte survives the round trip, dark values included
+static const int SRGB_TABLE_SIZE = 1 << 16;
+
+// Source texels read by every texel of a level, with their weights (Summing to 1)
+struct MipTaps {
+    std::vector<int> offsets;
+    std::vector<int> indices;
+    std::vector<float> weights;
+    int maxTaps;
+};
+
+// Byte to float of the first three channels and of alpha, in the space the content is filtered in
+struct MipTables {
+    float colour[256], linear[256], normal[256];
+    unsigned char toSRGB[SRGB_TABLE_SIZE];
+
+    MipTables() {
+        for(int i = 0; i < 256; i++) {
+            float value = i / 255.0f;
+
+            colour[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            linear[i] = value;
+            normal[i] = value * 2.0f - 1.0f;
+        }
+
+        for(int i = 0; i < SRGB_TABLE_SIZE; i++) {
+            float value = i / float(SRGB_TABLE_SIZE - 1);
+            float curve = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+
+            toSRGB[i] = static_cast<unsigned char>(glm::clamp(curve, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const MipTables& getTables() {
+    // Built once by whichever thread gets here first
+    static const MipTables tables;
+    return tables;
+}
+
+static float sinc(float x) {
+    if(std::abs(x) < 1e-5f) {
+        return 1.0f;
+    }
+
+    x *= glm::pi<float>();
+    return std::sin(x) / x;
+}
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static float besselI0(float x) {
+    float sum = 1.0f, term = 1.0f;
+
+    for(int k = 1; k < 32 && term > sum * 1e-8f; k++) {
+        term *= (x * x) / (4.0f * k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+static float getKernelRadius(MipFilter filter) {
+    switch(filter) {
+        case MIP_FILTER_KAISER:
+            return KAISER_RADIUS;
+
+        case MIP_FILTER_LANCZOS:
+            return LANCZOS_RADIUS;
+
+        default:
+            return 0.5f;
+    }
+}
+
+// Weight of a texel x texels away (In texels of the level being built)
+static float evaluateKernel(MipFilter filter, float x) {
+    x = std::abs(x);
+
+    switch(filter) {
+        case MIP_FILTER_KAISER: {
+            if(x >= KAISER_RADIUS) {
+                return 0.0f;
+            }
+
+            float t = x / KAISER_RADIUS;
+            return sinc(x) * besselI0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / besselI0(KAISER_ALPHA);
+        }
+
+        case MIP_FILTER_LANCZOS:
+            return x < LANCZOS_RADIUS ? sinc(x) * sinc(x / LANCZOS_RADIUS) : 0.0f;
+
+        default:
+            // Texels right on the edge of the box are shared with the neighbour, odd sizes have those
+            return x < 0.5f - 1e-5f ? 1.0f : (x < 0.5f + 1e-5f ? 0.5f : 0.0f);
+    }
+}
+
+// Taps along one axis - Rows keep their unwrapped index, so the taps of one row are consecutive numbers for the row cache
+static void computeTaps(int sourceSize, int size, const MipSettings& settings, bool isResolved, MipTaps& taps) {
+    float scale = float(sourceSize) / size;
+    float support = getKernelRadius(settings.filter) * scale;
+
+    taps.offsets.assign(1, 0);
+    taps.indices.clear();
+    taps.weights.clear();
+    taps.maxTaps = 0;
+
+    for(int i = 0; i < size; i++) {
+        float center = (i + 0.5f) * scale;
+        int first = static_cast<int>(std::floor(center - support)), last = static_cast<int>(std::ceil(center + support));
+
+        size_t begin = taps.weights.size();
+        float sum = 0.0f;
+
+        for(int j = first; j <= last; j++) {
+            float weight = evaluateKernel(settings.filter, (j + 0.5f - center) / scale);
+
+            if(weight == 0.0f) {
+                continue;
+            }
+
+            int index = j;
+
+            if(isResolved) {
+                index = settings.isWrapping ? ((j % sourceSize) + sourceSize) % sourceSize : glm::clamp(j, 0, sourceSize - 1);
+            }
+
+            taps.indices.push_back(index);
+            taps.weights.push_back(weight);
+            sum += weight;
+        }
+
+        for(size_t tap = begin; tap < taps.weights.size(); tap++) {
+            taps.weights[tap] /= sum;
+        }
+
+        taps.offsets.push_back(static_cast<int>(taps.weights.size()));
+        taps.maxTaps = std::max(taps.maxTaps, static_cast<int>(taps.weights.size() - begin));
+    }
+}
+
+// AVX2 and FMA, and an OS that saves the YMM registers
+static bool hasAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+
+    if(info[0] < 7) {
+        return false;
+    }
+
+    __cpuid(info, 1);
+    bool hasFMA = (info[2] & (1 << 12)) != 0;
+    bool hasOSXSAVE = (info[2] & (1 << 27)) != 0;
+
+    if(!hasFMA || !hasOSXSAVE || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+// 8 floats at a time, every tap added to the same register before it is stored - Returns where the SSE loop picks up
+static MIP_TARGET_AVX2 int sumRowsAVX2(const float* const* rows, const float* weights, int rowCount, int length, float* result) {
+    int i = 0;
+
+    for(; i + 8 <= length; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+
+        for(int row = 0; row < rowCount; row++) {
+            sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[row]), _mm256_loadu_ps(rows[row] + i), sum);
+        }
+
+        _mm256_storeu_ps(result + i, sum);
+    }
+
+    return i;
+}
+
+// Weighted sum of rows into result
+static void sumRows(const float* const* rows, const float* weights, int rowCount, int length, float* result) {
+    static const bool isAVX2 = hasAVX2();
+
+    int i = isAVX2 ? sumRowsAVX2(rows, weights, rowCount, length, result) : 0;
+
+    for(; i + 4 <= length; i += 4) {
+        __m128 sum = _mm_setzero_ps();
+
+        for(int row = 0; row < rowCount; row++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[row]), _mm_loadu_ps(rows[row] + i)));
+        }
+
+        _mm_storeu_ps(result + i, sum);
+    }
+
+    for(; i < length; i++) {
+        float sum = 0.0f;
+
+        for(int row = 0; row < rowCount; row++) {
+            sum += weights[row] * rows[row][i];
+        }
+
+        result[i] = sum;
+    }
+}
+
+// Constructor
+MipChain::MipChain() {
+    width = 0;
+    height = 0;
+}
+
+GLuint MipChain::getLevelCount(int width, int height) {
+    GLuint levelCount = 1;
+
+    for(int size = std::max(width, height); size > 1; size >>= 1) {
+        levelCount++;
+    }
+
+    return levelCount;
+}
+
+MipContent MipChain::chooseContent(const std::string& path) {
+    std::string name = std::filesystem::path(path).filename().string();
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if(name.find("normal") != std::string::npos) {
+        return MIP_CONTENT_NORMAL;
+    }
+
+    for(const char* data : { "spec", "rough", "metal", "_ao", "occlusion", "height", "disp", "mask" }) {
+        if(name.find(data) != std::string::npos) {
+            return MIP_CONTENT_LINEAR;
+        }
+    }
+
+    return MIP_CONTENT_COLOUR;
+}
+
+void MipChain::build(const unsigned char* image, int imageWidth, int imageHeight, const MipSettings& settings, JobSystem* jobSystem) {
+    width = imageWidth;
+    height = imageHeight;
+
+    GLuint levelCount = getLevelCount(width, height);
+    levelOffsets.resize(levelCount + 1);
+
+    size_t offset = 0;
+
+    for(GLuint level = 0; level < levelCount; level++) {
+        levelOffsets[level] = offset;
+        offset += size_t(getLevelWidth(level)) * getLevelHeight(level) * 4;
+    }
+
+    levelOffsets[levelCount] = offset;
+    pixels.resize(offset);
+
+    memcpy(pixels.data(), image, size_t(width) * height * 4);
+
+    for(GLuint level = 1; level < levelCount; level++) {
+        int levelHeight = getLevelHeight(level);
+        size_t texels = size_t(getLevelWidth(level)) * levelHeight;
+
+        // Each level depends on the one above, so only its rows are split
+        size_t partitionCount = jobSystem ? std::min(jobSystem->getThreadCount(), texels / MIP_PARTITION_MIN_TEXELS) : 1;
+        partitionCount = std::max<size_t>(std::min<size_t>(partitionCount, levelHeight), 1);
+
+        auto buildPartition = [&](size_t partition) {
+            size_t begin, end;
+            JobSystem::getPartitionRange(levelHeight, partitionCount, partition, 1, begin, end);
+
+            buildLevelRows(level, settings, static_cast<int>(begin), static_cast<int>(end));
+        };
+
+        if(partitionCount > 1) {
+            jobSystem->run(partitionCount, buildPartition);
+        }
+
+        else {
+            buildPartition(0);
+        }
+    }
+}
+
+void MipChain::buildLevelRows(GLuint level, const MipSettings& settings, int rowBegin, int rowEnd) {
+    if(rowBegin >= rowEnd) {
+        return;
+    }
+
+    int sourceWidth = getLevelWidth(level - 1), sourceHeight = getLevelHeight(level - 1);
+    int levelWidth = getLevelWidth(level);
+
+    const unsigned char* source = getLevel(level - 1);
+    unsigned char* destination = pixels.data() + levelOffsets[level];
+
+    MipTaps columnTaps, rowTaps;
+    computeTaps(sourceWidth, levelWidth, settings, true, columnTaps);
+    computeTaps(sourceHeight, getLevelHeight(level), settings, false, rowTaps);
+
+    const MipTables& tables = getTables();
+    const float* toFloat = settings.content == MIP_CONTENT_COLOUR ? tables.colour :
+                           (settings.content == MIP_CONTENT_NORMAL ? tables.normal : tables.linear);
+
+    // Source rows as floats, slot = unwrapped row % size - The taps of a row are consecutive, so they never share a slot
+    int cacheSize = rowTaps.maxTaps;
+    size_t rowLength = size_t(sourceWidth) * 4;
+
+    std::vector<float> cache(cacheSize * rowLength);
+    std::vector<int> cachedRows(cacheSize, INT_MIN);
+
+    // Vertical pass result, one float RGBA per source column
+    std::vector<float> column(rowLength);
+    std::vector<const float*> rows(cacheSize);
+
+    for(int y = rowBegin; y < rowEnd; y++) {
+        int tapBegin = rowTaps.offsets[y], tapCount = rowTaps.offsets[y + 1] - tapBegin;
+
+        for(int tap = 0; tap < tapCount; tap++) {
+            int row = rowTaps.indices[tapBegin + tap];
+            int slot = ((row % cacheSize) + cacheSize) % cacheSize;
+            float* cached = cache.data() + slot * rowLength;
+
+            if(cachedRows[slot] != row) {
+                int sourceRow = settings.isWrapping ? ((row % sourceHeight) + sourceHeight) % sourceHeight : glm::clamp(row, 0, sourceHeight - 1);
+                const unsigned char* texel = source + size_t(sourceRow) * rowLength;
+
+                for(int x = 0; x < sourceWidth; x++) {
+                    cached[x * 4 + 0] = toFloat[texel[x * 4 + 0]];
+                    cached[x * 4 + 1] = toFloat[texel[x * 4 + 1]];
+                    cached[x * 4 + 2] = toFloat[texel[x * 4 + 2]];
+                    cached[x * 4 + 3] = tables.linear[texel[x * 4 + 3]];
+                }
+
+                cachedRows[slot] = row;
+            }
+
+            rows[tap] = cached;
+        }
+
+        sumRows(rows.data(), rowTaps.weights.data() + tapBegin, tapCount, static_cast<int>(rowLength), column.data());
+
+        unsigned char* output = destination + size_t(y) * levelWidth * 4;
+
+        // Horizontal pass, a whole RGBA texel per SSE register
+        for(int x = 0; x < levelWidth; x++) {
+            __m128 sum = _mm_setzero_ps();
+
+            for(int tap = columnTaps.offsets[x]; tap < columnTaps.offsets[x + 1]; tap++) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(columnTaps.weights[tap]), _mm_loadu_ps(column.data() + columnTaps.indices[tap] * 4)));
+            }
+
+            alignas(16) float texel[4];
+            _mm_store_ps(texel, sum);
+
+            // Filtered normals get shorter (And sharp kernels can overshoot), back to unit length so the mips keep their bumps
+            if(settings.content == MIP_CONTENT_NORMAL) {
+                glm::vec3 normal(texel[0], texel[1], texel[2]);
+                float length = glm::length(normal);
+
+                normal = length > 1e-6f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+                for(int channel = 0; channel < 3; channel++) {
+                    output[x * 4 + channel] = static_cast<unsigned char>((normal[channel] * 0.5f + 0.5f) * 255.0f + 0.5f);
+                }
+            }
+
+            else if(settings.content == MIP_CONTENT_COLOUR) {
+                for(int channel = 0; channel < 3; channel++) {
+                    output[x * 4 + channel] = tables.toSRGB[static_cast<int>(glm::clamp(texel[channel], 0.0f, 1.0f) * (SRGB_TABLE_SIZE - 1) + 0.5f)];
+                }
+            }
+
+            else {
+                for(int channel = 0; channel < 3; channel++) {
+                    output[x * 4 + channel] = static_cast<unsigned char>(glm::clamp(texel[channel], 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+
+            output[x * 4 + 3] = static_cast<unsigned char>(glm::clamp(texel[3], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+}
+
+void MipChain::release() {
+    std::vector<unsigned char>().swap(pixels);
+    std::vector<size_t>().swap(levelOffsets);
+}
@@ -6,6 +6,9 @@ const std::filesystem::path currentSourcePath = __FILE__;
 // Extract the directory containing the source file
 const std::filesystem::path currentSourceDir = currentSourcePath.parent_path();
 
+// Built once instead of for every texture that gets loaded
+const std::string textureDirectory = removeBackslash((currentSourceDir / "Textures/").string().c_str());
+
 Model::Model() {
     localPosition = glm::vec3(0.0f);
     localRotation = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -14,67 +17,214 @@ Model::Model() {
     initialTransform = glm::mat4(1.0f);
     accumulateTransform = glm::mat4(1.0f);
 
-    matUniformSpecularIntensity = 0;
-    matUniformShininess = 0;
-    matUniformMetalness = 0;
+    transformSystem = nullptr;
+    transformNode = INVALID_TRANSFORM;
+
+    geometryArena = nullptr;
+    textureStreamer = nullptr;
+
+    // Only the full detail mesh
+    lodErrors.push_back(0.0f);
+    boundingRadius = 0.0f;
 
-    // Attach default material to each object
-    this->material = Material();
+    // Empty until a mesh is added
+    bounds = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
 }
 
 void Model::renderModel() {
+    // Meshes of the same material usually follow each other, so the group is only switched when it changes
+    GLuint currentMaterial = UINT_MAX;
+
     // Iterating over the mesh to render
     for(size_t i = 0; i < meshList.size(); i++) {
-        unsigned int materialIndex = meshToTex[i];
+        if(meshToMaterial[i] != currentMaterial) {
+            currentMaterial = meshToMaterial[i];
+            bindMaterial(currentMaterial);
+        }
+
+        meshList[i]->renderMesh();
+    }
+}
+
+void Model::renderModelClusters(const Frustum& frustum, const glm::vec3& eyePosition, bool coneCulling, ClusterStats& stats) {
+    GLuint currentMaterial = UINT_MAX;
+
+    for(size_t i = 0; i < meshList.size(); i++) {
+        const std::vector<Meshlet>& meshlets = meshMeshlets[i];
+
+        if(meshToMaterial[i] != currentMaterial) {
+            currentMaterial = meshToMaterial[i];
+            bindMaterial(currentMaterial);
+        }
 
-        // Debugging
-        // printf("Material Index : %i, Texture List Size : %i", materialIndex, textureList.size());
+        if(meshlets.empty()) {
+            meshList[i]->renderMesh();
+            continue;
+        }
+
+        // Visible meshlets next to each other are merged into a single draw
+        GLuint first = 0;
+        GLsizei count = 0;
+
+        for(const Meshlet& meshlet : meshlets) {
+            if(!isMeshletVisible(meshlet, frustum, eyePosition, coneCulling, stats)) {
+                continue;
+            }
 
-        // Iterate over all textures in textureList
-        for (size_t index = 0; index < textureList.size(); index++) {
-            // Checking if the texure exists
-            if (textureList[index]) {
-                // printf("Render Model : %i\n", index);
-                textureList[index]->useTexture(index);
+            if(count && first + count == meshlet.firstIndex) {
+                count += meshlet.indexCount;
+                continue;
             }
+
+            if(count) {
+                meshList[i]->renderMeshRange(first, count);
+            }
+
+            first = meshlet.firstIndex;
+            count = meshlet.indexCount;
         }
 
-        // Rendering materials if present
-        // for (auto& material : materials) {
-        //     material.useMaterial();
-        // }
-        // Binding the values to uniform
-        this->material.useMaterial(matUniformSpecularIntensity, matUniformShininess, matUniformMetalness);
+        if(count) {
+            meshList[i]->renderMeshRange(first, count);
+        }
+    }
+}
 
-        meshList[i]->renderMesh();
+void Model::queueModelCulled(CommandBuffer& queue, Shader* shader, const glm::mat4* transform, const Frustum& frustum, CullingStats& stats,
+                             GLint lightInstance) {
+    cullAABBs(frustum, meshBounds, meshVisible, stats);
+
+    for(size_t i = 0; i < meshList.size(); i++) {
+        if(meshVisible[i]) {
+            queue.push({ meshList[i], shader, materialGroups[meshToMaterial[i]], transform, lightInstance });
+        }
+    }
+}
+
+void Model::queueModel(CommandBuffer& queue, Shader* shader, const glm::mat4* transform, GLint lightInstance) {
+    const glm::mat4* drawTransform = transform ? transform : getWorldTransform();
+
+    for(size_t i = 0; i < meshList.size(); i++) {
+        queue.push({ meshList[i], shader, materialGroups[meshToMaterial[i]], drawTransform, lightInstance });
+    }
+
+    // Children always use their own transform, and the clusters since their bounds aren't part of the instance
+    for(Model* child : children) {
+        child->queueModel(queue, shader);
     }
 }
 
 void Model::renderModel(const GLuint& uniformModel) {
     // Binding the uniform model
-    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(accumulateTransform));
+    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(*getWorldTransform()));
 
-    // Iterating over the mesh to render
-    for(size_t i = 0; i < meshList.size(); i++) {
-        unsigned int materialIndex = meshToTex[i];
+    renderModel();
 
-        // Debugging
-        // printf("Material Index : %i, Texture List Size : %i", materialIndex, textureList.size());
+    for(Model* child : children) {
+        child->renderModel(uniformModel);
+    }
+}
 
-        // Iterate over all textures in textureList
-        for (size_t index = 0; index < textureList.size(); index++) {
-            // Checking if the texure exists
-            if (textureList[index]) {
-                // printf("Render Model : %i\n", index);
-                textureList[index]->useTexture(index);
+void Model::bindMaterial(GLuint materialIndex) {
+    if(materialIndex < materialGroups.size()) {
+        materialGroups[materialIndex]->bindGroup();
+    }
+}
+
+bool Model::isInArena() const {
+    for(size_t i = 0; i < meshLODs.size(); i++) {
+        for(Mesh* mesh : meshLODs[i]) {
+            if(!mesh->isInArena()) {
+                return false;
             }
         }
+    }
 
-        meshList[i]->renderMesh();
+    return true;
+}
+
+bool Model::appendDrawCommands(std::vector<DrawElementsIndirectCommand>& commands, GLuint baseInstance, GLuint instanceCount, GLuint lod, int materialIndex) {
+    if(!isInArena()) {
+        return false;
     }
 
-    for(Model* child : children) {
-        child->renderModel(uniformModel);
+    for(size_t i = 0; i < meshLODs.size(); i++) {
+        if(materialIndex >= 0 && meshToMaterial[i] != static_cast<GLuint>(materialIndex)) {
+            continue;
+        }
+
+        // Meshes that couldn't be simplified as much use their last level
+        const std::vector<Mesh*>& levels = meshLODs[i];
+        const MeshRange& range = levels[std::min<size_t>(lod, levels.size() - 1)]->getRange();
+
+        commands.push_back({ range.indexCount, instanceCount, range.firstIndex, range.baseVertex, baseInstance });
+    }
+
+    return true;
+}
+
+GLuint Model::selectLOD(GLfloat distance, GLfloat objectScale, GLfloat projectionScale, GLfloat pixelError, GLuint currentLOD) {
+    // Errors grow with every level, so the first level above the threshold ends the search
+    auto coarsestLOD = [&](GLfloat threshold) {
+        GLuint lod = 0;
+
+        for(GLuint i = 1; i < lodErrors.size(); i++) {
+            if(lodErrors[i] * objectScale * projectionScale / distance > threshold) {
+                break;
+            }
+
+            lod = i;
+        }
+
+        return lod;
+    };
+
+    GLuint lod = coarsestLOD(pixelError);
+
+    // Switching to a finer level straight away, the current one is already showing too much error
+    if(lod <= currentLOD) {
+        return lod;
+    }
+
+    // Switching to a coarser level only once we are well inside its range
+    return std::max(currentLOD, coarsestLOD(pixelError * (1.0f - LOD_HYSTERESIS)));
+}
+
+void Model::generateLODs(const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices, const AABB& meshBox) {
+    AllocationScope allocationScope("Model::generateLODs");
+
+    size_t previousIndexCount = indices.size();
+
+    // Anything moving the surface by more than a quarter of the mesh's size is not worth keeping - From the bounds of the mesh
+    // itself, so the limit doesn't depend on the meshes loaded before it
+    GLfloat errorLimit = glm::length(meshBox.max - meshBox.min) * 0.5f * 0.25f;
+
+    for(GLuint level = 1; level < MAX_LOD_LEVELS; level++) {
+        size_t targetIndexCount = size_t(previousIndexCount * LOD_REDUCTION) / 3 * 3;
+
+        // Starting from the original mesh every time, so the errors are measured against the full detail mesh
+        GLfloat error = simplifyMesh(vertices, VERTEX_LENGTH, indices, targetIndexCount, errorLimit, lodIndices);
+
+        // Stop once the mesh doesn't get meaningfully smaller (Locked borders/seams or the error limit)
+        if(lodIndices.empty() || lodIndices.size() > previousIndexCount * 0.9f) {
+            break;
+        }
+
+        previousIndexCount = lodIndices.size();
+
+        compactVertices(vertices, VERTEX_LENGTH, lodIndices, lodVertices);
+
+        Mesh* lodMesh = new Mesh();
+        lodMesh->createMesh( &lodVertices[0], &lodIndices[0], lodVertices.size(), lodIndices.size(), geometryArena );
+        meshLODs.back().push_back(lodMesh);
+
+        if(lodErrors.size() <= level) {
+            lodErrors.push_back(error);
+        }
+
+        else {
+            lodErrors[level] = std::max(lodErrors[level], error);
+        }
     }
 }
 
@@ -92,224 +242,500 @@ void Model::loadNode(aiNode *node, const aiScene *scene) {
     }
 }
 
-void Model::loadMesh(aiMesh * mesh, const aiScene * scene) {
-    std::vector<GLfloat> vertices;
-    std::vector<unsigned int> indices;
+void Model::buildVertexData(aiMesh *mesh, std::vector<GLfloat>& vertices, std::vector<unsigned int>& indices) {
+    // Sizing the buffers once, writing through a pointer instead of growing them a few floats at a time
+    vertices.resize(size_t(mesh->mNumVertices) * VERTEX_LENGTH);
+    GLfloat* vertex = vertices.data();
 
-    for(size_t i = 0; i < mesh->mNumVertices; i++) {
+    for(size_t i = 0; i < mesh->mNumVertices; i++, vertex += VERTEX_LENGTH) {
         // Recreating the array we made in main.cpp for Vertices, UVs and Normals
-        vertices.insert(vertices.end(), { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z });
+        vertex[0] = mesh->mVertices[i].x;
+        vertex[1] = mesh->mVertices[i].y;
+        vertex[2] = mesh->mVertices[i].z;
 
         // Checking if mesh has texture
-        if(mesh->mTextureCoords[0]) {
-            vertices.insert(vertices.end(), { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y });
-        }
-
-        else{
-            vertices.insert(vertices.end(), { 0.0f, 0.0f });
-        }
+        vertex[3] = mesh->mTextureCoords[0] ? mesh->mTextureCoords[0][i].x : 0.0f;
+        vertex[4] = mesh->mTextureCoords[0] ? mesh->mTextureCoords[0][i].y : 0.0f;
 
         // Adding Normals
         // Adding the reversed values because of the shader code
-        vertices.insert(vertices.end(), { -mesh->mNormals[i].x, -mesh->mNormals[i].y, -mesh->mNormals[i].z });
+        vertex[5] = -mesh->mNormals[i].x;
+        vertex[6] = -mesh->mNormals[i].y;
+        vertex[7] = -mesh->mNormals[i].z;
 
         // Adding Tangents
         // Checking if the tagnets are availabe
-        if(mesh->mTangents) {
-            // Debugging
-            // std::cout<<mesh->mTangents[i].x<<" "<<mesh->mTangents[i].y<<" "<<mesh->mTangents[i].z<<"\n";
-
-            vertices.insert(vertices.end(), { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z });
-        }
-
-        else {
-            vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f });
-        }
+        vertex[8] = mesh->mTangents ? mesh->mTangents[i].x : 0.0f;
+        vertex[9] = mesh->mTangents ? mesh->mTangents[i].y : 0.0f;
+        vertex[10] = mesh->mTangents ? mesh->mTangents[i].z : 0.0f;
     }
 
     // Adding indices
-    // Going through each face as it has 3 vertices (indices)
+    // Going through each face as it has 3 vertices (indices), after aiProcess_Triangulate
+    indices.clear();
+    indices.reserve(size_t(mesh->mNumFaces) * 3);
+
     for(size_t i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
+        const aiFace& face = mesh->mFaces[i];
 
-        for(size_t j = 0; j < face.mNumIndices; j++) {
-            indices.push_back(face.mIndices[j]);
-        }
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
     }
+}
+
+void Model::addMesh(const std::vector<GLfloat>& vertices, const unsigned int* indices, size_t numOfIndices, unsigned int materialIndex) {
+    AABB meshBox = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+
+    for(size_t i = 0; i < vertices.size(); i += VERTEX_LENGTH) {
+        glm::vec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+
+        boundingRadius = std::max(boundingRadius, glm::length(position));
+        meshBox.min = glm::min(meshBox.min, position);
+        meshBox.max = glm::max(meshBox.max, position);
+    }
+
+    meshBounds.addBox(meshBox);
+    bounds.min = glm::min(bounds.min, meshBox.min);
+    bounds.max = glm::max(bounds.max, meshBox.max);
 
     Mesh* newMesh = new Mesh();
-    newMesh->createMesh( &vertices[0], &indices[0], vertices.size(), indices.size() );
+    newMesh->createMesh( vertices.data(), indices, vertices.size(), numOfIndices, geometryArena );
     meshList.push_back(newMesh);
 
-    // Storing index of all materials
-    meshToTex.push_back(mesh->mMaterialIndex);
+    // The Assimp path already hands over loadIndices, the glTF indices may be mapped and have to be copied
+    if(indices != loadIndices.data()) {
+        loadIndices.assign(indices, indices + numOfIndices);
+    }
+
+    // Level 0 is the mesh itself
+    meshLODs.push_back({ newMesh });
+    generateLODs(vertices, loadIndices, meshBox);
+
+    // Only splitting meshes that are large enough for culling to pay off
+    meshMeshlets.emplace_back();
+    if(numOfIndices / 3 > MESHLET_MAX_TRIANGLES * MESHLET_MIN_CLUSTERS) {
+        AllocationScope allocationScope("buildMeshlets");
+
+        buildMeshlets(vertices, VERTEX_LENGTH, loadIndices, meshMeshlets.back());
+    }
+
+    // Index of the material group, checked once the materials are loaded
+    meshToMaterial.push_back(materialIndex);
+}
+
+void Model::loadMesh(aiMesh * mesh, const aiScene * scene) {
+    buildVertexData(mesh, loadVertices, loadIndices);
+
+    addMesh(loadVertices, loadIndices.data(), loadIndices.size(), mesh->mMaterialIndex);
 }
 
 // Function to load the maps, since the functionality for loading each map is similar
-void Model::loadMap(aiMaterial* material, aiTextureType textureType, int textureIndex) {
+Texture* Model::loadMap(aiMaterial* material, aiTextureType textureType, const std::string& defaultName) {
     aiString path;
 
-    // If there is a diffuse map
-    if(material->GetTexture(textureType, 0, &path) == AI_SUCCESS) {
-        int idx = std::string(path.data).rfind("\\");
-        std::string fileName = std::string(path.data).substr(idx + 1);
+    // No map of this type, using the default texture
+    if(material->GetTexture(textureType, 0, &path) != AI_SUCCESS) {
+        return loadTextureOrDefault("", defaultName);
+    }
 
-        std::string texRealtivePath = (currentSourceDir / "Textures/").string();
-        std::string texRelativeFormatted = removeBackslash(texRealtivePath.c_str());
-        std::string texPath = texRelativeFormatted + fileName;
+    // Only the file name is used, the textures are expected in the Textures folder
+    const char* fileName = strrchr(path.data, '\\');
+    fileName = fileName ? fileName + 1 : path.data;
 
-        // Debugging
-        // printf("Loading Texture from: %s\n", texPath.c_str());
+    // Debugging
+    // printf("Loading Texture from: %s\n", (textureDirectory + fileName).c_str());
 
-        textureList[textureIndex] = new Texture(texPath.c_str());
+    return loadTextureOrDefault(textureDirectory + fileName, defaultName);
+}
 
-        // Debugging
-        // printf("Loading Texture: %s\n", fileName.c_str());
+void Model::loadMaterials(const aiScene * scene) {
+    AllocationScope allocationScope("Model::loadMaterials");
+
+    // Debugging
+    // printf("Number of Materials : %i\n", scene->mNumMaterials);
 
-        if(!textureList[textureIndex]->loadTexture()) {
-            printf("Failed to load texture at: %s\n", texPath.c_str());
+    if(!scene->mNumMaterials) {
+        printf("Error loading materials!\n");
+    }
 
-            // SAFE_DELETE
-            delete textureList[textureIndex];
-            textureList[textureIndex] = nullptr;
+    // One group per material, the meshes already store the index of theirs (mMaterialIndex)
+    // Assimp always adds a default material, so files without materials still get a group with the default textures
+    for(unsigned int i = 0; i < scene->mNumMaterials; i++) {
+        aiMaterial* material = scene->mMaterials[i];
 
-            // Loading an empty Normal Map instead of the default white texture
-            if(textureType == aiTextureType_HEIGHT) {
-                // Debugging
-                // printf("Adding default Normal Map\n");
+        // Every unit gets a texture, missing maps are replaced with a default one
+        std::vector<Texture*> textures(NORMAL_TEXTURE_UNIT + 1, nullptr);
 
-                std::string texRealtivePath = (currentSourceDir / "Textures/Default/emptyNormal.png").string();
-                std::string texRelativeFormatted = removeBackslash(texRealtivePath.c_str());
+        textures[DIFFUSE_TEXTURE_UNIT] = loadMap(material, aiTextureType_DIFFUSE, "white.jpg");
+        textures[SPECULAR_TEXTURE_UNIT] = loadMap(material, aiTextureType_SPECULAR, "white.jpg");
 
-                textureList[textureIndex] = new Texture(texRelativeFormatted.c_str());
-                textureList[textureIndex]->loadTexture();
-            }
+        // aiTextureType_NORMAL doesn't load normal maps, aiTextureType_HEIGHT does - Wavefront OBJ format
+        textures[NORMAL_TEXTURE_UNIT] = loadMap(material, aiTextureType_HEIGHT, "emptyNormal.png");
+
+        MaterialGroup* group = new MaterialGroup();
+        group->createGroup(textures, Material());
+        materialGroups.push_back(group);
+    }
+
+    finalizeMaterials();
+
+    // Debugging
+    // printf("Texture List Size : %i\n", textureList.size());
+}
+
+void Model::addDefaultMaterial() {
+    std::vector<Texture*> textures(NORMAL_TEXTURE_UNIT + 1, nullptr);
+
+    textures[DIFFUSE_TEXTURE_UNIT] = loadTextureOrDefault("", "white.jpg");
+    textures[SPECULAR_TEXTURE_UNIT] = loadTextureOrDefault("", "white.jpg");
+    textures[NORMAL_TEXTURE_UNIT] = loadTextureOrDefault("", "emptyNormal.png");
+
+    MaterialGroup* group = new MaterialGroup();
+    group->createGroup(textures, Material());
+    materialGroups.push_back(group);
+}
+
+void Model::finalizeMaterials() {
+    if(materialGroups.empty()) {
+        addDefaultMaterial();
+    }
+
+    // Meshes without a valid material use the first one
+    for(unsigned int& materialIndex : meshToMaterial) {
+        if(materialIndex >= materialGroups.size()) {
+            materialIndex = 0;
         }
     }
 }
 
-void Model::loadMaterials(const aiScene * scene) {
-    // Initializing the vector
-    textureList.resize(scene->mNumMaterials);
+void Model::loadModel(const std::string& filePath, GeometryArena* arena, TextureStreamer* streamer) {
+    AllocationScope allocationScope("Model::loadModel");
 
-    // Debugging
-    // printf("Number of Materials : %i\n", scene->mNumMaterials);
+    // glTF files take the fast path, Assimp is only used if the native loader can't handle the file
+    if(std::filesystem::path(filePath).extension() == ".gltf" && loadGLTF(filePath, arena, streamer)) {
+        return;
+    }
 
-    // Checking if already loaded
-    bool diffuse = true, specular = true, normal = true, ambientOcclusion = true;
+    Assimp::Importer importer;
 
-    /*
-    The code is not using AI_SCENE_FLAGS_INCOMPLETE, hence it will always have 1 material by default
-    To bypass this, iterating over the materials by checking if numMaterials > 1 and using those as texture.
-    */
-    if(scene->mNumMaterials > 1) {
-        // TODO : Remove the magic number 1
-        aiMaterial* material = scene->mMaterials[1];
+    // Meshes fall back to their own buffers when this is nullptr
+    geometryArena = arena;
+    textureStreamer = streamer;
 
-        // Counting the various textures in the material
-        int textureCount = material->GetTextureCount(aiTextureType_DIFFUSE) +
-                           material->GetTextureCount(aiTextureType_AMBIENT_OCCLUSION) +
-                           material->GetTextureCount(aiTextureType_SPECULAR) +
-                           material->GetTextureCount(aiTextureType_HEIGHT);
+    // aiProcess_Triangulate - Triangulate quads or mesh
+    // aiProcess_FlipUVs - Flip UVs along Y axis (Because of the way our lighting is setup)
+    // aiProcess_GenSmoothNormals - We are not handling flat shading
+    // aiProcess_JoinIdenticalVertices - If overlapping vertices, will combine them
+    const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace );
 
-        // Debugging
-        // printf("Texture Count : %i\n", textureCount);
+    // If there is no model
+    if(!scene) {
+        printf("Failed to load model (%s) : %s\n", filePath.c_str(), importer.GetErrorString());
+        return;
+    }
 
-        // Resizing list to fit all the textures
-        textureList.resize(textureCount);
+    loadNode(scene->mRootNode, scene);
 
-        // Iterating over the various textures
-        for(size_t i = 0; i < textureCount; i++) {
-            textureList[i] = nullptr;
+    loadMaterials(scene);
 
-            // Debugging
-            // printf("Texture Index : %zi\n", i);
+    releaseLoadBuffers();
+}
 
-            // Checking for null maps
-            // DIFFUSE MAP - Texture Unit 0
-            if(material->GetTextureCount(aiTextureType_DIFFUSE) && diffuse) {
-                loadMap(material, aiTextureType_DIFFUSE, i);
-                diffuse = false;
-            }
+void Model::releaseLoadBuffers() {
+    // swap instead of clear, clear keeps the capacity around
+    std::vector<GLfloat>().swap(loadVertices);
+    std::vector<GLfloat>().swap(lodVertices);
+    std::vector<unsigned int>().swap(loadIndices);
+    std::vector<unsigned int>().swap(lodIndices);
 
-            // SPECULAR MAP - Texture Unit 1
-            else if(material->GetTextureCount(aiTextureType_SPECULAR) && specular) {
-                loadMap(material, aiTextureType_SPECULAR, i);
-                specular = false;
-            }
+    loadedTextures.clear();
+}
 
-            // NORMAL MAP - Texture Unit 2
-            // aiTextureType_NORMAL doesn't load normal maps, aiTextureType_HEIGHT does - Wavefront OBJ format
-            else if(material->GetTextureCount(aiTextureType_HEIGHT) && normal) {
-                loadMap(material, aiTextureType_HEIGHT, i);
-                normal = false;
-            }
+Texture* Model::loadTextureOrDefault(const std::string& texturePath, const std::string& defaultName) {
+    if(!texturePath.empty()) {
+        auto loaded = loadedTextures.find(texturePath);
+
+        if(loaded != loadedTextures.end()) {
+            return loaded->second;
+        }
+
+        // Texture keeps the pointer to the path, so it has to outlive loadTexture
+        Texture* texture = new Texture(texturePath.c_str());
+
+        // Flat normal until the normal map is streamed in, white for everything else
+        glm::u8vec4 placeholder = defaultName == "emptyNormal.png" ? glm::u8vec4(128, 128, 255, 255) : glm::u8vec4(255);
+
+        if(textureStreamer ? texture->loadTextureStreamed(textureStreamer, placeholder) : texture->loadTexture()) {
+            textureList.push_back(texture);
+            loadedTextures[texturePath] = texture;
+
+            return texture;
+        }
 
-            // AMBIENT OCCLUSION - Texture Unit 3
-            else if(material->GetTextureCount(aiTextureType_AMBIENT_OCCLUSION) && ambientOcclusion) {
-                loadMap(material, aiTextureType_AMBIENT_OCCLUSION, i);
-                ambientOcclusion = false;
+        printf("Failed to load texture at: %s\n", texturePath.c_str());
+        delete texture;
+    }
+
+    std::string defaultPath = textureDirectory + "Default/" + defaultName;
+    auto loaded = loadedTextures.find(defaultPath);
+
+    if(loaded != loadedTextures.end()) {
+        return loaded->second;
+    }
+
+    Texture* texture = new Texture(defaultPath.c_str());
+    texture->loadTexture();
+
+    textureList.push_back(texture);
+    loadedTextures[defaultPath] = texture;
+
+    return texture;
+}
+
+bool Model::loadGLTF(const std::string& filePath, GeometryArena* arena, TextureStreamer* streamer) {
+    GLTFLoader loader;
+
+    if(!loader.loadFile(filePath)) {
+        printf("Failed to load model (%s)\n", filePath.c_str());
+        return false;
+    }
+
+    geometryArena = arena;
+    textureStreamer = streamer;
+
+    // Primitives without a material get the default material of glTF, a group after the ones of the file
+    unsigned int defaultMaterial = static_cast<unsigned int>(loader.getMaterials().size());
+    bool isDefaultMaterialUsed = false;
+
+    // The indices are uploaded straight from the mapped file when possible
+    for(const GLTFPrimitive& primitive : loader.getPrimitives()) {
+        isDefaultMaterialUsed |= primitive.material < 0;
+
+        addMesh(primitive.vertices, primitive.getIndices(), primitive.indexCount,
+                primitive.material < 0 ? defaultMaterial : static_cast<unsigned int>(primitive.material));
+    }
+
+    // Same texture units as loadMaterials - Diffuse 0, Specular 1, Normal 2
+    for(const GLTFMaterial& material : loader.getMaterials()) {
+        std::vector<Texture*> textures(NORMAL_TEXTURE_UNIT + 1, nullptr);
+
+        textures[DIFFUSE_TEXTURE_UNIT] = loadTextureOrDefault(material.diffusePath, "white.jpg");
+        textures[SPECULAR_TEXTURE_UNIT] = loadTextureOrDefault("", "white.jpg");
+        textures[NORMAL_TEXTURE_UNIT] = loadTextureOrDefault(material.normalPath, "emptyNormal.png");
+
+        MaterialGroup* group = new MaterialGroup();
+        group->createGroup(textures, Material());
+        materialGroups.push_back(group);
+    }
+
+    // Without any material in the file, finalizeMaterials adds the same group as group 0
+    if(isDefaultMaterialUsed && defaultMaterial > 0) {
+        addDefaultMaterial();
+    }
+
+    finalizeMaterials();
+
+    releaseLoadBuffers();
+
+    return true;
+}
+
+void Model::benchmarkLoaders(const std::string& filePath, int iterations) {
+    size_t assimpVertices = 0, assimpIndices = 0;
+    size_t gltfVertices = 0, gltfIndices = 0;
+
+    // Position and UV of every Assimp vertex, quantized - Vertices are welded and reordered, so they are matched by value
+    std::unordered_set<std::string> assimpTexels;
+
+    auto getTexelKey = [](const GLfloat* vertex) {
+        std::string key;
+
+        for(int c = 0; c < 5; c++) {
+            key += std::to_string(static_cast<long long>(std::lround(vertex[c] * 10000.0f))) + ",";
+        }
+
+        return key;
+    };
+
+    // Assimp - Same flags as loadModel, interleaving every mesh like loadMesh does
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for(int i = 0; i < iterations; i++) {
+        Assimp::Importer importer;
+        const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace );
+
+        if(!scene) {
+            printf("Assimp failed to load (%s) : %s\n", filePath.c_str(), importer.GetErrorString());
+            return;
+        }
+
+        assimpVertices = assimpIndices = 0;
+
+        for(size_t m = 0; m < scene->mNumMeshes; m++) {
+            std::vector<GLfloat> vertices;
+            std::vector<unsigned int> indices;
+
+            buildVertexData(scene->mMeshes[m], vertices, indices);
+
+            assimpVertices += vertices.size() / VERTEX_LENGTH;
+            assimpIndices += indices.size();
+
+            if(i == 0) {
+                for(size_t v = 0; v < vertices.size(); v += VERTEX_LENGTH) {
+                    assimpTexels.insert(getTexelKey(&vertices[v]));
+                }
             }
+        }
+    }
+
+    auto middle = std::chrono::high_resolution_clock::now();
+
+    // glTF - Parsing, mapping and converting
+    for(int i = 0; i < iterations; i++) {
+        GLTFLoader loader;
+
+        if(!loader.loadFile(filePath)) {
+            return;
+        }
+
+        gltfVertices = gltfIndices = 0;
+
+        for(const GLTFPrimitive& primitive : loader.getPrimitives()) {
+            gltfVertices += primitive.vertexCount;
+            gltfIndices += primitive.indexCount;
+        }
+    }
 
-            // If there was no texture, plugin default texture
-            if(!textureList[i]) {
-                // Debugging
-                // printf("Adding default White Texture\n");
+    auto end = std::chrono::high_resolution_clock::now();
 
-                std::string texRealtivePath = (currentSourceDir / "Textures/Default/white.jpg").string();
-                std::string texRelativeFormatted = removeBackslash(texRealtivePath.c_str());
+    // Both loaders have to give the same UVs, a flipped V shows up as almost every vertex missing
+    size_t uvMismatches = 0;
+    GLTFLoader loader;
 
-                textureList[i] = new Texture(texRelativeFormatted.c_str());
-                textureList[i]->loadTexture();
+    if(loader.loadFile(filePath)) {
+        for(const GLTFPrimitive& primitive : loader.getPrimitives()) {
+            for(size_t v = 0; v < primitive.vertices.size(); v += VERTEX_LENGTH) {
+                uvMismatches += assimpTexels.find(getTexelKey(&primitive.vertices[v])) == assimpTexels.end();
             }
         }
     }
 
-    // Default material/No material
-    else if(scene->mNumMaterials == 1) {
-        aiMaterial* material = scene->mMaterials[0];
+    double assimpTime = std::chrono::duration<double, std::milli>(middle - start).count() / iterations;
+    double gltfTime = std::chrono::duration<double, std::milli>(end - middle).count() / iterations;
 
-        textureList[0] = nullptr;
+    printf("Loading %s, average of %i runs\n", filePath.c_str(), iterations);
+    printf("Assimp : %8.3f ms - %zu vertices, %zu indices\n", assimpTime, assimpVertices, assimpIndices);
+    printf("glTF   : %8.3f ms - %zu vertices, %zu indices\n", gltfTime, gltfVertices, gltfIndices);
+    printf("Speedup : %.2fx\n", gltfTime > 0.0 ? assimpTime / gltfTime : 0.0);
+    printf("UV mismatches : %zu of %zu glTF vertices%s\n", uvMismatches, gltfVertices, uvMismatches ? " - Loaders disagree!" : "");
+}
 
-        // Debugging
-        // printf("Missing materials!\nAdding default texture\n");
+void Model::benchmarkClusterCulling(const std::string& filePath, int views) {
+    std::vector<std::vector<GLfloat>> meshVertices;
+    std::vector<std::vector<unsigned int>> meshIndices;
 
-        std::string texRealtivePath = (currentSourceDir / "Textures/Default/white.jpg").string();
-        std::string texRelativeFormatted = removeBackslash(texRealtivePath.c_str());
+    // Loading on the CPU only, through the same paths as loadModel
+    GLTFLoader loader;
 
-        textureList[0] = new Texture(texRelativeFormatted.c_str());
-        textureList[0]->loadTexture();
+    if(std::filesystem::path(filePath).extension() == ".gltf" && loader.loadFile(filePath)) {
+        for(const GLTFPrimitive& primitive : loader.getPrimitives()) {
+            meshVertices.push_back(primitive.vertices);
+            meshIndices.emplace_back(primitive.getIndices(), primitive.getIndices() + primitive.indexCount);
+        }
     }
 
     else {
-        printf("Error loading materials!\n");
+        Assimp::Importer importer;
+        const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace );
+
+        if(!scene) {
+            printf("Failed to load model (%s) : %s\n", filePath.c_str(), importer.GetErrorString());
+            return;
+        }
+
+        for(size_t m = 0; m < scene->mNumMeshes; m++) {
+            meshVertices.emplace_back();
+            meshIndices.emplace_back();
+            buildVertexData(scene->mMeshes[m], meshVertices.back(), meshIndices.back());
+        }
     }
 
-    // Debugging
-    // printf("Texture List Size : %i\n", textureList.size());
-}
+    // Every mesh is split for the benchmark, regardless of MESHLET_MIN_CLUSTERS
+    std::vector<std::vector<Meshlet>> meshlets(meshVertices.size());
+    glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+    size_t clusterCount = 0;
 
-void Model::loadModel(const std::string& filePath) {
-    Assimp::Importer importer;
+    for(size_t m = 0; m < meshVertices.size(); m++) {
+        buildMeshlets(meshVertices[m], VERTEX_LENGTH, meshIndices[m], meshlets[m]);
+        clusterCount += meshlets[m].size();
 
-    // aiProcess_Triangulate - Triangulate quads or mesh
-    // aiProcess_FlipUVs - Flip UVs along Y axis (Because of the way our lighting is setup)
-    // aiProcess_GenSmoothNormals - We are not handling flat shading
-    // aiProcess_JoinIdenticalVertices - If overlapping vertices, will combine them
-    const aiScene *scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace );
+        for(size_t i = 0; i < meshVertices[m].size(); i += VERTEX_LENGTH) {
+            glm::vec3 position(meshVertices[m][i], meshVertices[m][i + 1], meshVertices[m][i + 2]);
+            minimum = glm::min(minimum, position);
+            maximum = glm::max(maximum, position);
+        }
+    }
 
-    // If there is no model
-    if(!scene) {
-        printf("Failed to load model (%s) : %s\n", filePath.c_str(), importer.GetErrorString());
+    if(clusterCount == 0) {
+        printf("No triangles in %s\n", filePath.c_str());
         return;
     }
 
-    loadNode(scene->mRootNode, scene);
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius = glm::length(maximum - minimum) * 0.5f;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.01f * radius, 100.0f * radius);
 
-    loadMaterials(scene);
+    printf("Cluster culling %s - %zu clusters (%u verts/%u tris max), %i views per distance\n",
+           filePath.c_str(), clusterCount, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, views);
+
+    // Close up (Most clusters outside the frustum) to far away (Only back faces culled)
+    for(float distance : { 1.25f, 2.0f, 4.0f }) {
+        ClusterStats stats;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for(int v = 0; v < views; v++) {
+            // Fibonacci sphere, evenly spread cameras looking at the center
+            float y = 1.0f - 2.0f * (v + 0.5f) / views;
+            float ring = std::sqrt(1.0f - y * y);
+            float angle = v * 2.39996323f;
+
+            glm::vec3 eye = center + distance * radius * glm::vec3(ring * std::cos(angle), y, ring * std::sin(angle));
+            glm::vec3 up = std::abs(y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+            Frustum frustum = extractFrustum(projection * glm::lookAt(eye, center, up));
+
+            for(const std::vector<Meshlet>& list : meshlets) {
+                for(const Meshlet& meshlet : list) {
+                    isMeshletVisible(meshlet, frustum, eye, true, stats);
+                }
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        double time = std::chrono::duration<double, std::micro>(end - start).count() / views;
+
+        printf("Distance %.2fx radius : %6.2f us per view\n", distance, time);
+        printf("    Frustum  : %6.2f%% clusters, %6.2f%% triangles rejected\n",
+               100.0 * stats.frustumCulledClusters / stats.clusters, 100.0 * stats.frustumCulledTriangles / stats.triangles);
+        printf("    Backface : %6.2f%% clusters, %6.2f%% triangles rejected\n",
+               100.0 * stats.backfaceCulledClusters / stats.clusters, 100.0 * stats.backfaceCulledTriangles / stats.triangles);
+    }
 }
 
 void Model::clearModel() {
+    // Level 0 is deleted with the meshList
+    for(size_t i = 0; i < meshLODs.size(); i++) {
+        for(size_t level = 1; level < meshLODs[i].size(); level++) {
+            delete meshLODs[i][level];
+        }
+    }
+
+    meshLODs.clear();
+    meshMeshlets.clear();
+    meshBounds.clear();
+    bounds = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    lodErrors.resize(1);
+
     for(size_t i = 0; i < meshList.size(); i++) {
         if(meshList[i]) {
             delete meshList[i];
@@ -317,12 +743,22 @@ void Model::clearModel() {
         }
     }
 
+    // Groups only point to the textures, so they go first
+    for(MaterialGroup* group : materialGroups) {
+        delete group;
+    }
+
+    materialGroups.clear();
+    meshToMaterial.clear();
+
     for(size_t i = 0; i < textureList.size(); i++) {
         if(textureList[i]) {
             delete textureList[i];
             textureList[i] = nullptr;
         }
     }
+
+    textureList.clear();
 }
 
 // Getters=============================================================================================================
@@ -338,6 +774,10 @@ GLuint Model::calculateChainLength() {
     return length;
 }
 
+const glm::mat4* Model::getWorldTransform() const {
+    return transformSystem ? &transformSystem->getWorldMatrix(transformNode) : &accumulateTransform;
+}
+
 void Model::clearChildren() {
     // Safe delete
     for(Model* child : children) {
@@ -396,30 +836,54 @@ void Model::attachParent(Model* parentModel) {
     printf("Failed to attach to parent!\n");
 }
 
+void Model::attachTransform(TransformSystem* system, TransformHandle parentNode) {
+    if(!system) {
+        printf("Failed to attach to transform system!\n");
+        return;
+    }
+
+    transformSystem = system;
+    transformNode = system->createNode(parentNode, localPosition, glm::quat(glm::radians(localRotation)), localScale);
+
+    for(Model* child : children) {
+        child->attachTransform(system, transformNode);
+    }
+}
+
 void Model::updateTranslation(glm::vec3& offset) {
     accumulateTransform = glm::translate(accumulateTransform, offset);
 }
 
 void Model::setPosition(glm::vec3& pos) {
     localPosition = pos;
+
+    if(transformSystem) {
+        transformSystem->setPosition(transformNode, localPosition);
+    }
 }
 
 void Model::setRotation(glm::vec3& rot) {
     localRotation = rot;
+
+    if(transformSystem) {
+        transformSystem->setRotation(transformNode, glm::quat(glm::radians(localRotation)));
+    }
 }
 
 void Model::setScale(glm::vec3& scale) {
     localScale = scale;
+
+    if(transformSystem) {
+        transformSystem->setScale(transformNode, localScale);
+    }
 }
 
 void Model::updateMaterialProperties(GLfloat specular, GLfloat shine, GLfloat metal) {
-    material.setMaterialParamters(specular, shine, metal);
-}
+    Material material(specular, shine, metal);
 
-void Model::setMaterialUniforms(GLuint uniformSpecularIntensity, GLuint uniformShininess, GLuint uniformMetalness) {
-    matUniformSpecularIntensity = uniformSpecularIntensity;
-    matUniformShininess = uniformShininess;
-    matUniformMetalness = uniformMetalness;
+    for(MaterialGroup* group : materialGroups) {
+        group->setParameters(material);
+    }
 }
 
 void Model::updateRotation(GLfloat angle, glm::vec3& axis, bool rads) {
@@ -0,0 +1,235 @@
+#include "RenderQueue.h"
+
+// Constructor
+CommandBuffer::CommandBuffer() {
+    view = glm::mat4(1.0f);
+    farPlane = 100.0f;
+    droppedDraws = 0;
+}
+
+void CommandBuffer::begin(const glm::mat4& viewMatrix, GLfloat farClipping) {
+    // Keeping the memory, the queue is filled again every pass
+    items.clear();
+    keys.clear();
+
+    view = viewMatrix;
+    farPlane = farClipping;
+    droppedDraws = 0;
+}
+
+bool CommandBuffer::push(const RenderItem& item, RenderPassType pass) {
+    if(items.size() >= RENDER_QUEUE_MAX_DRAWS) {
+        droppedDraws++;
+        return false;
+    }
+
+    // Distance in front of the camera of the origin of the draw, quantized over [0, far]
+    const glm::vec4& position = (*item.transform)[3];
+    GLfloat depth = -(view[0][2] * position.x + view[1][2] * position.y + view[2][2] * position.z + view[3][2] * position.w);
+
+    const uint64_t maxDepth = (uint64_t(1) << SORT_DEPTH_BITS) - 1;
+    uint64_t depthBits = static_cast<uint64_t>(glm::clamp(depth / farPlane, 0.0f, 1.0f) * maxDepth);
+
+    uint64_t state = static_cast<uint64_t>(item.shader->getShaderIDLocation()) & ((uint64_t(1) << SORT_SHADER_BITS) - 1);
+    uint64_t materialID = item.material ? item.material->getSortID() : 0;
+    state = (state << SORT_MATERIAL_BITS) | (materialID & ((uint64_t(1) << SORT_MATERIAL_BITS) - 1));
+
+    const int stateBits = SORT_SHADER_BITS + SORT_MATERIAL_BITS;
+    uint64_t key = static_cast<uint64_t>(pass);
+
+    if(pass == TRANSPARENT_PASS) {
+        key = (key << SORT_DEPTH_BITS) | (maxDepth - depthBits);
+        key = (key << stateBits) | state;
+    }
+
+    else {
+        key = (key << stateBits) | state;
+        key = (key << SORT_DEPTH_BITS) | depthBits;
+    }
+
+    keys.push_back((key << SORT_INDEX_BITS) | items.size());
+    items.push_back(item);
+
+    return true;
+}
+
+// Destructor
+CommandBuffer::~CommandBuffer() {
+}
+
+// Constructor
+RenderQueue::RenderQueue() {
+    stateChanges = 0;
+    sortTime = 0.0;
+}
+
+void RenderQueue::append(const CommandBuffer& commands) {
+    const uint64_t indexMask = RENDER_QUEUE_MAX_DRAWS - 1;
+
+    for(uint64_t key : commands.keys) {
+        if(items.size() >= RENDER_QUEUE_MAX_DRAWS) {
+            droppedDraws++;
+            continue;
+        }
+
+        // Same key, pointing to where the draw ends up in the queue
+        items.push_back(commands.items[key & indexMask]);
+        keys.push_back((key & ~indexMask) | (items.size() - 1));
+    }
+
+    droppedDraws += commands.droppedDraws;
+}
+
+void RenderQueue::sort() {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    radixSort(keys, scratchKeys, SORT_INDEX_BITS);
+
+    sortTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+GLuint RenderQueue::submit(GLuint uniformModel, GLuint uniformLightInstance, GLsizei viewCount) {
+    Shader* currentShader = nullptr;
+    MaterialGroup* currentMaterial = nullptr;
+
+    // Uniforms belong to the program, so the light list is set again after every shader change
+    GLint currentLightInstance = 0;
+    bool isLightInstanceSet = false;
+
+    stateChanges = 0;
+
+    for(uint64_t key : keys) {
+        const RenderItem& item = items[key & (RENDER_QUEUE_MAX_DRAWS - 1)];
+
+        if(item.shader != currentShader) {
+            item.shader->useShader();
+            currentShader = item.shader;
+            isLightInstanceSet = false;
+            stateChanges++;
+        }
+
+        // Textures and blocks are bound to the context, not the program, so they survive a shader change
+        if(item.material && item.material != currentMaterial) {
+            item.material->bindGroup();
+            currentMaterial = item.material;
+            stateChanges++;
+        }
+
+        // Most draws go through the clusters, the meshes of a model share their list
+        if(!isLightInstanceSet || item.lightInstance != currentLightInstance) {
+            glUniform1i(uniformLightInstance, item.lightInstance);
+            currentLightInstance = item.lightInstance;
+            isLightInstanceSet = true;
+        }
+
+        glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(*item.transform));
+        item.mesh->renderMesh(viewCount);
+    }
+
+    return keys.size();
+}
+
+void RenderQueue::benchmarkSort(size_t drawCount, int iterations) {
+    drawCount = std::min(drawCount, RENDER_QUEUE_MAX_DRAWS);
+
+    // A few shaders and a few hundred materials spread over the view
+    Shader shaders[4];
+    std::vector<MaterialGroup> materials(256);
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+
+    std::vector<glm::mat4> transforms(drawCount);
+    std::vector<RenderItem> draws(drawCount);
+
+    for(size_t i = 0; i < drawCount; i++) {
+        transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(distribution(generator), distribution(generator), distribution(generator)));
+
+        draws[i].mesh = nullptr;
+        draws[i].shader = &shaders[generator() % 4];
+        draws[i].material = &materials[generator() % materials.size()];
+        draws[i].transform = &transforms[i];
+    }
+
+    RenderQueue queue;
+    std::vector<uint64_t> copiedKeys;
+    double pushTime = 0.0, radixTime = 0.0, stdSortTime = 0.0;
+
+    for(int i = 0; i < iterations; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        queue.begin(glm::mat4(1.0f), 200.0f);
+
+        for(const RenderItem& draw : draws) {
+            queue.push(draw);
+        }
+
+        auto pushed = std::chrono::high_resolution_clock::now();
+        copiedKeys = queue.keys;
+
+        queue.sort();
+        radixTime += queue.getSortTime();
+        pushTime += std::chrono::duration<double, std::milli>(pushed - start).count();
+
+        // Same keys with a comparison sort, ignoring the index like the radix sort
+        auto stdStart = std::chrono::high_resolution_clock::now();
+        std::stable_sort(copiedKeys.begin(), copiedKeys.end(), [](uint64_t a, uint64_t b) {
+            return (a >> SORT_INDEX_BITS) < (b >> SORT_INDEX_BITS);
+        });
+        stdSortTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stdStart).count();
+
+        if(copiedKeys != queue.keys) {
+            printf("Render queue sort doesn't match std::stable_sort!\n");
+            return;
+        }
+    }
+
+    // Same draws recorded on every thread into their own buffer, then appended in order like the city does
+    JobSystem jobSystem;
+    jobSystem.createWorkers();
+
+    std::vector<CommandBuffer> buffers(jobSystem.getThreadCount());
+    std::vector<uint64_t> sortedKeys = queue.keys;
+    double recordTime = 0.0;
+
+    auto record = [&](size_t partition) {
+        size_t begin, end;
+        JobSystem::getPartitionRange(drawCount, buffers.size(), partition, 1, begin, end);
+
+        buffers[partition].begin(glm::mat4(1.0f), 200.0f);
+
+        for(size_t i = begin; i < end; i++) {
+            buffers[partition].push(draws[i]);
+        }
+    };
+
+    for(int i = 0; i < iterations; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        queue.begin(glm::mat4(1.0f), 200.0f);
+        jobSystem.run(buffers.size(), record);
+
+        for(const CommandBuffer& buffer : buffers) {
+            queue.append(buffer);
+        }
+
+        recordTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        queue.sort();
+
+        if(queue.keys != sortedKeys) {
+            printf("Render queue recorded on several threads doesn't match a single thread!\n");
+            return;
+        }
+    }
+
+    printf("Render Queue - %zu draws, %i iterations\n", drawCount, iterations);
+    printf("%12s %10.3f ms\n", "Push", pushTime / iterations);
+    printf("%12s %10.3f ms (%zu threads)\n", "Record", recordTime / iterations, jobSystem.getThreadCount());
+    printf("%12s %10.3f ms\n", "Radix sort", radixTime / iterations);
+    printf("%12s %10.3f ms\n", "stable_sort", stdSortTime / iterations);
+}
+
+// Destructor
+RenderQueue::~RenderQueue() {
+}
@@ -3,7 +3,7 @@
 // Using initializer list since the type is primitive GLuint and we need the values initialized upon creation of the object
 Scene::Scene(Window& window, GLuint s)  :
                 uniformProjection(0), uniformModel(0), uniformView(0), uniformEyePosition(0),
-                uniformSpecularIntensity(0), uniformShininess(0), uniformMetalness(0),
+                uniformIsIndirect(0), uniformLightInstance(0),
                 uniformshadingModel(0),
                 uniformIsShaded(0), uniformIsWireframe(0), uniformObjectColor(0), uniformWireframeColor(0),
                 uniformMaterialPreview(0), uniformSpecularPreview(0), uniformNormalPreview(0),
@@ -23,9 +23,7 @@ Scene::Scene(Window& window, GLuint s)  :
     mainGUI.initialize(mainWindow.getWindow());
 
     // Generating random points - Pre-Loading for faster rendering
-    generateRandomPoints(randomPoints, gridSize, pointSize, numPoints, seed);
-    generateRandomScales(randomScales, randomPoints.size(), seed);
-    generateRandomHeights(randomHeights, randomPoints.size(), seed);
+    generateCity(gridSize, pointSize, numPoints, seed);
 }
 
 void Scene::createPlane(const float floorSize, const float floorUV) {
@@ -116,10 +114,11 @@ void Scene::createTextures() {
     // 2. No Interpolation and MIP Maps
     // 3. Interpolation and MIP Maps Near
     // 4. Intepolation and MIP Maps Interpolation
+    // Streamed - Only the headers are read here, the pixels come in over the next frames
     whiteTexture = Texture("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Textures/Default/white.jpg");
-    whiteTexture.loadTexture();
+    whiteTexture.loadTextureStreamed(&textureStreamer);
     brickTexture = Texture("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Textures/Default/brickHi.png");
-    brickTexture.loadTexture();
+    brickTexture.loadTextureStreamed(&textureStreamer);
 
     // Generated Noise Texture
     // Parameters - Width, Height, Channels = 3 (Use 3 channels - RGB)
@@ -139,19 +138,59 @@ void Scene::createMaterials() {
 void Scene::setupScene(const std::filesystem::path& currentSourceDir) {
     // Create Shaders
     createShaders(currentSourceDir);
+    stereoTarget.createTarget(currentSourceDir);
 
     // Creating Lights and default Skyboxes
     createLights();
 
+    // Workers decoding the textures, everything loaded from here on is streamed
+    textureStreamer.createStreamer();
+    mainGUI.setTextureStreamer(&textureStreamer);
+
     // Loading and creating Textures
     createTextures();
 
     // Creating Materials
     createMaterials();
 
+    // Shared buffers for the models, meshes which don't fit get their own buffers
+    geometryArena.createArena(MAX_ARENA_VERTICES, MAX_ARENA_INDICES);
+
+    // Threads for culling and recording the city, GL calls stay on this thread
+    jobSystem.createWorkers();
+
     // Loading and creating Objects/Models
     // The plane is necessary for PCG
     loadObjects();
+
+    // Transforms of the animated models, the cube gets a child node for the picked point
+    monkey->attachTransform(&transforms);
+    cube->attachTransform(&transforms);
+    cubeCursorNode = transforms.createNode(cube->getTransformNode());
+
+    // Material groups - Parameters are uploaded once, the cube keeps the extra rough parameters with its own textures
+    floorMaterial.createGroup({ &brickTexture }, roughMat);
+    cube->updateMaterialProperties(extraRoughMat.getSpecularIntensity(), extraRoughMat.getShininess(), extraRoughMat.getMetalness());
+
+    // Uniforms========================================================================================================
+    // Locations don't change for the lifetime of the program, so they are only queried once
+    getUniformsFromShader(shaderList[0]);
+
+    // Binding the texture to correct texture units
+    shaderList[0]->setTexture(uniformDiffuseTexture, 0);
+    shaderList[0]->setTexture(uniformSpecularTexture, 1);
+    shaderList[0]->setTexture(uniformNormalTexture, 2);
+    glUniform1i(uniformIsIndirect, false);
+    glUniform1i(uniformLightInstance, NO_LIGHT_INSTANCE);
+
+    // Frame level blocks, bound once to the binding points of BRDF_Normals
+    cameraBuffer.createBuffer(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+    lightsBuffer.createBuffer(sizeof(LightsBlock), LIGHTS_BLOCK_BINDING);
+    settingsBuffer.createBuffer(sizeof(SettingsBlock), SETTINGS_BLOCK_BINDING);
+
+    // Light buffers of the clusters and the instances, bound once as well
+    clusteredLights.createBuffers();
+    instanceLights.createBuffer();
 }
 
 void Scene::getUniformsFromShader(Shader * shader) {
@@ -161,12 +200,11 @@ void Scene::getUniformsFromShader(Shader * shader) {
     uniformModel = shader->getModelLocation();
     uniformProjection = shader->getProjectionLocation();
     uniformView = shader->getViewLocation();
+    uniformIsIndirect = shader->getIsIndirectLocation();
+    uniformLightInstance = shader->getLightInstanceLocation();
 
     // Specular Light
     uniformEyePosition = shader->getEyePositionLocation();
-    uniformSpecularIntensity = shader->getSpecularIntensityLocation();
-    uniformShininess = shader->getShininessLocation();
-    uniformMetalness = shader->getMetalnessLocation();
 
     // Getting Shading Mode
     uniformshadingModel = shader->getShadingModelLocation();
@@ -205,10 +243,16 @@ void Scene::getUniformsFromShader(Shader * shader) {
 }
 
 void Scene::setUniformsForShader(glm::mat4 projectionMatrix, glm::mat4 viewMatrix, Shader * shader) {
-    // Binding the texture to correct texture units
-    shader->setTexture(uniformDiffuseTexture, 0);
-    shader->setTexture(uniformSpecularTexture, 1);
-    shader->setTexture(uniformNormalTexture, 2);
+    setUniformsForShader(&projectionMatrix, &viewMatrix, 1, shader);
+}
+
+void Scene::setUniformsForShader(const glm::mat4* projectionMatrices, const glm::mat4* viewMatrices, int viewCount, Shader* shader) {
+    passViewCount = std::min(viewCount, MAX_VIEWS);
+    passView = viewMatrices[0];
+
+    for(int view = 0; view < passViewCount; view++) {
+        viewProjections[view] = projectionMatrices[view] * viewMatrices[view];
+    }
 
     // TODO : Intergrate this to work like a proper roughness map
     // uniformNoiseTexture = shader.getNoiseTextureLocation();
@@ -220,7 +264,20 @@ void Scene::setUniformsForShader(glm::mat4 projectionMatrix, glm::mat4 viewMatri
     // Getting torch control
     // spotLights[0].setFlash(lowerLight, camera.getCameraDirection());
 
-    // Lights
+    // Camera==========================================================================================================
+    // Changes for every eye in anaglyph mode
+    CameraBlock cameraBlock = {};
+    cameraBlock.viewCount = passViewCount;
+
+    for(int view = 0; view < passViewCount; view++) {
+        cameraBlock.projection[view] = projectionMatrices[view];
+        cameraBlock.view[view] = viewMatrices[view];
+        cameraBlock.eyePosition[view] = glm::vec4(camera.getCameraPosition(), 1.0f);
+    }
+
+    cameraBuffer.updateBuffer(&cameraBlock);
+
+    // Lights==========================================================================================================
     // Directional Light
     mainLight.setDirLight( mainGUI.getDirectionalLightColor()[0],
                            mainGUI.getDirectionalLightColor()[1],
@@ -231,71 +288,86 @@ void Scene::setUniformsForShader(glm::mat4 projectionMatrix, glm::mat4 viewMatri
                            mainGUI.getDirectionalLightDirection()[1],
                            mainGUI.getDirectionalLightDirection()[2] );
 
-    shader->setDirectionalLight(&mainLight);
+    LightsBlock lightsBlock = {};
+    mainLight.fillBlock(lightsBlock.directionalLight);
+
+    // Point and spot lights are sorted into the clusters of the views of the pass
+    clusteredLights.clearLights();
+    ClusterLightBlock clusterLight;
 
     // Currently disabling the Point and Spot lights based off a boolean
     // Point Lights
     if(mainGUI.getIsPointLights()) {
-        shader->setPointLight(pointLights, pointLightCount);
-    }
-
-    else {
-        shader->setPointLight(pointLights, 0);
+        for(unsigned int i = 0; i < pointLightCount; i++) {
+            pointLights[i].fillBlock(clusterLight);
+            clusteredLights.addLight(clusterLight);
+        }
     }
 
     // Spot Lights
     if(mainGUI.getIsSpotLights()) {
-        shader->setSpotLight(spotLights, spotLightCount);
+        for(unsigned int i = 0; i < spotLightCount; i++) {
+            spotLights[i].fillBlock(clusterLight);
+            clusteredLights.addLight(clusterLight);
+        }
     }
 
-    else {
-        shader->setSpotLight(spotLights, 0);
+    // Street Lights of the city
+    if(mainGUI.getIsStreetLights()) {
+        for(const ClusterLightBlock& streetLight : streetLights) {
+            clusteredLights.addLight(streetLight);
+        }
     }
 
-    // Binding to uniforms in the shader
-    glUniformMatrix4fv(uniformProjection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-    glUniformMatrix4fv(uniformView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    glUniform3f(uniformEyePosition, camera.getCameraPosition().x,
-                                    camera.getCameraPosition().y,
-                                    camera.getCameraPosition().z);
+    clusteredLights.assignLights(projectionMatrices, viewMatrices, passViewCount, mainGUI.getIsMultithreaded() ? &jobSystem : nullptr);
+    clusteredLights.uploadBuffers();
+    clusteredLights.fillBlock(lightsBlock);
+
+    lightsBuffer.updateBuffer(&lightsBlock);
+
+    // Settings========================================================================================================
+    // Setting the triggers from UI Elements, these only change when the UI is used
+    SettingsBlock settingsBlock = {};
 
     // Setting the shading model
-    glUniform1i(uniformshadingModel, shadingModel);
+    settingsBlock.shadingModel = shadingModel;
 
-    // Setting the triggers from UI Elements
     // Material Preview
-    glUniform1i(uniformMaterialPreview, mainGUI.getMaterialPreview());
-    glUniform1i(uniformSpecularPreview, mainGUI.getSpecularPreview());
-    glUniform1i(uniformNormalPreview, mainGUI.getNormalPreview());
+    settingsBlock.materialPreview = mainGUI.getMaterialPreview();
+    settingsBlock.specularPreview = mainGUI.getSpecularPreview();
+    settingsBlock.normalPreview = mainGUI.getNormalPreview();
 
     // Object Properties
-    glUniform1i(uniformIsWireframe, mainGUI.getIsWireframe());
-    glUniform1i(uniformIsShaded, mainGUI.getIsShaded());
-
-    glUniform4f(uniformObjectColor, mainGUI.getObjectColor().x,
-                                    mainGUI.getObjectColor().y,
-                                    mainGUI.getObjectColor().z,
-                                    mainGUI.getObjectColor().w );
+    settingsBlock.isWireframe = mainGUI.getIsWireframe();
+    settingsBlock.isShaded = mainGUI.getIsShaded();
+    settingsBlock.objectColor = glm::vec4( mainGUI.getObjectColor().x,
+                                           mainGUI.getObjectColor().y,
+                                           mainGUI.getObjectColor().z,
+                                           mainGUI.getObjectColor().w );
+    settingsBlock.wireframeColor = glm::vec4( mainGUI.getWireframeColor().x,
+                                              mainGUI.getWireframeColor().y,
+                                              mainGUI.getWireframeColor().z,
+                                              mainGUI.getWireframeColor().w );
+
+    settingsBlock.envMapping = mainGUI.getIsEnvMapping();
+    settingsBlock.skybox = mainGUI.getIsSkyBox();
+    settingsBlock.backgroundColor = glm::vec3( mainGUI.getBackgroundColor().x,
+                                               mainGUI.getBackgroundColor().y,
+                                               mainGUI.getBackgroundColor().z );
 
-    glUniform4f(uniformWireframeColor, mainGUI.getWireframeColor().x,
-                                       mainGUI.getWireframeColor().y,
-                                       mainGUI.getWireframeColor().z,
-                                       mainGUI.getWireframeColor().w );
+    // Material Properties
+    settingsBlock.reflection = mainGUI.getIsReflection();
+    settingsBlock.refraction = mainGUI.getIsRefraction();
+    settingsBlock.ior = mainGUI.getIOR();
+    settingsBlock.reflectance = mainGUI.getFresnelReflectance();
+    settingsBlock.dispersion = mainGUI.getDispersion();
+    settingsBlock.normalStrength = mainGUI.getNormalStrength();
+    settingsBlock.specularStrength = mainGUI.getSpecularStrength();
 
-    glUniform1i(uniformEnvMapping, mainGUI.getIsEnvMapping());
-    glUniform1i(uniformSkybox, mainGUI.getIsSkyBox());
-    glUniform3f(uniformBackgroundColor, mainGUI.getBackgroundColor().x,
-                                        mainGUI.getBackgroundColor().y,
-                                        mainGUI.getBackgroundColor().z);
+    // Lights
+    settingsBlock.isInstanceLights = mainGUI.getIsInstanceLights();
 
-    // Material Properties
-    glUniform1i(uniformIsReflection, mainGUI.getIsReflection());
-    glUniform1i(uniformIsRefraction, mainGUI.getIsRefraction());
-    glUniform1f(uniformIOR, mainGUI.getIOR());
-    glUniform1f(uniformFresnelReflectance, mainGUI.getFresnelReflectance());
-    glUniform1f(uniformDispersion, mainGUI.getDispersion());
-    glUniform1f(uniformNormalStrength, mainGUI.getNormalStrength());
-    glUniform1f(uniformSpecularStrength, mainGUI.getSpecularStrength());
+    settingsBuffer.updateBuffer(&settingsBlock);
 }
 
 // Scene Properties====================================================================================================
@@ -317,34 +389,157 @@ void Scene::renderPCGElements() {
     }
 
     // Floor
-    glm::mat4 floor = glm::mat4(1.0f);
+    floorTransform = glm::mat4(1.0f);
 
     // TRS
     // To rotate around origin
-    // floor = glm::rotate(floor, glm::radians(rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-
-    floor = glm::translate(floor, glm::vec3(mainGUI.getFloorOffset()[0],
-                                            mainGUI.getFloorOffset()[1],
-                                            mainGUI.getFloorOffset()[2]));
-    floor = glm::scale(floor, glm::vec3(mainGUI.getFloorScale()[0],
-                                        mainGUI.getFloorScale()[1],
-                                        mainGUI.getFloorScale()[2]));
+    // floorTransform = glm::rotate(floorTransform, glm::radians(rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
 
-    glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(floor));
-    brickTexture.useTexture();
-    roughMat.useMaterial(uniformSpecularIntensity, uniformShininess, uniformMetalness);
+    floorTransform = glm::translate(floorTransform, glm::vec3(mainGUI.getFloorOffset()[0],
+                                                              mainGUI.getFloorOffset()[1],
+                                                              mainGUI.getFloorOffset()[2]));
+    floorTransform = glm::scale(floorTransform, glm::vec3(mainGUI.getFloorScale()[0],
+                                                          mainGUI.getFloorScale()[1],
+                                                          mainGUI.getFloorScale()[2]));
 
     // Failsafe
-    if(meshList.size()) {
-        meshList[0]->renderMesh();
+    if(!meshList.size()) {
+        createPlane();
+    }
+
+    // Buildings=======================================================================================================
+    // The city is only uploaded again when it changes, every frame just picks the LODs
+    if(!isCityUploaded) {
+        geometryArena.uploadTransforms(cityTransforms);
+
+        cityLightBounds.resize(cityTransforms.size());
+        buildCityBounds(building0, building0Instances, building0Bounds);
+        buildCityBounds(building1, building1Instances, building1Bounds);
+
+        isCityUploaded = true;
+    }
+
+    // Light lists - The city goes first, so the list of a building floor is at the index of its transform
+    // which is what the indirect draws read from the InstanceIndices buffer
+    instanceLights.addInstances(cityLightBounds.data(), cityLightBounds.size());
+
+    // Bounds of the plane made by createPlane
+    AABB floorBounds = { glm::vec3(-5.0f, 0.0f, -5.0f), glm::vec3(5.0f, 0.0f, 5.0f) };
+    GLint floorLightInstance = instanceLights.addInstance(transformAABB(floorBounds, floorTransform));
+
+    assignInstanceLights();
+
+    renderQueue.push({ meshList[0], shaderList[0], &floorMaterial, &floorTransform, floorLightInstance });
+
+    // Occluders come from both building types, so the buffer is drawn once before either of them is culled
+    buildOcclusionBuffer();
+
+    renderCityInstances(building0, building0Instances, building0Bounds);
+    renderCityInstances(building1, building1Instances, building1Bounds);
+}
+
+void Scene::buildOcclusionBuffer() {
+    isOcclusionReady = false;
+
+    // Both eyes would need their own buffer, stereo passes only use frustum culling
+    if(!mainGUI.getIsOcclusionCulling() || passViewCount != 1) {
+        return;
+    }
+
+    Frustum frustum = extractFrustum(viewProjections[0]);
+    glm::vec3 eyePosition = camera.getCameraPosition();
+    const AABBList* boundsLists[2] = { &building0Bounds, &building1Bounds };
+
+    bool isMultithreaded = mainGUI.getIsMultithreaded();
+    size_t partitionCount = isMultithreaded ? jobSystem.getThreadCount() : 1;
+
+    if(cityPartitions.size() < partitionCount) {
+        cityPartitions.resize(partitionCount);
+    }
+
+    // Every worker looks for candidates in its own range of both lists
+    auto collectPartition = [&](size_t partition) {
+        std::vector<OccluderCandidate>& candidates = cityPartitions[partition].occluders;
+        candidates.clear();
+
+        for(unsigned int list = 0; list < 2; list++) {
+            size_t begin, end;
+            JobSystem::getPartitionRange(boundsLists[list]->count, partitionCount, partition, 1, begin, end);
+
+            collectOccluders(*boundsLists[list], list, begin, end - begin, frustum, eyePosition, candidates);
+        }
+    };
+
+    jobSystem.run(partitionCount, collectPartition);
+
+    // Merged in order, so the same occluders are picked whatever the scheduling
+    occluderCandidates.clear();
+
+    for(size_t partition = 0; partition < partitionCount; partition++) {
+        const std::vector<OccluderCandidate>& candidates = cityPartitions[partition].occluders;
+        occluderCandidates.insert(occluderCandidates.end(), candidates.begin(), candidates.end());
+    }
+
+    selectOccluders(occluderCandidates);
+
+    occlusionBuffer.begin(viewProjections[0]);
+
+    for(const OccluderCandidate& candidate : occluderCandidates) {
+        occlusionBuffer.addOccluder(boundsLists[candidate.list]->getBox(candidate.index));
+    }
+
+    // The strips don't share any pixels, each one can go to a different worker
+    if(isMultithreaded) {
+        auto rasterizeStrip = [&](size_t strip) {
+            occlusionBuffer.rasterizeStrip(static_cast<int>(strip));
+        };
+
+        jobSystem.run(OcclusionBuffer::getStripCount(), rasterizeStrip);
     }
 
     else {
-        createPlane();
-        meshList[0]->renderMesh();
+        occlusionBuffer.rasterize();
     }
 
-    // Buildings=======================================================================================================
+    occlusionBuffer.buildPyramid();
+
+    isOcclusionReady = true;
+}
+
+void Scene::buildCityBounds(Model* model, const std::vector<CityInstance>& instances, AABBList& instanceBounds) {
+    instanceBounds.clear();
+
+    for (const CityInstance& instance : instances) {
+        AABB box = transformAABB(model->getBounds(), cityTransforms[instance.transform]);
+
+        instanceBounds.addBox(box);
+        cityLightBounds[instance.transform] = box;
+    }
+}
+
+void Scene::generateCity(int gridSize, int pointSize, int numPoints, int pointSeed) {
+    generateRandomPoints(randomPoints, gridSize, pointSize, numPoints, pointSeed);
+    generateRandomScales(randomScales, randomPoints.size(), seed);
+    generateRandomHeights(randomHeights, randomPoints.size(), seed);
+
+    buildCity();
+}
+
+void Scene::buildCity() {
+    cityTransforms.clear();
+    building0Instances.clear();
+    building1Instances.clear();
+    streetLights.clear();
+
+    // Warm and short ranged, so a cluster only sees the lamps of a few buildings
+    PointLight streetLight( 1.0f, 0.7f, 0.35f,
+                            0.0f, 0.8f,
+                            0.0f, 0.0f, 0.0f,
+                            1.0f, 0.5f, 16.0f );
+
+    ClusterLightBlock streetLightBlock;
+    streetLight.fillBlock(streetLightBlock);
+
     // Randomly placing the buildings
     for (size_t i=0; i < randomPoints.size(); i++) {
         const auto& point = randomPoints[i];
@@ -374,25 +569,250 @@ void Scene::renderPCGElements() {
             buil = glm::translate(buil, glm::vec3(point.first, j * (heightOffset * scale.y), -point.second));
             buil = glm::scale(buil, scale);
 
-            glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(buil));
-            roughMat.useMaterial(uniformSpecularIntensity, uniformShininess, uniformMetalness);
-
-            // Randomly pick a model
-            // int modelIndex = modelDistribution(gen);
+            CityInstance instance = { GLuint(cityTransforms.size()), glm::vec3(buil[3]), glm::max(scale.x, glm::max(scale.y, scale.z)) };
+            cityTransforms.push_back(buil);
 
             // Determine which model to render based on some criteria (e.g., point coordinates)
             if (point.first % 3 == 0) {
-                building0->renderModel();
+                building0Instances.push_back(instance);
             }
 
-            else if (point.first % 3 == 1) {
-                building1->renderModel();
+            else {
+                building1Instances.push_back(instance);
             }
 
-            else {
+            // Lamp on the street corner of the ground floor
+            if (j == 0) {
+                streetLightBlock.position = glm::vec3(point.first - 0.5f, 1.0f, -point.second + 0.5f);
+                streetLights.push_back(streetLightBlock);
+            }
+        }
+    }
+
+    // Buildings moved, the previous LODs don't mean anything anymore
+    buildingLODs.assign(cityTransforms.size(), 0);
+
+    isCityUploaded = false;
+}
+
+void Scene::assignInstanceLights() {
+    if(!mainGUI.getIsInstanceLights()) {
+        return;
+    }
+
+    // Same lights as the clusters of the pass, the lists index into the ClusterLights buffer
+    instanceLights.assignLights(clusteredLights.getLights(), mainGUI.getIsMultithreaded() ? &jobSystem : nullptr);
+    instanceLights.uploadBuffer();
+}
+
+void Scene::renderCityInstances(Model* model, const std::vector<CityInstance>& instances, const AABBList& instanceBounds) {
+    if(instances.empty()) {
+        return;
+    }
+
+    // Everything the workers need is read here, they don't touch the GUI or the camera
+    bool isCulling = mainGUI.getIsFrustumCulling();
+    bool isOcclusion = isOcclusionReady;
+    bool isLOD = mainGUI.getIsLOD();
+    GLfloat nearClipping = mainGUI.getCameraNearClipping();
+    GLfloat farClipping = mainGUI.getCameraFarClipping();
+    GLfloat pixelError = mainGUI.getLODPixelError();
+    Shader* shader = shaderList[0];
+
+    // Frustums of the current pass (Both eyes in single pass stereo), in world space like the bounds
+    Frustum frustums[MAX_VIEWS];
+    size_t frustumCount = passViewCount;
+
+    for(size_t view = 0; view < frustumCount; view++) {
+        frustums[view] = extractFrustum(viewProjections[view]);
+    }
+
+    // Projecting the LOD errors onto the screen
+    glm::vec3 eyePosition = camera.getCameraPosition();
+    GLfloat projectionScale = camera.calculateProjectionScale(mainWindow.getBufferHeight());
+
+    // Models that don't fit in the arena (Or instancing is off) are drawn one instance at a time at full detail
+    bool isIndirect = isInstancing && model->isInArena();
+
+    // One contiguous range of instances per thread, small cities stay on this thread
+    size_t partitionCount = mainGUI.getIsMultithreaded() ? jobSystem.getThreadCount() : 1;
+    partitionCount = std::max<size_t>(1, std::min(partitionCount, instances.size() / CITY_PARTITION_MIN_INSTANCES));
+
+    if(cityPartitions.size() < partitionCount) {
+        cityPartitions.resize(partitionCount);
+    }
+
+    instanceVisible.resize(instanceBounds.getPaddedCount());
+
+    // Runs on the workers - No GL calls, and the only shared data written is the visibility and LOD of the own instances
+    auto recordPartition = [&](size_t partition) {
+        AllocationScope allocationScope("Scene::recordPartition");
+
+        CityPartition& work = cityPartitions[partition];
+
+        size_t begin, end;
+        JobSystem::getPartitionRange(instances.size(), partitionCount, partition, CULLING_BATCH_SIZE, begin, end);
+
+        work.stats = CullingStats();
+        work.lodInstances.resize(model->getLODCount());
+        work.commands.begin(passView, farClipping);
+
+        for(std::vector<GLuint>& lodInstances : work.lodInstances) {
+            lodInstances.clear();
+        }
+
+        if(isCulling) {
+            cullAABBs(frustums, frustumCount, instanceBounds, begin, end - begin, instanceVisible, work.stats);
+        }
+
+        else if(isOcclusion) {
+            std::fill(instanceVisible.begin() + begin, instanceVisible.begin() + end, 1);
+        }
+
+        // Only the instances left in the frustum are tested against the occluders
+        if(isOcclusion) {
+            occlusionBuffer.cullAABBs(instanceBounds, begin, end - begin, instanceVisible, work.stats);
+        }
+
+        for(size_t i = begin; i < end; i++) {
+            const CityInstance& instance = instances[i];
+
+            if((isCulling || isOcclusion) && !instanceVisible[i]) {
                 continue;
             }
+
+            GLuint lod = 0;
+
+            if(isLOD) {
+                // Distance to the closest point of the bounding sphere
+                float distance = glm::length(instance.position - eyePosition) - model->getBoundingRadius() * instance.scale;
+                distance = glm::max(distance, nearClipping);
+
+                lod = model->selectLOD(distance, instance.scale, projectionScale, pixelError, buildingLODs[instance.transform]);
+            }
+
+            buildingLODs[instance.transform] = lod;
+
+            if(isIndirect) {
+                work.lodInstances[lod].push_back(instance.transform);
+            }
+
+            else {
+                model->queueModel(work.commands, shader, &cityTransforms[instance.transform], static_cast<GLint>(instance.transform));
+            }
         }
+    };
+
+    jobSystem.run(partitionCount, recordPartition);
+
+    // Back on the GL thread, merging the partitions in order so the result doesn't depend on the scheduling
+    ArenaAllocator<GLuint> frameAllocator(frameArena);
+    ArenaVector<ArenaVector<GLuint>> lodInstances(model->getLODCount(), ArenaVector<GLuint>(frameAllocator), frameAllocator);
+
+    for(size_t partition = 0; partition < partitionCount; partition++) {
+        const CityPartition& work = cityPartitions[partition];
+
+        cullingStats.tested += work.stats.tested;
+        cullingStats.culled += work.stats.culled;
+        cullingStats.occluded += work.stats.occluded;
+
+        for(size_t lod = 0; lod < work.lodInstances.size(); lod++) {
+            lodInstances[lod].insert(lodInstances[lod].end(), work.lodInstances[lod].begin(), work.lodInstances[lod].end());
+        }
+
+        renderQueue.append(work.commands);
+    }
+
+    if(isIndirect) {
+        renderModelIndirect(model, lodInstances);
+    }
+}
+
+void Scene::renderModelIndirect(Model* model, const ArenaVector<ArenaVector<GLuint>>& instances) {
+    drawInstances.clear();
+
+    // The instances of each LOD follow each other in the index buffer
+    for(const ArenaVector<GLuint>& lodInstances : instances) {
+        drawInstances.insert(drawInstances.end(), lodInstances.begin(), lodInstances.end());
+    }
+
+    if(drawInstances.empty()) {
+        return;
+    }
+
+    glUniform1i(uniformIsIndirect, true);
+
+    // Every instance is drawn once per view, the shader divides gl_InstanceID back down
+    GLuint viewCount = static_cast<GLuint>(passViewCount);
+
+    // Commands of every material one after another - baseInstance points to the first instance of the LOD
+    drawCommands.clear();
+    drawMaterialStarts.clear();
+
+    for(GLuint material = 0; material < model->getMaterialCount(); material++) {
+        drawMaterialStarts.push_back(static_cast<GLuint>(drawCommands.size()));
+        GLuint baseInstance = 0;
+
+        for(GLuint lod = 0; lod < instances.size(); lod++) {
+            if(!instances[lod].empty()) {
+                model->appendDrawCommands(drawCommands, baseInstance, instances[lod].size() * viewCount, lod, material);
+                baseInstance += instances[lod].size();
+            }
+        }
+    }
+
+    drawMaterialStarts.push_back(static_cast<GLuint>(drawCommands.size()));
+
+    // Both uploads once for the whole model, then one multi draw per material from its offset
+    geometryArena.uploadInstances(drawInstances);
+    geometryArena.uploadCommands(drawCommands);
+
+    for(GLuint material = 0; material < model->getMaterialCount(); material++) {
+        GLuint commandCount = drawMaterialStarts[material + 1] - drawMaterialStarts[material];
+
+        if(!commandCount) {
+            continue;
+        }
+
+        model->bindMaterial(material);
+        geometryArena.multiDrawIndirect(drawMaterialStarts[material], commandCount);
+
+        drawCalls++;
+    }
+
+    glUniform1i(uniformIsIndirect, false);
+}
+
+void Scene::updateCityBenchmark(double frameTime) {
+    // Skipping the first frames of every configuration, the city was just uploaded
+    if(++cityBenchmarkFrame > CITY_BENCHMARK_WARMUP) {
+        cityBenchmarkTime += frameTime;
+    }
+
+    if(cityBenchmarkFrame < CITY_BENCHMARK_WARMUP + CITY_BENCHMARK_FRAMES) {
+        return;
+    }
+
+    // Every grid size is measured with and without instancing
+    int gridSize = CITY_BENCHMARK_GRIDS[cityBenchmarkStep / 2];
+
+    printf("%9i %10zu %12s %10u %12.3f\n", gridSize, cityTransforms.size(), isInstancing ? "Instanced" : "Per Floor",
+           drawCalls, cityBenchmarkTime / CITY_BENCHMARK_FRAMES);
+
+    cityBenchmarkStep++;
+    cityBenchmarkFrame = 0;
+    cityBenchmarkTime = 0.0;
+
+    // Done, going back to the city from the UI
+    if(cityBenchmarkStep == 2 * CITY_BENCHMARK_GRID_COUNT) {
+        cityBenchmarkStep = -1;
+        generateCity(mainGUI.getGridSize(), mainGUI.getPointSize(), mainGUI.getNumPoints(), mainGUI.getSeed());
+
+        return;
+    }
+
+    if(cityBenchmarkStep % 2 == 0) {
+        generateCity(CITY_BENCHMARK_GRIDS[cityBenchmarkStep / 2], mainGUI.getPointSize(), mainGUI.getNumPoints(), mainGUI.getSeed());
     }
 }
 
@@ -405,8 +825,10 @@ void Scene::generalElements(glm::mat4& projectionMatrix, glm::mat4& viewMatrix)
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Checking for Skybox parameter in UI
-    if(mainGUI.getIsSkyBox() && mainGUI.getDrawSkyBox()) {
+    // Checking for Skybox parameter in UI, single pass stereo draws it for each eye itself
+    bool isSinglePassStereo = mainGUI.getIsAnaglyph() && mainGUI.getIsSinglePassStereo();
+
+    if(mainGUI.getIsSkyBox() && mainGUI.getDrawSkyBox() && !isSinglePassStereo) {
         // Drawing the Skybox before everything else
         // Checking Skybox index
         mainSkybox->getDefaultSkyboxes()[mainGUI.getSkyboxIndex() - 1]->drawSkybox(viewMatrix, projectionMatrix);
@@ -561,11 +983,11 @@ void Scene::generalElements(glm::mat4& projectionMatrix, glm::mat4& viewMatrix)
 
     // Switching modes - Wireframe/Normal
     if(mainGUI.getIsWireframe()) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        glState.setPolygonMode(GL_LINE);
     }
 
     else {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glState.setPolygonMode(GL_FILL);
     }
 
     // Updating the Procedural Content on button press
@@ -577,87 +999,115 @@ void Scene::generalElements(glm::mat4& projectionMatrix, glm::mat4& viewMatrix)
         //                                                     mainGUI.getNumPoints(),
         //                                                     mainGUI.getSeed() );
 
-        generateRandomPoints(randomPoints,
-                             mainGUI.getGridSize(),
-                             mainGUI.getPointSize(),
-                             mainGUI.getNumPoints(),
-                             mainGUI.getSeed() );
-
-        generateRandomScales(randomScales, randomPoints.size(), seed);
-        generateRandomHeights(randomHeights, randomPoints.size(), seed);
+        generateCity(mainGUI.getGridSize(), mainGUI.getPointSize(), mainGUI.getNumPoints(), mainGUI.getSeed());
 
         // To prevent multiple clicking
         mainGUI.setUpdate(false);
     }
 }
 
-// Calculate Toed-in or Asymmetric Frustum Anaglyph
-void Scene::calculateAnaglyph(glm::mat4 & projectionMatrix, glm::mat4 & viewMatrix) {
+// Calculate Toed-in or Asymmetric Frustum eyes
+void Scene::calculateEyeMatrices(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix,
+                                 glm::mat4* projectionMatrices, glm::mat4* viewMatrices) {
     /* Toed-In Method of Anaglyphical rendering
     In this method, we change the view matrix to point towards a custom target and offset the
     Render passes based off of the Inter Ocular Distance (IOD) and Convergence Distance (CD)
     * Only works for perspective renders
     */
-    //Red pass - Left Eye
-    glColorMask(GL_TRUE, GL_FALSE, GL_FALSE, GL_TRUE);
-    glClear(GL_DEPTH_BUFFER_BIT);
-
     // Checking for channel flip
     bool leftEye = mainGUI.getIsAnaglyphChannelsFlippedToed() ? false : true;
     bool rightEye = mainGUI.getIsAnaglyphChannelsFlippedFrustum() ? false : true;
 
-    if(mainGUI.getIsToedInRendering()) {
-        // Modifying the view matrix for left eye here
-        viewMatrix = camera.calculateViewMatrix(leftEye,
-                                                mainGUI.getInterOcularDistance(),
-                                                mainGUI.getCovergenceDistance());
-    }
+    // Red - Left Eye, Cyan - Right Eye
+    for(int eye = 0; eye < MAX_VIEWS; eye++) {
+        projectionMatrices[eye] = projectionMatrix;
+        viewMatrices[eye] = viewMatrix;
 
-    else if(mainGUI.getIsAsymmetricFrustumRendering()) {
-        // Modifying the projection matrix for left eye here
-        projectionMatrix = camera.calculateAsymmetricFrustum(rightEye,
-                                                             mainGUI.getInterOcularDistance(),
-                                                             mainGUI.getCovergenceDistance(),
-                                                             mainWindow.getBufferWidth(),
-                                                             mainWindow.getBufferHeight());
+        if(mainGUI.getIsToedInRendering()) {
+            // Modifying the view matrix for the eye here
+            viewMatrices[eye] = camera.calculateViewMatrix(eye == 0 ? leftEye : !leftEye,
+                                                           mainGUI.getInterOcularDistance(),
+                                                           mainGUI.getCovergenceDistance());
+        }
+
+        else if(mainGUI.getIsAsymmetricFrustumRendering()) {
+            // Modifying the projection matrix for the eye here
+            projectionMatrices[eye] = camera.calculateAsymmetricFrustum(eye == 0 ? rightEye : !rightEye,
+                                                                        mainGUI.getInterOcularDistance(),
+                                                                        mainGUI.getCovergenceDistance(),
+                                                                        mainWindow.getBufferWidth(),
+                                                                        mainWindow.getBufferHeight());
+        }
     }
+}
+
+// Calculate Toed-in or Asymmetric Frustum Anaglyph
+void Scene::calculateAnaglyph(glm::mat4 & projectionMatrix, glm::mat4 & viewMatrix) {
+    glm::mat4 projectionMatrices[MAX_VIEWS];
+    glm::mat4 viewMatrices[MAX_VIEWS];
+
+    calculateEyeMatrices(projectionMatrix, viewMatrix, projectionMatrices, viewMatrices);
+
+    //Red pass - Left Eye
+    glState.setColorMask(GL_TRUE, GL_FALSE, GL_FALSE, GL_TRUE);
+    glClear(GL_DEPTH_BUFFER_BIT);
 
     // Setting Uniforms for a shader
-    getUniformsFromShader(shaderList[0]);
-    setUniformsForShader(projectionMatrix, viewMatrix, shaderList[0]);
+    shaderList[0]->useShader();
+    setUniformsForShader(projectionMatrices[0], viewMatrices[0], shaderList[0]);
 
     // Rendering the scene
     renderScene();
 
     // Cyan pass - Right Eye
-    glColorMask(GL_FALSE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glState.setColorMask(GL_FALSE, GL_TRUE, GL_TRUE, GL_TRUE);
     glClear(GL_DEPTH_BUFFER_BIT);
 
-    if(mainGUI.getIsToedInRendering()) {
-        // Modifying the view matrix for right eye here
-        viewMatrix = camera.calculateViewMatrix(!leftEye,
-                                                mainGUI.getInterOcularDistance(),
-                                                mainGUI.getCovergenceDistance());
-    }
+    // Setting Uniforms for a shader
+    shaderList[0]->useShader();
+    setUniformsForShader(projectionMatrices[1], viewMatrices[1], shaderList[0]);
+
+    // Rendering the scene
+    renderScene();
 
-    else if(mainGUI.getIsAsymmetricFrustumRendering()) {
-        // Modifying the projection matrix for right eye here
-        projectionMatrix = camera.calculateAsymmetricFrustum(!rightEye,
-                                                             mainGUI.getInterOcularDistance(),
-                                                             mainGUI.getCovergenceDistance(),
-                                                             mainWindow.getBufferWidth(),
-                                                             mainWindow.getBufferHeight());
+    // Resetting the color pass to render all colors
+    glState.setColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+// Single pass Anaglyph - The scene is only traversed once, every draw is instanced for both eyes
+void Scene::calculateStereo(glm::mat4& projectionMatrix, glm::mat4& viewMatrix) {
+    glm::mat4 projectionMatrices[MAX_VIEWS];
+    glm::mat4 viewMatrices[MAX_VIEWS];
+
+    calculateEyeMatrices(projectionMatrix, viewMatrix, projectionMatrices, viewMatrices);
+
+    // Cleared with the background color of the general elements
+    stereoTarget.bindTarget(mainWindow.getBufferWidth(), mainWindow.getBufferHeight());
+
+    // The skybox shader only knows a single view, so it is drawn into each half
+    if(mainGUI.getIsSkyBox() && mainGUI.getDrawSkyBox()) {
+        for(int eye = 0; eye < MAX_VIEWS; eye++) {
+            stereoTarget.setEyeViewport(eye);
+            mainSkybox->getDefaultSkyboxes()[mainGUI.getSkyboxIndex() - 1]->drawSkybox(viewMatrices[eye], projectionMatrices[eye]);
+        }
+
+        stereoTarget.setTargetViewport();
     }
 
+    // Cuts each eye at the edge of its half - See BRDF_Normals.vert
+    glEnable(GL_CLIP_DISTANCE0);
+
     // Setting Uniforms for a shader
-    getUniformsFromShader(shaderList[0]);
-    setUniformsForShader(projectionMatrix, viewMatrix, shaderList[0]);
+    shaderList[0]->useShader();
+    setUniformsForShader(projectionMatrices, viewMatrices, MAX_VIEWS, shaderList[0]);
 
     // Rendering the scene
     renderScene();
 
-    // Resetting the color pass to render all colors
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_CLIP_DISTANCE0);
+
+    // Red from the left half, Cyan from the right half
+    stereoTarget.composite();
 }
 
 
@@ -666,19 +1116,25 @@ void Scene::loadObjects() {
     // Loading Models==================================================================================================
     // Default PCG Models
     building0 = new Model();
-    building0->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/buildings.obj");
+    building0->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/buildings.obj", &geometryArena, &textureStreamer);
 
     building1 = new Model();
-    building1->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/buildings_2.obj");
+    building1->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/buildings_2.obj", &geometryArena, &textureStreamer);
 
     cube = new Model();
-    cube->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/cube.obj");
+    cube->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/cube.obj", &geometryArena, &textureStreamer);
 
     monkey = new Model();
-    monkey->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/monkey.obj");
+    monkey->loadModel("D:/Programs/C++/Rendering/OpenGL/src/Rendering/Models/monkey.obj", &geometryArena, &textureStreamer);
 }
 
 void Scene::renderScene() {
+    // Batched draws (Indirect city, clusters) go straight to GL, everything else is sorted and submitted at the end
+    renderQueue.begin(passView, mainGUI.getCameraFarClipping());
+
+    // Objects of this pass get their light lists once they are placed
+    instanceLights.clearInstances();
+
     // If we want to render PCG Elements
     if(mainGUI.getIsPCG()) {
         renderPCGElements();
@@ -693,31 +1149,64 @@ void Scene::renderScene() {
             rotationAngle = 0.0f;
         }
 
-        glm::mat4 base = glm::mat4(1.0f);
-            // TRS
-            base = glm::translate(base, glm::vec3(0.0f, 2.0f, 0.0f));
-            base = glm::rotate(base, glm::radians(rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-            base = glm::scale(base, glm::vec3(1.5f));
-            glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(base));
+        // TRS
+        transforms.setLocalTransform(monkey->getTransformNode(),
+                                     glm::vec3(0.0f, 2.0f, 0.0f),
+                                     glm::angleAxis(glm::radians(rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f)),
+                                     glm::vec3(1.5f));
+
+        // The cube follows the picked point, offset in the space of the cube's own transform
+        transforms.setPosition(cubeCursorNode, camera.getRayHitCoords(mainWindow.getXPos(),
+                                                                      mainWindow.getYPos(),
+                                                                      mainWindow.getBufferWidth(),
+                                                                      mainWindow.getBufferHeight()));
+
+        // Only the nodes set above (And their children) are computed again
+        transforms.update(&jobSystem);
+
+        const glm::mat4& base = *monkey->getWorldTransform();
+
+        // Light lists of both models, from their bounds where they are this frame
+        GLint monkeyLightInstance = instanceLights.addInstance(transformAABB(monkey->getBounds(), base));
+        GLint cubeLightInstance = instanceLights.addInstance(transformAABB(cube->getBounds(), transforms.getWorldMatrix(cubeCursorNode)));
+
+        assignInstanceLights();
 
         monkey->updateMaterialProperties(mainGUI.getSpecular(), mainGUI.getShininess(), mainGUI.getMetalness());
-        monkey->setMaterialUniforms(uniformSpecularIntensity, uniformShininess, uniformMetalness);
-        monkey->renderModel();
+
+        // Clusters and meshes are culled for a single eye, stereo passes draw the whole model
+        bool isSingleView = passViewCount == 1;
+
+        if(mainGUI.getIsClusterCulling() && isSingleView) {
+            // Culling in object space, so the frustum and the eye are moved into the model's space
+            ClusterStats stats;
+            glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(base));
+            glUniform1i(uniformLightInstance, monkeyLightInstance);
+            glm::vec3 eyePosition = glm::vec3(glm::inverse(base) * glm::vec4(camera.getCameraPosition(), 1.0f));
+
+            monkey->renderModelClusters(extractFrustum(viewProjections[0] * base), eyePosition, mainGUI.getIsClusterConeCulling(), stats);
+
+            mainGUI.setClusterStats(stats.clusters, stats.frustumCulledClusters + stats.backfaceCulledClusters,
+                                    stats.triangles, stats.frustumCulledTriangles + stats.backfaceCulledTriangles);
+        }
+
+        else if(mainGUI.getIsFrustumCulling() && isSingleView) {
+            monkey->queueModelCulled(renderQueue, shaderList[0], monkey->getWorldTransform(), extractFrustum(viewProjections[0] * base), cullingStats,
+                                     monkeyLightInstance);
+        }
+
+        else {
+            monkey->queueModel(renderQueue, shaderList[0], nullptr, monkeyLightInstance);
+        }
 
         // Debugging
         // ImGui::Text("%i, %i", mainWindow.getBufferWidth(), mainWindow.getBufferHeight());
 
-        cube->setInitialTransformMatrix();
-            // TRS
-            cube->updateTranslation( camera.getRayHitCoords(mainWindow.getXPos(),
-                                                            mainWindow.getYPos(),
-                                                            mainWindow.getBufferWidth(),
-                                                            mainWindow.getBufferHeight()) );
-        cube->updateTransform();
-
-        extraRoughMat.useMaterial(uniformSpecularIntensity, uniformShininess, uniformMetalness);
-        cube->renderModel(uniformModel);
+        cube->queueModel(renderQueue, shaderList[0], &transforms.getWorldMatrix(cubeCursorNode), cubeLightInstance);
     }
+
+    renderQueue.sort();
+    drawCalls += renderQueue.submit(uniformModel, uniformLightInstance, passViewCount);
 }
 
 // Render Pass - Renders all data in the scene=========================================================================
@@ -735,13 +1224,17 @@ void Scene::renderPass(glm::mat4 projectionMatrix, glm::mat4 viewMatrix) {
     generalElements(projectionMatrix, viewMatrix);
 
     // Anaglyph Rendering
-    if(mainGUI.getIsAnaglyph()) {
+    if(mainGUI.getIsAnaglyph() && mainGUI.getIsSinglePassStereo()) {
+        calculateStereo(projectionMatrix, viewMatrix);
+    }
+
+    else if(mainGUI.getIsAnaglyph()) {
         calculateAnaglyph(projectionMatrix, viewMatrix);
     }
 
     else {
         // Setting Uniforms for a shader
-        getUniformsFromShader(shaderList[0]);
+        shaderList[0]->useShader();
         setUniformsForShader(projectionMatrix, viewMatrix, shaderList[0]);
 
         // Rendering the scene
@@ -754,11 +1247,76 @@ void Scene::renderPass(glm::mat4 projectionMatrix, glm::mat4 viewMatrix) {
 }
 
 void Scene::update(float time) {
+    AllocationScope allocationScope("Scene::update");
+
+    size_t allocationCount = getAllocationCount();
+    size_t allocationBytes = getAllocationBytes();
+    size_t glCallCount = getGLCallCount();
+    size_t stateChangesIssued = glState.getIssuedCalls();
+    size_t stateChangesElided = glState.getElidedCalls();
+    size_t uniformUploads = cameraBuffer.getUploadCount() + lightsBuffer.getUploadCount() + settingsBuffer.getUploadCount();
+
     deltaTime = time;
 
+    // Everything from the last frame is gone
+    frameArena.reset();
+    drawCalls = 0;
+    cullingStats = CullingStats();
+
+    // Starting the city benchmark on button press, it runs over the next frames
+    if(mainGUI.getIsCityBenchmark()) {
+        mainGUI.setCityBenchmark(false);
+
+        printf("City Benchmark - %i frames per configuration\n", CITY_BENCHMARK_FRAMES);
+        printf("%9s %10s %12s %10s %12s\n", "Grid Size", "Instances", "Mode", "Draw Calls", "CPU ms/frame");
+
+        cityBenchmarkStep = 0;
+        cityBenchmarkFrame = 0;
+        cityBenchmarkTime = 0.0;
+        generateCity(CITY_BENCHMARK_GRIDS[0], mainGUI.getPointSize(), mainGUI.getNumPoints(), mainGUI.getSeed());
+    }
+
+    // Odd steps of the benchmark draw every floor on its own
+    isInstancing = cityBenchmarkStep >= 0 ? cityBenchmarkStep % 2 == 0 : mainGUI.getIsInstancing();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Tails of the textures decoded since the last frame, then finer levels up to the budget
+    textureStreamer.setUploadBudget(mainGUI.getTextureUploadBudget());
+    textureStreamer.update();
+
     // Handles the rendering of each elements - UI, GLFW, Objects, etc.
     renderPass(projection, camera.calculateViewMatrix());
 
+    double frameTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    if(cityBenchmarkStep >= 0) {
+        updateCityBenchmark(frameTime);
+    }
+
+    mainGUI.setFrameStats(drawCalls, frameTime);
+    mainGUI.setCullingStats(cullingStats.tested, cullingStats.culled);
+    mainGUI.setOcclusionStats(cullingStats.occluded, isOcclusionReady ? static_cast<unsigned int>(occlusionBuffer.getOccluderCount()) : 0);
+    mainGUI.setLightClusterStats(static_cast<unsigned int>(clusteredLights.getLightCount()), clusteredLights.getMaxClusterLights(),
+                                 clusteredLights.getAverageClusterLights(), clusteredLights.getAssignTime());
+
+    if(mainGUI.getIsInstanceLights()) {
+        mainGUI.setInstanceLightStats(static_cast<unsigned int>(instanceLights.getInstanceCount()), instanceLights.getMaxInstanceLights(),
+                                      instanceLights.getAverageInstanceLights(), instanceLights.getAssignTime());
+    }
+
+    else {
+        mainGUI.setInstanceLightStats(0, 0, 0.0f, 0.0);
+    }
+    mainGUI.setGLStats(getGLCallCount() - glCallCount,
+                       cameraBuffer.getUploadCount() + lightsBuffer.getUploadCount() + settingsBuffer.getUploadCount() - uniformUploads);
+    mainGUI.setStateCacheStats(glState.getIssuedCalls() - stateChangesIssued, glState.getElidedCalls() - stateChangesElided);
+    mainGUI.setRenderQueueStats(renderQueue.getDrawCount(), renderQueue.getStateChanges(), renderQueue.getSortTime());
+
+    // Shown in the UI on the next frame
+    mainGUI.setAllocationStats(getAllocationCount() - allocationCount, getAllocationBytes() - allocationBytes,
+                               frameArena.getUsed(), frameArena.getCapacity());
+
 }
 
 Scene::~Scene() {
@@ -5,6 +5,8 @@ in vec2 texCoord;
 in vec3 Normal;
 in mat3 TBNMatrix;
 in vec3 fragPos;
+flat in int viewIndex;
+flat in int lightList;
 
 out vec4 color;
 
@@ -14,8 +16,7 @@ vec3 viewDir;
 float specularMapFactor;
 
 // Should be same as Utilities.h header file
-const int MAX_POINT_LIGHTS = 3;
-const int MAX_SPOT_LIGHTS = 3;
+const int MAX_VIEWS = 2;
 
 struct Light {
     vec3 colour;
@@ -42,34 +43,96 @@ struct SpotLight {
     float edge;
 };
 
-struct Material {
-    float specularIntensity;
-    float shininess;
-    float metalness;
+// Frame level data lives in std140 uniform blocks, only uploaded when something changes - See UniformBuffer.h
+// Camera - Shared with the vertex shader
+layout (std140, binding = 0) uniform Camera {
+    mat4 projection[MAX_VIEWS];
+    mat4 view[MAX_VIEWS];
+    vec4 eyePosition[MAX_VIEWS];
+    int viewCount;
 };
 
-// Counter variables
-uniform int pointLightCount;
-uniform int spotLightCount;
-uniform int shadingModel;
+// Lights
+layout (std140, binding = 1) uniform Lights {
+    DirectionalLight directionalLight;
+
+    // Clusters along x, y and z, and the number of lights
+    ivec4 clusterCount;
 
-// Object Color
-uniform vec4 objectColor;
-uniform vec4 wireframeColor;
+    // Slice of a view depth - log(depth) * x + y
+    vec4 clusterDepth;
+};
 
-// Material Preview Mode
-uniform bool materialPreview;
-uniform bool specularPreview;
-uniform bool normalPreview;
+// Point and spot lights of the clusters, filled every pass on the CPU - See ClusteredLights.h
+// Point lights have an edge below -1, range is where the light is faded out completely
+struct ClusterLight {
+    vec3 position;
+    float range;
+    vec3 colour;
+    float ambientIntensity;
+    vec3 direction;
+    float edge;
+    float diffuseIntensity;
+    float constant;
+    float linear;
+    float exponent;
+};
 
-// Wireframe or Shaded
-uniform bool isWireframe;
-uniform bool isShaded;
+layout (std430, binding = 2) readonly buffer ClusterLights {
+    ClusterLight clusterLights[];
+};
 
-// Lights
-uniform DirectionalLight directionalLight;
-uniform PointLight pointLight[MAX_POINT_LIGHTS];
-uniform SpotLight spotLight[MAX_SPOT_LIGHTS];
+// Offset and count of the light list of every cluster, one grid per view
+layout (std430, binding = 3) readonly buffer ClusterGrid {
+    uvec2 clusterGrid[];
+};
+
+layout (std430, binding = 4) readonly buffer ClusterIndices {
+    uint clusterIndices[];
+};
+
+// Lights touching the bounds of every object of the pass, indices into the same lights - See InstanceLights.h
+// Offset and count of list i at 2i and 2i + 1, offsets are from the start of the buffer
+layout (std430, binding = 5) readonly buffer InstanceLightLists {
+    uint instanceLightLists[];
+};
+
+// Toggles from the UI
+layout (std140, binding = 2) uniform Settings {
+    // Object Color
+    vec4 objectColor;
+    vec4 wireframeColor;
+
+    // Skybox
+    vec3 backgroundColor;
+
+    int shadingModel;
+
+    // Material Preview Mode
+    bool materialPreview;
+    bool specularPreview;
+    bool normalPreview;
+
+    // Wireframe or Shaded
+    bool isWireframe;
+    bool isShaded;
+
+    // Skybox
+    bool envMapping;
+    bool skybox;
+
+    // Transmission
+    bool reflection;
+    bool refraction;
+    float ior;
+    float reflectance;
+    float dispersion;
+    float normalStrength;
+    float specularStrength;
+
+    // Objects with a list only loop over the lights touching them
+    bool instanceLights;
+};
 
 // Textures
 // Bound at Texture Unit 0
@@ -85,26 +148,15 @@ uniform sampler2D normalMap;
 // Bound at Texture Unit 1
 // uniform sampler2D noiseTexture;
 
-// Materials
-uniform Material material;
-
-// Eye Position
-uniform vec3 eyePosition;
+// Materials - One buffer per material group, bound when the group changes
+layout (std140, binding = 3) uniform Material {
+    float specularIntensity;
+    float shininess;
+    float metalness;
+} material;
 
 // Skybox
 uniform samplerCube environmentMap;
-uniform bool envMapping;
-uniform bool skybox;
-uniform vec3 backgroundColor;
-
-// Transmission
-uniform bool reflection;
-uniform bool refraction;
-uniform float ior;
-uniform float reflectance;
-uniform float dispersion;
-uniform float normalStrength;
-uniform float specularStrength;
 
 vec3 calcReflection() {
     // Environment Reflection Mapping
@@ -163,7 +215,7 @@ vec4 calcLightByDirection(Light light, vec3 direction) {
 
         // Phong Illumination
         else if (shadingModel == 0) {
-            vec3 fragToEye = TBNMatrix * normalize(eyePosition - fragPos);
+            vec3 fragToEye = TBNMatrix * normalize(eyePosition[viewIndex].xyz - fragPos);
             vec3 reflectedVertex = normalize(reflect(direction, normalize(normalTBN)));
 
             specularFactor = dot(fragToEye, reflectedVertex);
@@ -283,8 +335,8 @@ vec4 calcPointLightsBase(PointLight pLight) {
 }
 
 vec4 calcSpotLightsBase(SpotLight sLight) {
-    // Getting Direction
-    vec3 rayDirection = TBNMatrix * normalize(fragPos - sLight.base.position);
+    // Getting Direction - World space like the cone the light was assigned to the clusters with
+    vec3 rayDirection = normalize(fragPos - sLight.base.position);
 	float slFactor = dot(rayDirection, normalize(sLight.direction));
     vec4 colour = vec4(0, 0, 0, 0);
 
@@ -299,21 +351,44 @@ vec4 calcSpotLightsBase(SpotLight sLight) {
     return colour;
 }
 
-vec4 calcPointLights() {
-    vec4 totalColour = vec4(0, 0, 0, 0);
+uint getClusterIndex() {
+    // Screen tile and depth slice of the fragment in the view the lights were assigned for
+    vec4 viewPos = view[viewIndex] * vec4(fragPos, 1.0);
+    vec4 clipPos = projection[viewIndex] * viewPos;
+    vec2 tile = clamp((clipPos.xy / clipPos.w * 0.5 + 0.5) * vec2(clusterCount.xy), vec2(0.0), vec2(clusterCount.xy - 1));
 
-    for(int i = 0; i < pointLightCount; i++) {
-        totalColour += calcPointLightsBase(pointLight[i]);
+    int slice = clamp(int(floor(log(max(-viewPos.z, 1e-4)) * clusterDepth.x + clusterDepth.y)), 0, clusterCount.z - 1);
+
+    return uint(tile.x) + uint(clusterCount.x) * (uint(tile.y) + uint(clusterCount.y) * (uint(slice) + uint(clusterCount.z) * uint(viewIndex)));
+}
+
+vec4 calcClusterLight(ClusterLight light) {
+    PointLight pLight = PointLight(Light(light.colour, light.ambientIntensity, light.diffuseIntensity),
+                                   light.position, light.constant, light.linear, light.exponent);
+
+    // Fading out before the range, so the light doesn't stop at the edge of the clusters
+    float distanceRatio = length(fragPos - light.position) / light.range;
+    float window = clamp(1.0 - distanceRatio * distanceRatio * distanceRatio * distanceRatio, 0.0, 1.0);
+
+    if(light.edge < -1.0) {
+        return calcPointLightsBase(pLight) * window * window;
     }
 
-    return totalColour;
+    return calcSpotLightsBase(SpotLight(pLight, light.direction, light.edge)) * window * window;
 }
 
-vec4 calcSpotLights() {
+vec4 calcClusteredLights() {
     vec4 totalColour = vec4(0, 0, 0, 0);
 
-    for(int i = 0; i < spotLightCount; i++) {
-        totalColour += calcSpotLightsBase(spotLight[i]);
+    // Same lights, from the list of the object or of the cluster of the fragment
+    bool isObjectList = instanceLights && lightList >= 0;
+    uvec2 list = isObjectList ? uvec2(instanceLightLists[2 * lightList], instanceLightLists[2 * lightList + 1])
+                              : clusterGrid[getClusterIndex()];
+
+    for(uint i = 0; i < list.y; i++) {
+        uint index = isObjectList ? instanceLightLists[list.x + i] : clusterIndices[list.x + i];
+
+        totalColour += calcClusterLight(clusterLights[index]);
     }
 
     return totalColour;
@@ -344,7 +419,7 @@ vec4 calcGoochComplex(Light light, vec3 direction) {
 
     // If no diffuse, then no specular
     if (diffuseFactor > 0.0f) {
-        vec3 fragToEye = TBNMatrix * normalize(eyePosition - fragPos);
+        vec3 fragToEye = TBNMatrix * normalize(eyePosition[viewIndex].xyz - fragPos);
         vec3 reflectedVertex = normalize(reflect(direction, normalize(normalTBN)));
 
         float specularFactor = dot(fragToEye, reflectedVertex);
@@ -384,8 +459,12 @@ void main() {
     // Setting specular map strength - Blending between actual map and white
     specularMapFactor = mix(vec3(1.0, 1.0, 1.0).r, texture(specularMap, texCoord).r, specularStrength);
 
+    // Cooked normal maps (BC5) only store x and y, z is rebuilt from them - Same result for the RGB ones
+    vec2 normalXY = texture(normalMap, texCoord).rg * 2.0 - 1.0;
+    vec3 mappedNormal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0))) * 0.5 + 0.5;
+
     // Converting to TBN space & blending between Mapped and Empty normal
-    normalTBN = mix(vec3(0.216, 0.216, 1.0), texture(normalMap, texCoord).rgb, normalStrength);
+    normalTBN = mix(vec3(0.216, 0.216, 1.0), mappedNormal, normalStrength);
 
     // Mapping from 10.0,11.0] -> [-1.0, 1.0]
     normalTBN = normalTBN * 2.0 - 1.0;
@@ -393,7 +472,7 @@ void main() {
     normalTBN = -normalize(TBNMatrix * normalTBN);
 
     // Calculating View Position
-    viewDir = TBNMatrix * normalize(fragPos - eyePosition);
+    viewDir = TBNMatrix * normalize(fragPos - eyePosition[viewIndex].xyz);
 
     // If we just want to view the textures
     if(materialPreview) {
@@ -422,8 +501,7 @@ void main() {
 
         if(shadingModel < 2) {
             finalColour = calcDirectionalLight();
-            finalColour += calcPointLights();
-            finalColour += calcSpotLights();
+            finalColour += calcClusteredLights();
         }
 
         else if(shadingModel == 2) {
@@ -445,8 +523,7 @@ void main() {
 
         if(shadingModel < 2) {
             finalColour = calcDirectionalLight();
-            finalColour += calcPointLights();
-            finalColour += calcSpotLights();
+            finalColour += calcClusteredLights();
         }
 
         else if(shadingModel == 2) {
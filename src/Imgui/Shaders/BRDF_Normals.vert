@@ -18,13 +18,64 @@ out mat3 TBNMatrix;
 // For specular
 out vec3 fragPos;
 
+// Eye of the current instance in single pass stereo, 0 otherwise
+flat out int viewIndex;
+
+// Light list of the object, -1 for the lights of the cluster - See InstanceLights.h
+flat out int lightList;
+
+// Both eyes of single pass stereo - Same as MAX_VIEWS in Utilities.h
+const int MAX_VIEWS = 2;
+
 // MVP - Model, View, Projection Structure
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// View and Projection are shared by every draw of a pass - See UniformBuffer.h
+// Single pass stereo draws every instance viewCount times, with the eyes side by side in the target - See StereoTarget.h
+layout (std140, binding = 0) uniform Camera {
+    mat4 projection[MAX_VIEWS];
+    mat4 view[MAX_VIEWS];
+    vec4 eyePosition[MAX_VIEWS];
+    int viewCount;
+};
+
+// Multi draw indirect - Static model matrices of all the instances, and the instances drawn this frame
+// indexed using the baseInstance of the draw command
+uniform bool isIndirect;
+
+layout (std430, binding = 0) readonly buffer InstanceTransforms {
+    mat4 instanceModel[];
+};
+
+layout (std430, binding = 1) readonly buffer InstanceIndices {
+    uint instanceIndex[];
+};
+
+// Objects that aren't drawn indirectly set their list here, the city uses the index of its transforms
+uniform int lightInstance;
 
 void main() {
-    gl_Position = projection * view * model * vec4(pos, 1.0);
+    // Consecutive instances are the views of the same object
+    viewIndex = gl_InstanceID % viewCount;
+    int instance = gl_InstanceID / viewCount;
+
+    uint transformIndex = isIndirect ? instanceIndex[gl_BaseInstance + instance] : 0u;
+    mat4 modelMatrix = isIndirect ? instanceModel[transformIndex] : model;
+
+    lightList = isIndirect ? int(transformIndex) : lightInstance;
+
+    gl_Position = projection[viewIndex] * view[viewIndex] * modelMatrix * vec4(pos, 1.0);
+
+    if(viewCount > 1) {
+        // Clipping against the inner edge of the eye's half (x = w for the left eye, x = -w for the right one)
+        // before squeezing it in, otherwise triangles crossing it would spill into the other eye
+        gl_ClipDistance[0] = viewIndex == 0 ? gl_Position.w - gl_Position.x : gl_Position.w + gl_Position.x;
+        gl_Position.x = 0.5 * gl_Position.x + (viewIndex == 0 ? -0.5 : 0.5) * gl_Position.w;
+    }
+
+    else {
+        gl_ClipDistance[0] = 1.0;
+    }
     col = vec4(clamp(pos, 0.0f, 1.0f), 1.0f);
 
     texCoord = tex;
@@ -33,14 +84,14 @@ void main() {
     // Transpose and Inverse to preserve non-uniform scaling
     // Model is used to preserve scale and rotation
     // Since normal is just a direction
-    Normal = mat3(transpose(inverse(model))) * norm;
+    Normal = mat3(transpose(inverse(modelMatrix))) * norm;
 
     // **Referenced from : https://learnopengl.com/Advanced-Lighting/Normal-Mapping**
     // Calculating TBN matrix for normal maps
     // Gram-Schmidt process - We are calculating the bitangents
     // directly in the vertex instead of reading them from the mesh
-    vec3 T = normalize(vec3(model * vec4(tangent, 0.0)));
-    vec3 N = normalize(vec3(model * vec4(norm, 0.0)));
+    vec3 T = normalize(vec3(modelMatrix * vec4(tangent, 0.0)));
+    vec3 N = normalize(vec3(modelMatrix * vec4(norm, 0.0)));
 
     // Re-Orthogonalize T with respect to N
     T = normalize(T - dot(T, N) * N);
@@ -51,5 +102,5 @@ void main() {
     TBNMatrix = transpose(mat3(T, B, N));
 
     // Swizzling in GLSL
-    fragPos = (model * vec4(pos, 1.0)).xyz;
+    fragPos = (modelMatrix * vec4(pos, 1.0)).xyz;
 }
@@ -0,0 +1,18 @@
+#version 460 core
+
+out vec4 color;
+
+// Both eyes side by side - See StereoTarget.h
+layout (binding = 0) uniform sampler2D stereoTexture;
+
+void main() {
+    // Same pixel of both eyes, the window is as big as a single eye
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    int eyeWidth = textureSize(stereoTexture, 0).x / 2;
+
+    vec3 left = texelFetch(stereoTexture, pixel, 0).rgb;
+    vec3 right = texelFetch(stereoTexture, pixel + ivec2(eyeWidth, 0), 0).rgb;
+
+    // Red from the left eye, Cyan from the right eye
+    color = vec4(left.r, right.g, right.b, 1.0);
+}
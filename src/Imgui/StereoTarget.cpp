@@ -0,0 +1,127 @@
+#include "StereoTarget.h"
+
+// Constructor
+StereoTarget::StereoTarget() {
+    FBO = 0;
+    colorTexture = 0;
+    depthBuffer = 0;
+    emptyVAO = 0;
+
+    eyeWidth = 0;
+    eyeHeight = 0;
+}
+
+void StereoTarget::createTarget(const std::filesystem::path& currentSourceDir) {
+    std::string vertexShaderPath = returnPath(currentSourceDir, "Shaders/Stereo.vert");
+    std::string fragmentShaderPath = returnPath(currentSourceDir, "Shaders/Stereo.frag");
+
+    compositeShader.createFromFiles(vertexShaderPath.c_str(), fragmentShaderPath.c_str());
+
+    glGenVertexArrays(1, &emptyVAO);
+}
+
+void StereoTarget::createBuffers() {
+    glGenFramebuffers(1, &FBO);
+
+    // Both eyes side by side
+    glGenTextures(1, &colorTexture);
+    glState.bindTexture(0, GL_TEXTURE_2D, colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2 * eyeWidth, eyeHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // Read with texelFetch, but the texture is incomplete without a non mipmapped filter
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // Depth is never sampled, so a renderbuffer is enough
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 2 * eyeWidth, eyeHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Stereo frame buffer error : %u\n", status);
+    }
+}
+
+void StereoTarget::bindTarget(GLsizei width, GLsizei height) {
+    if(width != eyeWidth || height != eyeHeight || !FBO) {
+        cleanBuffers();
+
+        eyeWidth = width;
+        eyeHeight = height;
+
+        createBuffers();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    setTargetViewport();
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void StereoTarget::setEyeViewport(int eye) {
+    glViewport(eye * eyeWidth, 0, eyeWidth, eyeHeight);
+}
+
+void StereoTarget::setTargetViewport() {
+    glViewport(0, 0, 2 * eyeWidth, eyeHeight);
+}
+
+void StereoTarget::composite() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, eyeWidth, eyeHeight);
+
+    // Every pixel of the window is written, the depth of the default framebuffer is left as it is
+    glDisable(GL_DEPTH_TEST);
+    glState.setPolygonMode(GL_FILL);
+
+    compositeShader.useShader();
+    glState.bindTexture(0, GL_TEXTURE_2D, colorTexture);
+    glState.bindVertexArray(emptyVAO);
+
+    // Single triangle covering the window
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+void StereoTarget::cleanBuffers() {
+    if(FBO) {
+        glDeleteFramebuffers(1, &FBO);
+        FBO = 0;
+    }
+
+    if(colorTexture) {
+        glState.forgetTexture(colorTexture);
+        glDeleteTextures(1, &colorTexture);
+        colorTexture = 0;
+    }
+
+    if(depthBuffer) {
+        glDeleteRenderbuffers(1, &depthBuffer);
+        depthBuffer = 0;
+    }
+}
+
+void StereoTarget::cleanTarget() {
+    cleanBuffers();
+
+    if(emptyVAO) {
+        glState.forgetVertexArray(emptyVAO);
+        glDeleteVertexArrays(1, &emptyVAO);
+        emptyVAO = 0;
+    }
+
+    eyeWidth = 0;
+    eyeHeight = 0;
+}
+
+// Destructor
+StereoTarget::~StereoTarget() {
+    cleanTarget();
+}
@@ -0,0 +1,408 @@
+#include "TextureCooker.h"
+
+// BC1/BC3/BC5 block compressors
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+// VkFormat of each cooked format, KTX2 identifies the format by its Vulkan enum
+static const GLuint VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static const GLuint VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+static const GLuint VK_FORMAT_BC3_UNORM_BLOCK = 137;
+static const GLuint VK_FORMAT_BC3_SRGB_BLOCK = 138;
+static const GLuint VK_FORMAT_BC5_UNORM_BLOCK = 141;
+
+// Transfer functions of the data format descriptor
+static const uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+static const uint32_t KHR_DF_TRANSFER_SRGB = 2;
+
+static const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// Identifier, header and index - The level index starts right after
+static const size_t KTX2_LEVEL_INDEX_OFFSET = 80;
+
+static const char* COOK_FORMAT_NAMES[] = { "BC1", "BC3", "BC5" };
+
+// Files are little endian, like every platform the renderer runs on
+static uint32_t readU32(const unsigned char* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint64_t readU64(const unsigned char* data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+GLenum KTX2Image::getGLFormat() const {
+    // sRGB files are uploaded as UNORM too, the shaders use the texels as they are
+    switch(vkFormat) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return GL_COMPRESSED_RG_RGTC2;
+
+        default:
+            return 0;
+    }
+}
+
+CookFormat TextureCooker::chooseFormat(MipContent content, bool hasAlpha) {
+    if(content == MIP_CONTENT_NORMAL) {
+        return COOK_FORMAT_BC5;
+    }
+
+    return hasAlpha ? COOK_FORMAT_BC3 : COOK_FORMAT_BC1;
+}
+
+std::string TextureCooker::getCookedPath(const std::string& path) {
+    return std::filesystem::path(path).replace_extension(".ktx2").string();
+}
+
+void TextureCooker::compressLevel(const unsigned char* pixels, int width, int height, CookFormat format,
+                                  unsigned char* blocks, JobSystem* jobSystem) {
+    size_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockBytes = getBlockBytes(format);
+
+    size_t partitionCount = jobSystem ? std::min(jobSystem->getThreadCount(), blocksY) : 1;
+
+    // Rows of blocks don't share anything, each range can go to a different worker
+    auto compressJob = [&](size_t partition) {
+        size_t begin, end;
+        JobSystem::getPartitionRange(blocksY, partitionCount, partition, 1, begin, end);
+
+        unsigned char block[64];
+        unsigned char redGreen[32];
+
+        for(size_t blockY = begin; blockY < end; blockY++) {
+            for(size_t blockX = 0; blockX < blocksX; blockX++) {
+                for(int y = 0; y < 4; y++) {
+                    size_t sourceY = std::min(blockY * 4 + y, size_t(height - 1));
+
+                    for(int x = 0; x < 4; x++) {
+                        size_t sourceX = std::min(blockX * 4 + x, size_t(width - 1));
+                        memcpy(block + (y * 4 + x) * 4, pixels + (sourceY * width + sourceX) * 4, 4);
+                    }
+                }
+
+                unsigned char* destination = blocks + (blockY * blocksX + blockX) * blockBytes;
+
+                if(format == COOK_FORMAT_BC5) {
+                    for(int texel = 0; texel < 16; texel++) {
+                        redGreen[texel * 2] = block[texel * 4];
+                        redGreen[texel * 2 + 1] = block[texel * 4 + 1];
+                    }
+
+                    stb_compress_bc5_block(destination, redGreen);
+                }
+
+                else {
+                    stb_compress_dxt_block(destination, block, format == COOK_FORMAT_BC3, STB_DXT_HIGHQUAL);
+                }
+            }
+        }
+    };
+
+    if(jobSystem && partitionCount > 1) {
+        jobSystem->run(partitionCount, compressJob);
+    }
+
+    else {
+        for(size_t partition = 0; partition < partitionCount; partition++) {
+            compressJob(partition);
+        }
+    }
+}
+
+bool TextureCooker::writeKTX2(const std::string& path, CookFormat format, bool isSRGB, int width, int height,
+                              const std::vector<std::vector<unsigned char>>& levels) {
+    std::vector<unsigned char> file;
+
+    auto putU32 = [&](uint32_t value) {
+        for(int i = 0; i < 4; i++) {
+            file.push_back(static_cast<unsigned char>(value >> (8 * i)));
+        }
+    };
+
+    auto putU64 = [&](uint64_t value) {
+        putU32(static_cast<uint32_t>(value));
+        putU32(static_cast<uint32_t>(value >> 32));
+    };
+
+    GLuint vkFormats[] = { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK };
+    GLuint srgbFormats[] = { VK_FORMAT_BC1_RGB_SRGB_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK };
+
+    // BC5 has no sRGB variant, only colour is encoded with the curve
+    isSRGB = isSRGB && format != COOK_FORMAT_BC5;
+    uint32_t levelCount = static_cast<uint32_t>(levels.size());
+    uint32_t blockBytes = static_cast<uint32_t>(getBlockBytes(format));
+
+    // Samples of the data format descriptor - Bit offset, bit length - 1, channel
+    // BC1 is a single colour sample, BC3 alpha then colour, BC5 red then green (Khronos Data Format, section 5.6)
+    struct Sample { uint32_t offset, length, channel; };
+    std::vector<Sample> samples;
+
+    if(format == COOK_FORMAT_BC1) {
+        samples = { { 0, 63, 0 } };
+    }
+
+    else if(format == COOK_FORMAT_BC3) {
+        samples = { { 0, 63, 15 }, { 64, 63, 0 } };
+    }
+
+    else {
+        samples = { { 0, 63, 0 }, { 64, 63, 1 } };
+    }
+
+    // BC1A, BC3 and BC5 colour models
+    uint32_t colorModels[] = { 128, 130, 132 };
+
+    uint32_t descriptorSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+    uint32_t dfdOffset = static_cast<uint32_t>(KTX2_LEVEL_INDEX_OFFSET + 24 * levelCount);
+    uint32_t dfdLength = 4 + descriptorSize;
+
+    file.insert(file.end(), KTX2_IDENTIFIER, KTX2_IDENTIFIER + 12);
+
+    // Header - vkFormat, typeSize, width, height, depth, layers, faces, levels, supercompression
+    putU32(isSRGB ? srgbFormats[format] : vkFormats[format]);
+    putU32(1);
+    putU32(width);
+    putU32(height);
+    putU32(0);
+    putU32(0);
+    putU32(1);
+    putU32(levelCount);
+    putU32(0);
+
+    // Index - Data format descriptor, no key/values and no supercompression data
+    putU32(dfdOffset);
+    putU32(dfdLength);
+    putU32(0);
+    putU32(0);
+    putU64(0);
+    putU64(0);
+
+    // Level index, filled once the levels are placed
+    file.resize(dfdOffset, 0);
+
+    // Data format descriptor - Basic block, BT.709 primaries, sRGB or linear transfer, 4x4 blocks
+    putU32(dfdLength);
+    putU32(0);
+    putU32(2 | (descriptorSize << 16));
+    putU32(colorModels[format] | (1 << 8) | ((isSRGB ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16));
+    putU32(3 | (3 << 8));
+    putU32(blockBytes);
+    putU32(0);
+
+    for(const Sample& sample : samples) {
+        putU32(sample.offset | (sample.length << 16) | (sample.channel << 24));
+        putU32(0);
+        putU32(0);
+        putU32(0xFFFFFFFF);
+    }
+
+    // Smallest level first, every level aligned to a block
+    for(GLint level = static_cast<GLint>(levelCount) - 1; level >= 0; level--) {
+        file.resize((file.size() + blockBytes - 1) / blockBytes * blockBytes, 0);
+
+        uint64_t offset = file.size(), length = levels[level].size();
+        unsigned char* entry = file.data() + KTX2_LEVEL_INDEX_OFFSET + 24 * level;
+
+        // Byte offset, byte length, uncompressed byte length - Same as the length without supercompression
+        memcpy(entry, &offset, 8);
+        memcpy(entry + 8, &length, 8);
+        memcpy(entry + 16, &length, 8);
+
+        file.insert(file.end(), levels[level].begin(), levels[level].end());
+    }
+
+    std::ofstream output(path, std::ios::binary);
+
+    if(!output) {
+        printf("Failed to write: %s\n", path.c_str());
+        return false;
+    }
+
+    output.write(reinterpret_cast<const char*>(file.data()), file.size());
+
+    return output.good();
+}
+
+bool TextureCooker::cookFile(const std::string& source, const std::string& destination, JobSystem* jobSystem, CookStats& stats) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char* image = stbi_load(source.c_str(), &width, &height, &channels, 4);
+
+    if(!image) {
+        printf("Failed to load: %s\n", source.c_str());
+        return false;
+    }
+
+    // BC1 drops the alpha, only worth keeping if some texel isn't opaque
+    bool hasAlpha = false;
+
+    if(channels == 2 || channels == 4) {
+        for(size_t texel = 0; texel < size_t(width) * height && !hasAlpha; texel++) {
+            hasAlpha = image[texel * 4 + 3] != 255;
+        }
+    }
+
+    MipContent content = MipChain::chooseContent(source);
+    CookFormat format = chooseFormat(content, hasAlpha);
+
+    // Cube faces are sampled with GL_CLAMP_TO_EDGE, everything else repeats
+    std::string lowerSource = source;
+    std::transform(lowerSource.begin(), lowerSource.end(), lowerSource.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    MipSettings settings;
+    settings.content = content;
+    settings.filter = MIP_FILTER_KAISER;
+    settings.isWrapping = lowerSource.find("skybox") == std::string::npos;
+
+    MipChain mips;
+    mips.build(image, width, height, settings, jobSystem);
+
+    stbi_image_free(image);
+
+    auto mipsDone = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::vector<unsigned char>> compressedLevels(mips.getLevelCount());
+    size_t texels = 0;
+
+    stats.rawBytes = 0;
+    stats.cookedBytes = 0;
+
+    for(GLuint level = 0; level < mips.getLevelCount(); level++) {
+        int levelWidth = std::max(width >> level, 1), levelHeight = std::max(height >> level, 1);
+
+        compressedLevels[level].resize(size_t((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * getBlockBytes(format));
+        compressLevel(mips.getLevel(level), levelWidth, levelHeight, format, compressedLevels[level].data(), jobSystem);
+
+        texels += size_t(levelWidth) * levelHeight;
+        stats.rawBytes += mips.getLevelSize(level);
+        stats.cookedBytes += compressedLevels[level].size();
+    }
+
+    auto encodeDone = std::chrono::high_resolution_clock::now();
+
+    stats.width = width;
+    stats.height = height;
+    stats.levelCount = mips.getLevelCount();
+    stats.format = format;
+    stats.mipTime = std::chrono::duration<double, std::milli>(mipsDone - start).count();
+    stats.encodeTime = std::chrono::duration<double, std::milli>(encodeDone - mipsDone).count();
+    stats.megapixelsPerSecond = stats.encodeTime > 0.0 ? texels / (stats.encodeTime * 1000.0) : 0.0;
+
+    // MipChain stores colour levels with the sRGB curve, the file says so
+    return writeKTX2(destination, format, content == MIP_CONTENT_COLOUR, width, height, compressedLevels);
+}
+
+void TextureCooker::cookFiles(const std::vector<std::string>& paths) {
+    JobSystem jobSystem;
+    jobSystem.createWorkers();
+
+    // Directories are walked for every image stb can read
+    std::vector<std::string> files;
+
+    for(const std::string& path : paths) {
+        if(!std::filesystem::is_directory(path)) {
+            files.push_back(path);
+            continue;
+        }
+
+        for(const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            if(entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")) {
+                files.push_back(entry.path().string());
+            }
+        }
+    }
+
+    printf("Texture Cooker - %zu files, %zu threads\n", files.size(), jobSystem.getThreadCount());
+    printf("%-40s %11s %6s %9s %9s %10s %10s %7s\n", "Texture", "Size", "Format", "Mips ms", "MP/s", "Raw MB", "Cooked MB", "Saved");
+
+    size_t totalRaw = 0, totalCooked = 0, cookedCount = 0;
+
+    for(const std::string& file : files) {
+        CookStats stats;
+
+        if(!cookFile(file, getCookedPath(file), &jobSystem, stats)) {
+            continue;
+        }
+
+        std::string name = std::filesystem::path(file).filename().string();
+        std::string size = std::to_string(stats.width) + "x" + std::to_string(stats.height);
+
+        printf("%-40.40s %11s %6s %9.2f %9.2f %10.2f %10.2f %6.1f%%\n", name.c_str(), size.c_str(), COOK_FORMAT_NAMES[stats.format],
+               stats.mipTime, stats.megapixelsPerSecond, stats.rawBytes / 1048576.0, stats.cookedBytes / 1048576.0,
+               100.0 * (1.0 - double(stats.cookedBytes) / stats.rawBytes));
+
+        totalRaw += stats.rawBytes;
+        totalCooked += stats.cookedBytes;
+        cookedCount++;
+    }
+
+    if(cookedCount) {
+        printf("%zu cooked - VRAM %.2f MB -> %.2f MB (%.1f%% saved)\n", cookedCount, totalRaw / 1048576.0, totalCooked / 1048576.0,
+               100.0 * (1.0 - double(totalCooked) / totalRaw));
+    }
+}
+
+bool TextureCooker::loadKTX2(const std::string& path, KTX2Image& image) {
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+
+    if(!input) {
+        return false;
+    }
+
+    image.data.resize(static_cast<size_t>(input.tellg()));
+    input.seekg(0);
+    input.read(reinterpret_cast<char*>(image.data.data()), image.data.size());
+
+    const unsigned char* data = image.data.data();
+    size_t size = image.data.size();
+
+    if(!input || size < KTX2_LEVEL_INDEX_OFFSET || memcmp(data, KTX2_IDENTIFIER, 12) != 0) {
+        printf("Not a KTX2 file: %s\n", path.c_str());
+        return false;
+    }
+
+    image.vkFormat = readU32(data + 12);
+    image.width = static_cast<int>(readU32(data + 20));
+    image.height = static_cast<int>(readU32(data + 24));
+    image.faceCount = readU32(data + 36);
+    image.levelCount = readU32(data + 40);
+
+    // Supercompressed files and files leaving the mips to the loader aren't written by the cooker
+    if(readU32(data + 44) != 0 || image.levelCount == 0 || size < KTX2_LEVEL_INDEX_OFFSET + 24 * size_t(image.levelCount)) {
+        printf("Unsupported KTX2 file: %s\n", path.c_str());
+        return false;
+    }
+
+    image.levelOffsets.resize(image.levelCount);
+    image.levelSizes.resize(image.levelCount);
+
+    for(GLuint level = 0; level < image.levelCount; level++) {
+        const unsigned char* entry = data + KTX2_LEVEL_INDEX_OFFSET + 24 * level;
+
+        image.levelOffsets[level] = static_cast<size_t>(readU64(entry));
+        image.levelSizes[level] = static_cast<size_t>(readU64(entry + 8));
+
+        if(image.levelOffsets[level] + image.levelSizes[level] > size) {
+            printf("Truncated KTX2 file: %s\n", path.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
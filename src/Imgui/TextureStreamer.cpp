@@ -0,0 +1,386 @@
+#include "TextureStreamer.h"
+
+// Constructor
+TextureStreamer::TextureStreamer() {
+    isStopping = false;
+    nextID = 1;
+
+    uploadBuffer = 0;
+    uploadMemory = nullptr;
+    uploadRegion = 0;
+
+    for(int region = 0; region < TEXTURE_STREAM_FRAMES; region++) {
+        uploadFences[region] = nullptr;
+    }
+
+    uploadBudget = TEXTURE_STREAM_BUDGET;
+
+    uploadedBytes = 0;
+    pendingBytes = 0;
+    decodingCount = 0;
+    streamingCount = 0;
+    residentCount = 0;
+    updateTime = 0.0;
+}
+
+void TextureStreamer::createStreamer(size_t workerCount) {
+    // Failsafe, in case the streamer is created again
+    stopStreamer();
+
+    // Written by the CPU while the GPU copies from the other regions, never read back
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = static_cast<GLsizeiptr>(TEXTURE_STREAM_MAX_BUDGET) * TEXTURE_STREAM_FRAMES;
+
+    glGenBuffers(1, &uploadBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+    uploadMemory = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+
+    // Uploads from client memory would read from the buffer otherwise
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(!uploadMemory) {
+        printf("Failed to map the texture upload buffer, only the mip tails will be streamed\n");
+    }
+
+    isStopping = false;
+
+    for(size_t i = 0; i < std::max<size_t>(workerCount, 1); i++) {
+        workers.emplace_back(&TextureStreamer::workerLoop, this);
+    }
+}
+
+uint64_t TextureStreamer::requestTexture(GLuint textureID, const std::string& path, int width, int height, GLuint levelCount) {
+    uint64_t id = nextID++;
+
+    StreamEntry entry;
+    entry.id = id;
+    entry.residency = { path, textureID, width, height, levelCount, levelCount - 1, TEXTURE_DECODING };
+    entry.decoded.id = id;
+    entry.decoded.isFailed = false;
+    entry.uploadLevel = -1;
+    entry.uploadRow = 0;
+
+    entries.push_back(std::move(entry));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back({ id, path, width, height, levelCount });
+    }
+
+    requestCondition.notify_one();
+
+    return id;
+}
+
+void TextureStreamer::cancelTexture(uint64_t id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for(auto request = requests.begin(); request != requests.end(); ++request) {
+            if(request->id == id) {
+                requests.erase(request);
+                break;
+            }
+        }
+    }
+
+    // Files already being decoded are dropped by update() since the entry is gone
+    for(auto entry = entries.begin(); entry != entries.end(); ++entry) {
+        if(entry->id == id) {
+            entries.erase(entry);
+            break;
+        }
+    }
+}
+
+void TextureStreamer::workerLoop() {
+    while(true) {
+        DecodeRequest request;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            requestCondition.wait(lock, [&]() { return isStopping || !requests.empty(); });
+
+            if(isStopping) {
+                return;
+            }
+
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        DecodedTexture decoded;
+        decoded.id = request.id;
+        decoded.isFailed = true;
+
+        // Always 4 channels, so every level is RGBA8 and its rows stay aligned
+        int width = 0, height = 0, channels = 0;
+        unsigned char* image = stbi_load(request.path.c_str(), &width, &height, &channels, 4);
+
+        // The storage was allocated from the header, a file that changed since then can't be used
+        if(image && width == request.width && height == request.height) {
+            // Workers already run side by side, every file is built on its own worker
+            MipSettings settings;
+            settings.content = MipChain::chooseContent(request.path);
+
+            decoded.mips.build(image, width, height, settings);
+            decoded.isFailed = decoded.mips.getLevelCount() != request.levelCount;
+        }
+
+        if(image) {
+            stbi_image_free(image);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        decodedTextures.push_back(std::move(decoded));
+    }
+}
+
+TextureStreamer::StreamEntry* TextureStreamer::findEntry(uint64_t id) {
+    for(StreamEntry& entry : entries) {
+        if(entry.id == id) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+void TextureStreamer::setResidentLevel(StreamEntry& entry, GLuint level) {
+    entry.residency.residentLevel = level;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+    if(level == 0) {
+        entry.residency.state = TEXTURE_RESIDENT;
+
+        // Everything is on the GPU, swap instead of clear so the memory is released
+        entry.decoded.mips.release();
+    }
+}
+
+void TextureStreamer::uploadTail(StreamEntry& entry) {
+    TextureResidency& residency = entry.residency;
+
+    glState.bindTexture(0, GL_TEXTURE_2D, residency.textureID);
+
+    GLint level = static_cast<GLint>(residency.levelCount) - 1;
+
+    for(; level >= 0; level--) {
+        int levelWidth = std::max(residency.width >> level, 1), levelHeight = std::max(residency.height >> level, 1);
+
+        if(level < static_cast<GLint>(residency.levelCount) - 1 && std::max(levelWidth, levelHeight) > TEXTURE_STREAM_TAIL_SIZE) {
+            break;
+        }
+
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                        entry.decoded.mips.getLevel(level));
+
+        uploadedBytes += size_t(levelWidth) * levelHeight * 4;
+    }
+
+    residency.state = TEXTURE_STREAMING;
+    entry.uploadLevel = level;
+    entry.uploadRow = 0;
+
+    setResidentLevel(entry, level + 1);
+
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
+}
+
+size_t TextureStreamer::uploadRows(StreamEntry& entry, size_t regionOffset, size_t budget) {
+    TextureResidency& residency = entry.residency;
+
+    int levelWidth = std::max(residency.width >> entry.uploadLevel, 1), levelHeight = std::max(residency.height >> entry.uploadLevel, 1);
+    size_t rowBytes = size_t(levelWidth) * 4;
+
+    // Bigger levels are split over as many frames as the budget needs
+    size_t rows = std::min(size_t(levelHeight - entry.uploadRow), budget / rowBytes);
+
+    if(!rows) {
+        return 0;
+    }
+
+    size_t bytes = rows * rowBytes;
+    memcpy(uploadMemory + regionOffset, entry.decoded.mips.getLevel(entry.uploadLevel) + entry.uploadRow * rowBytes, bytes);
+
+    glState.bindTexture(0, GL_TEXTURE_2D, residency.textureID);
+
+    // The pixel pointer is an offset into the bound pixel buffer
+    glTexSubImage2D(GL_TEXTURE_2D, entry.uploadLevel, 0, entry.uploadRow, levelWidth, static_cast<GLsizei>(rows),
+                    GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(regionOffset));
+
+    entry.uploadRow += static_cast<GLint>(rows);
+
+    if(entry.uploadRow == levelHeight) {
+        setResidentLevel(entry, entry.uploadLevel);
+
+        entry.uploadLevel--;
+        entry.uploadRow = 0;
+    }
+
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
+
+    return bytes;
+}
+
+void TextureStreamer::update() {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uploadedBytes = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readyTextures.swap(decodedTextures);
+    }
+
+    // Mip tails first, these are tiny and let the materials show the real colours
+    for(DecodedTexture& decoded : readyTextures) {
+        StreamEntry* entry = findEntry(decoded.id);
+
+        // Cancelled while it was being decoded
+        if(!entry) {
+            continue;
+        }
+
+        if(decoded.isFailed) {
+            printf("Failed to stream: %s\n", entry->residency.path.c_str());
+            entry->residency.state = TEXTURE_FAILED;
+            continue;
+        }
+
+        entry->decoded = std::move(decoded);
+        uploadTail(*entry);
+    }
+
+    readyTextures.clear();
+
+    // Region of this frame, skipped while the GPU still copies from it instead of stalling
+    GLsync& fence = uploadFences[uploadRegion];
+    bool isRegionFree = uploadMemory != nullptr;
+
+    if(isRegionFree && fence) {
+        isRegionFree = glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED;
+
+        if(isRegionFree) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if(isRegionFree) {
+        size_t regionStart = size_t(uploadRegion) * TEXTURE_STREAM_MAX_BUDGET;
+        size_t used = 0;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+
+        // Coarsest pending level of all the textures first, until the budget runs out
+        while(used < uploadBudget) {
+            StreamEntry* next = nullptr;
+
+            for(StreamEntry& entry : entries) {
+                if(entry.residency.state == TEXTURE_STREAMING && (!next || entry.uploadLevel > next->uploadLevel)) {
+                    next = &entry;
+                }
+            }
+
+            if(!next) {
+                break;
+            }
+
+            size_t bytes = uploadRows(*next, regionStart + used, uploadBudget - used);
+
+            // Not even a row of it fits in what is left
+            if(!bytes) {
+                break;
+            }
+
+            used += bytes;
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if(used) {
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            uploadRegion = (uploadRegion + 1) % TEXTURE_STREAM_FRAMES;
+            uploadedBytes += used;
+        }
+    }
+
+    // Stats
+    pendingBytes = 0;
+    decodingCount = 0;
+    streamingCount = 0;
+    residentCount = 0;
+
+    for(const StreamEntry& entry : entries) {
+        switch(entry.residency.state) {
+            case TEXTURE_DECODING:
+                decodingCount++;
+                break;
+
+            case TEXTURE_STREAMING: {
+                streamingCount++;
+
+                // Rest of the current level and every finer level
+                size_t rowBytes = size_t(std::max(entry.residency.width >> entry.uploadLevel, 1)) * 4;
+                pendingBytes += entry.decoded.mips.getLevelOffset(entry.uploadLevel) + entry.decoded.mips.getLevelSize(entry.uploadLevel) -
+                                entry.uploadRow * rowBytes;
+                break;
+            }
+
+            case TEXTURE_RESIDENT:
+                residentCount++;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    updateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void TextureStreamer::setUploadBudget(size_t bytes) {
+    uploadBudget = std::min(bytes, TEXTURE_STREAM_MAX_BUDGET);
+}
+
+void TextureStreamer::stopStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+        requests.clear();
+    }
+
+    requestCondition.notify_all();
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+
+    workers.clear();
+    decodedTextures.clear();
+
+    for(int region = 0; region < TEXTURE_STREAM_FRAMES; region++) {
+        if(uploadFences[region]) {
+            glDeleteSync(uploadFences[region]);
+            uploadFences[region] = nullptr;
+        }
+    }
+
+    if(uploadBuffer) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        glDeleteBuffers(1, &uploadBuffer);
+        uploadBuffer = 0;
+        uploadMemory = nullptr;
+    }
+}
+
+// Destructor
+TextureStreamer::~TextureStreamer() {
+    stopStreamer();
+}
@@ -0,0 +1,412 @@
+#include "TransformSystem.h"
+
+#include <immintrin.h>
+
+// Constructor
+TransformSystem::TransformSystem() {
+    isOrderDirty = false;
+    updatedCount = 0;
+}
+
+// Parent * Translation * Rotation * Scale in one go - The local matrix has a 0 0 0 1 row, so every column is the sum of 3
+// columns of the parent (Plus the translation of the parent for the last one) and the local matrix is never stored
+static void composeWorld(const glm::mat4& parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, glm::mat4& result) {
+    glm::mat3 rotationMatrix = glm::mat3_cast(rotation);
+
+    __m128 p0 = _mm_loadu_ps(&parent[0][0]);
+    __m128 p1 = _mm_loadu_ps(&parent[1][0]);
+    __m128 p2 = _mm_loadu_ps(&parent[2][0]);
+    __m128 p3 = _mm_loadu_ps(&parent[3][0]);
+
+    for(int column = 0; column < 3; column++) {
+        __m128 sum = _mm_mul_ps(p0, _mm_set1_ps(rotationMatrix[column][0] * scale[column]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(p1, _mm_set1_ps(rotationMatrix[column][1] * scale[column])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(p2, _mm_set1_ps(rotationMatrix[column][2] * scale[column])));
+
+        _mm_storeu_ps(&result[column][0], sum);
+    }
+
+    __m128 translation = _mm_add_ps(p3, _mm_mul_ps(p0, _mm_set1_ps(position.x)));
+    translation = _mm_add_ps(translation, _mm_mul_ps(p1, _mm_set1_ps(position.y)));
+    translation = _mm_add_ps(translation, _mm_mul_ps(p2, _mm_set1_ps(position.z)));
+
+    _mm_storeu_ps(&result[3][0], translation);
+}
+
+// Translation * Rotation * Scale, without building the three matrices
+static glm::mat4 composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    glm::mat3 rotationMatrix = glm::mat3_cast(rotation);
+
+    return glm::mat4( glm::vec4(rotationMatrix[0] * scale.x, 0.0f),
+                      glm::vec4(rotationMatrix[1] * scale.y, 0.0f),
+                      glm::vec4(rotationMatrix[2] * scale.z, 0.0f),
+                      glm::vec4(position, 1.0f) );
+}
+
+void TransformSystem::reserve(size_t nodeCount) {
+    positions.reserve(nodeCount);
+    rotations.reserve(nodeCount);
+    scales.reserve(nodeCount);
+    worldMatrices.reserve(nodeCount);
+    parents.reserve(nodeCount);
+    dirty.reserve(nodeCount);
+    changed.reserve(nodeCount);
+    parentHandles.reserve(nodeCount);
+    handleToIndex.reserve(nodeCount);
+    indexToHandle.reserve(nodeCount);
+}
+
+TransformHandle TransformSystem::createNode(TransformHandle parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    if(parent != INVALID_TRANSFORM && parent >= handleToIndex.size()) {
+        printf("Transform parent %u doesn't exist!\n", parent);
+        parent = INVALID_TRANSFORM;
+    }
+
+    TransformHandle node = static_cast<TransformHandle>(handleToIndex.size());
+
+    // Appended after its parent, so the arrays stay in a valid order until they are sorted by depth
+    handleToIndex.push_back(static_cast<GLuint>(positions.size()));
+    indexToHandle.push_back(node);
+    parentHandles.push_back(parent);
+
+    positions.push_back(position);
+    rotations.push_back(rotation);
+    scales.push_back(scale);
+    worldMatrices.push_back(glm::mat4(1.0f));
+    parents.push_back(parent == INVALID_TRANSFORM ? INVALID_TRANSFORM : handleToIndex[parent]);
+    dirty.push_back(1);
+    changed.push_back(0);
+
+    // The node is one level deeper than its parent, which may be in the middle of the arrays
+    isOrderDirty = true;
+
+    return node;
+}
+
+void TransformSystem::setParent(TransformHandle node, TransformHandle parent) {
+    // Walking up from the new parent, the node must not be one of its ancestors
+    for(TransformHandle ancestor = parent; ancestor != INVALID_TRANSFORM; ancestor = parentHandles[ancestor]) {
+        if(ancestor == node) {
+            printf("Transform %u can't be parented to its own child!\n", node);
+            return;
+        }
+    }
+
+    parentHandles[node] = parent;
+    dirty[handleToIndex[node]] = 1;
+    isOrderDirty = true;
+}
+
+void TransformSystem::setLocalTransform(TransformHandle node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    GLuint index = handleToIndex[node];
+
+    positions[index] = position;
+    rotations[index] = rotation;
+    scales[index] = scale;
+    dirty[index] = 1;
+}
+
+void TransformSystem::setPosition(TransformHandle node, const glm::vec3& position) {
+    GLuint index = handleToIndex[node];
+
+    positions[index] = position;
+    dirty[index] = 1;
+}
+
+void TransformSystem::setRotation(TransformHandle node, const glm::quat& rotation) {
+    GLuint index = handleToIndex[node];
+
+    rotations[index] = rotation;
+    dirty[index] = 1;
+}
+
+void TransformSystem::setScale(TransformHandle node, const glm::vec3& scale) {
+    GLuint index = handleToIndex[node];
+
+    scales[index] = scale;
+    dirty[index] = 1;
+}
+
+void TransformSystem::sortByDepth() {
+    size_t nodeCount = positions.size();
+
+    // Children of every handle in the current order of the arrays, as ranges of one list
+    std::vector<GLuint> childStarts(nodeCount + 1, 0);
+    std::vector<TransformHandle> children(nodeCount);
+
+    for(TransformHandle node = 0; node < nodeCount; node++) {
+        if(parentHandles[node] != INVALID_TRANSFORM) {
+            childStarts[parentHandles[node] + 1]++;
+        }
+    }
+
+    for(size_t node = 1; node <= nodeCount; node++) {
+        childStarts[node] += childStarts[node - 1];
+    }
+
+    std::vector<GLuint> nextChild(childStarts.begin(), childStarts.end() - 1);
+    std::vector<TransformHandle> sortedHandles;
+    sortedHandles.reserve(nodeCount);
+
+    for(GLuint index = 0; index < nodeCount; index++) {
+        TransformHandle node = indexToHandle[index];
+
+        if(parentHandles[node] == INVALID_TRANSFORM) {
+            sortedHandles.push_back(node);
+        }
+
+        else {
+            children[nextChild[parentHandles[node]]++] = node;
+        }
+    }
+
+    // Breadth first from the roots - Every level is in the order of the parents, so update reads the level before it front to
+    // back instead of jumping around it, and siblings keep their order
+    levelStarts.assign(1, 0);
+    size_t levelEnd = sortedHandles.size();
+
+    for(size_t i = 0; i < sortedHandles.size(); i++) {
+        if(i == levelEnd) {
+            levelStarts.push_back(levelEnd);
+            levelEnd = sortedHandles.size();
+        }
+
+        TransformHandle node = sortedHandles[i];
+        sortedHandles.insert(sortedHandles.end(), children.begin() + childStarts[node], children.begin() + childStarts[node + 1]);
+    }
+
+    levelStarts.push_back(sortedHandles.size());
+
+    // Moving every array into the new order
+    std::vector<glm::vec3> sortedPositions(nodeCount), sortedScales(nodeCount);
+    std::vector<glm::quat> sortedRotations(nodeCount);
+    std::vector<glm::mat4> sortedWorldMatrices(nodeCount);
+    std::vector<unsigned char> sortedDirty(nodeCount), sortedChanged(nodeCount);
+
+    for(GLuint index = 0; index < nodeCount; index++) {
+        GLuint oldIndex = handleToIndex[sortedHandles[index]];
+
+        sortedPositions[index] = positions[oldIndex];
+        sortedRotations[index] = rotations[oldIndex];
+        sortedScales[index] = scales[oldIndex];
+        sortedWorldMatrices[index] = worldMatrices[oldIndex];
+        sortedDirty[index] = dirty[oldIndex];
+        sortedChanged[index] = changed[oldIndex];
+    }
+
+    positions.swap(sortedPositions);
+    rotations.swap(sortedRotations);
+    scales.swap(sortedScales);
+    worldMatrices.swap(sortedWorldMatrices);
+    dirty.swap(sortedDirty);
+    changed.swap(sortedChanged);
+    indexToHandle.swap(sortedHandles);
+
+    for(GLuint index = 0; index < nodeCount; index++) {
+        handleToIndex[indexToHandle[index]] = index;
+    }
+
+    // Parents only once every handle has its new index
+    for(GLuint index = 0; index < nodeCount; index++) {
+        TransformHandle parent = parentHandles[indexToHandle[index]];
+        parents[index] = parent == INVALID_TRANSFORM ? INVALID_TRANSFORM : handleToIndex[parent];
+    }
+
+    isOrderDirty = false;
+}
+
+size_t TransformSystem::updateRange(size_t begin, size_t end) {
+    size_t updated = 0;
+
+    for(size_t i = begin; i < end; i++) {
+        GLuint parent = parents[i];
+
+        // Parents are in an earlier level, so their flag is already set for this update
+        bool isChanged = dirty[i] || (parent != INVALID_TRANSFORM && changed[parent]);
+        changed[i] = isChanged;
+
+        if(!isChanged) {
+            continue;
+        }
+
+        dirty[i] = 0;
+        updated++;
+
+        if(parent == INVALID_TRANSFORM) {
+            worldMatrices[i] = composeTRS(positions[i], rotations[i], scales[i]);
+        }
+
+        else {
+            composeWorld(worldMatrices[parent], positions[i], rotations[i], scales[i], worldMatrices[i]);
+        }
+    }
+
+    return updated;
+}
+
+void TransformSystem::update(JobSystem* jobSystem) {
+    if(isOrderDirty) {
+        sortByDepth();
+    }
+
+    updatedCount = 0;
+
+    for(size_t level = 0; level + 1 < levelStarts.size(); level++) {
+        size_t begin = levelStarts[level];
+        size_t end = levelStarts[level + 1];
+
+        size_t partitionCount = jobSystem ? jobSystem->getThreadCount() : 1;
+        partitionCount = std::max<size_t>(1, std::min(partitionCount, (end - begin) / TRANSFORM_PARTITION_MIN_NODES));
+
+        if(partitionCount == 1) {
+            updatedCount += updateRange(begin, end);
+            continue;
+        }
+
+        // Nodes of a level only read their parents from the levels before, the flags are separate bytes per node
+        std::atomic<size_t> levelUpdated(0);
+
+        auto updatePartition = [&](size_t partition) {
+            size_t partitionBegin, partitionEnd;
+            JobSystem::getPartitionRange(end - begin, partitionCount, partition, 1, partitionBegin, partitionEnd);
+
+            levelUpdated += updateRange(begin + partitionBegin, begin + partitionEnd);
+        };
+
+        jobSystem->run(partitionCount, updatePartition);
+        updatedCount += levelUpdated;
+    }
+}
+
+// Pointer based hierarchy updated recursively, what the models do - Reference for the benchmark
+struct RecursiveTransformNode {
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+    glm::mat4 world;
+    std::vector<RecursiveTransformNode*> children;
+
+    void update(const glm::mat4& parentWorld) {
+        world = parentWorld * composeTRS(position, rotation, scale);
+
+        for(RecursiveTransformNode* child : children) {
+            child->update(world);
+        }
+    }
+};
+
+void TransformSystem::benchmarkUpdate(size_t nodeCount, int iterations) {
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    auto randomRotation = [&]() {
+        return glm::normalize(glm::quat(distribution(generator), distribution(generator), distribution(generator), distribution(generator) + 2.0f));
+    };
+
+    // A few roots, every other node under a random earlier one (Around log(n) levels deep)
+    TransformSystem system;
+    system.reserve(nodeCount);
+
+    std::vector<RecursiveTransformNode> recursiveNodes(nodeCount);
+    std::vector<RecursiveTransformNode*> recursiveRoots;
+
+    for(size_t i = 0; i < nodeCount; i++) {
+        TransformHandle parent = i % 1000 == 0 ? INVALID_TRANSFORM : static_cast<TransformHandle>(generator() % i);
+
+        glm::vec3 position(distribution(generator), distribution(generator), distribution(generator));
+        glm::quat rotation = randomRotation();
+        glm::vec3 scale(1.0f + 0.01f * distribution(generator));
+
+        system.createNode(parent, position, rotation, scale);
+
+        recursiveNodes[i].position = position;
+        recursiveNodes[i].rotation = rotation;
+        recursiveNodes[i].scale = scale;
+
+        if(parent == INVALID_TRANSFORM) {
+            recursiveRoots.push_back(&recursiveNodes[i]);
+        }
+
+        else {
+            recursiveNodes[parent].children.push_back(&recursiveNodes[i]);
+        }
+    }
+
+    JobSystem jobSystem;
+    jobSystem.createWorkers();
+
+    // Sorting happens once, on the first update
+    auto start = std::chrono::high_resolution_clock::now();
+    system.update(&jobSystem);
+    double firstTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    double recursiveTime = 0.0, allTime = 0.0, fewTime = 0.0, cleanTime = 0.0;
+    size_t fewUpdated = 0;
+
+    for(int i = 0; i < iterations; i++) {
+        // Everything changes - Every root marked dirty
+        auto recursiveStart = std::chrono::high_resolution_clock::now();
+
+        for(RecursiveTransformNode* root : recursiveRoots) {
+            root->update(glm::mat4(1.0f));
+        }
+
+        recursiveTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recursiveStart).count();
+
+        for(size_t root = 0; root < nodeCount; root += 1000) {
+            system.setRotation(static_cast<TransformHandle>(root), system.getRotation(static_cast<TransformHandle>(root)));
+        }
+
+        auto allStart = std::chrono::high_resolution_clock::now();
+        system.update(&jobSystem);
+        allTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - allStart).count();
+
+        // 0.1% of the nodes move, with their subtrees
+        for(size_t moved = 0; moved < nodeCount / 1000; moved++) {
+            system.setRotation(static_cast<TransformHandle>(generator() % nodeCount), randomRotation());
+        }
+
+        auto fewStart = std::chrono::high_resolution_clock::now();
+        system.update(&jobSystem);
+        fewTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - fewStart).count();
+        fewUpdated += system.getUpdatedCount();
+
+        // Nothing changes
+        auto cleanStart = std::chrono::high_resolution_clock::now();
+        system.update(&jobSystem);
+        cleanTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cleanStart).count();
+    }
+
+    // Same world matrices as the recursion, once the moved rotations are copied over
+    for(size_t i = 0; i < nodeCount; i++) {
+        recursiveNodes[i].rotation = system.getRotation(static_cast<TransformHandle>(i));
+    }
+
+    for(RecursiveTransformNode* root : recursiveRoots) {
+        root->update(glm::mat4(1.0f));
+    }
+
+    float maxError = 0.0f;
+
+    for(size_t i = 0; i < nodeCount; i++) {
+        const glm::mat4& world = system.getWorldMatrix(static_cast<TransformHandle>(i));
+
+        for(int column = 0; column < 4; column++) {
+            glm::vec4 difference = glm::abs(world[column] - recursiveNodes[i].world[column]);
+            maxError = std::max(maxError, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+        }
+    }
+
+    printf("Transform System - %zu nodes, %zu levels, %i iterations, %zu threads\n", nodeCount, system.getLevelCount(),
+           iterations, jobSystem.getThreadCount());
+    printf("%16s %10.3f ms\n", "Sort + update", firstTime);
+    printf("%16s %10.3f ms\n", "Recursive", recursiveTime / iterations);
+    printf("%16s %10.3f ms\n", "All dirty", allTime / iterations);
+    printf("%16s %10.3f ms (%zu nodes)\n", "0.1% dirty", fewTime / iterations, fewUpdated / iterations);
+    printf("%16s %10.3f ms\n", "Clean", cleanTime / iterations);
+    printf("%16s %10.6f\n", "Max error", maxError);
+}
+
+// Destructor
+TransformSystem::~TransformSystem() {
+}
@@ -0,0 +1,71 @@
+#include <cstring>
+
+#include "UniformBuffer.h"
+
+// Constructor
+UniformBuffer::UniformBuffer() {
+    UBO = 0;
+    bindingPoint = 0;
+    size = 0;
+    uploadCount = 0;
+}
+
+void UniformBuffer::createBuffer(GLsizeiptr bufferSize, GLuint binding) {
+    // Failsafe, in case the buffer is re-created
+    cleanBuffer();
+
+    size = bufferSize;
+    bindingPoint = binding;
+
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // The binding point never changes, every program using the block reads from this buffer
+    glState.bindUniformBuffer(bindingPoint, UBO);
+}
+
+void UniformBuffer::bindBuffer() {
+    if(UBO) {
+        glState.bindUniformBuffer(bindingPoint, UBO);
+    }
+}
+
+bool UniformBuffer::updateBuffer(const void* data) {
+    if(!UBO) {
+        return false;
+    }
+
+    // Nothing uploaded yet, or the contents changed
+    if(!uploadedData.empty() && memcmp(uploadedData.data(), data, size) == 0) {
+        return false;
+    }
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uploadedData.assign(bytes, bytes + size);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    uploadCount++;
+
+    return true;
+}
+
+void UniformBuffer::cleanBuffer() {
+    if(UBO) {
+        glState.forgetUniformBuffer(UBO);
+        glDeleteBuffers(1, &UBO);
+        UBO = 0;
+    }
+
+    uploadedData.clear();
+    size = 0;
+}
+
+// Destructor
+UniformBuffer::~UniformBuffer() {
+    cleanBuffer();
+}
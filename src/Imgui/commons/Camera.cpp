@@ -191,6 +191,11 @@ glm::mat4 Camera::calculateOrthographicProjectionMatrix() {
     return glm::ortho(-scale, scale, -scale, scale, nearClipping, farClipping);
 }
 
+GLfloat Camera::calculateProjectionScale(const GLint& height) {
+    // Screen height in pixels divided by the height of the view frustum at a distance of 1
+    return GLfloat(height) / (2.0f * tan(glm::radians(FOV) / 2.0f));
+}
+
 glm::vec3 Camera::getRayDirection(GLfloat mouseX, GLfloat mouseY, int screenWidth, int screenHeight) {
     // Converting mouse coordinates to NDC (Normalized Device Coordinates)
     glm::vec4 rayClip = glm::vec4((2.0f * mouseX) / screenWidth - 1.0f, 1.0f - (2.0f * mouseY) / screenHeight, -1.0f, 1.0f);
@@ -25,6 +25,16 @@ void DirectionalLight::useLight( GLuint ambientIntensityLocation, GLuint ambient
     glUniform1f(diffuseIntensityLocation, diffIntensity);
 }
 
+void DirectionalLight::fillBlock(DirectionalLightBlock& block) const {
+    // Ambient Light
+    block.base.colour = dirColor;
+    block.base.ambientIntensity = ambIntensity;
+
+    // Diffuse Light
+    block.direction = direction;
+    block.base.diffuseIntensity = diffIntensity;
+}
+
 void DirectionalLight::setDirLight( GLfloat red, GLfloat green, GLfloat blue,
                                     GLfloat amb, GLfloat diff,
                                     GLfloat x, GLfloat y, GLfloat z ) {
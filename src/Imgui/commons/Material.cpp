@@ -19,6 +19,13 @@ void Material::useMaterial(GLuint specularIntensityLocation, GLuint shininessLoc
     glUniform1f(metalnessLocation, metalness);
 }
 
+void Material::fillBlock(MaterialBlock& block) const {
+    block.specularIntensity = specularIntensity;
+    block.shininess = shininess;
+    block.metalness = metalness;
+    block.padding = 0.0f;
+}
+
 void Material::setMaterialParamters(GLfloat specular, GLfloat shine, GLfloat metal) {
     specularIntensity = specular;
     shininess = shine;
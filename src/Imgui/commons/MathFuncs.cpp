@@ -121,3 +121,37 @@ bool areFloatArraysEqual(const float a[3], const float b[3], float epsilon) {
     }
     return true;
 }
+
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+    Frustum frustum;
+
+    // Rows of the matrix, GLM is column major
+    glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+    frustum.planes[0] = row3 + row0;
+    frustum.planes[1] = row3 - row0;
+    frustum.planes[2] = row3 + row1;
+    frustum.planes[3] = row3 - row1;
+    frustum.planes[4] = row3 + row2;
+    frustum.planes[5] = row3 - row2;
+
+    // Normalizing so that the distances are in world units
+    for(int i = 0; i < 6; i++) {
+        frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+    }
+
+    return frustum;
+}
+
+bool isSphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+    for(int i = 0; i < 6; i++) {
+        if(glm::dot(glm::vec3(frustum.planes[i]), center) + frustum.planes[i].w < -radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
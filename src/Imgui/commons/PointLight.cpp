@@ -43,5 +43,53 @@ void PointLight::useLight(  GLuint ambientIntensityLocation, GLuint ambientColou
     glUniform1f(exponentLocation, exponent);
 }
 
+GLfloat PointLight::calculateRange() const {
+    // Brightest the light gets before attenuation
+    GLfloat intensity = glm::max(colour.x, glm::max(colour.y, colour.z)) * (ambientIntensity + diffuseIntensity);
+
+    if(intensity <= 0.0f) {
+        return 0.0f;
+    }
+
+    // Solving exponent * d^2 + linear * d + constant = intensity / cutoff for d
+    GLfloat target = intensity / LIGHT_ATTENUATION_CUTOFF - constant;
+
+    if(target <= 0.0f) {
+        return 0.0f;
+    }
+
+    GLfloat range = LIGHT_MAX_RANGE;
+
+    if(exponent > 0.0f) {
+        range = (-linear + glm::sqrt(linear * linear + 4.0f * exponent * target)) / (2.0f * exponent);
+    }
+
+    else if(linear > 0.0f) {
+        range = target / linear;
+    }
+
+    return glm::min(range, LIGHT_MAX_RANGE);
+}
+
+void PointLight::fillBlock(ClusterLightBlock& block) const {
+    // Ambient Light
+    block.colour = colour;
+    block.ambientIntensity = ambientIntensity;
+
+    // Diffuse Light
+    block.diffuseIntensity = diffuseIntensity;
+
+    // Point Light - Lights every direction
+    block.position = position;
+    block.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    block.edge = POINT_LIGHT_EDGE;
+
+    // Attenuation Factor
+    block.constant = constant;
+    block.linear = linear;
+    block.exponent = exponent;
+    block.range = calculateRange();
+}
+
 PointLight::~PointLight() {
 }
@@ -6,6 +6,8 @@ Shader::Shader() {
     uniformModel = 0;
     uniformProjection = 0;
     uniformView = 0;
+    uniformIsIndirect = 0;
+    uniformLightInstance = 0;
 
     pointLightCount = 0;
     spotLightCount = 0;
@@ -55,6 +57,8 @@ void Shader::compileProgram() {
     uniformProjection = glGetUniformLocation(shaderID, "projection");
     uniformView = glGetUniformLocation(shaderID, "view");
     uniformModel = glGetUniformLocation(shaderID, "model");
+    uniformIsIndirect = glGetUniformLocation(shaderID, "isIndirect");
+    uniformLightInstance = glGetUniformLocation(shaderID, "lightInstance");
 
     // For switching shading models
     uniformshadingModel = glGetUniformLocation(shaderID, "shadingModel");
@@ -384,6 +388,14 @@ GLuint Shader::getFresnelReflectance() {
     return uniformFresnelReflectance;
 }
 
+GLuint Shader::getIsIndirectLocation() {
+    return uniformIsIndirect;
+}
+
+GLuint Shader::getLightInstanceLocation() {
+    return uniformLightInstance;
+}
+
 GLuint Shader::getDispersionLocation() {
     return uniformDispersion;
 }
@@ -450,7 +462,7 @@ void Shader::setSpotLight(SpotLight * sLight, unsigned int lightCount) {
 
 void Shader::useShader() {
     if(shaderID) {
-        glUseProgram(shaderID);
+        glState.useProgram(shaderID);
     }
 
     else {
@@ -460,6 +472,7 @@ void Shader::useShader() {
 
 void Shader::cleanShader() {
     if(shaderID) {
+        glState.forgetProgram(shaderID);
         glDeleteProgram(shaderID);
         shaderID = 0;
     }
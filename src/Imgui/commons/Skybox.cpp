@@ -29,11 +29,14 @@ Skybox::Skybox(std::vector<std::string> faceLocations) {
 
     // Texture setup
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, bitDepth;
 
-    for(size_t i = 0; i < 6; i++) {
+    // Compressed faces with their mips, or the images as they are
+    bool isCooked = loadCookedFaces(faceLocations);
+
+    for(size_t i = 0; i < 6 && !isCooked; i++) {
         unsigned char *texData = stbi_load(faceLocations[i].c_str(), &width, &height, &bitDepth, 0);
         if(!texData) {
             printf("Failed to load: %s\n", faceLocations[i].c_str());
@@ -59,7 +62,7 @@ Skybox::Skybox(std::vector<std::string> faceLocations) {
     }
 
     // For zooming out - Minify
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, isCooked ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     // For zooming in - Magnify
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     // Setting parameter values
@@ -205,6 +208,39 @@ void Skybox::loadDefaultSkyboxes() {
     defaultSkyboxes.push_back(std::move(skyboxPtr));
 }
 
+bool Skybox::loadCookedFaces(const std::vector<std::string>& faceLocations) {
+    std::vector<KTX2Image> faces(6);
+
+    for(size_t i = 0; i < 6; i++) {
+        std::string cookedPath = TextureCooker::getCookedPath(faceLocations[i]);
+
+        if(!std::filesystem::exists(cookedPath) || !TextureCooker::loadKTX2(cookedPath, faces[i]) || !faces[i].getGLFormat()) {
+            return false;
+        }
+
+        // Every face of a cube map has the same size, format and levels
+        if(faces[i].vkFormat != faces[0].vkFormat || faces[i].width != faces[0].width || faces[i].height != faces[0].height ||
+           faces[i].levelCount != faces[0].levelCount || faces[i].faceCount != 1) {
+            printf("Cooked skybox faces don't match: %s\n", cookedPath.c_str());
+            return false;
+        }
+    }
+
+    GLenum format = faces[0].getGLFormat();
+
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, faces[0].levelCount, format, faces[0].width, faces[0].height);
+
+    for(size_t i = 0; i < 6; i++) {
+        for(GLuint level = 0; level < faces[i].levelCount; level++) {
+            glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i), level, 0, 0,
+                                      std::max(faces[i].width >> level, 1), std::max(faces[i].height >> level, 1), format,
+                                      static_cast<GLsizei>(faces[i].levelSizes[level]), faces[i].data.data() + faces[i].levelOffsets[level]);
+        }
+    }
+
+    return true;
+}
+
 void Skybox::drawSkybox(glm::mat4 viewMatrix, glm::mat4 projectionMatrix) {
     // Removing the Transform values from mat4 by converting into mat3
     // Keeping only Translation and Rotation
@@ -219,8 +255,7 @@ void Skybox::drawSkybox(glm::mat4 viewMatrix, glm::mat4 projectionMatrix) {
     glUniformMatrix4fv(uniformProjection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
     glUniformMatrix4fv(uniformView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
     skyShader->validate();
 
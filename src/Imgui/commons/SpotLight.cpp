@@ -50,6 +50,21 @@ void SpotLight::useLight(   GLuint ambientIntensityLocation, GLuint ambientColou
     glUniform1f(edgeLocation, processedEdge);
 }
 
+void SpotLight::fillBlock(ClusterLightBlock& block) const {
+    PointLight::fillBlock(block);
+
+    // Turned off spot lights don't light anything, a range of 0 keeps them out of every cluster
+    if(!isOn) {
+        block.ambientIntensity = 0.0f;
+        block.diffuseIntensity = 0.0f;
+        block.range = 0.0f;
+    }
+
+    // SpotLight Factors
+    block.direction = direction;
+    block.edge = processedEdge;
+}
+
 void SpotLight::setFlash(glm::vec3 pos, glm::vec3 dir) {
     position = pos;
     direction = dir;
@@ -6,6 +6,8 @@ Texture::Texture() {
     height = 0;
     bitDepth = 0;
     filePath = "";
+    streamer = nullptr;
+    streamID = 0;
 }
 
 Texture::Texture(const char* fileLoc) {
@@ -14,6 +16,8 @@ Texture::Texture(const char* fileLoc) {
     height = 0;
     bitDepth = 0;
     filePath = fileLoc;
+    streamer = nullptr;
+    streamID = 0;
 }
 
 void Texture::printTextureInfo() {
@@ -22,62 +26,124 @@ void Texture::printTextureInfo() {
     printf("File Path : %s", filePath);
 }
 
-// Load Textures based on channels
-bool Texture::loadTexture() {
-    unsigned char *texData = stbi_load(filePath, &width, &height, &bitDepth, 0);
-    if(!texData) {
-        printf("Failed to load: %s\n", filePath);
+bool Texture::loadCookedTexture() {
+    std::string cookedPath = TextureCooker::getCookedPath(filePath);
+
+    if(!std::filesystem::exists(cookedPath)) {
+        return false;
+    }
+
+    KTX2Image image;
+
+    if(!TextureCooker::loadKTX2(cookedPath, image) || image.faceCount != 1 || !image.getGLFormat()) {
+        printf("Failed to load cooked texture: %s\n", cookedPath.c_str());
         return false;
     }
 
+    width = image.width;
+    height = image.height;
+    bitDepth = image.getGLFormat() == GL_COMPRESSED_RG_RGTC2 ? 2 : 4;
+
+    GLenum format = image.getGLFormat();
+
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
 
     // Setting parameter values
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // For zooming out - Minify
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    // For zooming in - Magnify
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Change the RGB type based off of your image
-    // RGB - 3 channels
-    if(bitDepth == 3) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texData);
+    glTexStorage2D(GL_TEXTURE_2D, image.levelCount, format, width, height);
+
+    for(GLuint level = 0; level < image.levelCount; level++) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, std::max(width >> level, 1), std::max(height >> level, 1), format,
+                                  static_cast<GLsizei>(image.levelSizes[level]), image.data.data() + image.levelOffsets[level]);
+    }
+
+    // Unbinding Texture
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+void Texture::uploadMipChain(const MipChain& mips, GLuint levelCount) {
+    // RGB files stay RGB8 on the GPU, the driver drops the alpha of the RGBA levels
+    GLenum internalFormat = bitDepth == 2 || bitDepth == 4 ? GL_RGBA8 : GL_RGB8;
+
+    glTexStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, width, height);
+
+    for(GLuint level = 0; level < levelCount; level++) {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mips.getLevelWidth(level), mips.getLevelHeight(level), GL_RGBA, GL_UNSIGNED_BYTE,
+                        mips.getLevel(level));
     }
+}
 
-    // RGBA - 4 channels
-    else if(bitDepth == 4) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData);
+// Load Textures based on channels
+bool Texture::loadTexture() {
+    // Cooked files need no decoding and no mips
+    if(loadCookedTexture()) {
+        return true;
     }
 
-    else {
-            printf("The texture has %i channels, unable to load!", bitDepth);
+    // Always decoded as RGBA so every level of the chain has 4 byte texels, bitDepth keeps the channels of the file
+    unsigned char *texData = stbi_load(filePath, &width, &height, &bitDepth, 4);
+    if(!texData) {
+        printf("Failed to load: %s\n", filePath);
+        return false;
     }
 
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // Mips filtered in the space the file needs (Linear light for colour, renormalized normals) instead of glGenerateMipmap
+    MipSettings settings;
+    settings.content = MipChain::chooseContent(filePath);
 
-    // Unbinding Texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    MipChain mips;
+    mips.build(texData, width, height, settings);
 
     // We have already copied the data
     stbi_image_free(texData);
 
+    glGenTextures(1, &textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
+
+    // Setting parameter values
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // For zooming out - Minify
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    // For zooming in - Magnify
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    uploadMipChain(mips, mips.getLevelCount());
+
+    // Unbinding Texture
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
+
     return true;
 }
 
 // Choosing different types of loading
 bool Texture::loadTexture(int choice) {
-    unsigned char *texData = stbi_load(filePath, &width, &height, &bitDepth, 0);
+    unsigned char *texData = stbi_load(filePath, &width, &height, &bitDepth, 4);
     if(!texData) {
         printf("Failed to load: %s\n", filePath);
         return false;
     }
 
+    MipSettings settings;
+    settings.content = MipChain::chooseContent(filePath);
+
+    // Choice 1 samples without mips, only level 0 is uploaded
+    MipChain mips;
+    mips.build(texData, width, height, settings);
+
+    // We have already copied the data
+    stbi_image_free(texData);
+
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
 
     // Setting parameter values
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -122,43 +188,60 @@ bool Texture::loadTexture(int choice) {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
 
-    // Change the RGB type based off of your image
-    // RGB - 3 channels
-    if(bitDepth == 3) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texData);
-    }
+    // Debugging
+    // printf("Using MIP Map\n");
+    uploadMipChain(mips, choice == 1 ? 1 : mips.getLevelCount());
 
-    // RGBA - 4 channels
-    else if(bitDepth == 4) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData);
-    }
+    // Unbinding Texture
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
 
-    else {
-            printf("The texture has %i channels, unable to load!", bitDepth);
+    return true;
+}
+
+bool Texture::loadTextureStreamed(TextureStreamer* textureStreamer, const glm::u8vec4& placeholder) {
+    // Cooked files are small and ready to upload, nothing to stream
+    if(loadCookedTexture()) {
+        return true;
     }
 
-    if(choice != 1) {
-        // Debugging
-        // printf("Using MIP Map\n");
-        glGenerateMipmap(GL_TEXTURE_2D);
+    // Header only, the pixels are decoded by the workers of the streamer
+    if(!stbi_info(filePath, &width, &height, &bitDepth)) {
+        printf("Failed to load: %s\n", filePath);
+        return false;
     }
 
+    GLuint levelCount = MipChain::getLevelCount(width, height);
+
+    glGenTextures(1, &textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
+
+    // Setting parameter values
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Every channel count is streamed as RGBA, only the 1x1 level has something in it until the tail is uploaded
+    glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, width, height);
+    glTexSubImage2D(GL_TEXTURE_2D, levelCount - 1, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelCount - 1);
+
     // Unbinding Texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
 
-    // We have already copied the data
-    stbi_image_free(texData);
+    streamer = textureStreamer;
+    streamID = streamer->requestTexture(textureID, filePath, width, height, levelCount);
 
     return true;
 }
 
 unsigned char* Texture::generateNoise() {
-    // Assuming you want RGB values, adjust as needed
+    // RGBA for the mip chain, channels past bitDepth stay opaque
     int channels = bitDepth;
-    unsigned char* texData = new unsigned char[width * height * channels];
+    unsigned char* texData = new unsigned char[width * height * 4];
 
-    for (int i = 0; i < width * height * channels; ++i) {
-        texData[i] = rand() % 256; // Generate random values between 0 and 255
+    for (int i = 0; i < width * height * 4; ++i) {
+        texData[i] = i % 4 < channels ? rand() % 256 : 255; // Generate random values between 0 and 255
     }
 
     return texData;
@@ -173,7 +256,7 @@ bool Texture::generateRandomTexture(GLuint w, GLuint h, GLuint d) {
     unsigned char *texData = generateNoise();
 
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
 
     // Setting parameter values
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -187,38 +270,133 @@ bool Texture::generateRandomTexture(GLuint w, GLuint h, GLuint d) {
     // For zooming in - Magnify
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Change the RGB type based off of your image
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texData);
-
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // Noise is data, filtered as it is
+    MipSettings settings;
+    settings.content = MIP_CONTENT_LINEAR;
 
-    // Unbinding Texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    MipChain mips;
+    mips.build(texData, width, height, settings);
 
     // We have already copied the data
     delete[] texData;
 
+    uploadMipChain(mips, mips.getLevelCount());
+
+    // Unbinding Texture
+    glState.bindTexture(0, GL_TEXTURE_2D, 0);
+
     // Debugging
     printf("Generated Noise Texture successfully!");
 
     return true;
 }
 
+void Texture::benchmarkMipChain(int size, int iterations) {
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<int> texel(0, 255);
+
+    // Noise is the worst case for the filters, every tap reads a different value
+    std::vector<unsigned char> image(size_t(size) * size * 4);
+
+    for(unsigned char& value : image) {
+        value = static_cast<unsigned char>(texel(generator));
+    }
+
+    JobSystem jobSystem;
+    jobSystem.createWorkers();
+
+    const char* filterNames[] = { "Box", "Kaiser", "Lanczos" };
+    double buildTimes[3][2] = {};
+
+    MipChain mips;
+
+    for(int filter = 0; filter < 3; filter++) {
+        MipSettings settings;
+        settings.filter = static_cast<MipFilter>(filter);
+
+        for(int i = 0; i < iterations; i++) {
+            for(int threaded = 0; threaded < 2; threaded++) {
+                auto start = std::chrono::high_resolution_clock::now();
+                mips.build(image.data(), size, size, settings, threaded ? &jobSystem : nullptr);
+                auto end = std::chrono::high_resolution_clock::now();
+
+                buildTimes[filter][threaded] += std::chrono::duration<double, std::milli>(end - start).count();
+            }
+        }
+    }
+
+    // Same storage both ways, only where the mips come from differs - glFinish so the driver can't defer the work
+    GLuint levelCount = MipChain::getLevelCount(size, size);
+    double driverTime = 0.0, uploadTime = 0.0;
+
+    MipSettings settings;
+    settings.filter = MIP_FILTER_BOX;
+    mips.build(image.data(), size, size, settings, &jobSystem);
+
+    for(int i = 0; i < iterations; i++) {
+        GLuint textures[2];
+        glGenTextures(2, textures);
+
+        glFinish();
+        auto start = std::chrono::high_resolution_clock::now();
+
+        glState.bindTexture(0, GL_TEXTURE_2D, textures[0]);
+        glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, size, size);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+
+        auto driverDone = std::chrono::high_resolution_clock::now();
+
+        glState.bindTexture(0, GL_TEXTURE_2D, textures[1]);
+        glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, size, size);
+
+        for(GLuint level = 0; level < levelCount; level++) {
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mips.getLevelWidth(level), mips.getLevelHeight(level), GL_RGBA, GL_UNSIGNED_BYTE,
+                            mips.getLevel(level));
+        }
+
+        glFinish();
+        auto uploadDone = std::chrono::high_resolution_clock::now();
+
+        driverTime += std::chrono::duration<double, std::milli>(driverDone - start).count();
+        uploadTime += std::chrono::duration<double, std::milli>(uploadDone - driverDone).count();
+
+        glState.bindTexture(0, GL_TEXTURE_2D, 0);
+        glDeleteTextures(2, textures);
+    }
+
+    printf("Mip Chain - %i x %i, %u levels, %i iterations, %zu threads\n", size, size, levelCount, iterations, jobSystem.getThreadCount());
+    printf("%18s %14s %14s\n", "Filter", "Single ms", "Job system ms");
+
+    for(int filter = 0; filter < 3; filter++) {
+        printf("%18s %14.3f %14.3f\n", filterNames[filter], buildTimes[filter][0] / iterations, buildTimes[filter][1] / iterations);
+    }
+
+    printf("%18s %14.3f ms (Level 0 upload + glGenerateMipmap)\n", "Driver mips", driverTime / iterations);
+    printf("%18s %14.3f ms (Every level uploaded, build time above not included)\n", "CPU mips upload", uploadTime / iterations);
+}
+
 // Default Texture Unit
 void Texture::useTexture() {
     // Texture Unit
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
 }
 
 // Manually setting the Texture Unit
 void Texture::useTexture(int textureUnit) {
-    // Texture Unit - Incrementing it based on an integer
-    glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(textureUnit));
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    // Texture Unit - Incrementing it based on an integer, skipped if the texture is already bound there
+    glState.bindTexture(static_cast<GLuint>(textureUnit), GL_TEXTURE_2D, textureID);
 }
 
 void Texture::cleanTexture() {
+    // Nothing left to upload into
+    if(streamer) {
+        streamer->cancelTexture(streamID);
+        streamer = nullptr;
+    }
+
+    glState.forgetTexture(textureID);
     glDeleteTextures(1, &textureID);
     textureID = 0;
     width = 0;
@@ -1,5 +1,6 @@
 #include <iostream>
 #include "Window.h"
+#include "GLCallCounter.h"
 
 Window::Window() {
     width = 800;
@@ -76,6 +77,9 @@ int Window::initialize() {
         return -1;
     }
 
+    // Counting the GL calls of every frame for the stats
+    installGLCallCounters();
+
     // Enabling Depth Buffer
     glEnable(GL_DEPTH_TEST);
 
@@ -0,0 +1,195 @@
+#include "frustumCulling.h"
+
+// SIMD intrinsics - SSE is always there on x64, the AVX loop is picked at runtime
+#include <immintrin.h>
+
+// MSVC compiles AVX intrinsics without /arch, GCC and Clang need the target on the function itself - A whole file built with
+// /arch:AVX or -mavx could use AVX anywhere in it, which the runtime check can't guard
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CULLING_TARGET_AVX
+#else
+#define CULLING_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+void AABBList::clear() {
+    minX.clear();
+    minY.clear();
+    minZ.clear();
+    maxX.clear();
+    maxY.clear();
+    maxZ.clear();
+    count = 0;
+}
+
+void AABBList::addBox(const AABB& box) {
+    // Adding a new batch of padding once the last one is used up
+    if(count == minX.size()) {
+        size_t paddedCount = count + CULLING_BATCH_SIZE;
+
+        minX.resize(paddedCount, 0.0f);
+        minY.resize(paddedCount, 0.0f);
+        minZ.resize(paddedCount, 0.0f);
+        maxX.resize(paddedCount, 0.0f);
+        maxY.resize(paddedCount, 0.0f);
+        maxZ.resize(paddedCount, 0.0f);
+    }
+
+    minX[count] = box.min.x;
+    minY[count] = box.min.y;
+    minZ[count] = box.min.z;
+    maxX[count] = box.max.x;
+    maxY[count] = box.max.y;
+    maxZ[count] = box.max.z;
+
+    count++;
+}
+
+AABB transformAABB(const AABB& box, const glm::mat4& transform) {
+    glm::vec3 center = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+    glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+    glm::vec3 newExtent(0.0f);
+
+    // Each axis of the new box gets the absolute contribution of every old axis
+    for(int column = 0; column < 3; column++) {
+        newExtent += glm::abs(glm::vec3(transform[column])) * extent[column];
+    }
+
+    return { newCenter - newExtent, newCenter + newExtent };
+}
+
+bool isAABBInFrustum(const Frustum& frustum, const AABB& box) {
+    for(const glm::vec4& plane : frustum.planes) {
+        // Corner of the box furthest along the plane normal
+        glm::vec3 corner( plane.x >= 0.0f ? box.max.x : box.min.x,
+                          plane.y >= 0.0f ? box.max.y : box.min.y,
+                          plane.z >= 0.0f ? box.max.z : box.min.z );
+
+        if(glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// AVX, and an OS that saves the YMM registers
+static bool hasAVX() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+
+    bool hasAVX = (info[2] & (1 << 28)) != 0;
+    bool hasOSXSAVE = (info[2] & (1 << 27)) != 0;
+
+    return hasAVX && hasOSXSAVE && (_xgetbv(0) & 6) == 6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+// Batches [first, last) against a single frustum, the corners are picked per plane - 8 boxes at a time
+static CULLING_TARGET_AVX void cullBatchesAVX(const Frustum& frustum, const float* const* cornerX, const float* const* cornerY,
+                                              const float* const* cornerZ, size_t first, size_t last, unsigned char* visible) {
+    for(size_t i = first; i < last; i += CULLING_BATCH_SIZE) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for(int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(frustum.planes[p].x), _mm256_loadu_ps(cornerX[p] + i)),
+                                            _mm256_mul_ps(_mm256_set1_ps(frustum.planes[p].y), _mm256_loadu_ps(cornerY[p] + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(frustum.planes[p].z), _mm256_loadu_ps(cornerZ[p] + i)));
+            distance = _mm256_add_ps(distance, _mm256_set1_ps(frustum.planes[p].w));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+
+        // Visible in any of the frustums
+        for(size_t j = 0; j < CULLING_BATCH_SIZE; j++) {
+            visible[i + j] |= (mask >> j) & 1;
+        }
+    }
+}
+
+// Same with two halves of 4 boxes per batch
+static void cullBatchesSSE(const Frustum& frustum, const float* const* cornerX, const float* const* cornerY,
+                           const float* const* cornerZ, size_t first, size_t last, unsigned char* visible) {
+    for(size_t i = first; i < last; i += CULLING_BATCH_SIZE) {
+        int mask = 0;
+
+        for(size_t half = 0; half < CULLING_BATCH_SIZE; half += 4) {
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for(int p = 0; p < 6; p++) {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.planes[p].x), _mm_loadu_ps(cornerX[p] + i + half)),
+                                             _mm_mul_ps(_mm_set1_ps(frustum.planes[p].y), _mm_loadu_ps(cornerY[p] + i + half)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(frustum.planes[p].z), _mm_loadu_ps(cornerZ[p] + i + half)));
+                distance = _mm_add_ps(distance, _mm_set1_ps(frustum.planes[p].w));
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+            }
+
+            mask |= _mm_movemask_ps(inside) << half;
+        }
+
+        for(size_t j = 0; j < CULLING_BATCH_SIZE; j++) {
+            visible[i + j] |= (mask >> j) & 1;
+        }
+    }
+}
+
+void cullAABBs(const Frustum& frustum, const AABBList& boxes, std::vector<unsigned char>& visible, CullingStats& stats) {
+    visible.resize(boxes.getPaddedCount());
+
+    cullAABBs(frustum, boxes, 0, boxes.count, visible, stats);
+}
+
+void cullAABBs(const Frustum& frustum, const AABBList& boxes, size_t first, size_t count, std::vector<unsigned char>& visible, CullingStats& stats) {
+    cullAABBs(&frustum, 1, boxes, first, count, visible, stats);
+}
+
+void cullAABBs(const Frustum* frustums, size_t frustumCount, const AABBList& boxes, size_t first, size_t count,
+               std::vector<unsigned char>& visible, CullingStats& stats) {
+    static const bool isAVX = hasAVX();
+
+    // Whole batches, the padding of the list covers the last one
+    size_t last = std::min(first + count, boxes.count);
+    size_t paddedLast = std::min((last + CULLING_BATCH_SIZE - 1) / CULLING_BATCH_SIZE * CULLING_BATCH_SIZE, boxes.getPaddedCount());
+
+    for(size_t i = first; i < paddedLast; i++) {
+        visible[i] = 0;
+    }
+
+    for(size_t f = 0; f < frustumCount; f++) {
+        const Frustum& frustum = frustums[f];
+
+        // The corner furthest along each plane normal only depends on the signs of the normal, so it is picked once per plane
+        const float* cornerX[6];
+        const float* cornerY[6];
+        const float* cornerZ[6];
+
+        for(int p = 0; p < 6; p++) {
+            cornerX[p] = frustum.planes[p].x >= 0.0f ? boxes.maxX.data() : boxes.minX.data();
+            cornerY[p] = frustum.planes[p].y >= 0.0f ? boxes.maxY.data() : boxes.minY.data();
+            cornerZ[p] = frustum.planes[p].z >= 0.0f ? boxes.maxZ.data() : boxes.minZ.data();
+        }
+
+        if(isAVX) {
+            cullBatchesAVX(frustum, cornerX, cornerY, cornerZ, first, paddedLast, visible.data());
+        }
+
+        else {
+            cullBatchesSSE(frustum, cornerX, cornerY, cornerZ, first, paddedLast, visible.data());
+        }
+    }
+
+    // Padding is not counted
+    stats.tested += last > first ? last - first : 0;
+
+    for(size_t i = first; i < last; i++) {
+        stats.culled += !visible[i];
+    }
+}
@@ -0,0 +1,329 @@
+#include "meshSimplify.h"
+
+// Symmetric 4x4 matrix of the plane equations, only the upper triangle is stored
+// Doubles since the sums of squares get large quickly
+struct Quadric {
+    double a00, a01, a02, a03;
+    double a11, a12, a13;
+    double a22, a23;
+    double a33;
+};
+
+// Collapsing the edge from -> to
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+static Quadric planeQuadric(const glm::dvec3& normal, double distance) {
+    return { normal.x * normal.x, normal.x * normal.y, normal.x * normal.z, normal.x * distance,
+             normal.y * normal.y, normal.y * normal.z, normal.y * distance,
+             normal.z * normal.z, normal.z * distance,
+             distance * distance };
+}
+
+static void addQuadric(Quadric& q, const Quadric& r) {
+    q.a00 += r.a00; q.a01 += r.a01; q.a02 += r.a02; q.a03 += r.a03;
+    q.a11 += r.a11; q.a12 += r.a12; q.a13 += r.a13;
+    q.a22 += r.a22; q.a23 += r.a23;
+    q.a33 += r.a33;
+}
+
+// Sum of squared distances from p to all the planes in the quadric
+static double evaluateQuadric(const Quadric& q, const glm::dvec3& p) {
+    double result = q.a00 * p.x * p.x + 2.0 * q.a01 * p.x * p.y + 2.0 * q.a02 * p.x * p.z + 2.0 * q.a03 * p.x
+                  + q.a11 * p.y * p.y + 2.0 * q.a12 * p.y * p.z + 2.0 * q.a13 * p.y
+                  + q.a22 * p.z * p.z + 2.0 * q.a23 * p.z
+                  + q.a33;
+
+    // Precision issues can make it slightly negative
+    return result > 0.0 ? result : 0.0;
+}
+
+// Checking if moving the vertex from -> to flips any of the remaining triangles around it
+static bool flipsTriangles(const std::vector<glm::dvec3>& positions, const std::vector<unsigned int>& indices,
+                           const std::vector<unsigned int>& adjacency, unsigned int begin, unsigned int end,
+                           unsigned int from, unsigned int to) {
+    for(unsigned int i = begin; i < end; i++) {
+        const unsigned int* tri = &indices[adjacency[i] * 3];
+
+        // These triangles become degenerate and are removed
+        if(tri[0] == to || tri[1] == to || tri[2] == to) {
+            continue;
+        }
+
+        glm::dvec3 a = positions[tri[0]], b = positions[tri[1]], c = positions[tri[2]];
+        glm::dvec3 before = glm::cross(b - a, c - a);
+
+        if(tri[0] == from) a = positions[to];
+        if(tri[1] == from) b = positions[to];
+        if(tri[2] == from) c = positions[to];
+
+        glm::dvec3 after = glm::cross(b - a, c - a);
+
+        if(glm::dot(before, after) <= 0.0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+float simplifyMesh(const std::vector<float>& vertices, unsigned int vertexLength, const std::vector<unsigned int>& indices,
+                   size_t targetIndexCount, float maxError, std::vector<unsigned int>& result) {
+    result = indices;
+
+    size_t vertexCount = vertices.size() / vertexLength;
+
+    if(vertexCount == 0 || indices.size() <= targetIndexCount) {
+        return 0.0f;
+    }
+
+    std::vector<glm::dvec3> positions(vertexCount);
+
+    for(size_t i = 0; i < vertexCount; i++) {
+        positions[i] = glm::dvec3(vertices[i * vertexLength], vertices[i * vertexLength + 1], vertices[i * vertexLength + 2]);
+    }
+
+    // Welding vertices by position, so that seams and borders can be found
+    std::vector<unsigned int> sorted(vertexCount);
+    for(size_t i = 0; i < vertexCount; i++) {
+        sorted[i] = i;
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [&positions](unsigned int a, unsigned int b) {
+        if(positions[a].x != positions[b].x) return positions[a].x < positions[b].x;
+        if(positions[a].y != positions[b].y) return positions[a].y < positions[b].y;
+        return positions[a].z < positions[b].z;
+    });
+
+    std::vector<unsigned int> positionID(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+
+    for(size_t i = 0; i < vertexCount; ) {
+        size_t j = i + 1;
+        while(j < vertexCount && positions[sorted[j]] == positions[sorted[i]]) {
+            j++;
+        }
+
+        for(size_t k = i; k < j; k++) {
+            positionID[sorted[k]] = sorted[i];
+
+            // More than one vertex at this position - UV or Normal seam
+            locked[sorted[k]] = (j - i) > 1;
+        }
+
+        i = j;
+    }
+
+    // Border edges only have a single triangle, locking their vertices
+    std::vector<std::pair<unsigned int, unsigned int>> edges;
+    edges.reserve(indices.size());
+
+    for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+        for(int e = 0; e < 3; e++) {
+            unsigned int a = positionID[indices[i + e]], b = positionID[indices[i + (e + 1) % 3]];
+            edges.push_back({ std::min(a, b), std::max(a, b) });
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    for(size_t i = 0; i < edges.size(); ) {
+        size_t j = i + 1;
+        while(j < edges.size() && edges[j] == edges[i]) {
+            j++;
+        }
+
+        if(j - i == 1) {
+            locked[edges[i].first] = true;
+            locked[edges[i].second] = true;
+        }
+
+        i = j;
+    }
+
+    // Propagating the lock to every vertex at a locked position
+    for(size_t i = 0; i < vertexCount; i++) {
+        if(locked[positionID[i]]) {
+            locked[i] = true;
+        }
+    }
+
+    // Quadrics of the triangle planes around each vertex
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+
+    for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::dvec3& a = positions[indices[i]];
+        const glm::dvec3& b = positions[indices[i + 1]];
+        const glm::dvec3& c = positions[indices[i + 2]];
+
+        glm::dvec3 normal = glm::cross(b - a, c - a);
+        double length = glm::length(normal);
+
+        // Degenerate triangle
+        if(length <= 0.0) {
+            continue;
+        }
+
+        normal /= length;
+
+        Quadric q = planeQuadric(normal, -glm::dot(normal, a));
+
+        addQuadric(quadrics[indices[i]], q);
+        addQuadric(quadrics[indices[i + 1]], q);
+        addQuadric(quadrics[indices[i + 2]], q);
+    }
+
+    double maxCost = double(maxError) * double(maxError);
+    double worstCost = 0.0;
+
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+
+    // Each pass collapses a set of independent edges, cheapest first
+    while(result.size() > targetIndexCount) {
+        collapses.clear();
+
+        for(size_t i = 0; i + 2 < result.size(); i += 3) {
+            for(int e = 0; e < 3; e++) {
+                unsigned int a = result[i + e], b = result[i + (e + 1) % 3];
+
+                Quadric q = quadrics[a];
+                addQuadric(q, quadrics[b]);
+
+                // Picking the cheaper direction that is allowed
+                double costAB = locked[a] ? -1.0 : evaluateQuadric(q, positions[b]);
+                double costBA = locked[b] ? -1.0 : evaluateQuadric(q, positions[a]);
+
+                if(costAB >= 0.0 && (costBA < 0.0 || costAB <= costBA)) {
+                    collapses.push_back({ a, b, costAB });
+                }
+
+                else if(costBA >= 0.0) {
+                    collapses.push_back({ b, a, costBA });
+                }
+            }
+        }
+
+        if(collapses.empty()) {
+            break;
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.cost < b.cost;
+        });
+
+        // Triangles around each vertex, stored in a single array
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+
+        for(size_t i = 0; i < result.size(); i++) {
+            adjacencyOffsets[result[i] + 1]++;
+        }
+
+        for(size_t i = 0; i < vertexCount; i++) {
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        }
+
+        adjacency.resize(result.size());
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+        for(size_t i = 0; i < result.size(); i++) {
+            adjacency[fill[result[i]]++] = i / 3;
+        }
+
+        for(size_t i = 0; i < vertexCount; i++) {
+            remap[i] = i;
+        }
+
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+        size_t trianglesRemoved = 0;
+        size_t collapseCount = 0;
+
+        for(const Collapse& collapse : collapses) {
+            // Sorted, so nothing cheaper is left
+            if(collapse.cost > maxCost) {
+                break;
+            }
+
+            if(touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            unsigned int begin = adjacencyOffsets[collapse.from], end = adjacencyOffsets[collapse.from + 1];
+
+            if(flipsTriangles(positions, result, adjacency, begin, end, collapse.from, collapse.to)) {
+                continue;
+            }
+
+            // Locking the ring around the collapse, so the flip check stays valid for the rest of the pass
+            for(unsigned int i = begin; i < end; i++) {
+                const unsigned int* tri = &result[adjacency[i] * 3];
+
+                touched[tri[0]] = true;
+                touched[tri[1]] = true;
+                touched[tri[2]] = true;
+
+                if(tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+                    trianglesRemoved++;
+                }
+            }
+
+            remap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            worstCost = std::max(worstCost, collapse.cost);
+            collapseCount++;
+
+            if(trianglesRemoved >= trianglesToRemove) {
+                break;
+            }
+        }
+
+        // Can't simplify any further within the error limit
+        if(collapseCount == 0) {
+            break;
+        }
+
+        // Rewriting the triangles, removing the degenerate ones
+        size_t write = 0;
+
+        for(size_t i = 0; i + 2 < result.size(); i += 3) {
+            unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+
+            if(a == b || b == c || a == c) {
+                continue;
+            }
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+
+        result.resize(write);
+    }
+
+    return float(std::sqrt(worstCost));
+}
+
+void compactVertices(const std::vector<float>& vertices, unsigned int vertexLength, std::vector<unsigned int>& indices,
+                     std::vector<float>& result) {
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size() / vertexLength, unused);
+
+    result.clear();
+
+    for(unsigned int& index : indices) {
+        if(remap[index] == unused) {
+            remap[index] = result.size() / vertexLength;
+            result.insert(result.end(), vertices.begin() + index * vertexLength, vertices.begin() + (index + 1) * vertexLength);
+        }
+
+        index = remap[index];
+    }
+}
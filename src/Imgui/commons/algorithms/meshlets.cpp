@@ -0,0 +1,153 @@
+#include "meshlets.h"
+
+// Filling in the bounding sphere and the normal cone of the triangles in [first, first + count)
+static void computeBounds(const std::vector<float>& vertices, unsigned int vertexLength, const std::vector<unsigned int>& indices,
+                          Meshlet& meshlet) {
+    auto position = [&](unsigned int index) {
+        return glm::vec3(vertices[index * vertexLength], vertices[index * vertexLength + 1], vertices[index * vertexLength + 2]);
+    };
+
+    unsigned int first = meshlet.firstIndex, last = meshlet.firstIndex + meshlet.indexCount;
+
+    // Sphere around the center of the bounding box, not the tightest but good enough for culling
+    glm::vec3 minimum = position(indices[first]), maximum = minimum;
+
+    for(unsigned int i = first; i < last; i++) {
+        minimum = glm::min(minimum, position(indices[i]));
+        maximum = glm::max(maximum, position(indices[i]));
+    }
+
+    meshlet.center = (minimum + maximum) * 0.5f;
+    meshlet.radius = 0.0f;
+
+    for(unsigned int i = first; i < last; i++) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(position(indices[i]) - meshlet.center));
+    }
+
+    // Normal cone - Average of the face normals, the cutoff covers the normal furthest away from the axis
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.indexCount / 3);
+
+    glm::vec3 axis(0.0f);
+
+    for(unsigned int i = first; i + 2 < last; i += 3) {
+        glm::vec3 a = position(indices[i]), b = position(indices[i + 1]), c = position(indices[i + 2]);
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+
+        // Degenerate triangles don't face anywhere
+        if(length <= 0.0f) {
+            continue;
+        }
+
+        normals.push_back(normal / length);
+        axis += normals.back();
+    }
+
+    float axisLength = glm::length(axis);
+
+    // Never culled by the cone test
+    meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneCutoff = 2.0f;
+
+    if(normals.empty() || axisLength <= 0.0f) {
+        return;
+    }
+
+    axis /= axisLength;
+
+    float minimumDot = 1.0f;
+    for(const glm::vec3& normal : normals) {
+        minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+    }
+
+    // Normals spread over more than a hemisphere, some triangle always faces the camera
+    if(minimumDot <= 0.0f) {
+        return;
+    }
+
+    // Every triangle faces away once the view direction is within 90 degrees - cone angle of the axis
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+}
+
+void buildMeshlets(const std::vector<float>& vertices, unsigned int vertexLength, const std::vector<unsigned int>& indices,
+                   std::vector<Meshlet>& meshlets) {
+    meshlets.clear();
+
+    size_t vertexCount = vertices.size() / vertexLength;
+
+    // Slot of each vertex in the current meshlet, used to count the unique vertices
+    const unsigned char unused = 0xff;
+    std::vector<unsigned char> slot(vertexCount, unused);
+    std::vector<unsigned int> meshletVertices;
+    meshletVertices.reserve(MESHLET_MAX_VERTICES);
+
+    Meshlet current = {};
+
+    auto finishMeshlet = [&]() {
+        if(current.indexCount == 0) {
+            return;
+        }
+
+        computeBounds(vertices, vertexLength, indices, current);
+        meshlets.push_back(current);
+
+        for(unsigned int vertex : meshletVertices) {
+            slot[vertex] = unused;
+        }
+
+        meshletVertices.clear();
+
+        current = {};
+        current.firstIndex = meshlets.back().firstIndex + meshlets.back().indexCount;
+    };
+
+    // Starting a new meshlet whenever the next triangle doesn't fit
+    for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+        unsigned int newVertices = 0;
+
+        for(int j = 0; j < 3; j++) {
+            newVertices += slot[indices[i + j]] == unused;
+        }
+
+        if(meshletVertices.size() + newVertices > MESHLET_MAX_VERTICES || current.indexCount / 3 + 1 > MESHLET_MAX_TRIANGLES) {
+            finishMeshlet();
+        }
+
+        for(int j = 0; j < 3; j++) {
+            if(slot[indices[i + j]] == unused) {
+                slot[indices[i + j]] = meshletVertices.size();
+                meshletVertices.push_back(indices[i + j]);
+            }
+        }
+
+        current.indexCount += 3;
+    }
+
+    finishMeshlet();
+}
+
+bool isMeshletVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& eyePosition, bool coneCulling, ClusterStats& stats) {
+    unsigned int triangles = meshlet.indexCount / 3;
+
+    stats.clusters++;
+    stats.triangles += triangles;
+
+    if(!isSphereInFrustum(frustum, meshlet.center, meshlet.radius)) {
+        stats.frustumCulledClusters++;
+        stats.frustumCulledTriangles += triangles;
+        return false;
+    }
+
+    // Conservative version of the cone test that accounts for the size of the cluster
+    glm::vec3 toCenter = meshlet.center - eyePosition;
+
+    if(coneCulling && glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius) {
+        stats.backfaceCulledClusters++;
+        stats.backfaceCulledTriangles += triangles;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,364 @@
+#include "occlusionCulling.h"
+
+// SSE intrinsics
+#include <immintrin.h>
+
+// Front faces of a box, counter clockwise seen from outside - Corner i has bit 0 set for max x, bit 1 for max y, bit 2 for max z
+static const int BOX_TRIANGLES[12][3] = {
+    { 1, 3, 7 }, { 1, 7, 5 },   // +X
+    { 0, 4, 6 }, { 0, 6, 2 },   // -X
+    { 2, 6, 7 }, { 2, 7, 3 },   // +Y
+    { 0, 1, 5 }, { 0, 5, 4 },   // -Y
+    { 4, 5, 7 }, { 4, 7, 6 },   // +Z
+    { 0, 2, 3 }, { 0, 3, 1 }    // -Z
+};
+
+void collectOccluders(const AABBList& boxes, unsigned int list, size_t first, size_t count, const Frustum& frustum,
+                      const glm::vec3& eyePosition, std::vector<OccluderCandidate>& candidates) {
+    size_t last = std::min(first + count, boxes.count);
+
+    for(size_t i = first; i < last; i++) {
+        AABB box = boxes.getBox(i);
+
+        glm::vec3 center = 0.5f * (box.min + box.max);
+        float radius = 0.5f * glm::length(box.max - box.min);
+        float distance = glm::length(center - eyePosition);
+
+        // Boxes around the eye would cross the near plane anyway
+        if(distance <= radius) {
+            continue;
+        }
+
+        float size = radius / distance;
+
+        if(size >= OCCLUDER_MIN_SIZE && isAABBInFrustum(frustum, box)) {
+            candidates.push_back({ size, list, static_cast<unsigned int>(i) });
+        }
+    }
+}
+
+void selectOccluders(std::vector<OccluderCandidate>& candidates, size_t maxCount) {
+    if(candidates.size() <= maxCount) {
+        return;
+    }
+
+    std::nth_element(candidates.begin(), candidates.begin() + maxCount, candidates.end(),
+                     [](const OccluderCandidate& a, const OccluderCandidate& b) { return a.size > b.size; });
+
+    candidates.resize(maxCount);
+}
+
+// Constructor
+OcclusionBuffer::OcclusionBuffer() {
+    viewProjection = glm::mat4(1.0f);
+
+    for(int width = OCCLUSION_BUFFER_WIDTH, height = OCCLUSION_BUFFER_HEIGHT; ; width /= 2, height /= 2) {
+        levels.emplace_back(std::max(width, 1) * std::max(height, 1), 1.0f);
+
+        if(width <= 1 && height <= 1) {
+            break;
+        }
+    }
+}
+
+void OcclusionBuffer::begin(const glm::mat4& viewProjectionMatrix) {
+    viewProjection = viewProjectionMatrix;
+    occluders.clear();
+}
+
+bool OcclusionBuffer::projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, ScreenBox& screenBox) const {
+    for(int i = 0; i < 8; i++) {
+        glm::vec3 corner(i & 1 ? boxMax.x : boxMin.x, i & 2 ? boxMax.y : boxMin.y, i & 4 ? boxMax.z : boxMin.z);
+        glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+
+        // Behind the near plane the projection flips, the box can't be used
+        if(clip.z < -clip.w || clip.w <= 0.0f) {
+            return false;
+        }
+
+        screenBox.corners[i] = glm::vec3( (clip.x / clip.w * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH,
+                                          (clip.y / clip.w * 0.5f + 0.5f) * OCCLUSION_BUFFER_HEIGHT,
+                                          clip.z / clip.w );
+    }
+
+    return true;
+}
+
+bool OcclusionBuffer::addOccluder(const AABB& box) {
+    glm::vec3 center = 0.5f * (box.min + box.max);
+    glm::vec3 halfSize = 0.5f * OCCLUDER_SCALE * (box.max - box.min);
+
+    ScreenBox screenBox;
+
+    if(!projectBox(center - halfSize, center + halfSize, screenBox)) {
+        return false;
+    }
+
+    occluders.push_back(screenBox);
+    return true;
+}
+
+void OcclusionBuffer::rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, int firstRow, int lastRow) {
+    // Twice the signed area, back faces are clockwise on the screen
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+    if(area <= 0.0f) {
+        return;
+    }
+
+    // Pixels whose center can be inside, clipped to the strip
+    int minX = std::max(0, static_cast<int>(std::floor(std::min(v0.x, std::min(v1.x, v2.x)))));
+    int maxX = std::min(OCCLUSION_BUFFER_WIDTH - 1, static_cast<int>(std::floor(std::max(v0.x, std::max(v1.x, v2.x)))));
+    int minY = std::max(firstRow, static_cast<int>(std::floor(std::min(v0.y, std::min(v1.y, v2.y)))));
+    int maxY = std::min(lastRow - 1, static_cast<int>(std::floor(std::max(v0.y, std::max(v1.y, v2.y)))));
+
+    if(minX > maxX || minY > maxY) {
+        return;
+    }
+
+    // Edge functions e = a * x + b * y + c, positive inside - Edge i is opposite of vertex i
+    const glm::vec3* vertices[3] = { &v0, &v1, &v2 };
+    float a[3], b[3], c[3];
+
+    for(int edge = 0; edge < 3; edge++) {
+        const glm::vec3& from = *vertices[(edge + 1) % 3];
+        const glm::vec3& to = *vertices[(edge + 2) % 3];
+
+        a[edge] = from.y - to.y;
+        b[edge] = to.x - from.x;
+        c[edge] = (to.y - from.y) * from.x - (to.x - from.x) * from.y;
+    }
+
+    // Depth is linear on the screen, the edge functions over the area are the barycentric coordinates
+    float depthA = (v0.z * a[0] + v1.z * a[1] + v2.z * a[2]) / area;
+    float depthB = (v0.z * b[0] + v1.z * b[1] + v2.z * b[2]) / area;
+    float depthC = (v0.z * c[0] + v1.z * c[1] + v2.z * c[2]) / area;
+
+    // 4 pixels at a time, starting on a multiple of 4 so the loads stay in the row
+    int startX = minX & ~3;
+    __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 zero = _mm_setzero_ps();
+
+    float* depth = levels[0].data();
+
+    for(int y = minY; y <= maxY; y++) {
+        float centerY = y + 0.5f;
+        float* row = depth + y * OCCLUSION_BUFFER_WIDTH;
+
+        for(int x = startX; x <= maxX; x += 4) {
+            __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), centerX), _mm_set1_ps(b[0] * centerY + c[0])), zero);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), centerX), _mm_set1_ps(b[1] * centerY + c[1])), zero));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), centerX), _mm_set1_ps(b[2] * centerY + c[2])), zero));
+
+            if(_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            // Keeping the nearest depth of the covered pixels
+            __m128 triangleDepth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthA), centerX), _mm_set1_ps(depthB * centerY + depthC));
+            __m128 currentDepth = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(currentDepth, triangleDepth);
+
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, currentDepth)));
+        }
+    }
+}
+
+void OcclusionBuffer::rasterizeStrip(int strip) {
+    int firstRow = strip * OCCLUSION_STRIP_HEIGHT;
+    int lastRow = std::min(firstRow + OCCLUSION_STRIP_HEIGHT, OCCLUSION_BUFFER_HEIGHT);
+
+    std::fill(levels[0].begin() + firstRow * OCCLUSION_BUFFER_WIDTH, levels[0].begin() + lastRow * OCCLUSION_BUFFER_WIDTH, 1.0f);
+
+    for(const ScreenBox& box : occluders) {
+        for(const int* triangle : BOX_TRIANGLES) {
+            rasterizeTriangle(box.corners[triangle[0]], box.corners[triangle[1]], box.corners[triangle[2]], firstRow, lastRow);
+        }
+    }
+}
+
+void OcclusionBuffer::rasterize() {
+    for(int strip = 0; strip < getStripCount(); strip++) {
+        rasterizeStrip(strip);
+    }
+}
+
+void OcclusionBuffer::buildPyramid() {
+    int width = OCCLUSION_BUFFER_WIDTH, height = OCCLUSION_BUFFER_HEIGHT;
+
+    for(size_t level = 1; level < levels.size(); level++) {
+        const std::vector<float>& previous = levels[level - 1];
+        std::vector<float>& current = levels[level];
+
+        // A side already down to 1 texel stays at 1
+        int nextWidth = std::max(width / 2, 1), nextHeight = std::max(height / 2, 1);
+
+        for(int y = 0; y < nextHeight; y++) {
+            int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+
+            for(int x = 0; x < nextWidth; x++) {
+                int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+
+                current[y * nextWidth + x] = std::max( std::max(previous[y0 * width + x0], previous[y0 * width + x1]),
+                                                       std::max(previous[y1 * width + x0], previous[y1 * width + x1]) );
+            }
+        }
+
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    ScreenBox screenBox;
+
+    if(!projectBox(boxMin, boxMax, screenBox)) {
+        return true;
+    }
+
+    glm::vec3 screenMin = screenBox.corners[0], screenMax = screenBox.corners[0];
+
+    for(int i = 1; i < 8; i++) {
+        screenMin = glm::min(screenMin, screenBox.corners[i]);
+        screenMax = glm::max(screenMax, screenBox.corners[i]);
+    }
+
+    // Off the buffer, left to the frustum culling
+    if(screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= OCCLUSION_BUFFER_WIDTH || screenMin.y >= OCCLUSION_BUFFER_HEIGHT) {
+        return true;
+    }
+
+    int minX = std::max(0, static_cast<int>(screenMin.x));
+    int minY = std::max(0, static_cast<int>(screenMin.y));
+    int maxX = std::min(OCCLUSION_BUFFER_WIDTH - 1, static_cast<int>(screenMax.x));
+    int maxY = std::min(OCCLUSION_BUFFER_HEIGHT - 1, static_cast<int>(screenMax.y));
+
+    // Level where the rectangle covers 2x2 texels at most
+    size_t level = 0;
+
+    while(level + 1 < levels.size() && std::max(maxX - minX, maxY - minY) >> level > 1) {
+        level++;
+    }
+
+    int width = std::max(OCCLUSION_BUFFER_WIDTH >> level, 1);
+    const std::vector<float>& depth = levels[level];
+
+    float farthest = 0.0f;
+
+    for(int y = minY >> level; y <= maxY >> level; y++) {
+        for(int x = minX >> level; x <= maxX >> level; x++) {
+            farthest = std::max(farthest, depth[y * width + x]);
+        }
+    }
+
+    // Nearest point of the box behind everything drawn over it
+    return screenMin.z <= farthest;
+}
+
+void OcclusionBuffer::cullAABBs(const AABBList& boxes, size_t first, size_t count, std::vector<unsigned char>& visible, CullingStats& stats) const {
+    size_t last = std::min(first + count, boxes.count);
+
+    for(size_t i = first; i < last; i++) {
+        if(!visible[i]) {
+            continue;
+        }
+
+        if(!isVisible(glm::vec3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]), glm::vec3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]))) {
+            visible[i] = 0;
+            stats.occluded++;
+        }
+    }
+}
+
+void OcclusionBuffer::benchmarkCity(int gridSize, int views) {
+    // Same random city as the scene, every floor is a box around its building point
+    std::vector<std::pair<int, int>> points;
+    std::vector<glm::vec3> scales;
+    std::vector<int> heights;
+
+    generateRandomPoints(points, gridSize, 2, gridSize);
+    generateRandomScales(scales, points.size());
+    generateRandomHeights(heights, points.size());
+
+    AABBList boxes;
+
+    for(size_t i = 0; i < points.size(); i++) {
+        float floorHeight = (points[i].first % 3 == 0 ? 2.64f : 3.29f) * scales[i].y;
+
+        for(int floor = 0; floor <= heights[i]; floor++) {
+            glm::vec3 base(points[i].first, floor * floorHeight, -points[i].second);
+            boxes.addBox({ base - glm::vec3(scales[i].x, 0.0f, scales[i].z), base + glm::vec3(scales[i].x, floorHeight, scales[i].z) });
+        }
+    }
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> position(0.0f, static_cast<float>(gridSize));
+    std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    OcclusionBuffer buffer;
+    std::vector<unsigned char> visible;
+    std::vector<OccluderCandidate> candidates;
+
+    CullingStats stats;
+    size_t occluderCount = 0;
+    double selectTime = 0.0, rasterTime = 0.0, pyramidTime = 0.0, testTime = 0.0;
+
+    for(int view = 0; view < views; view++) {
+        // Street level, looking along the ground
+        glm::vec3 eye(position(generator), 1.7f, -position(generator));
+        float direction = angle(generator);
+        glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + glm::vec3(std::cos(direction), 0.0f, std::sin(direction)), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        Frustum frustum = extractFrustum(viewProjection);
+        ::cullAABBs(frustum, boxes, visible, stats);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        candidates.clear();
+        collectOccluders(boxes, 0, 0, boxes.count, frustum, eye, candidates);
+        selectOccluders(candidates);
+
+        buffer.begin(viewProjection);
+
+        for(const OccluderCandidate& candidate : candidates) {
+            buffer.addOccluder(boxes.getBox(candidate.index));
+        }
+
+        auto selected = std::chrono::high_resolution_clock::now();
+        buffer.rasterize();
+
+        auto rasterized = std::chrono::high_resolution_clock::now();
+        buffer.buildPyramid();
+
+        auto built = std::chrono::high_resolution_clock::now();
+        buffer.cullAABBs(boxes, 0, boxes.count, visible, stats);
+
+        auto tested = std::chrono::high_resolution_clock::now();
+
+        occluderCount += buffer.getOccluderCount();
+        selectTime += std::chrono::duration<double, std::milli>(selected - start).count();
+        rasterTime += std::chrono::duration<double, std::milli>(rasterized - selected).count();
+        pyramidTime += std::chrono::duration<double, std::milli>(built - rasterized).count();
+        testTime += std::chrono::duration<double, std::milli>(tested - built).count();
+    }
+
+    unsigned int inFrustum = stats.tested - stats.culled;
+
+    printf("Occlusion Culling - Grid %i, %zu floors, %i views\n", gridSize, boxes.count, views);
+    printf("%16s %10.1f per view\n", "In frustum", static_cast<double>(inFrustum) / views);
+    printf("%16s %10.1f per view (%.1f%% of the boxes in the frustum)\n", "Occluded", static_cast<double>(stats.occluded) / views,
+           inFrustum ? 100.0 * stats.occluded / inFrustum : 0.0);
+    printf("%16s %10.1f per view\n", "Occluders", static_cast<double>(occluderCount) / views);
+    printf("%16s %10.3f ms\n", "Select", selectTime / views);
+    printf("%16s %10.3f ms\n", "Rasterize", rasterTime / views);
+    printf("%16s %10.3f ms\n", "Pyramid", pyramidTime / views);
+    printf("%16s %10.3f ms\n", "Test", testTime / views);
+}
+
+// Destructor
+OcclusionBuffer::~OcclusionBuffer() {
+}
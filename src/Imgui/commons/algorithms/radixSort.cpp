@@ -0,0 +1,139 @@
+#include "radixSort.h"
+
+// Bits of a digit, gathered from up to two runs of the key - Constant bits between the runs don't change the order
+struct RadixDigit {
+    int lowShift, highShift, highOffset;
+    uint64_t lowMask, highMask;
+    int bucketCount;
+
+    size_t getBucket(uint64_t key) const {
+        return static_cast<size_t>(((key >> lowShift) & lowMask) | (((key >> highShift) & highMask) << highOffset));
+    }
+};
+
+// Length of the run of set bits starting at bit
+static int getRunLength(uint64_t bits, int bit) {
+    int length = 0;
+
+    while(bit + length < 64 && ((bits >> (bit + length)) & 1)) {
+        length++;
+    }
+
+    return length;
+}
+
+void radixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, int firstBit) {
+    size_t count = keys.size();
+
+    if(count < 2 || firstBit >= 64) {
+        return;
+    }
+
+    scratch.resize(count);
+
+    // Bits that differ between at least two keys, the others are the same everywhere and don't need sorting
+    uint64_t anyBits = 0, allBits = ~0ull;
+
+    for(uint64_t key : keys) {
+        anyBits |= key;
+        allBits &= key;
+    }
+
+    uint64_t remainingBits = (anyBits ^ allBits) >> firstBit << firstBit;
+
+    // Every digit takes the next RADIX_BITS varying bits, least significant first - Unused fields and the gaps they leave in
+    // the key cost no passes
+    RadixDigit digits[64];
+    int passCount = 0;
+
+    while(remainingBits) {
+        RadixDigit& digit = digits[passCount++];
+        int width = 0;
+
+        for(int run = 0; run < 2 && remainingBits && width < RADIX_BITS; run++) {
+            int bit = 0;
+
+            while(!((remainingBits >> bit) & 1)) {
+                bit++;
+            }
+
+            int length = std::min(getRunLength(remainingBits, bit), RADIX_BITS - width);
+            uint64_t mask = (uint64_t(1) << length) - 1;
+
+            if(run == 0) {
+                digit.lowShift = bit;
+                digit.lowMask = mask;
+                digit.highShift = 0;
+                digit.highMask = 0;
+                digit.highOffset = 0;
+            }
+
+            else {
+                digit.highShift = bit;
+                digit.highMask = mask;
+                digit.highOffset = width;
+            }
+
+            remainingBits &= ~(mask << bit);
+            width += length;
+        }
+
+        digit.bucketCount = 1 << width;
+    }
+
+    if(!passCount) {
+        return;
+    }
+
+    // Only the histogram of the first pass is counted on its own, every pass counts the digit of the next one while moving the keys
+    uint32_t histogram[RADIX_BUCKETS];
+    uint32_t nextHistogram[RADIX_BUCKETS];
+
+    std::fill(histogram, histogram + digits[0].bucketCount, 0);
+
+    for(uint64_t key : keys) {
+        histogram[digits[0].getBucket(key)]++;
+    }
+
+    uint64_t* source = keys.data();
+    uint64_t* destination = scratch.data();
+
+    for(int pass = 0; pass < passCount; pass++) {
+        const RadixDigit digit = digits[pass];
+
+        // Turning the counts into the first position of each bucket
+        uint32_t offset = 0;
+
+        for(int bucket = 0; bucket < digit.bucketCount; bucket++) {
+            uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        if(pass + 1 < passCount) {
+            const RadixDigit nextDigit = digits[pass + 1];
+            std::fill(nextHistogram, nextHistogram + nextDigit.bucketCount, 0);
+
+            for(size_t i = 0; i < count; i++) {
+                uint64_t key = source[i];
+                nextHistogram[nextDigit.getBucket(key)]++;
+                destination[histogram[digit.getBucket(key)]++] = key;
+            }
+
+            std::copy(nextHistogram, nextHistogram + nextDigit.bucketCount, histogram);
+        }
+
+        else {
+            for(size_t i = 0; i < count; i++) {
+                destination[histogram[digit.getBucket(source[i])]++] = source[i];
+            }
+        }
+
+        std::swap(source, destination);
+    }
+
+    // Odd number of passes, the result is in the scratch buffer
+    if(source != keys.data()) {
+        keys.swap(scratch);
+    }
+}
@@ -45,16 +45,86 @@ GLfloat deltaTime = 0.0f;
 GLfloat lastTime = 0.0f;
 
 // Main Function=======================================================================================================
-int main()
+int main(int argc, char* argv[])
 {
+    // Headless loader benchmark, also checks both loaders give the same UVs - Executable --benchmark-loaders [model.gltf] [iterations]
+    if(argc >= 2 && std::string(argv[1]) == "--benchmark-loaders") {
+        Model::benchmarkLoaders(argc >= 3 ? argv[2] : returnPath(currentSourceDir, "../../files/scene.gltf"), argc >= 4 ? atoi(argv[3]) : 10);
+        return 0;
+    }
+
+    // Headless cluster culling benchmark - Executable --benchmark-clusters model1.obj [model2.gltf ...]
+    if(argc >= 3 && std::string(argv[1]) == "--benchmark-clusters") {
+        for(int i = 2; i < argc; i++) {
+            Model::benchmarkClusterCulling(argv[i]);
+        }
+
+        return 0;
+    }
+
+    // Headless render queue benchmark - Executable --benchmark-render-queue [draws]
+    if(argc >= 2 && std::string(argv[1]) == "--benchmark-render-queue") {
+        RenderQueue::benchmarkSort(argc >= 3 ? atoi(argv[2]) : 100000);
+        return 0;
+    }
+
+    // Headless transform hierarchy benchmark - Executable --benchmark-transforms [nodes]
+    if(argc >= 2 && std::string(argv[1]) == "--benchmark-transforms") {
+        TransformSystem::benchmarkUpdate(argc >= 3 ? atoi(argv[2]) : 1000000);
+        return 0;
+    }
+
+    // Headless occlusion culling benchmark - Executable --benchmark-occlusion [gridSize]
+    if(argc >= 2 && std::string(argv[1]) == "--benchmark-occlusion") {
+        if(argc >= 3) {
+            OcclusionBuffer::benchmarkCity(atoi(argv[2]));
+        }
+
+        else {
+            for(int gridSize : { 20, 200, 2000 }) {
+                OcclusionBuffer::benchmarkCity(gridSize);
+            }
+        }
+
+        return 0;
+    }
+
+    // Headless clustered lighting benchmark - Executable --benchmark-lights [lights]
+    if(argc >= 2 && std::string(argv[1]) == "--benchmark-lights") {
+        ClusteredLights::benchmarkAssign(argc >= 3 ? atoi(argv[2]) : 10000);
+        return 0;
+    }
+
+    // Headless per instance lighting benchmark - Executable --benchmark-instance-lights [instances] [lights]
+    if(argc >= 2 && std::string(argv[1]) == "--benchmark-instance-lights") {
+        InstanceLights::benchmarkAssign(argc >= 3 ? atoi(argv[2]) : 50000, argc >= 4 ? atoi(argv[3]) : 10000);
+        return 0;
+    }
+
+    // Offline texture cooking - Executable --cook-textures path/to/Textures [file.png ...]
+    // Writes a block compressed .ktx2 next to every image, Texture and Skybox load those instead of the images
+    if(argc >= 3 && std::string(argv[1]) == "--cook-textures") {
+        TextureCooker::cookFiles(std::vector<std::string>(argv + 2, argv + argc));
+        return 0;
+    }
+
     // Our main window
     Window mainWindow(1366, 768);
     mainWindow.initialize();
 
+    // CPU mip chain benchmark, needs the context for the driver comparison - Executable --benchmark-mips [size]
+    if(argc >= 2 && std::string(argv[1]) == "--benchmark-mips") {
+        Texture::benchmarkMipChain(argc >= 3 ? atoi(argv[2]) : 4096);
+        return 0;
+    }
+
     // Our scene
     Scene mainScene(mainWindow, seed);
     mainScene.setupScene(currentSourceDir);
 
+    // Everything allocated while loading, grouped by call site
+    printAllocationSites("Allocations while loading");
+
     // Main Loop - Running till the window is open=====================================================================
     while(!mainWindow.getShouldClose()) {
         // For Delta Time
@@ -69,7 +139,7 @@ int main()
         mainScene.update(deltaTime);
 
         // Un-Binding the program
-        glUseProgram(0);
+        glState.useProgram(0);
 
         // We have 2 scenes, one which we are drawing to and one current
         mainWindow.swapBuffers();
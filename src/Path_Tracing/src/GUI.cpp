@@ -61,13 +61,20 @@ namespace GUI {
         ImGui::NewFrame();
     }
 
+    // "##" followed by the uniform name, on the stack so drawing the UI doesn't allocate
+	const char* hiddenLabel(char (&label)[ELEMENT_NAME_SIZE], const char* name) {
+		snprintf(label, sizeof(label), "##%s", name);
+		return label;
+	}
+
     // These functions are used to create various sliders/elements and bind the values to shaders
 	void shaderFloatParameter(const char* name, const char* displayName, float* floatPtr) {
 		ImGui::Text(displayName);
 		ImGui::SameLine();
 
         // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-		if (ImGui::DragFloat(std::string("##").append(name).c_str(), floatPtr, sliderSpeed)) {
+		char label[ELEMENT_NAME_SIZE];
+		if (ImGui::DragFloat(hiddenLabel(label, name), floatPtr, sliderSpeed)) {
 			if (Scene::shaderID) {
                 glUniform1f(glGetUniformLocation(Scene::shaderID, name), *floatPtr);
             }
@@ -81,7 +88,8 @@ namespace GUI {
 		ImGui::SameLine();
 
         // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-		if (ImGui::DragFloat(std::string("##").append(name).c_str(), floatPtr, sliderSpeed, 0.0f, 1.0f)) {
+		char label[ELEMENT_NAME_SIZE];
+		if (ImGui::DragFloat(hiddenLabel(label, name), floatPtr, sliderSpeed, 0.0f, 1.0f)) {
 			if (Scene::shaderID) {
                 glUniform1f(glGetUniformLocation(Scene::shaderID, name), *floatPtr);
             }
@@ -95,7 +103,8 @@ namespace GUI {
 		ImGui::SameLine();
 
         // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-		if (ImGui::DragFloat3(std::string("##").append(name).c_str(), floatPtr, sliderSpeed)) {
+		char label[ELEMENT_NAME_SIZE];
+		if (ImGui::DragFloat3(hiddenLabel(label, name), floatPtr, sliderSpeed)) {
 			if (Scene::shaderID) {
                 glUniform3f(glGetUniformLocation(Scene::shaderID, name), *(floatPtr + 0), *(floatPtr + 1), *(floatPtr + 2));
             }
@@ -126,22 +135,23 @@ namespace GUI {
 		ImGui::PushItemWidth(-1);
 		if (Scene::selectedObjectIndex != -1) {
 			int i = Scene::selectedObjectIndex;
-			std::string indexStr = std::to_string(i);
+			char name[ELEMENT_NAME_SIZE], label[ELEMENT_NAME_SIZE];
 
-			ImGui::Text(std::string("Object #").append(indexStr).c_str());
+			ImGui::Text("Object #%d", i);
 
-			shaderVecParameter(arrayElementName("u_objects", i, "position").c_str(), "Position", Scene::objects[i].position);
+			shaderVecParameter(arrayElementName(name, sizeof(name), "u_objects", i, "position"), "Position", Scene::objects[i].position);
 
 			ImGui::Text("Is Cube");
 			ImGui::SameLine();
 			bool isCube = Scene::objects[i].type == 2;
-			std::string typeVariableName = arrayElementName("u_objects", i, "type");
-			std::string scaleVariableName = arrayElementName("u_objects", i, "scale");
+			char typeVariableName[ELEMENT_NAME_SIZE], scaleVariableName[ELEMENT_NAME_SIZE];
+			arrayElementName(typeVariableName, sizeof(typeVariableName), "u_objects", i, "type");
+			arrayElementName(scaleVariableName, sizeof(scaleVariableName), "u_objects", i, "scale");
 
             // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-			if (ImGui::Checkbox(std::string("##").append(typeVariableName).c_str(), &isCube)) {
+			if (ImGui::Checkbox(hiddenLabel(label, typeVariableName), &isCube)) {
 				Scene::objects[i].type = isCube ? 2 : 1;
-				if (Scene::shaderID) glUniform1ui(glGetUniformLocation(Scene::shaderID, typeVariableName.c_str()), Scene::objects[i].type);
+				if (Scene::shaderID) glUniform1ui(glGetUniformLocation(Scene::shaderID, typeVariableName), Scene::objects[i].type);
 				refreshRequired = true;
 
 				if (isCube) {
@@ -156,7 +166,7 @@ namespace GUI {
 					Scene::objects[i].scale[2] = minDimension / 2.0f;
 				}
 
-				if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, scaleVariableName.c_str()), Scene::objects[i].scale[0], Scene::objects[i].scale[1], Scene::objects[i].scale[2]);
+				if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, scaleVariableName), Scene::objects[i].scale[0], Scene::objects[i].scale[1], Scene::objects[i].scale[2]);
 			}
 
 			if (Scene::objects[i].type == 1) {
@@ -164,26 +174,26 @@ namespace GUI {
 				ImGui::SameLine();
 
                 // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-				if (ImGui::InputFloat(std::string("##").append(scaleVariableName).c_str(), &Scene::objects[i].scale[0])) {
+				if (ImGui::InputFloat(hiddenLabel(label, scaleVariableName), &Scene::objects[i].scale[0])) {
 					Scene::objects[i].scale[1] = Scene::objects[i].scale[0];
 					Scene::objects[i].scale[2] = Scene::objects[i].scale[0];
-					if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, scaleVariableName.c_str()), Scene::objects[i].scale[0], Scene::objects[i].scale[1], Scene::objects[i].scale[2]);
+					if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, scaleVariableName), Scene::objects[i].scale[0], Scene::objects[i].scale[1], Scene::objects[i].scale[2]);
 					refreshRequired = true;
 				}
 			}
 
 			else if (Scene::objects[i].type == 2) {
-				shaderVecParameter(scaleVariableName.c_str(), "Scale", Scene::objects[i].scale);
+				shaderVecParameter(scaleVariableName, "Scale", Scene::objects[i].scale);
 			}
 
-			shaderColorParameter(arrayElementName("u_objects", i, "material.albedo").c_str(), "Albedo", Scene::objects[i].material.albedo);
-			shaderColorParameter(arrayElementName("u_objects", i, "material.specular").c_str(), "Specular", Scene::objects[i].material.specular);
-			shaderColorParameter(arrayElementName("u_objects", i, "material.emission").c_str(), "Emission", Scene::objects[i].material.emission);
-			shaderFloatParameter(arrayElementName("u_objects", i, "material.emissionStrength").c_str(), "Emission Strength", &Scene::objects[i].material.emissionStrength);
+			shaderColorParameter(arrayElementName(name, sizeof(name), "u_objects", i, "material.albedo"), "Albedo", Scene::objects[i].material.albedo);
+			shaderColorParameter(arrayElementName(name, sizeof(name), "u_objects", i, "material.specular"), "Specular", Scene::objects[i].material.specular);
+			shaderColorParameter(arrayElementName(name, sizeof(name), "u_objects", i, "material.emission"), "Emission", Scene::objects[i].material.emission);
+			shaderFloatParameter(arrayElementName(name, sizeof(name), "u_objects", i, "material.emissionStrength"), "Emission Strength", &Scene::objects[i].material.emissionStrength);
 
-			shaderSliderParameter(arrayElementName("u_objects", i, "material.roughness").c_str(), "Roughness", &Scene::objects[i].material.roughness);
-			shaderSliderParameter(arrayElementName("u_objects", i, "material.specularHighlight").c_str(), "Highlight", &Scene::objects[i].material.specularHighlight);
-			shaderSliderParameter(arrayElementName("u_objects", i, "material.specularExponent").c_str(), "Exponent", &Scene::objects[i].material.specularExponent);
+			shaderSliderParameter(arrayElementName(name, sizeof(name), "u_objects", i, "material.roughness"), "Roughness", &Scene::objects[i].material.roughness);
+			shaderSliderParameter(arrayElementName(name, sizeof(name), "u_objects", i, "material.specularHighlight"), "Highlight", &Scene::objects[i].material.specularHighlight);
+			shaderSliderParameter(arrayElementName(name, sizeof(name), "u_objects", i, "material.specularExponent"), "Exponent", &Scene::objects[i].material.specularExponent);
 
 			ImGui::NewLine();
 		}
@@ -222,15 +232,18 @@ namespace GUI {
 
 		ImGui::PushItemWidth(-1);
 		for (int i = 0; i < Scene::lights.size(); i++) {
-			std::string indexStr = std::to_string(i);
+			char name[ELEMENT_NAME_SIZE];
 
-			ImGui::Text(std::string("Light #").append(indexStr).c_str());
+			// Every light has the same labels, the index keeps their ids apart
+			ImGui::PushID(i);
+
+			ImGui::Text("Light #%d", i);
 			ImGui::Text("Position");
 			ImGui::SameLine();
 
             // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-			if (ImGui::InputFloat3(std::string("##light_pos_").append(indexStr).c_str(), Scene::lights[i].position)) {
-				if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, std::string("u_lights[").append(std::to_string(i)).append("].position").c_str()), Scene::lights[i].position[0], Scene::lights[i].position[1], Scene::lights[i].position[2]);
+			if (ImGui::InputFloat3("##light_pos", Scene::lights[i].position)) {
+				if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, arrayElementName(name, sizeof(name), "u_lights", i, "position")), Scene::lights[i].position[0], Scene::lights[i].position[1], Scene::lights[i].position[2]);
 				refreshRequired = true;
 			}
 
@@ -238,18 +251,18 @@ namespace GUI {
 			ImGui::SameLine();
 
             // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-			if (ImGui::InputFloat(std::string("##light_radius_").append(indexStr).c_str(), &Scene::lights[i].radius)) {
-				if (Scene::shaderID) glUniform1f(glGetUniformLocation(Scene::shaderID, std::string("u_lights[").append(std::to_string(i)).append("].radius").c_str()), Scene::lights[i].radius);
+			if (ImGui::InputFloat("##light_radius", &Scene::lights[i].radius)) {
+				if (Scene::shaderID) glUniform1f(glGetUniformLocation(Scene::shaderID, arrayElementName(name, sizeof(name), "u_lights", i, "radius")), Scene::lights[i].radius);
 				refreshRequired = true;
 			}
 
-			ImGui::Text(std::string("Light #").append(indexStr).c_str());
+			ImGui::Text("Light #%d", i);
 			ImGui::Text("Color");
 			ImGui::SameLine();
 
             // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-			if (ImGui::ColorEdit3(std::string("##light_color_").append(indexStr).c_str(), Scene::lights[i].color)) {
-				if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, std::string("u_lights[").append(std::to_string(i)).append("].color").c_str()), Scene::lights[i].color[0], Scene::lights[i].color[1], Scene::lights[i].color[2]);
+			if (ImGui::ColorEdit3("##light_color", Scene::lights[i].color)) {
+				if (Scene::shaderID) glUniform3f(glGetUniformLocation(Scene::shaderID, arrayElementName(name, sizeof(name), "u_lights", i, "color")), Scene::lights[i].color[0], Scene::lights[i].color[1], Scene::lights[i].color[2]);
 				refreshRequired = true;
 			}
 
@@ -257,8 +270,8 @@ namespace GUI {
 			ImGui::SameLine();
 
             // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-			if (ImGui::DragFloat(std::string("##light_power_").append(indexStr).c_str(), &Scene::lights[i].power, sliderSpeed)) {
-				if (Scene::shaderID) glUniform1f(glGetUniformLocation(Scene::shaderID, std::string("u_lights[").append(std::to_string(i)).append("].power").c_str()), Scene::lights[i].power);
+			if (ImGui::DragFloat("##light_power", &Scene::lights[i].power, sliderSpeed)) {
+				if (Scene::shaderID) glUniform1f(glGetUniformLocation(Scene::shaderID, arrayElementName(name, sizeof(name), "u_lights", i, "power")), Scene::lights[i].power);
 				refreshRequired = true;
 			}
 
@@ -266,11 +279,13 @@ namespace GUI {
 			ImGui::SameLine();
 
             // '##' is used to hide the label for the particular element and provide unique identifiers to ImGui's internal state management
-			if (ImGui::DragFloat(std::string("##light_reach_").append(indexStr).c_str(), &Scene::lights[i].reach, sliderSpeed)) {
-				if (Scene::shaderID) glUniform1f(glGetUniformLocation(Scene::shaderID, std::string("u_lights[").append(std::to_string(i)).append("].reach").c_str()), Scene::lights[i].reach);
+			if (ImGui::DragFloat("##light_reach", &Scene::lights[i].reach, sliderSpeed)) {
+				if (Scene::shaderID) glUniform1f(glGetUniformLocation(Scene::shaderID, arrayElementName(name, sizeof(name), "u_lights", i, "reach")), Scene::lights[i].reach);
 				refreshRequired = true;
 			}
 
+			ImGui::PopID();
+
 			if (i < 2) {
                 ImGui::NewLine();
             }
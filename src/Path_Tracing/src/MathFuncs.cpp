@@ -1,5 +1,6 @@
 #include "MathFuncs.h"
 
-std::string arrayElementName(const char* arrayName, int index, const char* keyName) {
-    return std::string(arrayName).append("[").append(std::to_string(index)).append("].").append(keyName);
+const char* arrayElementName(char* buffer, size_t size, const char* arrayName, int index, const char* keyName) {
+    snprintf(buffer, size, "%s[%d].%s", arrayName, index, keyName);
+    return buffer;
 }
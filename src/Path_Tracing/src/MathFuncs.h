@@ -3,8 +3,12 @@
 
 #include <iostream>
 #include <string>
+#include <cstdio>
 
-// This function is used to name the elements according to our shader
-std::string arrayElementName(const char* arrayName, int index, const char* keyName);
+// Longest uniform name built by arrayElementName, with the "##" ImGui prefix
+constexpr size_t ELEMENT_NAME_SIZE = 64;
+
+// This function is used to name the elements according to our shader - Written into buffer, so the UI doesn't allocate every frame
+const char* arrayElementName(char* buffer, size_t size, const char* arrayName, int index, const char* keyName);
 
 #endif
@@ -7,6 +7,9 @@
 // GUI Header fpr operations
 #include "GUI.h"
 
+// Uniform names of the object and light arrays
+#include "MathFuncs.h"
+
 extern bool refreshRequired;
 
 namespace Scene {
@@ -67,29 +70,87 @@ namespace Scene {
 		this->reach = reach;
 	}
 
+	// Uniform locations of every object and light, looked up once per shader instead of building their names every frame
+	struct ObjectUniforms {
+		GLint type, position, scale;
+		GLint albedo, specular, emission, emissionStrength, roughness, specularHighlight, specularExponent;
+	};
+
+	struct LightUniforms {
+		GLint position, radius, color, power, reach;
+	};
+
+	std::vector<ObjectUniforms> objectUniforms;
+	std::vector<LightUniforms> lightUniforms;
+	GLuint uniformShaderID = 0;
+
+	GLint arrayElementLocation(const char* arrayName, int index, const char* keyName) {
+		char name[ELEMENT_NAME_SIZE];
+		return glGetUniformLocation(shaderID, arrayElementName(name, sizeof(name), arrayName, index, keyName));
+	}
+
+	// New shaders start over, new objects and lights are looked up when they are first sent
+	void updateUniformLocations() {
+		if (uniformShaderID != shaderID) {
+			objectUniforms.clear();
+			lightUniforms.clear();
+			uniformShaderID = shaderID;
+		}
+
+		for (int i = static_cast<int>(objectUniforms.size()); i < static_cast<int>(objects.size()); i++) {
+			ObjectUniforms uniforms;
+			uniforms.type = arrayElementLocation("u_objects", i, "type");
+			uniforms.position = arrayElementLocation("u_objects", i, "position");
+			uniforms.scale = arrayElementLocation("u_objects", i, "scale");
+			uniforms.albedo = arrayElementLocation("u_objects", i, "material.albedo");
+			uniforms.specular = arrayElementLocation("u_objects", i, "material.specular");
+			uniforms.emission = arrayElementLocation("u_objects", i, "material.emission");
+			uniforms.emissionStrength = arrayElementLocation("u_objects", i, "material.emissionStrength");
+			uniforms.roughness = arrayElementLocation("u_objects", i, "material.roughness");
+			uniforms.specularHighlight = arrayElementLocation("u_objects", i, "material.specularHighlight");
+			uniforms.specularExponent = arrayElementLocation("u_objects", i, "material.specularExponent");
+			objectUniforms.push_back(uniforms);
+		}
+
+		for (int i = static_cast<int>(lightUniforms.size()); i < static_cast<int>(lights.size()); i++) {
+			LightUniforms uniforms;
+			uniforms.position = arrayElementLocation("u_lights", i, "position");
+			uniforms.radius = arrayElementLocation("u_lights", i, "radius");
+			uniforms.color = arrayElementLocation("u_lights", i, "color");
+			uniforms.power = arrayElementLocation("u_lights", i, "power");
+			uniforms.reach = arrayElementLocation("u_lights", i, "reach");
+			lightUniforms.push_back(uniforms);
+		}
+	}
+
 	void sendObjectData(int objectIndex) {
-		std::string i_str = std::to_string(objectIndex);
-		glUniform1ui(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].type").c_str()), objects[objectIndex].type);
-		glUniform3f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].position").c_str()), objects[objectIndex].position[0], objects[objectIndex].position[1], objects[objectIndex].position[2]);
-		glUniform3f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].scale").c_str()), objects[objectIndex].scale[0], objects[objectIndex].scale[1], objects[objectIndex].scale[2]);
-		glUniform3f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].material.albedo").c_str()), objects[objectIndex].material.albedo[0], objects[objectIndex].material.albedo[1], objects[objectIndex].material.albedo[2]);
-		glUniform3f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].material.specular").c_str()), objects[objectIndex].material.specular[0], objects[objectIndex].material.specular[1], objects[objectIndex].material.specular[2]);
-		glUniform3f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].material.emission").c_str()), objects[objectIndex].material.emission[0], objects[objectIndex].material.emission[1], objects[objectIndex].material.emission[2]);
-		glUniform1f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].material.emissionStrength").c_str()), objects[objectIndex].material.emissionStrength);
-		glUniform1f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].material.roughness").c_str()), objects[objectIndex].material.roughness);
-		glUniform1f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].material.specularHighlight").c_str()), objects[objectIndex].material.specularHighlight);
-		glUniform1f(glGetUniformLocation(shaderID, std::string("u_objects[").append(i_str).append("].material.specularExponent").c_str()), objects[objectIndex].material.specularExponent);
+		updateUniformLocations();
+
+		const ObjectUniforms& uniforms = objectUniforms[objectIndex];
+		const Object& object = objects[objectIndex];
+
+		glUniform1ui(uniforms.type, object.type);
+		glUniform3f(uniforms.position, object.position[0], object.position[1], object.position[2]);
+		glUniform3f(uniforms.scale, object.scale[0], object.scale[1], object.scale[2]);
+		glUniform3f(uniforms.albedo, object.material.albedo[0], object.material.albedo[1], object.material.albedo[2]);
+		glUniform3f(uniforms.specular, object.material.specular[0], object.material.specular[1], object.material.specular[2]);
+		glUniform3f(uniforms.emission, object.material.emission[0], object.material.emission[1], object.material.emission[2]);
+		glUniform1f(uniforms.emissionStrength, object.material.emissionStrength);
+		glUniform1f(uniforms.roughness, object.material.roughness);
+		glUniform1f(uniforms.specularHighlight, object.material.specularHighlight);
+		glUniform1f(uniforms.specularExponent, object.material.specularExponent);
 	}
 
 	void bind(GLuint shaderProgram) {
 		shaderID = shaderProgram;
+		updateUniformLocations();
 
 		for (int i = 0; i < lights.size(); i++) {
-			glUniform3f(glGetUniformLocation(shaderProgram, std::string("u_lights[").append(std::to_string(i)).append("].position").c_str()), lights[i].position[0], lights[i].position[1], lights[i].position[2]);
-			glUniform1f(glGetUniformLocation(shaderProgram, std::string("u_lights[").append(std::to_string(i)).append("].radius").c_str()), lights[i].radius);
-			glUniform3f(glGetUniformLocation(shaderProgram, std::string("u_lights[").append(std::to_string(i)).append("].color").c_str()), lights[i].color[0], lights[i].color[1], lights[i].color[2]);
-			glUniform1f(glGetUniformLocation(shaderProgram, std::string("u_lights[").append(std::to_string(i)).append("].power").c_str()), lights[i].power);
-			glUniform1f(glGetUniformLocation(shaderProgram, std::string("u_lights[").append(std::to_string(i)).append("].reach").c_str()), lights[i].reach);
+			glUniform3f(lightUniforms[i].position, lights[i].position[0], lights[i].position[1], lights[i].position[2]);
+			glUniform1f(lightUniforms[i].radius, lights[i].radius);
+			glUniform3f(lightUniforms[i].color, lights[i].color[0], lights[i].color[1], lights[i].color[2]);
+			glUniform1f(lightUniforms[i].power, lights[i].power);
+			glUniform1f(lightUniforms[i].reach, lights[i].reach);
 		}
 
 		glUniform3f(glGetUniformLocation(shaderProgram, "u_planeMaterial.albedo"), planeMaterial.albedo[0], planeMaterial.albedo[1], planeMaterial.albedo[2]);